@@ -19,6 +19,7 @@
  */
 
 #include "context_priv.h"
+#include "xcam_thread.h"
 #include "ctxs/context_stitch.h"
 #if HAVE_LIBCL
 #include "ctxs/context_cl.h"
@@ -27,6 +28,31 @@
 using namespace XCam;
 
 #define DEFAULT_INPUT_BUFFER_POOL_COUNT  20
+#define DEFAULT_MAX_INFLIGHT_COUNT       2
+
+struct ContextAsyncJob {
+    SmartPtr<VideoBuffer>         buf_in;
+    SmartPtr<VideoBuffer>         buf_out;
+    SmartPtr<ContextAsyncDone>    done;
+};
+
+class ContextAsyncThread
+    : public Thread
+{
+public:
+    explicit ContextAsyncThread (ContextBase *context)
+        : Thread ("capi-async")
+        , _context (context)
+    {}
+
+protected:
+    virtual bool loop () {
+        return _context->process_async_job ();
+    }
+
+private:
+    ContextBase *_context;
+};
 
 static const char *HandleNames[] = {
     "none",
@@ -55,11 +81,17 @@ ContextBase::ContextBase (HandleType type)
     , _format (V4L2_PIX_FMT_NV12)
     , _mem_type (XCAM_MEM_TYPE_CPU)
     , _alloc_out_buf (0)
+    , _max_inflight (DEFAULT_MAX_INFLIGHT_COUNT)
+    , _inflight (0)
+    , _async_running (false)
+    , _in_done (false)
 {
 }
 
 ContextBase::~ContextBase ()
 {
+    // derived context is gone here, async jobs must be stopped before deleting context
+    XCAM_ASSERT (!_async_thread.ptr ());
     xcam_free (_usage);
 }
 
@@ -103,6 +135,11 @@ ContextBase::set_parameters (ContextParams &param_list)
         ERROR, _output_width || _output_height , XCAM_RETURN_ERROR_PARAM,
         "illegal output size %dx%d", _output_width, _output_height);
 
+    parse_value (param_list, "maxinflight", _max_inflight);
+    XCAM_FAIL_RETURN (
+        ERROR, _max_inflight > 0, XCAM_RETURN_ERROR_PARAM,
+        "illegal max in-flight count %d", _max_inflight);
+
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -113,6 +150,192 @@ ContextBase::is_handler_valid () const
     return false;
 }
 
+bool
+ContextBase::support_async () const
+{
+    return true;
+}
+
+XCamReturn
+ContextBase::get_metrics (XCamHandleMetrics &metrics)
+{
+    {
+        SmartLock locker (_async_mutex);
+        metrics.frames_in_flight = _inflight;
+    }
+
+    if (_inbuf_pool.ptr ()) {
+        BufferPool::Metrics pool_metrics;
+        _inbuf_pool->get_metrics (pool_metrics);
+        metrics.buffers_acquired = pool_metrics.acquired;
+        convert_latency_metrics (pool_metrics.starved_wait, metrics.buffers_starved);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ContextBase::reset_metrics ()
+{
+    if (_inbuf_pool.ptr ())
+        _inbuf_pool->reset_metrics ();
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ContextBase::execute_async (
+    SmartPtr<VideoBuffer> &buf_in, SmartPtr<VideoBuffer> &buf_out, const SmartPtr<ContextAsyncDone> &done)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, support_async (), XCAM_RETURN_ERROR_PARAM,
+        "context (%s) does not support async execute", get_type_name ());
+
+    // a thread stopped in its done callback is joined before a new one starts
+    bool stopping = false;
+    {
+        SmartLock locker (_async_mutex);
+        stopping = _async_thread.ptr () && !_async_running && !in_async_done_unsafe ();
+    }
+    if (stopping)
+        stop_async ();
+
+    SmartPtr<ContextAsyncJob> job = new ContextAsyncJob;
+    job->buf_in = buf_in;
+    job->buf_out = buf_out;
+    job->done = done;
+
+    SmartLock locker (_async_mutex);
+    if (!_async_thread.ptr ()) {
+        _async_thread = new ContextAsyncThread (this);
+        _async_running = true;
+        if (!_async_thread->start ()) {
+            _async_running = false;
+            _async_thread.release ();
+            XCAM_LOG_ERROR ("context (%s) start async thread failed", get_type_name ());
+            return XCAM_RETURN_ERROR_THREAD;
+        }
+    }
+
+    while (_async_running && _inflight >= _max_inflight)
+        _async_cond.wait (_async_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, _async_running, XCAM_RETURN_ERROR_ORDER,
+        "context (%s) async execute failed, async thread was stopped", get_type_name ());
+
+    _async_jobs.push_back (job);
+    ++_inflight;
+    _async_cond.broadcast ();
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+ContextBase::process_async_job ()
+{
+    SmartPtr<ContextAsyncJob> job;
+    {
+        SmartLock locker (_async_mutex);
+        while (_async_running && _async_jobs.empty ())
+            _async_cond.wait (_async_mutex);
+
+        // jobs queued before stop are still processed
+        if (_async_jobs.empty ())
+            return false;
+
+        job = _async_jobs.front ();
+        _async_jobs.pop_front ();
+    }
+
+    XCamReturn ret = execute (job->buf_in, job->buf_out);
+    if (ret != XCAM_RETURN_NO_ERROR && ret != XCAM_RETURN_BYPASS) {
+        XCAM_LOG_ERROR ("context (%s) async execute failed", get_type_name ());
+    }
+
+    // the callback may queue the next frame or flush, count the job out before it
+    {
+        SmartLock locker (_async_mutex);
+        --_inflight;
+        _in_done = true;
+        _done_thread = pthread_self ();
+        _async_cond.broadcast ();
+    }
+
+    if (job->done.ptr ())
+        job->done->execute_done (this, job->buf_out, ret);
+
+    SmartLock locker (_async_mutex);
+    _in_done = false;
+    _async_cond.broadcast ();
+
+    return true;
+}
+
+bool
+ContextBase::in_async_done_unsafe () const
+{
+    return _in_done && pthread_equal (_done_thread, pthread_self ());
+}
+
+bool
+ContextBase::in_async_done ()
+{
+    SmartLock locker (_async_mutex);
+    return in_async_done_unsafe ();
+}
+
+XCamReturn
+ContextBase::wait_async_done ()
+{
+    SmartLock locker (_async_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, !in_async_done_unsafe () || _inflight == 0,
+        XCAM_RETURN_ERROR_ORDER,
+        "context (%s) can not wait for queued frames in the async done callback", get_type_name ());
+
+    while (_inflight > 0 || (_in_done && !pthread_equal (_done_thread, pthread_self ())))
+        _async_cond.wait (_async_mutex);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ContextBase::stop_async ()
+{
+    SmartPtr<ContextAsyncThread> thread;
+    {
+        SmartLock locker (_async_mutex);
+        if (!_async_thread.ptr ())
+            return XCAM_RETURN_NO_ERROR;
+
+        // the async thread can not join itself, in its done callback it only stops taking jobs
+        // and exits once the callback returns, the next stop_async or execute_async joins it
+        if (in_async_done_unsafe ()) {
+            XCAM_FAIL_RETURN (
+                ERROR, _inflight == 0, XCAM_RETURN_ERROR_ORDER,
+                "context (%s) can not stop async thread in the done callback while frames are queued",
+                get_type_name ());
+
+            _async_running = false;
+            _async_cond.broadcast ();
+            return XCAM_RETURN_NO_ERROR;
+        }
+
+        _async_running = false;
+        _async_cond.broadcast ();
+        thread = _async_thread;
+    }
+
+    thread->stop ();
+
+    SmartLock locker (_async_mutex);
+    XCAM_ASSERT (_inflight == 0);
+    // execute_async may have joined it as well and started a new one
+    if (_async_thread.ptr () == thread.ptr ())
+        _async_thread.release ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
 void
 ContextBase::set_buf_pool (const SmartPtr<BufferPool> &pool)
 {
@@ -137,6 +360,25 @@ ContextBase::need_alloc_out_buf () const
     return _alloc_out_buf;
 }
 
+bool
+ContextBase::check_import_info (const XCamVideoBufferInfo &info, bool is_input) const
+{
+    uint32_t width = is_input ? _input_width : _output_width;
+    uint32_t height = is_input ? _input_height : _output_height;
+
+    XCAM_FAIL_RETURN (
+        ERROR, info.format == _format, false,
+        "context (%s) import %s buffer failed, format(%s) mismatch",
+        get_type_name (), is_input ? "input" : "output", xcam_fourcc_to_string (info.format));
+
+    XCAM_FAIL_RETURN (
+        ERROR, info.width == width && info.height == height, false,
+        "context (%s) import %s buffer failed, size(%dx%d) mismatch with %dx%d",
+        get_type_name (), is_input ? "input" : "output", info.width, info.height, width, height);
+
+    return true;
+}
+
 uint32_t
 ContextBase::get_in_width () const
 {
@@ -167,6 +409,12 @@ ContextBase::get_format () const
     return _format;
 }
 
+uint32_t
+ContextBase::get_max_inflight () const
+{
+    return _max_inflight;
+}
+
 ContextBase *
 create_context (const char *name)
 {
@@ -198,3 +446,13 @@ create_context (const char *name)
     return context;
 }
 
+void
+convert_latency_metrics (const LatencyHistogram &hist, XCamHandleLatency &latency)
+{
+    latency.count = hist.count;
+    latency.errors = hist.errors;
+    latency.mean_us = hist.mean_us ();
+    latency.p50_us = hist.percentile_us (0.5f);
+    latency.p99_us = hist.percentile_us (0.99f);
+    latency.max_us = hist.max_us;
+}
@@ -23,8 +23,11 @@
 
 #include <string.h>
 #include <map>
+#include <list>
 #include "xcam_utils.h"
+#include "xcam_mutex.h"
 #include "buffer_pool.h"
+#include "xcam_handle.h"
 
 using namespace XCam;
 
@@ -47,7 +50,20 @@ typedef struct _CompareStr {
 
 typedef std::map<const char*, const char*, CompareStr> ContextParams;
 
+class ContextBase;
+class ContextAsyncThread;
+struct ContextAsyncJob;
+
+class ContextAsyncDone {
+public:
+    virtual ~ContextAsyncDone () {}
+    // called in context async thread once buf_in was processed
+    virtual void execute_done (ContextBase *context, SmartPtr<VideoBuffer> &buf_out, XCamReturn error) = 0;
+};
+
 class ContextBase {
+    friend class ContextAsyncThread;
+
 public:
     virtual ~ContextBase ();
 
@@ -62,11 +78,26 @@ public:
 
     virtual XCamReturn execute (SmartPtr<VideoBuffer> &buf_in, SmartPtr<VideoBuffer> &buf_out) = 0;
 
+    // queue buffers to context async thread, block while max in-flight jobs are pending
+    XCamReturn execute_async (
+        SmartPtr<VideoBuffer> &buf_in, SmartPtr<VideoBuffer> &buf_out, const SmartPtr<ContextAsyncDone> &done);
+    XCamReturn wait_async_done ();
+    XCamReturn stop_async ();
+    // true in the done callback running on context async thread
+    bool in_async_done ();
+    virtual bool support_async () const;
+
+    // frames in flight and input pool metrics, contexts add their handler metrics
+    virtual XCamReturn get_metrics (XCamHandleMetrics &metrics);
+    virtual XCamReturn reset_metrics ();
+
     SmartPtr<BufferPool> get_input_buffer_pool () const {
         return  _inbuf_pool;
     }
     const char* get_type_name () const;
     bool need_alloc_out_buf () const;
+    // imported buffers are processed in place, they must match the configured size
+    bool check_import_info (const XCamVideoBufferInfo &info, bool is_input) const;
 
 protected:
     ContextBase (HandleType type);
@@ -80,10 +111,14 @@ protected:
     uint32_t get_out_width () const;
     uint32_t get_out_height () const;
     uint32_t get_format () const;
+    uint32_t get_max_inflight () const;
 
     void parse_value (const ContextParams &params, const char *name, uint32_t &value);
 
 private:
+    bool process_async_job ();
+    bool in_async_done_unsafe () const;
+
     XCAM_DEAD_COPY (ContextBase);
 
 protected:
@@ -99,8 +134,21 @@ protected:
     uint32_t                         _format;
     uint32_t                         _mem_type;
     bool                             _alloc_out_buf;
+    uint32_t                         _max_inflight;
+
+private:
+    SmartPtr<ContextAsyncThread>     _async_thread;
+    std::list<SmartPtr<ContextAsyncJob> > _async_jobs;
+    uint32_t                         _inflight;
+    bool                             _async_running;
+    bool                             _in_done;
+    pthread_t                        _done_thread;
+    Mutex                            _async_mutex;
+    Cond                             _async_cond;
 };
 
 ContextBase *create_context (const char *name);
 
+void convert_latency_metrics (const LatencyHistogram &hist, XCamHandleLatency &latency);
+
 #endif // XCAM_CONTEXT_PRIV_H
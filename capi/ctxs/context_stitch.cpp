@@ -194,6 +194,52 @@ StitchContext::is_handler_valid () const
     return _stitcher.ptr () ? true : false;
 }
 
+bool
+StitchContext::support_async () const
+{
+    // EGL context is bound to the thread which initialized it
+    return _module != StitchGLES;
+}
+
+XCamReturn
+StitchContext::get_metrics (XCamHandleMetrics &metrics)
+{
+    XCamReturn ret = ContextBase::get_metrics (metrics);
+    if (!_stitcher.ptr ())
+        return ret;
+
+    Stitcher::Metrics stitch_metrics;
+    _stitcher->get_stitch_metrics (stitch_metrics);
+
+    static_assert (
+        (int) XCAM_HANDLE_STAGE_COUNT == (int) Stitcher::StageCount,
+        "handle stages must match stitcher stages");
+    for (uint32_t i = 0; i < Stitcher::StageCount; ++i)
+        convert_latency_metrics (stitch_metrics.stages[i], metrics.stages[i]);
+
+    metrics.frames_in_flight = XCAM_MAX (metrics.frames_in_flight, stitch_metrics.frames_in_flight);
+
+    BufferPool::Metrics pools = stitch_metrics.pools;
+    if (_inbuf_pool.ptr ()) {
+        BufferPool::Metrics in_pool;
+        _inbuf_pool->get_metrics (in_pool);
+        pools.merge (in_pool);
+    }
+    metrics.buffers_acquired = pools.acquired;
+    convert_latency_metrics (pools.starved_wait, metrics.buffers_starved);
+
+    return ret;
+}
+
+XCamReturn
+StitchContext::reset_metrics ()
+{
+    if (_stitcher.ptr ())
+        _stitcher->reset_stitch_metrics ();
+
+    return ContextBase::reset_metrics ();
+}
+
 XCamReturn
 StitchContext::execute (SmartPtr<VideoBuffer> &buf_in, SmartPtr<VideoBuffer> &buf_out)
 {
@@ -202,17 +248,7 @@ StitchContext::execute (SmartPtr<VideoBuffer> &buf_in, SmartPtr<VideoBuffer> &bu
         XCAM_RETURN_ERROR_MEM, "input or output buffer is NULL");
 
     VideoBufferList in_buffers;
-    in_buffers.push_back (buf_in);
-
-    SmartPtr<VideoBuffer> pre_buf = buf_in;
-    SmartPtr<VideoBuffer> att_buf = pre_buf->find_typed_attach<VideoBuffer> ();
-    while (att_buf.ptr ()) {
-        pre_buf->detach_buffer (att_buf);
-        in_buffers.push_back (att_buf);
-
-        pre_buf = att_buf;
-        att_buf = pre_buf->find_typed_attach<VideoBuffer> ();
-    }
+    take_attached_chain (buf_in, in_buffers);
 
     return _stitcher->stitch_buffers (in_buffers, buf_out);
 }
@@ -360,6 +396,9 @@ StitchContext::show_help ()
         "                Range   : [none]\n"
         "                Default : none\n"
 #endif
+        "  maxinflight : Max frames pending in xcam_handle_execute_async\n"
+        "                Range   : [1 - INT_MAX]\n"
+        "                Default : 2\n"
         "  help        : Print usage\n"
         "                Range   : [0, 1]\n"
         "                Default : 0\n",
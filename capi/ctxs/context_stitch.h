@@ -47,6 +47,9 @@ public:
     virtual XCamReturn init_handler ();
     virtual XCamReturn uinit_handler ();
     virtual bool is_handler_valid () const;
+    virtual bool support_async () const;
+    virtual XCamReturn get_metrics (XCamHandleMetrics &metrics);
+    virtual XCamReturn reset_metrics ();
 
     virtual XCamReturn execute (SmartPtr<VideoBuffer> &buf_in, SmartPtr<VideoBuffer> &buf_out);
 
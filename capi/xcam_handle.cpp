@@ -39,8 +39,15 @@ xcam_create_handle (const char *name)
 void
 xcam_destroy_handle (XCamHandle *handle)
 {
-    if (handle)
-        delete CONTEXT_BASE_CAST (handle);
+    if (handle) {
+        ContextBase *context = CONTEXT_BASE_CAST (handle);
+        if (context->in_async_done ()) {
+            XCAM_LOG_ERROR ("xcam_destroy_handle failed, handle can NOT be destroyed in its async done callback");
+            return;
+        }
+        context->stop_async ();
+        delete context;
+    }
 }
 
 XCamReturn
@@ -70,6 +77,11 @@ xcam_handle_uinit (XCamHandle *handle)
         ERROR, context, XCAM_RETURN_ERROR_PARAM,
         "xcam_handler_uinit failed, handle can NOT be NULL");
 
+    XCamReturn ret = context->stop_async ();
+    XCAM_FAIL_RETURN (
+        ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
+        "xcam_handler_uinit failed, stop async thread of handle(%s) failed", context->get_type_name ());
+
     return context->uinit_handler ();
 }
 
@@ -230,23 +242,21 @@ copy_xcambuf_to_extbuf (XCamVideoBuffer *extbuf, const SmartPtr<VideoBuffer> &xc
     return true;
 }
 
-XCamReturn
-xcam_handle_execute (
-    XCamHandle *handle, XCamVideoBuffer **buf_in, XCamVideoBuffer **buf_out)
+static XCamReturn
+convert_extbufs (
+    XCamHandle *handle, XCamVideoBuffer **buf_in, XCamVideoBuffer **buf_out,
+    SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
 {
     ContextBase *context = CONTEXT_BASE_CAST (handle);
-    XCAM_FAIL_RETURN (
-        ERROR, context && buf_in && buf_out, XCAM_RETURN_ERROR_PARAM,
-        "xcam_handle_execute failed, either of handle/buf_in/buf_out can NOT be NULL");
-
-    XCAM_FAIL_RETURN (
-        ERROR, context->is_handler_valid (), XCAM_RETURN_ERROR_PARAM,
-        "context (%s) failed, handler was not initialized", context->get_type_name ());
-
     bool append_buf = !context->need_alloc_out_buf ();
 
-    SmartPtr<VideoBuffer> input, output, pre, cur;
+    SmartPtr<VideoBuffer> pre, cur;
     for (int i = 0; buf_in[i] != NULL; i++) {
+        if (append_buf) {
+            XCAM_FAIL_RETURN (
+                ERROR, context->check_import_info (buf_in[i]->info, true), XCAM_RETURN_ERROR_PARAM,
+                "xcam_handle(%s) execute failed, input buffer(%d) can NOT be imported", context->get_type_name (), i);
+        }
         cur = append_buf ?
             append_extbuf_to_xcambuf (buf_in[i]) : copy_extbuf_to_xcambuf (handle, buf_in[i]);
         XCAM_FAIL_RETURN (
@@ -260,20 +270,51 @@ xcam_handle_execute (
         }
         pre = cur;
     }
+    XCAM_FAIL_RETURN (
+        ERROR, input.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle(%s) execute failed, input buffers are empty", context->get_type_name ());
 
     if (append_buf) {
+        XCAM_FAIL_RETURN (
+            ERROR, buf_out[0] && context->check_import_info (buf_out[0]->info, false), XCAM_RETURN_ERROR_PARAM,
+            "xcam_handle(%s) execute failed, output buffer can NOT be imported", context->get_type_name ());
+
         output = append_extbuf_to_xcambuf (buf_out[0]);
         XCAM_FAIL_RETURN (
             ERROR, output.ptr (), XCAM_RETURN_ERROR_MEM,
             "xcam_handle(%s) execute failed, convert output buffer failed", context->get_type_name ());
     }
 
-    XCamReturn ret = context->execute (input, output);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+xcam_handle_execute (
+    XCamHandle *handle, XCamVideoBuffer **buf_in, XCamVideoBuffer **buf_out)
+{
+    ContextBase *context = CONTEXT_BASE_CAST (handle);
+    XCAM_FAIL_RETURN (
+        ERROR, context && buf_in && buf_out, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_execute failed, either of handle/buf_in/buf_out can NOT be NULL");
+
+    XCAM_FAIL_RETURN (
+        ERROR, context->is_handler_valid (), XCAM_RETURN_ERROR_PARAM,
+        "context (%s) failed, handler was not initialized", context->get_type_name ());
+
+    // keep frame order with jobs queued by xcam_handle_execute_async
+    context->wait_async_done ();
+
+    SmartPtr<VideoBuffer> input, output;
+    XCamReturn ret = convert_extbufs (handle, buf_in, buf_out, input, output);
+    if (ret != XCAM_RETURN_NO_ERROR)
+        return ret;
+
+    ret = context->execute (input, output);
     XCAM_FAIL_RETURN (
         ERROR, ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_BYPASS, ret,
         "context (%s) failed, handler execute failed", context->get_type_name ());
 
-    if (!append_buf) {
+    if (context->need_alloc_out_buf ()) {
         XCAM_FAIL_RETURN (
             ERROR, copy_xcambuf_to_extbuf (buf_out[0], output), XCAM_RETURN_ERROR_MEM,
             "xcam_handle(%s) execute failed, convert output buffer failed", context->get_type_name ());
@@ -281,3 +322,132 @@ xcam_handle_execute (
 
     return ret;
 }
+
+class HandleExecuteDone
+    : public ContextAsyncDone
+{
+public:
+    HandleExecuteDone (
+        XCamHandle *handle, XCamVideoBuffer **buf_in, XCamVideoBuffer **buf_out,
+        XCamHandleExecuteDone callback, void *user_data);
+    virtual ~HandleExecuteDone ();
+
+    virtual void execute_done (ContextBase *context, SmartPtr<VideoBuffer> &buf_out, XCamReturn error);
+
+private:
+    XCAM_DEAD_COPY (HandleExecuteDone);
+
+private:
+    XCamHandle                      *_handle;
+    std::vector<XCamVideoBuffer *>   _buf_in;
+    std::vector<XCamVideoBuffer *>   _buf_out;
+    XCamHandleExecuteDone            _callback;
+    void                            *_user_data;
+};
+
+HandleExecuteDone::HandleExecuteDone (
+    XCamHandle *handle, XCamVideoBuffer **buf_in, XCamVideoBuffer **buf_out,
+    XCamHandleExecuteDone callback, void *user_data)
+    : _handle (handle)
+    , _callback (callback)
+    , _user_data (user_data)
+{
+    // external buffers are held until callback returns, arrays are kept NULL-terminated
+    for (int i = 0; buf_in[i] != NULL; i++) {
+        if (buf_in[i]->ref)
+            xcam_video_buffer_ref (buf_in[i]);
+        _buf_in.push_back (buf_in[i]);
+    }
+    _buf_in.push_back (NULL);
+
+    for (int i = 0; buf_out[i] != NULL; i++) {
+        if (buf_out[i]->ref)
+            xcam_video_buffer_ref (buf_out[i]);
+        _buf_out.push_back (buf_out[i]);
+    }
+    _buf_out.push_back (NULL);
+}
+
+HandleExecuteDone::~HandleExecuteDone ()
+{
+    for (size_t i = 0; _buf_in[i] != NULL; i++) {
+        if (_buf_in[i]->ref && _buf_in[i]->unref)
+            xcam_video_buffer_unref (_buf_in[i]);
+    }
+    for (size_t i = 0; _buf_out[i] != NULL; i++) {
+        if (_buf_out[i]->ref && _buf_out[i]->unref)
+            xcam_video_buffer_unref (_buf_out[i]);
+    }
+}
+
+void
+HandleExecuteDone::execute_done (ContextBase *context, SmartPtr<VideoBuffer> &buf_out, XCamReturn error)
+{
+    if ((error == XCAM_RETURN_NO_ERROR || error == XCAM_RETURN_BYPASS) && context->need_alloc_out_buf ()) {
+        if (!copy_xcambuf_to_extbuf (_buf_out[0], buf_out)) {
+            XCAM_LOG_ERROR (
+                "xcam_handle(%s) async execute failed, convert output buffer failed", context->get_type_name ());
+            error = XCAM_RETURN_ERROR_MEM;
+        }
+    }
+
+    if (_callback)
+        _callback (_handle, &_buf_in[0], &_buf_out[0], error, _user_data);
+}
+
+XCamReturn
+xcam_handle_execute_async (
+    XCamHandle *handle, XCamVideoBuffer **buf_in, XCamVideoBuffer **buf_out,
+    XCamHandleExecuteDone callback, void *user_data)
+{
+    ContextBase *context = CONTEXT_BASE_CAST (handle);
+    XCAM_FAIL_RETURN (
+        ERROR, context && buf_in && buf_out && buf_out[0], XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_execute_async failed, either of handle/buf_in/buf_out can NOT be NULL");
+
+    XCAM_FAIL_RETURN (
+        ERROR, context->is_handler_valid (), XCAM_RETURN_ERROR_PARAM,
+        "context (%s) failed, handler was not initialized", context->get_type_name ());
+
+    SmartPtr<VideoBuffer> input, output;
+    XCamReturn ret = convert_extbufs (handle, buf_in, buf_out, input, output);
+    if (ret != XCAM_RETURN_NO_ERROR)
+        return ret;
+
+    SmartPtr<ContextAsyncDone> done = new HandleExecuteDone (handle, buf_in, buf_out, callback, user_data);
+    return context->execute_async (input, output, done);
+}
+
+XCamReturn
+xcam_handle_flush (XCamHandle *handle)
+{
+    ContextBase *context = CONTEXT_BASE_CAST (handle);
+    XCAM_FAIL_RETURN (
+        ERROR, context, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_flush failed, handle can NOT be NULL");
+
+    return context->wait_async_done ();
+}
+
+XCamReturn
+xcam_handle_get_metrics (XCamHandle *handle, XCamHandleMetrics *metrics)
+{
+    ContextBase *context = CONTEXT_BASE_CAST (handle);
+    XCAM_FAIL_RETURN (
+        ERROR, context && metrics, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_get_metrics failed, either of handle/metrics can NOT be NULL");
+
+    xcam_mem_clear (*metrics);
+    return context->get_metrics (*metrics);
+}
+
+XCamReturn
+xcam_handle_reset_metrics (XCamHandle *handle)
+{
+    ContextBase *context = CONTEXT_BASE_CAST (handle);
+    XCAM_FAIL_RETURN (
+        ERROR, context, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_reset_metrics failed, handle can NOT be NULL");
+
+    return context->reset_metrics ();
+}
@@ -36,7 +36,7 @@ typedef struct _XCamHandle XCamHandle;
  */
 XCamHandle *xcam_create_handle (const char *name);
 
-/*! \brief    destroy xcam handle
+/*! \brief    destroy xcam handle, not allowed in the completion callback of xcam_handle_execute_async
  *
  * \params[in]    handle        handle need to destory
  */
@@ -67,6 +67,9 @@ XCamReturn xcam_handle_set_parameters (XCamHandle *handle, const char *params);
 XCamReturn xcam_handle_init (XCamHandle *handle);
 
 /*! \brief    xcam handle uninitialize
+ *
+ * Stops the async thread. In the completion callback it fails with XCAM_RETURN_ERROR_ORDER
+ * while other frames are queued; otherwise the thread exits once the callback returns.
  *
  * \params[in]        handle       xcam handle
  * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; others on errors.
@@ -84,6 +87,89 @@ XCamReturn xcam_handle_uinit (XCamHandle *handle);
  */
 XCamReturn xcam_handle_execute (XCamHandle *handle, XCamVideoBuffer **buf_in, XCamVideoBuffer **buf_out);
 
+/*! \brief    completion callback of xcam_handle_execute_async, called in handle's async thread
+ *
+ * \params[in]        handle       xcam handle
+ * \params[in]        buf_in       input buffers of the finished frame, NULL-terminated
+ * \params[in]        buf_out      output buffers of the finished frame, NULL-terminated
+ * \params[in]        ret          XCAM_RETURN_NO_ERROR on sucess; others on errors.
+ * \params[in]        user_data    user data passed to xcam_handle_execute_async
+ */
+typedef void (*XCamHandleExecuteDone) (
+    XCamHandle *handle, XCamVideoBuffer **buf_in, XCamVideoBuffer **buf_out, XCamReturn ret, void *user_data);
+
+/*! \brief    xcam handle process buffer asynchronously
+ *
+ * Buffers are imported without copy (map or dmabuf fd) when handle does not allocate output buffer,
+ * they must match "fmt", "inw"/"inh" and "outw"/"outh"; otherwise input is copied at once and
+ * output is copied before callback. Buffers with ref/unref are referenced until callback returns.
+ * The call blocks while "maxinflight" (default 2) frames are pending.
+ *
+ * \params[in]        handle       xcam handle
+ * \params[in]        buf_in       input buffers, NULL-terminated
+ * \params[in]        buf_out      output buffers, NULL-terminated
+ * \params[in]        callback     called once the frame is finished, can be NULL
+ * \params[in]        user_data    user data passed to callback
+ * \return            XCamReturn   XCAM_RETURN_NO_ERROR on frame queued; others on errors.
+ */
+XCamReturn xcam_handle_execute_async (
+    XCamHandle *handle, XCamVideoBuffer **buf_in, XCamVideoBuffer **buf_out,
+    XCamHandleExecuteDone callback, void *user_data);
+
+/*! \brief    wait until all frames queued by xcam_handle_execute_async are finished
+ *
+ * In the completion callback the frames queued after the current one can not finish
+ * while it waits, the call then fails with XCAM_RETURN_ERROR_ORDER instead of blocking.
+ *
+ * \params[in]        handle       xcam handle
+ * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; others on errors.
+ */
+XCamReturn xcam_handle_flush (XCamHandle *handle);
+
+typedef enum {
+    XCAM_HANDLE_STAGE_GEOMAP = 0,
+    XCAM_HANDLE_STAGE_FEATURE_MATCH,
+    XCAM_HANDLE_STAGE_BLEND,
+    XCAM_HANDLE_STAGE_COPY,
+    XCAM_HANDLE_STAGE_FRAME,
+    XCAM_HANDLE_STAGE_COUNT
+} XCamHandleStage;
+
+/* latency in microseconds, percentiles are upper bounds of power-of-two buckets */
+typedef struct _XCamHandleLatency {
+    uint64_t    count;
+    uint64_t    errors;
+    uint64_t    mean_us;
+    uint64_t    p50_us;
+    uint64_t    p99_us;
+    uint64_t    max_us;
+} XCamHandleLatency;
+
+typedef struct _XCamHandleMetrics {
+    XCamHandleLatency   stages[XCAM_HANDLE_STAGE_COUNT];
+    uint32_t            frames_in_flight;
+    uint64_t            buffers_acquired;
+    /* buffer requests which found the pool empty and their wait time */
+    XCamHandleLatency   buffers_starved;
+} XCamHandleMetrics;
+
+/*! \brief    get counters and per-stage latencies since init or last reset, safe while executing
+ *
+ * Stages which the handle does not run are left zero.
+ *
+ * \params[in]        handle       xcam handle
+ * \params[out]       metrics      metrics of the handle
+ * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; others on errors.
+ */
+XCamReturn xcam_handle_get_metrics (XCamHandle *handle, XCamHandleMetrics *metrics);
+
+/*! \brief    reset counters and latencies of xcam_handle_get_metrics
+ *
+ * \params[in]        handle       xcam handle
+ * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; others on errors.
+ */
+XCamReturn xcam_handle_reset_metrics (XCamHandle *handle);
+
 XCAM_END_DECLARE
 
 #endif //C_XCAM_HANDLE_H
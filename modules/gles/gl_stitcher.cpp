@@ -70,6 +70,13 @@ enum DmaBufferOpt {
     WriteDmaBuffer,
 };
 
+// fisheye lookup tables of a staged calibration, generated off the GL thread
+struct GeoMapTables
+    : Stitcher::CalibrationTables
+{
+    FisheyeDewarp::MapTable       luts[XCAM_STITCH_MAX_CAMERAS];
+};
+
 class StitcherImpl {
     friend class XCam::GLStitcher;
 
@@ -77,6 +84,8 @@ public:
     explicit StitcherImpl (GLStitcher *handler);
 
     XCamReturn init_config (const SmartPtr<GLStitcher::StitcherParam> &param);
+    XCamReturn prepare_tables (Stitcher &staged, SmartPtr<GeoMapTables> &tables);
+    XCamReturn rebuild (const SmartPtr<GeoMapTables> &tables);
     XCamReturn import_dma_buffer (const SmartPtr<GLStitcher::StitcherParam> &param);
     XCamReturn export_dma_buffer (const SmartPtr<GLStitcher::StitcherParam> &param);
     XCamReturn start_geomappers (const SmartPtr<GLStitcher::StitcherParam> &param);
@@ -86,7 +95,8 @@ public:
     XCamReturn stop ();
 
 private:
-    XCamReturn init_geomappers (uint32_t idx);
+    XCamReturn init_geometry (const SmartPtr<GeoMapTables> &tables);
+    XCamReturn init_geomappers (uint32_t idx, const FisheyeDewarp::MapTable *lut);
     XCamReturn init_blender (uint32_t idx);
 
     XCamReturn init_geomapper (
@@ -145,6 +155,7 @@ private:
 
     bool                          _fastmap_activated;
     bool                          _fastmap_blend_activated;
+    bool                          _unused_released;
 
     uint32_t                      _fisheye_img_roi_radius[XCAM_STITCH_MAX_CAMERAS];
 
@@ -157,6 +168,7 @@ StitcherImpl::StitcherImpl (GLStitcher *handler)
     , _dewarp_mode (DewarpSphere)
     , _fastmap_activated (false)
     , _fastmap_blend_activated (false)
+    , _unused_released (false)
     , _stitcher (handler)
 {
     xcam_mem_clear (_fisheye_img_roi_radius);
@@ -199,9 +211,15 @@ StitcherImpl::init_config (const SmartPtr<GLStitcher::StitcherParam> &param)
         _pix_fmt = info.format;
     }
 
+    return init_geometry (NULL);
+}
+
+XCamReturn
+StitcherImpl::init_geometry (const SmartPtr<GeoMapTables> &tables)
+{
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
     for (uint32_t idx = 0; idx < _camera_num; ++idx) {
-        ret = init_geomappers (idx);
+        ret = init_geomappers (idx, tables.ptr () ? &tables->luts[idx] : NULL);
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
             "gl-stitcher init geo mappers failed, idx: %d", idx);
@@ -233,6 +251,45 @@ StitcherImpl::init_config (const SmartPtr<GLStitcher::StitcherParam> &param)
     return XCAM_RETURN_NO_ERROR;
 }
 
+static void
+get_lut_size (const Stitcher::RoundViewSlice &slice, uint32_t &lut_width, uint32_t &lut_height)
+{
+    lut_width = XCAM_ALIGN_UP (slice.width / MAP_FACTOR_X, 4);
+    lut_height = XCAM_ALIGN_UP (slice.height / MAP_FACTOR_Y, 2);
+}
+
+XCamReturn
+StitcherImpl::prepare_tables (Stitcher &staged, SmartPtr<GeoMapTables> &tables)
+{
+    SmartPtr<GeoMapTables> luts = new GeoMapTables;
+    XCAM_ASSERT (luts.ptr ());
+
+    uint32_t lut_width, lut_height;
+    for (uint32_t idx = 0; idx < _camera_num; ++idx) {
+        get_lut_size (staged.get_round_view_slice (idx), lut_width, lut_height);
+        XCamReturn ret = staged.gen_fisheye_table (idx, lut_width, lut_height, luts->luts[idx]);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "gl-stitcher generate staged geomap table failed, idx: %d", idx);
+    }
+
+    tables = luts;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::rebuild (const SmartPtr<GeoMapTables> &tables)
+{
+    // GL objects belong to the stitching thread, rebuilt here with the staged luts
+    stop ();
+    _fastmap_activated = false;
+    _fastmap_blend_activated = false;
+    _unused_released = false;
+    xcam_mem_clear (_fisheye_img_roi_radius);
+
+    return init_geometry (tables);
+}
+
 XCamReturn
 start_geomapper (
     const SmartPtr<GLGeoMapHandler> &geomapper,
@@ -507,7 +564,9 @@ StitcherImpl::start_feature_matches ()
     for (uint32_t idx = 0; idx < _camera_num; ++idx) {
         uint32_t next_idx = (idx + 1) % _camera_num;
 
+        int64_t fm_start = LatencyStats::now_us ();
         XCamReturn ret = start_feature_match (_geomap_buf[idx][FMRight], _geomap_buf[next_idx][FMLeft], idx);
+        _stitcher->record_stage (Stitcher::StageFeatureMatch, fm_start, ret);
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
             "gl-stitcher execute feature match failed, idx: %d", idx);
@@ -562,8 +621,7 @@ StitcherImpl::release_geomapper_rsc (uint32_t cam_id, GeoMapIdx idx)
 XCamReturn
 StitcherImpl::release_unused_rsc ()
 {
-    static bool have_been_released = false;
-    if (have_been_released)
+    if (_unused_released)
         return XCAM_RETURN_NO_ERROR;
 
     for (uint32_t idx = 0; idx < _camera_num; ++idx) {
@@ -583,7 +641,7 @@ StitcherImpl::release_unused_rsc ()
         }
     }
 
-    have_been_released = true;
+    _unused_released = true;
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -649,25 +707,32 @@ StitcherImpl::init_geomapper (
 }
 
 XCamReturn
-StitcherImpl::init_geomappers (uint32_t idx)
+StitcherImpl::init_geomappers (uint32_t idx, const FisheyeDewarp::MapTable *lut)
 {
     if (_dewarp_mode == DewarpSphere)
         _fisheye_info[idx] = _stitch_info.fisheye_info[idx];
 
     const Stitcher::RoundViewSlice &slice = _stitcher->get_round_view_slice (idx);
-    uint32_t lut_width = XCAM_ALIGN_UP (slice.width / MAP_FACTOR_X, 4);
-    uint32_t lut_height = XCAM_ALIGN_UP (slice.height / MAP_FACTOR_Y, 2);
+    uint32_t lut_width, lut_height;
+    get_lut_size (slice, lut_width, lut_height);
 
-    FisheyeDewarp::MapTable map_table (lut_width * lut_height);
-    XCamReturn ret = gen_geomap_table (slice, idx, map_table, lut_width, lut_height);
+    FisheyeDewarp::MapTable map_table;
+    if (!lut) {
+        map_table.resize (lut_width * lut_height);
+        XCamReturn ret = gen_geomap_table (slice, idx, map_table, lut_width, lut_height);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "gl-stitcher generate geomap table failed, idx: %d", idx);
+        lut = &map_table;
+    }
     XCAM_FAIL_RETURN (
-        ERROR, xcam_ret_is_ok (ret), ret,
-        "gl-stitcher generate geomap table failed, idx: %d", idx);
+        ERROR, lut->size () == lut_width * lut_height, XCAM_RETURN_ERROR_PARAM,
+        "gl-stitcher geomap table size mismatch, idx: %d", idx);
 
     _geomapper[idx][Copy0] = create_geomapper (_stitcher->get_scale_mode ());
     _geomapper[idx][Copy0]->enable_allocator (false);
     _geomapper[idx][Copy0]->set_std_output_size (slice.width, slice.height);
-    _geomapper[idx][Copy0]->set_lookup_table (map_table.data (), lut_width, lut_height);
+    _geomapper[idx][Copy0]->set_lookup_table (lut->data (), lut_width, lut_height);
     _geomapper[idx][Copy0]->init_factors ();
 
     const SmartPtr<GLBuffer> &lut_buf = _geomapper[idx][Copy0]->get_lut_buf ();
@@ -993,10 +1058,35 @@ GLStitcher::~GLStitcher ()
 XCamReturn
 GLStitcher::terminate ()
 {
+    stop_calibration ();
     _impl->stop ();
     return GLImageHandler::terminate ();
 }
 
+XCamReturn
+GLStitcher::prepare_calibration (Stitcher &staged, SmartPtr<CalibrationTables> &tables)
+{
+    SmartPtr<GLStitcherPriv::GeoMapTables> luts;
+    XCamReturn ret = _impl->prepare_tables (staged, luts);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "gl-stitcher prepare calibration tables failed");
+
+    tables = luts;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+GLStitcher::commit_calibration (const SmartPtr<CalibrationTables> &tables)
+{
+    SmartPtr<GLStitcherPriv::GeoMapTables> luts = tables.dynamic_cast_ptr<GLStitcherPriv::GeoMapTables> ();
+    XCAM_FAIL_RETURN (
+        ERROR, luts.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "gl-stitcher commit calibration without tables");
+
+    return _impl->rebuild (luts);
+}
+
 XCamReturn
 GLStitcher::stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf)
 {
@@ -1037,6 +1127,7 @@ GLStitcher::stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer
     }
 
     XCamReturn ret = execute_buffer (param, true);
+    record_stage (StageFrame, param->start_time, ret);
 
     if (!out_buf.ptr () && xcam_ret_is_ok (ret)) {
         if (param->out_dmabuf.ptr()) {
@@ -1148,6 +1239,14 @@ GLStitcher::start_work (const SmartPtr<Parameters> &base)
         ERROR, param.ptr () && param->in_bufs[0].ptr (), XCAM_RETURN_ERROR_MEM,
         "gl-stitcher execute failed, invalid parameters");
 
+    // frames are synchronous, nothing is in flight between two start_work
+    if (is_calibration_ready ()) {
+        ret = apply_ready_calibration ();
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "gl_stitcher apply calibration failed");
+    }
+
     if (param->enable_dmabuf) {
         ret = _impl->import_dma_buffer (param);
         XCAM_FAIL_RETURN (
@@ -61,6 +61,8 @@ public:
 
 protected:
     virtual XCamReturn stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf);
+    virtual XCamReturn prepare_calibration (Stitcher &staged, SmartPtr<CalibrationTables> &tables);
+    virtual XCamReturn commit_calibration (const SmartPtr<CalibrationTables> &tables);
 
     virtual XCamReturn configure_resource (const SmartPtr<Parameters> &param);
     virtual XCamReturn start_work (const SmartPtr<Parameters> &param);
@@ -0,0 +1,704 @@
+/*
+ * soft_3a_stats.cpp - CPU 3a statistics calculator
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <unistd.h>
+#include <vector>
+#include <algorithm>
+
+#include <thread_pool.h>
+#include <xcam_mutex.h>
+
+#include "soft_3a_stats.h"
+
+#if ENABLE_AVX512
+#include <immintrin.h>
+#endif
+
+#define SOFT_3A_STATS_MAX_THREADS 8
+#define SOFT_3A_STATS_DEFAULT_GRID 16
+
+namespace XCam {
+
+enum {
+    BayerR = 0,
+    BayerGr,
+    BayerGb,
+    BayerB
+};
+
+class Soft3aStatsSync {
+public:
+    explicit Soft3aStatsSync (uint32_t items)
+        : _remain_items (items)
+    {}
+
+    void dec () {
+        SmartLock locker (_mutex);
+        XCAM_ASSERT (_remain_items > 0);
+        if (--_remain_items == 0)
+            _cond.broadcast ();
+    }
+    void wait () {
+        SmartLock locker (_mutex);
+        while (_remain_items > 0)
+            _cond.wait (_mutex);
+    }
+
+private:
+    XCAM_DEAD_COPY (Soft3aStatsSync);
+
+private:
+    uint32_t    _remain_items;
+    Mutex       _mutex;
+    Cond        _cond;
+};
+
+class Soft3aStatsTask
+    : public ThreadPool::UserData
+{
+public:
+    Soft3aStatsTask (
+        Soft3aStatsCalculator *calculator, const uint8_t *mem, XCam3AStats *stats,
+        uint32_t start, uint32_t end, const SmartPtr<Soft3aStatsSync> &sync)
+        : _calculator (calculator)
+        , _mem (mem)
+        , _stats (stats)
+        , _start (start)
+        , _end (end)
+        , _sync (sync)
+    {}
+
+    virtual XCamReturn run () {
+        _calculator->calculate_rows (_mem, _stats, _start, _end);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    virtual void done (XCamReturn) {
+        _sync->dec ();
+    }
+
+private:
+    Soft3aStatsCalculator       *_calculator;
+    const uint8_t               *_mem;
+    XCam3AStats                 *_stats;
+    uint32_t                     _start;
+    uint32_t                     _end;
+    SmartPtr<Soft3aStatsSync>    _sync;
+};
+
+static bool
+get_bayer_order (uint32_t format, uint32_t *order)
+{
+    // position in 2x2 block: (row << 1) | column
+    switch (format) {
+    case V4L2_PIX_FMT_SBGGR8:
+    case V4L2_PIX_FMT_SBGGR10:
+    case V4L2_PIX_FMT_SBGGR12:
+    case V4L2_PIX_FMT_SBGGR16:
+        order[BayerR] = 3;
+        order[BayerGr] = 2;
+        order[BayerGb] = 1;
+        order[BayerB] = 0;
+        return true;
+    case V4L2_PIX_FMT_SGBRG8:
+    case V4L2_PIX_FMT_SGBRG10:
+    case V4L2_PIX_FMT_SGBRG12:
+        order[BayerR] = 2;
+        order[BayerGr] = 3;
+        order[BayerGb] = 0;
+        order[BayerB] = 1;
+        return true;
+    case V4L2_PIX_FMT_SGRBG8:
+    case V4L2_PIX_FMT_SGRBG10:
+    case V4L2_PIX_FMT_SGRBG12:
+    case XCAM_PIX_FMT_SGRBG16:
+        order[BayerR] = 1;
+        order[BayerGr] = 0;
+        order[BayerGb] = 3;
+        order[BayerB] = 2;
+        return true;
+    case V4L2_PIX_FMT_SRGGB8:
+    case V4L2_PIX_FMT_SRGGB10:
+    case V4L2_PIX_FMT_SRGGB12:
+        order[BayerR] = 0;
+        order[BayerGr] = 1;
+        order[BayerGb] = 2;
+        order[BayerB] = 3;
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+static inline uint32_t
+clamp_pixel (int32_t value)
+{
+    return (uint32_t) XCAM_CLAMP (value, 0, 255);
+}
+
+// BT.601 full range, coefficients in 8-bit fixed point
+static inline void
+yuv_to_rgb (uint32_t y, uint32_t u, uint32_t v, uint32_t &r, uint32_t &g, uint32_t &b)
+{
+    int32_t cu = (int32_t)u - 128;
+    int32_t cv = (int32_t)v - 128;
+
+    r = clamp_pixel ((int32_t)y + ((359 * cv) >> 8));
+    g = clamp_pixel ((int32_t)y - ((88 * cu + 183 * cv) >> 8));
+    b = clamp_pixel ((int32_t)y + ((454 * cu) >> 8));
+}
+
+static void
+fill_nv12_grid (
+    XCamGridStat &grid, uint64_t sum_y, uint64_t sum_u, uint64_t sum_v,
+    uint32_t count, uint32_t valid, uint32_t shift)
+{
+    xcam_mem_clear (grid);
+    if (!count)
+        return;
+
+    uint32_t avg_y = sum_y / (count * 4);
+    uint32_t r, g, b;
+    yuv_to_rgb (avg_y, sum_u / count, sum_v / count, r, g, b);
+
+    grid.avg_y = avg_y >> shift;
+    grid.avg_r = r >> shift;
+    grid.avg_gr = g >> shift;
+    grid.avg_gb = g >> shift;
+    grid.avg_b = b >> shift;
+    grid.valid_wb_count = valid;
+}
+
+// sum is indexed by position in 2x2 block
+static void
+fill_bayer_grid (
+    XCamGridStat &grid, const uint64_t *sum, const uint32_t *order,
+    uint32_t count, uint32_t valid, uint32_t shift, uint32_t max_value)
+{
+    xcam_mem_clear (grid);
+    if (!count)
+        return;
+
+    // 16-bit containers may hold bits above color bits, clamp to bins
+    uint32_t r = XCAM_MIN ((uint32_t)((sum[order[BayerR]] / count) >> shift), max_value);
+    uint32_t gr = XCAM_MIN ((uint32_t)((sum[order[BayerGr]] / count) >> shift), max_value);
+    uint32_t gb = XCAM_MIN ((uint32_t)((sum[order[BayerGb]] / count) >> shift), max_value);
+    uint32_t b = XCAM_MIN ((uint32_t)((sum[order[BayerB]] / count) >> shift), max_value);
+
+    grid.avg_r = r;
+    grid.avg_gr = gr;
+    grid.avg_gb = gb;
+    grid.avg_b = b;
+    grid.avg_y = (r + gr + gb + b) / 4;
+    grid.valid_wb_count = valid;
+}
+
+#if ENABLE_AVX512
+/*
+ * Column sums of a row pair: top and bottom get the pixels of both block rows,
+ * valid counts 2x2 blocks whose pixels are all below saturation.
+ * The C loops finish what is left of rows after 64-pixel vectors.
+ */
+static inline void
+accumulate_blocks_c (
+    const uint8_t *row0, const uint8_t *row1, uint32_t x, uint32_t width,
+    uint32_t *top, uint32_t *bottom, uint32_t *valid)
+{
+    for (; x < width; x += 2) {
+        uint32_t p0 = row0[x], p1 = row0[x + 1];
+        uint32_t p2 = row1[x], p3 = row1[x + 1];
+
+        top[x] += p0;
+        top[x + 1] += p1;
+        bottom[x] += p2;
+        bottom[x + 1] += p3;
+        valid[x / 2] += (XCAM_MAX (XCAM_MAX (p0, p1), XCAM_MAX (p2, p3)) < 255);
+    }
+}
+
+// luma needs no position in block, sum whole 2x2 blocks
+static inline void
+accumulate_luma_c (
+    const uint8_t *row0, const uint8_t *row1, uint32_t x, uint32_t width,
+    uint32_t *luma, uint32_t *valid)
+{
+    for (; x < width; x += 2) {
+        uint32_t p0 = row0[x], p1 = row0[x + 1];
+        uint32_t p2 = row1[x], p3 = row1[x + 1];
+
+        luma[x / 2] += p0 + p1 + p2 + p3;
+        valid[x / 2] += (XCAM_MAX (XCAM_MAX (p0, p1), XCAM_MAX (p2, p3)) < 255);
+    }
+}
+
+static inline void
+accumulate_row_c (const uint8_t *row, uint32_t x, uint32_t width, uint32_t *sum)
+{
+    for (; x < width; ++x)
+        sum[x] += row[x];
+}
+
+static inline void
+accumulate_u8_avx512 (__m512i pixels, uint32_t *sum)
+{
+    _mm512_storeu_si512 (sum, _mm512_add_epi32 (
+                             _mm512_loadu_si512 (sum), _mm512_cvtepu8_epi32 (_mm512_extracti32x4_epi32 (pixels, 0))));
+    _mm512_storeu_si512 (sum + 16, _mm512_add_epi32 (
+                             _mm512_loadu_si512 (sum + 16), _mm512_cvtepu8_epi32 (_mm512_extracti32x4_epi32 (pixels, 1))));
+    _mm512_storeu_si512 (sum + 32, _mm512_add_epi32 (
+                             _mm512_loadu_si512 (sum + 32), _mm512_cvtepu8_epi32 (_mm512_extracti32x4_epi32 (pixels, 2))));
+    _mm512_storeu_si512 (sum + 48, _mm512_add_epi32 (
+                             _mm512_loadu_si512 (sum + 48), _mm512_cvtepu8_epi32 (_mm512_extracti32x4_epi32 (pixels, 3))));
+}
+
+// 32 blocks of two 64-pixel rows, saturated at 255
+static inline void
+count_valid_avx512 (__m512i p0, __m512i p1, uint32_t *valid)
+{
+    const __m512i const_saturation = _mm512_set1_epi16 (255);
+    const __m512i const_low_byte = _mm512_set1_epi16 (0xFF);
+    const __m512i const_one = _mm512_set1_epi32 (1);
+
+    // block maximum lands in the low byte of each 16-bit lane
+    __m512i max = _mm512_max_epu8 (p0, p1);
+    max = _mm512_and_si512 (_mm512_max_epu8 (max, _mm512_srli_epi16 (max, 8)), const_low_byte);
+    __mmask32 blocks = _mm512_cmplt_epu16_mask (max, const_saturation);
+
+    __m512i valid_lo = _mm512_loadu_si512 (valid);
+    __m512i valid_hi = _mm512_loadu_si512 (valid + 16);
+    _mm512_storeu_si512 (valid, _mm512_mask_add_epi32 (valid_lo, (__mmask16) blocks, valid_lo, const_one));
+    _mm512_storeu_si512 (valid + 16, _mm512_mask_add_epi32 (valid_hi, (__mmask16) (blocks >> 16), valid_hi, const_one));
+}
+
+static void
+accumulate_blocks (
+    const uint8_t *row0, const uint8_t *row1, uint32_t width,
+    uint32_t *top, uint32_t *bottom, uint32_t *valid)
+{
+    uint32_t x = 0;
+    for (; x + 64 <= width; x += 64) {
+        __m512i p0 = _mm512_loadu_si512 (row0 + x);
+        __m512i p1 = _mm512_loadu_si512 (row1 + x);
+        accumulate_u8_avx512 (p0, top + x);
+        accumulate_u8_avx512 (p1, bottom + x);
+        count_valid_avx512 (p0, p1, valid + x / 2);
+    }
+    accumulate_blocks_c (row0, row1, x, width, top, bottom, valid);
+}
+
+static void
+accumulate_luma (const uint8_t *row0, const uint8_t *row1, uint32_t width, uint32_t *luma, uint32_t *valid)
+{
+    const __m512i const_one = _mm512_set1_epi8 (1);
+
+    uint32_t x = 0;
+    for (; x + 64 <= width; x += 64) {
+        __m512i p0 = _mm512_loadu_si512 (row0 + x);
+        __m512i p1 = _mm512_loadu_si512 (row1 + x);
+
+        // horizontal pairs of both rows, 16-bit sums of 32 blocks
+        __m512i blocks = _mm512_add_epi16 (_mm512_maddubs_epi16 (p0, const_one), _mm512_maddubs_epi16 (p1, const_one));
+        uint32_t *luma_ptr = luma + x / 2;
+        _mm512_storeu_si512 (luma_ptr, _mm512_add_epi32 (
+                                 _mm512_loadu_si512 (luma_ptr), _mm512_cvtepu16_epi32 (_mm512_extracti64x4_epi64 (blocks, 0))));
+        _mm512_storeu_si512 (luma_ptr + 16, _mm512_add_epi32 (
+                                 _mm512_loadu_si512 (luma_ptr + 16), _mm512_cvtepu16_epi32 (_mm512_extracti64x4_epi64 (blocks, 1))));
+        count_valid_avx512 (p0, p1, valid + x / 2);
+    }
+    accumulate_luma_c (row0, row1, x, width, luma, valid);
+}
+
+static void
+accumulate_row (const uint8_t *row, uint32_t width, uint32_t *sum)
+{
+    uint32_t x = 0;
+    for (; x + 64 <= width; x += 64)
+        accumulate_u8_avx512 (_mm512_loadu_si512 (row + x), sum + x);
+    accumulate_row_c (row, x, width, sum);
+}
+#endif
+
+Soft3aStatsCalculator::Soft3aStatsCalculator (uint32_t thread_num)
+    : _thread_num (thread_num)
+    , _grid_size (SOFT_3A_STATS_DEFAULT_GRID)
+    , _subsample (1)
+    , _bit_depth (8)
+    , _value_shift (0)
+{
+    if (_thread_num == 0) {
+        long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+        _thread_num = XCAM_CLAMP (cpus, 1, SOFT_3A_STATS_MAX_THREADS);
+    }
+    xcam_mem_clear (_bayer_order);
+}
+
+Soft3aStatsCalculator::~Soft3aStatsCalculator ()
+{
+    stop ();
+}
+
+bool
+Soft3aStatsCalculator::set_grid_size (uint32_t size)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, size >= 2 && (size % 2) == 0, false,
+        "Soft3aStatsCalculator grid size(%d) must be even", size);
+
+    _grid_size = size;
+    return true;
+}
+
+bool
+Soft3aStatsCalculator::set_subsample (uint32_t step)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, step > 0, false,
+        "Soft3aStatsCalculator subsample step must be positive");
+
+    _subsample = step;
+    return true;
+}
+
+bool
+Soft3aStatsCalculator::set_bit_depth (uint32_t bits)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, bits >= 8 && bits <= 16, false,
+        "Soft3aStatsCalculator unsupported bit depth(%d)", bits);
+
+    _bit_depth = bits;
+    return true;
+}
+
+XCamReturn
+Soft3aStatsCalculator::prepare (const VideoBufferInfo &info, uint32_t stats_count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, info.format == V4L2_PIX_FMT_NV12 || get_bayer_order (info.format, _bayer_order),
+        XCAM_RETURN_ERROR_PARAM,
+        "Soft3aStatsCalculator unsupported format(%s)", xcam_fourcc_to_string (info.format));
+    XCAM_FAIL_RETURN (
+        ERROR, _bit_depth <= info.color_bits, XCAM_RETURN_ERROR_PARAM,
+        "Soft3aStatsCalculator bit depth(%d) is larger than input color bits(%d)",
+        _bit_depth, info.color_bits);
+    XCAM_FAIL_RETURN (
+        ERROR, info.width >= _grid_size && info.height >= _grid_size, XCAM_RETURN_ERROR_PARAM,
+        "Soft3aStatsCalculator frame(%dx%d) is smaller than grid(%d)",
+        info.width, info.height, _grid_size);
+
+    _info = info;
+    _value_shift = info.color_bits - _bit_depth;
+
+    SmartPtr<X3aStatsPool> pool = new X3aStatsPool ();
+    XCAM_ASSERT (pool.ptr ());
+    pool->set_bit_depth (_bit_depth);
+    pool->set_grid_pixel_size (_grid_size);
+    pool->set_video_info (info);
+    XCAM_FAIL_RETURN (
+        ERROR, pool->reserve (stats_count), XCAM_RETURN_ERROR_MEM,
+        "Soft3aStatsCalculator reserve stats buffers failed");
+    _stats_pool = pool;
+
+    XCAM_LOG_DEBUG (
+        "Soft3aStatsCalculator prepared %s %dx%d, grid:%d subsample:%d bits:%d",
+        xcam_fourcc_to_string (info.format), info.width, info.height,
+        _grid_size, _subsample, _bit_depth);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+Soft3aStatsCalculator::stop ()
+{
+    if (_stats_pool.ptr ())
+        _stats_pool->stop ();
+
+    if (_threads.ptr ()) {
+        _threads->stop ();
+        _threads.release ();
+    }
+}
+
+XCamReturn
+Soft3aStatsCalculator::calculate (const SmartPtr<VideoBuffer> &buf, SmartPtr<X3aStats> &stats)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _stats_pool.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "Soft3aStatsCalculator calculate failed, prepare it first");
+    XCAM_ASSERT (buf.ptr ());
+
+    const VideoBufferInfo &info = buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        info.format == _info.format && info.width == _info.width && info.height == _info.height,
+        XCAM_RETURN_ERROR_PARAM,
+        "Soft3aStatsCalculator buffer(%dx%d) doesn't match prepared info(%dx%d)",
+        info.width, info.height, _info.width, _info.height);
+    _info = info;
+
+    SmartPtr<VideoBuffer> stats_buf = _stats_pool->get_buffer (_stats_pool);
+    XCAM_FAIL_RETURN (WARNING, stats_buf.ptr (), XCAM_RETURN_ERROR_MEM, "3a stats pool stopped.");
+    SmartPtr<X3aStats> out_stats = stats_buf.dynamic_cast_ptr<X3aStats> ();
+    XCAM_ASSERT (out_stats.ptr ());
+    XCam3AStats *stats_ptr = out_stats->get_stats ();
+
+    const uint8_t *mem = buf->map ();
+    XCAM_FAIL_RETURN (ERROR, mem, XCAM_RETURN_ERROR_MEM, "Soft3aStatsCalculator map buffer failed");
+
+    const uint32_t rows = stats_ptr->info.aligned_height;
+    uint32_t bands = XCAM_MIN (_thread_num, rows);
+    if (bands <= 1) {
+        calculate_rows (mem, stats_ptr, 0, rows);
+    } else {
+        if (!_threads.ptr ()) {
+            _threads = new ThreadPool ("soft-3a-stats");
+            _threads->set_threads (bands, bands);
+            XCamReturn ret = _threads->start ();
+            if (!xcam_ret_is_ok (ret)) {
+                _threads.release ();
+                buf->unmap ();
+                XCAM_LOG_ERROR ("Soft3aStatsCalculator start threads failed");
+                return ret;
+            }
+        }
+
+        SmartPtr<Soft3aStatsSync> sync = new Soft3aStatsSync (bands);
+        uint32_t rows_per_band = xcam_ceil (rows, bands) / bands;
+        uint32_t start = 0;
+        for (uint32_t i = 0; i < bands; ++i) {
+            uint32_t end = XCAM_MIN (start + rows_per_band, rows);
+            SmartPtr<Soft3aStatsTask> task = new Soft3aStatsTask (
+                this, mem, stats_ptr, start, end, sync);
+            if (start >= end || !xcam_ret_is_ok (_threads->queue (task))) {
+                sync->dec ();
+            }
+            start = end;
+        }
+        sync->wait ();
+    }
+    buf->unmap ();
+
+    fill_histogram (stats_ptr);
+
+    out_stats->set_timestamp (buf->get_timestamp ());
+    stats = out_stats;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+Soft3aStatsCalculator::calculate_rows (const uint8_t *mem, XCam3AStats *stats, uint32_t start, uint32_t end)
+{
+    const uint32_t grid_cols = stats->info.aligned_width;
+
+#if ENABLE_AVX512
+    if (_subsample == 1 && _info.color_bits == 8) {
+        sum_rows_by_columns (mem, stats, start, end);
+        return;
+    }
+#endif
+
+    for (uint32_t grid_y = start; grid_y < end; ++grid_y) {
+        for (uint32_t grid_x = 0; grid_x < grid_cols; ++grid_x) {
+            XCamGridStat &grid = stats->stats[grid_y * grid_cols + grid_x];
+            if (_info.format == V4L2_PIX_FMT_NV12)
+                calculate_nv12_grid (mem, grid, grid_x, grid_y);
+            else if (_info.color_bits == 8)
+                calculate_bayer_grid<uint8_t> (mem, grid, grid_x, grid_y);
+            else
+                calculate_bayer_grid<uint16_t> (mem, grid, grid_x, grid_y);
+        }
+    }
+}
+
+#if ENABLE_AVX512
+void
+Soft3aStatsCalculator::sum_rows_by_columns (const uint8_t *mem, XCam3AStats *stats, uint32_t start, uint32_t end)
+{
+    const uint32_t grid_cols = stats->info.aligned_width;
+    const bool is_nv12 = (_info.format == V4L2_PIX_FMT_NV12);
+    const uint32_t width = XCAM_ALIGN_DOWN (_info.width, 2);
+    const uint32_t height = XCAM_ALIGN_DOWN (_info.height, 2);
+    const uint32_t max_value = (1 << _bit_depth) - 1;
+
+    // nv12 keeps 2x2 luma sums in top and chroma per column
+    std::vector<uint32_t> sums (width * 3 + width / 2);
+    uint32_t *top = sums.data ();
+    uint32_t *bottom = top + width;
+    uint32_t *chroma = bottom + width;
+    uint32_t *valid = chroma + width;
+
+    for (uint32_t grid_y = start; grid_y < end; ++grid_y) {
+        const uint32_t y0 = grid_y * _grid_size;
+        const uint32_t y1 = XCAM_MIN (y0 + _grid_size, height);
+
+        std::fill (sums.begin (), sums.end (), 0);
+        for (uint32_t y = y0; y < y1; y += 2) {
+            const uint8_t *row0 = mem + _info.offsets[0] + y * _info.strides[0];
+            const uint8_t *row1 = row0 + _info.strides[0];
+
+            if (is_nv12) {
+                accumulate_luma (row0, row1, width, top, valid);
+                accumulate_row (mem + _info.offsets[1] + (y / 2) * _info.strides[1], width, chroma);
+            } else {
+                accumulate_blocks (row0, row1, width, top, bottom, valid);
+            }
+        }
+
+        const uint32_t block_rows = (y1 > y0) ? (y1 - y0) / 2 : 0;
+        for (uint32_t grid_x = 0; grid_x < grid_cols; ++grid_x) {
+            const uint32_t x0 = grid_x * _grid_size;
+            const uint32_t x1 = XCAM_MIN (x0 + _grid_size, width);
+
+            uint64_t sum[4] = {0, 0, 0, 0};
+            uint64_t sum_u = 0, sum_v = 0;
+            uint32_t valid_num = 0;
+            for (uint32_t x = x0; x < x1 && is_nv12; x += 2) {
+                sum[0] += top[x / 2];
+                sum_u += chroma[x];
+                sum_v += chroma[x + 1];
+                valid_num += valid[x / 2];
+            }
+            for (uint32_t x = x0; x < x1 && !is_nv12; x += 2) {
+                sum[0] += top[x];
+                sum[1] += top[x + 1];
+                sum[2] += bottom[x];
+                sum[3] += bottom[x + 1];
+                valid_num += valid[x / 2];
+            }
+
+            const uint32_t count = (x1 > x0) ? (x1 - x0) / 2 * block_rows : 0;
+            XCamGridStat &grid = stats->stats[grid_y * grid_cols + grid_x];
+            if (is_nv12)
+                fill_nv12_grid (grid, sum[0], sum_u, sum_v, count, valid_num, _value_shift);
+            else
+                fill_bayer_grid (grid, sum, _bayer_order, count, valid_num, _value_shift, max_value);
+        }
+    }
+}
+#endif
+
+uint32_t
+Soft3aStatsCalculator::get_saturation () const
+{
+    // largest input value, bit depth is kept in the high bits of color bits
+    const uint32_t max_value = (1 << _bit_depth) - 1;
+    return ((max_value + 1) << _value_shift) - 1;
+}
+
+void
+Soft3aStatsCalculator::fill_histogram (XCam3AStats *stats)
+{
+    const XCam3AStatsInfo &stats_info = stats->info;
+    XCamHistogram *hist_rgb = stats->hist_rgb;
+    uint32_t *hist_y = stats->hist_y;
+
+    memset (hist_rgb, 0, sizeof (XCamHistogram) * stats_info.histogram_bins);
+    memset (hist_y, 0, sizeof (uint32_t) * stats_info.histogram_bins);
+    for (uint32_t j = 0; j < stats_info.height; j++) {
+        for (uint32_t i = 0; i < stats_info.width; i++) {
+            const XCamGridStat &grid = stats->stats[j * stats_info.aligned_width + i];
+            hist_rgb[grid.avg_r].r++;
+            hist_rgb[grid.avg_gr].gr++;
+            hist_rgb[grid.avg_gb].gb++;
+            hist_rgb[grid.avg_b].b++;
+            hist_y[grid.avg_y]++;
+        }
+    }
+}
+
+void
+Soft3aStatsCalculator::calculate_nv12_grid (const uint8_t *mem, XCamGridStat &grid, uint32_t grid_x, uint32_t grid_y)
+{
+    const uint32_t x0 = grid_x * _grid_size;
+    const uint32_t y0 = grid_y * _grid_size;
+    const uint32_t x1 = XCAM_MIN (x0 + _grid_size, XCAM_ALIGN_DOWN (_info.width, 2));
+    const uint32_t y1 = XCAM_MIN (y0 + _grid_size, XCAM_ALIGN_DOWN (_info.height, 2));
+    const uint32_t step = _subsample * 2;
+    const uint32_t shift = _value_shift;
+    const uint32_t y_stride = _info.strides[0];
+    const uint32_t uv_stride = _info.strides[1];
+
+    uint64_t sum_y = 0, sum_u = 0, sum_v = 0;
+    uint32_t count = 0, valid = 0;
+
+    for (uint32_t y = y0; y < y1; y += step) {
+        const uint8_t *row0 = mem + _info.offsets[0] + y * y_stride;
+        const uint8_t *row1 = row0 + y_stride;
+        const uint8_t *uv = mem + _info.offsets[1] + (y / 2) * uv_stride;
+
+        for (uint32_t x = x0; x < x1; x += step) {
+            uint32_t y00 = row0[x], y01 = row0[x + 1];
+            uint32_t y10 = row1[x], y11 = row1[x + 1];
+
+            sum_y += y00 + y01 + y10 + y11;
+            sum_u += uv[x];
+            sum_v += uv[x + 1];
+            ++count;
+
+            if (XCAM_MAX (XCAM_MAX (y00, y01), XCAM_MAX (y10, y11)) < 255)
+                ++valid;
+        }
+    }
+
+    fill_nv12_grid (grid, sum_y, sum_u, sum_v, count, valid, shift);
+}
+
+template <typename T>
+void
+Soft3aStatsCalculator::calculate_bayer_grid (const uint8_t *mem, XCamGridStat &grid, uint32_t grid_x, uint32_t grid_y)
+{
+    const uint32_t x0 = grid_x * _grid_size;
+    const uint32_t y0 = grid_y * _grid_size;
+    const uint32_t x1 = XCAM_MIN (x0 + _grid_size, XCAM_ALIGN_DOWN (_info.width, 2));
+    const uint32_t y1 = XCAM_MIN (y0 + _grid_size, XCAM_ALIGN_DOWN (_info.height, 2));
+    const uint32_t step = _subsample * 2;
+    const uint32_t shift = _value_shift;
+    const uint32_t max_value = (1 << _bit_depth) - 1;
+    const uint32_t saturation = get_saturation ();
+    const uint32_t stride = _info.strides[0];
+
+    // sums by position in 2x2 block, mapped to channels once per grid
+    uint64_t sum[4] = {0, 0, 0, 0};
+    uint32_t count = 0, valid = 0;
+
+    for (uint32_t y = y0; y < y1; y += step) {
+        const T *row0 = (const T *)(mem + _info.offsets[0] + y * stride);
+        const T *row1 = (const T *)(mem + _info.offsets[0] + (y + 1) * stride);
+
+        for (uint32_t x = x0; x < x1; x += step) {
+            uint32_t p0 = row0[x], p1 = row0[x + 1];
+            uint32_t p2 = row1[x], p3 = row1[x + 1];
+
+            sum[0] += p0;
+            sum[1] += p1;
+            sum[2] += p2;
+            sum[3] += p3;
+            ++count;
+
+            if (XCAM_MAX (XCAM_MAX (p0, p1), XCAM_MAX (p2, p3)) < saturation)
+                ++valid;
+        }
+    }
+
+    fill_bayer_grid (grid, sum, _bayer_order, count, valid, shift, max_value);
+}
+
+}
@@ -0,0 +1,89 @@
+/*
+ * soft_3a_stats.h - CPU 3a statistics calculator
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SOFT_3A_STATS_H
+#define XCAM_SOFT_3A_STATS_H
+
+#include <xcam_std.h>
+#include <video_buffer.h>
+#include <x3a_stats_pool.h>
+
+namespace XCam {
+
+class ThreadPool;
+class Soft3aStatsTask;
+
+/*
+ * Fills XCam3AStats grids from NV12 or Bayer(8/10/12/16 bits) frames on CPU,
+ * for 3a analyzers without ISP or OpenCL stats. Histograms are built from
+ * grid averages as CL3AStatsCalculatorContext does.
+ * Grid rows are split into bands which run on a thread pool, subsample
+ * skips 2x2 blocks inside grids to trade accuracy for speed.
+ * With AVX512 and no subsample, bands of 8-bit input sum whole rows per
+ * column and grids are cut from the column sums.
+ */
+class Soft3aStatsCalculator
+{
+    friend class Soft3aStatsTask;
+
+public:
+    explicit Soft3aStatsCalculator (uint32_t thread_num = 0);
+    ~Soft3aStatsCalculator ();
+
+    // grid in pixels, even number
+    bool set_grid_size (uint32_t size);
+    // sample every step-th 2x2 block in both directions
+    bool set_subsample (uint32_t step);
+    // precision of averages and histogram bins, not above input color bits
+    bool set_bit_depth (uint32_t bits);
+
+    XCamReturn prepare (const VideoBufferInfo &info, uint32_t stats_count = 6);
+    XCamReturn calculate (const SmartPtr<VideoBuffer> &buf, SmartPtr<X3aStats> &stats);
+    void stop ();
+
+private:
+    void calculate_rows (const uint8_t *mem, XCam3AStats *stats, uint32_t start, uint32_t end);
+    void sum_rows_by_columns (const uint8_t *mem, XCam3AStats *stats, uint32_t start, uint32_t end);
+    void calculate_nv12_grid (const uint8_t *mem, XCamGridStat &grid, uint32_t grid_x, uint32_t grid_y);
+    template <typename T>
+    void calculate_bayer_grid (const uint8_t *mem, XCamGridStat &grid, uint32_t grid_x, uint32_t grid_y);
+    void fill_histogram (XCam3AStats *stats);
+    uint32_t get_saturation () const;
+
+    XCAM_DEAD_COPY (Soft3aStatsCalculator);
+
+private:
+    uint32_t                            _thread_num;
+    uint32_t                            _grid_size;
+    uint32_t                            _subsample;
+    uint32_t                            _bit_depth;
+
+    VideoBufferInfo                     _info;
+    uint32_t                            _value_shift;
+    // offsets of r, gr, gb, b in a 2x2 bayer block, as (row << 1 | column)
+    uint32_t                            _bayer_order[4];
+
+    SmartPtr<X3aStatsPool>              _stats_pool;
+    SmartPtr<ThreadPool>                _threads;
+};
+
+}
+
+#endif //XCAM_SOFT_3A_STATS_H
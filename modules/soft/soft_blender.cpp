@@ -49,6 +49,7 @@ namespace SoftBlenderPriv {
 
 struct PyramidResource {
     SmartPtr<BufferPool>       overlap_pool;
+    SmartPtr<BufferPool>       lap_pool;
     SmartPtr<GaussDownScale>   scale_task[SoftBlender::BufIdxCount];
     SmartPtr<LaplaceTask>      lap_task[SoftBlender::BufIdxCount];
     SmartPtr<ReconstructTask>  recon_task;
@@ -67,13 +68,18 @@ blend[N] = blend (Ga[N)], Gb[N)])
  Level0: output = reconstruct (reconst[1], LapA[0], LapB[0])
 
  LevelN: Pool[N].size = G[N].size
+ Lap[N] holds 16-bit fixed point, LapPool[N] buffers are twice as wide as G[N-1]
+
+ The 8-bit lap kept (in - upsample) / 2 and lost its lowest bit on every level, the loss adds up
+ through reconstruction, so output differs from the 8-bit path by up to 3 levels at 4 pyramid
+ levels. The price is memory: lap no longer borrows the overlap pools, LAP_POOL_SIZE double width
+ NV12 buffers per level cost about 16 * width * height bytes for a width x height merge window.
  */
 class BlenderPrivConfig {
 public:
     PyramidResource        pyr_layer[XCAM_SOFT_PYRAMID_MAX_LEVEL];
     uint32_t               pyr_levels;
     SmartPtr<BlendTask>    last_level_blend;
-    SmartPtr<BufferPool>   first_lap_pool;
     SmartPtr<UcharImage>   orig_mask;
 
     Mutex                  map_args_mutex;
@@ -243,6 +249,9 @@ SoftBlenderPriv::BlenderPrivConfig::stop ()
         if (pyr_layer[i].overlap_pool.ptr ()) {
             pyr_layer[i].overlap_pool->stop ();
         }
+        if (pyr_layer[i].lap_pool.ptr ()) {
+            pyr_layer[i].lap_pool->stop ();
+        }
     }
 
     if (last_level_blend.ptr ()) {
@@ -420,14 +429,8 @@ SoftBlenderPriv::BlenderPrivConfig::start_lap_task (
     SmartPtr<VideoBuffer> gauss = scale_args->out_buf;
     const VideoBufferInfo &buf_info = gauss->get_video_info ();
 
-    SmartPtr<VideoBuffer> out_buf;
-    if (level == 0) {
-        XCAM_ASSERT (first_lap_pool.ptr ());
-        out_buf = first_lap_pool->get_buffer ();
-    } else {
-        XCAM_ASSERT (pyr_layer[level - 1].overlap_pool.ptr ());
-        out_buf = pyr_layer[level - 1].overlap_pool->get_buffer ();
-    }
+    XCAM_ASSERT (pyr_layer[level].lap_pool.ptr ());
+    SmartPtr<VideoBuffer> out_buf = pyr_layer[level].lap_pool->get_buffer ();
 
     XCAM_FAIL_RETURN (
         ERROR, out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
@@ -441,16 +444,16 @@ SoftBlenderPriv::BlenderPrivConfig::start_lap_task (
     args->orig_v = scale_args->in_v;
 
     args->gauss_luma = new UcharImage (gauss, 0);
-    args->out_luma = new UcharImage (out_buf, 0);
+    args->out_luma = new ShortImage (out_buf, 0);
 
     if (V4L2_PIX_FMT_NV12 == buf_info.format) {
         args->gauss_uv = new Uchar2Image (gauss, 1);
-        args->out_uv = new Uchar2Image (out_buf, 1);
+        args->out_uv = new Short2Image (out_buf, 1);
     } else if (V4L2_PIX_FMT_YUV420 == buf_info.format) {
         args->gauss_u = new UcharImage (gauss, 1);
         args->gauss_v = new UcharImage (gauss, 2);
-        args->out_u = new UcharImage (out_buf, 1);
-        args->out_v = new UcharImage (out_buf, 2);
+        args->out_u = new ShortImage (out_buf, 1);
+        args->out_v = new ShortImage (out_buf, 2);
     } else {
         XCAM_LOG_ERROR ("laplace_task inupt gauss buffer pixel format:%d unsupported!", buf_info.format);
     }
@@ -789,14 +792,14 @@ SoftBlenderPriv::BlenderPrivConfig::start_reconstruct_task_by_lap (
         } else {
             args = (*i).second;
         }
-        args->lap_luma[idx] = new UcharImage (lap, 0);
+        args->lap_luma[idx] = new ShortImage (lap, 0);
 
         const VideoBufferInfo &buf_info = lap->get_video_info ();
         if (V4L2_PIX_FMT_NV12 == buf_info.format) {
-            args->lap_uv[idx] = new Uchar2Image (lap, 1);
+            args->lap_uv[idx] = new Short2Image (lap, 1);
         } else if (V4L2_PIX_FMT_YUV420 == buf_info.format) {
-            args->lap_u[idx] = new UcharImage (lap, 1);
-            args->lap_v[idx] = new UcharImage (lap, 2);
+            args->lap_u[idx] = new ShortImage (lap, 1);
+            args->lap_v[idx] = new ShortImage (lap, 2);
         } else {
             XCAM_LOG_ERROR ("reconstruct_task_by_lap input buffer pixel format:%d unsupported!", buf_info.format);
         }
@@ -888,15 +891,6 @@ SoftBlender::configure_resource (const SmartPtr<Parameters> &param)
     //overlap_info.init (in0_info.format, merge_size.width, merge_size.height);
     XCAM_ASSERT (merge_size.width % SOFT_BLENDER_ALIGNMENT_X == 0);
 
-    overlap_info.init (in0_info.format, merge_size.width, merge_size.height);
-    SmartPtr<BufferPool> first_lap_pool = new SoftVideoBufAllocator (overlap_info);
-    XCAM_ASSERT (first_lap_pool.ptr ());
-    _priv_config->first_lap_pool = first_lap_pool;
-    XCAM_FAIL_RETURN (
-        ERROR, _priv_config->first_lap_pool->reserve (LAP_POOL_SIZE), XCAM_RETURN_ERROR_MEM,
-        "blender:%s reserve lap buffer pool(w:%d,h:%d) failed",
-        XCAM_STR(get_name ()), overlap_info.width, overlap_info.height);
-
     SmartPtr<Worker::Callback> gauss_scale_cb = new CbGaussDownScale (this);
     SmartPtr<Worker::Callback> lap_cb = new CbLapTask (this);
     SmartPtr<Worker::Callback> reconst_cb = new CbReconstructTask (this);
@@ -908,6 +902,17 @@ SoftBlender::configure_resource (const SmartPtr<Parameters> &param)
         "blender:%s init masks failed", XCAM_STR (get_name ()));
 
     for (uint32_t i = 0; i < _priv_config->pyr_levels; ++i) {
+        // each 16-bit laplace sample takes two bytes of a double width buffer
+        VideoBufferInfo lap_info;
+        lap_info.init (in0_info.format, merge_size.width * 2, merge_size.height);
+        SmartPtr<BufferPool> lap_pool = new SoftVideoBufAllocator (lap_info);
+        XCAM_ASSERT (lap_pool.ptr ());
+        _priv_config->pyr_layer[i].lap_pool = lap_pool;
+        XCAM_FAIL_RETURN (
+            ERROR, _priv_config->pyr_layer[i].lap_pool->reserve (LAP_POOL_SIZE), XCAM_RETURN_ERROR_MEM,
+            "blender:%s reserve lap buffer pool(w:%d,h:%d) failed",
+            XCAM_STR(get_name ()), lap_info.width, lap_info.height);
+
         merge_size.width = XCAM_ALIGN_UP ((merge_size.width + 1) / 2, SOFT_BLENDER_ALIGNMENT_X);
         merge_size.height = XCAM_ALIGN_UP ((merge_size.height + 1) / 2, SOFT_BLENDER_ALIGNMENT_Y);
         overlap_info.init (in0_info.format, merge_size.width, merge_size.height);
@@ -206,9 +206,10 @@ normalize_8 (float *value, const float max)
     value[7] /= max;
 }
 
+template <typename ImageT>
 static inline void
 read_and_blend_pixel_luma_8 (
-    const UcharImage *in0, const UcharImage *in1,
+    const ImageT *in0, const ImageT *in1,
     const UcharImage *mask,
     const uint32_t in_x, const uint32_t in_y,
     float *out_luma,
@@ -216,22 +217,23 @@ read_and_blend_pixel_luma_8 (
 {
     float luma0_line[8], luma1_line[8];
     mask->read_array_no_check<float, 8> (in_x, in_y, out_mask);
-    in0->read_array_no_check<float, 8> (in_x, in_y, luma0_line);
-    in1->read_array_no_check<float, 8> (in_x, in_y, luma1_line);
+    in0->template read_array_no_check<float, 8> (in_x, in_y, luma0_line);
+    in1->template read_array_no_check<float, 8> (in_x, in_y, luma1_line);
     normalize_8 (out_mask, 255.0f);
     blend_luma_8 (luma0_line, luma1_line, out_mask, out_luma);
 }
 
+template <typename ImageT>
 static inline void
 read_and_blend_uv_4 (
-    const Uchar2Image *in_a, const Uchar2Image *in_b,
+    const ImageT *in_a, const ImageT *in_b,
     const float *mask,
     const uint32_t in_x, const uint32_t in_y,
     Float2 *out_uv)
 {
     Float2 line_a[4], line_b[4];
-    in_a->read_array_no_check<Float2, 4> (in_x, in_y, line_a);
-    in_b->read_array_no_check<Float2, 4> (in_x, in_y, line_b);
+    in_a->template read_array_no_check<Float2, 4> (in_x, in_y, line_a);
+    in_b->template read_array_no_check<Float2, 4> (in_x, in_y, line_b);
 
     //out_uv[0] = line_a[0] * mask + line_b[0] * ( 1.0f - mask[0]);
 #define BLEND_UV_4(i) out_uv[i] = (line_a[i] - line_b[i]) * mask[i] + line_b[i]
@@ -241,16 +243,17 @@ read_and_blend_uv_4 (
     BLEND_UV_4 (3);
 }
 
+template <typename ImageT>
 static inline void
 read_and_blend_chroma_4 (
-    const UcharImage *in_a, const UcharImage *in_b,
+    const ImageT *in_a, const ImageT *in_b,
     const float *mask,
     const uint32_t in_x, const uint32_t in_y,
     float *out_chroma)
 {
     float line_a[4], line_b[4];
-    in_a->read_array_no_check<float, 4> (in_x, in_y, line_a);
-    in_b->read_array_no_check<float, 4> (in_x, in_y, line_b);
+    in_a->template read_array_no_check<float, 4> (in_x, in_y, line_a);
+    in_b->template read_array_no_check<float, 4> (in_x, in_y, line_b);
 
     //out_chroma[0] = line_a[0] * mask + line_b[0] * ( 1.0f - mask[0]);
 #define BLEND_CHROMA_4(i) out_chroma[i] = (line_a[i] - line_b[i]) * mask[i] + line_b[i]
@@ -350,9 +353,9 @@ BlendTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 }
 
 static inline void
-minus_array_8 (float *orig, float *gauss, Uchar *ret)
+minus_array_8 (float *orig, float *gauss, Short *ret)
 {
-#define ORG_MINUS_GAUSS(i) ret[i] = convert_to_uchar<float> ((orig[i] - gauss[i]) * 0.5f + 128.0f)
+#define ORG_MINUS_GAUSS(i) ret[i] = convert_to_short<float> ((orig[i] - gauss[i]) * SOFT_LAP_SCALE)
     ORG_MINUS_GAUSS(0);
     ORG_MINUS_GAUSS(1);
     ORG_MINUS_GAUSS(2);
@@ -396,14 +399,14 @@ interpolate_luma_half_row_8x1 (UcharImage* image, uint32_t fixed_x, uint32_t nex
 
 void
 LaplaceTask::interplate_luma_8x2 (
-    UcharImage *orig_luma, UcharImage *gauss_luma, UcharImage *out_luma,
+    UcharImage *orig_luma, UcharImage *gauss_luma, ShortImage *out_luma,
     uint32_t out_x, uint32_t out_y)
 {
     uint32_t gauss_x = out_x / 2, first_gauss_y = out_y / 2;
     float inter_value[8];
     float gauss_v[5];
     float orig_v[8];
-    Uchar lap_ret[8];
+    Short lap_ret[8];
     //interplate instaed of coefficient
     interpolate_luma_int_row_8x1 (gauss_luma, gauss_x, first_gauss_y, gauss_v, inter_value);
     orig_luma->read_array_no_check<float, 8> (out_x, out_y, orig_v);
@@ -418,25 +421,24 @@ LaplaceTask::interplate_luma_8x2 (
 }
 
 static inline void
-minus_array_uv_4 (Float2 *orig, Float2 *gauss, Uchar2 *ret)
+minus_array_uv_4 (Float2 *orig, Float2 *gauss, Short2 *ret)
 {
-#define ORG_MINUS_GAUSS_UV(i) orig[i] -= gauss[i]; orig[i] *= 0.5f; orig[i] += 128.0f
+#define ORG_MINUS_GAUSS_UV(i) orig[i] -= gauss[i]; orig[i] *= SOFT_LAP_SCALE
     ORG_MINUS_GAUSS_UV(0);
     ORG_MINUS_GAUSS_UV(1);
     ORG_MINUS_GAUSS_UV(2);
     ORG_MINUS_GAUSS_UV(3);
-    convert_to_uchar2_N<Float2, 4> (orig, ret);
+    convert_to_short2_N<Float2, 4> (orig, ret);
 }
 
 static inline void
-minus_array_chroma_4 (float *orig, float *gauss, Uchar *ret)
+minus_array_chroma_4 (float *orig, float *gauss, Short *ret)
 {
-#define ORG_MINUS_GAUSS_UV(i) orig[i] -= gauss[i]; orig[i] *= 0.5f; orig[i] += 128.0f
     ORG_MINUS_GAUSS_UV(0);
     ORG_MINUS_GAUSS_UV(1);
     ORG_MINUS_GAUSS_UV(2);
     ORG_MINUS_GAUSS_UV(3);
-    convert_to_uchar_N<float, 4> (orig, ret);
+    convert_to_short_N<float, 4> (orig, ret);
 }
 
 static inline void
@@ -489,7 +491,7 @@ interpolate_chroma_half_row_4x1 (UcharImage *image, uint32_t x, uint32_t y, floa
 
 void
 LaplaceTask::laplace_luma (
-    UcharImage *orig_luma, UcharImage *gauss_luma, UcharImage *out_luma,
+    UcharImage *orig_luma, UcharImage *gauss_luma, ShortImage *out_luma,
     uint32_t x, uint32_t y)
 {
     uint32_t out_x = x * 8, out_y = y * 4;
@@ -499,7 +501,7 @@ LaplaceTask::laplace_luma (
 
 void
 LaplaceTask::laplace_uv (
-    Uchar2Image *orig_uv, Uchar2Image *gauss_uv, Uchar2Image *out_uv,
+    Uchar2Image *orig_uv, Uchar2Image *gauss_uv, Short2Image *out_uv,
     uint32_t x, uint32_t y)
 {
     uint32_t out_uv_x = x * 4, out_uv_y = y * 2;
@@ -507,7 +509,7 @@ LaplaceTask::laplace_uv (
     Float2 gauss_uv_value[3];
     Float2 orig_uv_value[4];
     Float2 inter_uv_value[4];
-    Uchar2 lap_uv_ret[4];
+    Short2 lap_uv_ret[4];
     interpolate_uv_int_row_4x1 (gauss_uv, gauss_uv_x, gauss_uv_y, gauss_uv_value, inter_uv_value);
     orig_uv->read_array_no_check<Float2, 4> (out_uv_x, out_uv_y, orig_uv_value);
     minus_array_uv_4 (orig_uv_value, inter_uv_value, lap_uv_ret);
@@ -521,7 +523,7 @@ LaplaceTask::laplace_uv (
 
 void
 LaplaceTask::laplace_chroma (
-    UcharImage *orig_chroma, UcharImage *gauss_chroma, UcharImage *out_chroma,
+    UcharImage *orig_chroma, UcharImage *gauss_chroma, ShortImage *out_chroma,
     uint32_t x, uint32_t y)
 {
     uint32_t out_chroma_x = x * 4, out_chroma_y = y * 2;
@@ -529,7 +531,7 @@ LaplaceTask::laplace_chroma (
     float gauss_chroma_value[3];
     float orig_chroma_value[4];
     float inter_chroma_value[4];
-    Uchar lap_chroma_ret[4];
+    Short lap_chroma_ret[4];
     interpolate_chroma_int_row_4x1 (gauss_chroma, gauss_chroma_x, gauss_chroma_y, gauss_chroma_value, inter_chroma_value);
     orig_chroma->read_array_no_check<float, 4> (out_chroma_x, out_chroma_y, orig_chroma_value);
     minus_array_chroma_4 (orig_chroma_value, inter_chroma_value, lap_chroma_ret);
@@ -546,10 +548,12 @@ LaplaceTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range
 {
     SmartPtr<LaplaceTask::Args> args = base.dynamic_cast_ptr<LaplaceTask::Args> ();
     XCAM_ASSERT (args.ptr ());
-    UcharImage *orig_luma = args->orig_luma.ptr (), *gauss_luma = args->gauss_luma.ptr (), *out_luma = args->out_luma.ptr ();
-    Uchar2Image *orig_uv = args->orig_uv.ptr (), *gauss_uv = args->gauss_uv.ptr (), *out_uv = args->out_uv.ptr ();
-    UcharImage *orig_u = args->orig_u.ptr (), *gauss_u = args->gauss_u.ptr (), *out_u = args->out_u.ptr ();
-    UcharImage *orig_v = args->orig_v.ptr (), *gauss_v = args->gauss_v.ptr (), *out_v = args->out_v.ptr ();
+    UcharImage *orig_luma = args->orig_luma.ptr (), *gauss_luma = args->gauss_luma.ptr ();
+    Uchar2Image *orig_uv = args->orig_uv.ptr (), *gauss_uv = args->gauss_uv.ptr ();
+    UcharImage *orig_u = args->orig_u.ptr (), *gauss_u = args->gauss_u.ptr ();
+    UcharImage *orig_v = args->orig_v.ptr (), *gauss_v = args->gauss_v.ptr ();
+    ShortImage *out_luma = args->out_luma.ptr (), *out_u = args->out_u.ptr (), *out_v = args->out_v.ptr ();
+    Short2Image *out_uv = args->out_uv.ptr ();
 
     XCAM_ASSERT (orig_luma && (orig_uv || (orig_u && orig_v)));
     XCAM_ASSERT (gauss_luma && (gauss_uv || (gauss_u && gauss_v)));
@@ -576,7 +580,7 @@ LaplaceTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range
 static inline void
 reconstruct_luma_8x1 (float *lap, float *up_sample, Uchar *result)
 {
-#define RECONSTRUCT_UP_SAMPLE(i) result[i] = convert_to_uchar<float>(up_sample[i] + lap[i] * 2.0f - 256.0f)
+#define RECONSTRUCT_UP_SAMPLE(i) result[i] = convert_to_uchar<float>(up_sample[i] + lap[i] / SOFT_LAP_SCALE)
     RECONSTRUCT_UP_SAMPLE(0);
     RECONSTRUCT_UP_SAMPLE(1);
     RECONSTRUCT_UP_SAMPLE(2);
@@ -591,8 +595,8 @@ static inline void
 reconstruct_uv_4x1 (Float2 *lap, Float2 *up_sample, Uchar2 *uv_uc)
 {
 #define RECONSTRUCT_UP_SAMPLE_UV(i) \
-    uv_uc[i].x = convert_to_uchar<float>(up_sample[i].x + lap[i].x * 2.0f - 256.0f); \
-    uv_uc[i].y = convert_to_uchar<float>(up_sample[i].y + lap[i].y * 2.0f - 256.0f)
+    uv_uc[i].x = convert_to_uchar<float>(up_sample[i].x + lap[i].x / SOFT_LAP_SCALE); \
+    uv_uc[i].y = convert_to_uchar<float>(up_sample[i].y + lap[i].y / SOFT_LAP_SCALE)
 
     RECONSTRUCT_UP_SAMPLE_UV (0);
     RECONSTRUCT_UP_SAMPLE_UV (1);
@@ -604,7 +608,7 @@ static inline void
 reconstruct_chroma_4x1 (float *lap, float *up_sample, Uchar *chroma_uc)
 {
 #define RECONSTRUCT_UP_SAMPLE_CHROMA(i) \
-    chroma_uc[i] = convert_to_uchar<float>(up_sample[i] + lap[i] * 2.0f - 256.0f);
+    chroma_uc[i] = convert_to_uchar<float>(up_sample[i] + lap[i] / SOFT_LAP_SCALE);
 
     RECONSTRUCT_UP_SAMPLE_CHROMA (0);
     RECONSTRUCT_UP_SAMPLE_CHROMA (1);
@@ -614,7 +618,7 @@ reconstruct_chroma_4x1 (float *lap, float *up_sample, Uchar *chroma_uc)
 
 void
 ReconstructTask::reconstruct_luma (
-    UcharImage **lap_luma, UcharImage *gauss_luma, UcharImage *out_luma,
+    ShortImage **lap_luma, UcharImage *gauss_luma, UcharImage *out_luma,
     UcharImage *mask_image, float* luma_mask1, float* luma_mask2,
     uint32_t x, uint32_t y)
 {
@@ -654,7 +658,7 @@ ReconstructTask::reconstruct_luma (
 
 void
 ReconstructTask::reconstruct_uv (
-    Uchar2Image **lap_uv, Uchar2Image *gauss_uv, Uchar2Image *out_uv,
+    Short2Image **lap_uv, Uchar2Image *gauss_uv, Uchar2Image *out_uv,
     float* mask1, float* mask2,
     uint32_t x, uint32_t y)
 {
@@ -680,7 +684,7 @@ ReconstructTask::reconstruct_uv (
 
 void
 ReconstructTask::reconstruct_chroma (
-    UcharImage **lap_chroma, UcharImage *gauss_chroma, UcharImage *out_chroma,
+    ShortImage **lap_chroma, UcharImage *gauss_chroma, UcharImage *out_chroma,
     float* mask1, float* mask2,
     uint32_t x, uint32_t y)
 {
@@ -709,11 +713,11 @@ ReconstructTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &r
 {
     SmartPtr<ReconstructTask::Args> args = base.dynamic_cast_ptr<ReconstructTask::Args> ();
     XCAM_ASSERT (args.ptr ());
-    UcharImage *lap_luma[2] = {args->lap_luma[0].ptr (), args->lap_luma[1].ptr ()};
+    ShortImage *lap_luma[2] = {args->lap_luma[0].ptr (), args->lap_luma[1].ptr ()};
     UcharImage *gauss_luma = args->gauss_luma.ptr (), *out_luma = args->out_luma.ptr ();
-    Uchar2Image *lap_uv[2] = {args->lap_uv[0].ptr (), args->lap_uv[1].ptr ()};
-    UcharImage *lap_u[2] = {args->lap_u[0].ptr (), args->lap_u[1].ptr ()};
-    UcharImage *lap_v[2] = {args->lap_v[0].ptr (), args->lap_v[1].ptr ()};
+    Short2Image *lap_uv[2] = {args->lap_uv[0].ptr (), args->lap_uv[1].ptr ()};
+    ShortImage *lap_u[2] = {args->lap_u[0].ptr (), args->lap_u[1].ptr ()};
+    ShortImage *lap_v[2] = {args->lap_v[0].ptr (), args->lap_v[1].ptr ()};
 
     Uchar2Image *gauss_uv = args->gauss_uv.ptr (), *out_uv = args->out_uv.ptr ();
     UcharImage *gauss_u = args->gauss_u.ptr (), *out_u = args->out_u.ptr ();
@@ -33,6 +33,11 @@
 #define GAUSS_DOWN_SCALE_RADIUS 2
 #define GAUSS_DOWN_SCALE_SIZE  ((GAUSS_DOWN_SCALE_RADIUS)*2+1)
 
+// Laplacian levels are kept in signed 16-bit fixed point with 7 fraction bits,
+// (orig - gauss) in [-255, 255] maps to [-32640, 32640]
+#define SOFT_LAP_FRACTION_BITS 7
+#define SOFT_LAP_SCALE ((float)(1 << SOFT_LAP_FRACTION_BITS))
+
 namespace XCam {
 
 namespace XCamSoftTasks {
@@ -179,9 +184,11 @@ class LaplaceTask
 {
 public:
     struct Args : SoftArgs {
-        SmartPtr<UcharImage>        orig_luma, gauss_luma, out_luma;
-        SmartPtr<Uchar2Image>       orig_uv, gauss_uv, out_uv;
-        SmartPtr<UcharImage>        orig_u, orig_v, gauss_u, gauss_v, out_u, out_v;
+        SmartPtr<UcharImage>        orig_luma, gauss_luma;
+        SmartPtr<Uchar2Image>       orig_uv, gauss_uv;
+        SmartPtr<UcharImage>        orig_u, orig_v, gauss_u, gauss_v;
+        SmartPtr<ShortImage>        out_luma, out_u, out_v;
+        SmartPtr<Short2Image>       out_uv;
 
         const uint32_t              level;
         const SoftBlender::BufIdx   idx;
@@ -210,17 +217,17 @@ private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
 
     void laplace_luma (
-        UcharImage *orig_luma, UcharImage *gauss_luma, UcharImage *out_luma,
+        UcharImage *orig_luma, UcharImage *gauss_luma, ShortImage *out_luma,
         uint32_t x, uint32_t y);
     void laplace_uv (
-        Uchar2Image *orig_uv, Uchar2Image *gauss_uv, Uchar2Image *out_uv,
+        Uchar2Image *orig_uv, Uchar2Image *gauss_uv, Short2Image *out_uv,
         uint32_t x, uint32_t y);
     void laplace_chroma (
-        UcharImage *orig_chroma, UcharImage *gauss_chroma, UcharImage *out_chroma,
+        UcharImage *orig_chroma, UcharImage *gauss_chroma, ShortImage *out_chroma,
         uint32_t x, uint32_t y);
 
     void interplate_luma_8x2 (
-        UcharImage *orig_luma, UcharImage *gauss_luma, UcharImage *out_luma,
+        UcharImage *orig_luma, UcharImage *gauss_luma, ShortImage *out_luma,
         uint32_t out_x, uint32_t out_y);
 };
 
@@ -229,9 +236,11 @@ class ReconstructTask
 {
 public:
     struct Args : SoftArgs {
-        SmartPtr<UcharImage>        gauss_luma, lap_luma[2], out_luma;
-        SmartPtr<Uchar2Image>       gauss_uv, lap_uv[2], out_uv;
-        SmartPtr<UcharImage>        gauss_u, gauss_v, lap_u[2], lap_v[2], out_u, out_v;
+        SmartPtr<UcharImage>        gauss_luma, out_luma;
+        SmartPtr<Uchar2Image>       gauss_uv, out_uv;
+        SmartPtr<UcharImage>        gauss_u, gauss_v, out_u, out_v;
+        SmartPtr<ShortImage>        lap_luma[2], lap_u[2], lap_v[2];
+        SmartPtr<Short2Image>       lap_uv[2];
 
         SmartPtr<UcharImage>        mask;
         const uint32_t              level;
@@ -258,15 +267,15 @@ public:
 private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
     void reconstruct_luma (
-        UcharImage **lap_luma, UcharImage *gauss_luma, UcharImage *out_luma,
+        ShortImage **lap_luma, UcharImage *gauss_luma, UcharImage *out_luma,
         UcharImage *mask_image, float* luma_mask1, float* luma_mask2,
         uint32_t x, uint32_t y);
     void reconstruct_uv (
-        Uchar2Image **lap_uv, Uchar2Image *gauss_uv, Uchar2Image *out_uv,
+        Short2Image **lap_uv, Uchar2Image *gauss_uv, Uchar2Image *out_uv,
         float* mask1, float* mask2,
         uint32_t x, uint32_t y);
     void reconstruct_chroma (
-        UcharImage **lap_chroma, UcharImage *gauss_chroma, UcharImage *out_chroma,
+        ShortImage **lap_chroma, UcharImage *gauss_chroma, UcharImage *out_chroma,
         float* mask1, float* mask2,
         uint32_t x, uint32_t y);
 };
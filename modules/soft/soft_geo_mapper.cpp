@@ -172,6 +172,88 @@ SoftGeoMapper::create_remap_task ()
     return map_task;
 }
 
+static XCamReturn
+set_direct_outs (const SmartPtr<ImageHandler::Parameters> &param, XCamSoftTasks::GeoMapTask::Args &args)
+{
+    SmartPtr<SoftGeoMapper::DirectParam> direct_param = param.dynamic_cast_ptr<SoftGeoMapper::DirectParam> ();
+    if (!direct_param.ptr () || !direct_param->direct_buf.ptr () || direct_param->direct_areas.empty ())
+        return XCAM_RETURN_NO_ERROR;
+
+    const SmartPtr<VideoBuffer> &buf = direct_param->direct_buf;
+    const VideoBufferInfo &info = buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, info.format == param->out_buf->get_video_info ().format, XCAM_RETURN_ERROR_PARAM,
+        "geomap direct output format:%s differs from output buffer",
+        xcam_fourcc_to_string (info.format));
+
+    const SoftGeoMapDirectAreas &areas = direct_param->direct_areas;
+    for (uint32_t i = 0; i < areas.size (); ++i) {
+        const Rect &in = areas[i].in_area;
+        const Rect &out = areas[i].out_area;
+        XCAM_FAIL_RETURN (
+            ERROR,
+            in.width == out.width && in.height == out.height &&
+            !(in.pos_x % 2) && !(in.pos_y % 2) && !(in.width % 2) && !(in.height % 2) &&
+            !(out.pos_x % 2) && !(out.pos_y % 2) &&
+            out.pos_x >= 0 && out.pos_y >= 0 &&
+            out.pos_x + out.width <= (int32_t)info.width && out.pos_y + out.height <= (int32_t)info.height,
+            XCAM_RETURN_ERROR_PARAM,
+            "geomap direct area(%d) invalid, in(%d, %d, %d, %d) out(%d, %d, %d, %d)",
+            i, in.pos_x, in.pos_y, in.width, in.height, out.pos_x, out.pos_y, out.width, out.height);
+
+        XCamSoftTasks::GeoMapTask::DirectOut direct;
+        direct.area = in;
+        direct.shared = areas[i].shared;
+        direct.luma = new UcharImage (
+            buf, out.width, out.height, info.strides[0],
+            info.offsets[0] + out.pos_x + out.pos_y * info.strides[0]);
+        if (V4L2_PIX_FMT_NV12 == info.format) {
+            direct.uv = new Uchar2Image (
+                buf, out.width / 2, out.height / 2, info.strides[1],
+                info.offsets[1] + out.pos_x + out.pos_y / 2 * info.strides[1]);
+        } else if (V4L2_PIX_FMT_YUV420 == info.format) {
+            direct.u = new UcharImage (
+                buf, out.width / 2, out.height / 2, info.strides[1],
+                info.offsets[1] + out.pos_x / 2 + out.pos_y / 2 * info.strides[1]);
+            direct.v = new UcharImage (
+                buf, out.width / 2, out.height / 2, info.strides[2],
+                info.offsets[2] + out.pos_x / 2 + out.pos_y / 2 * info.strides[2]);
+        } else {
+            XCAM_LOG_ERROR ("geomap direct output format:%s unsupported", xcam_fourcc_to_string (info.format));
+            return XCAM_RETURN_ERROR_PARAM;
+        }
+        args.direct_outs.push_back (direct);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+// work units of the map area, the whole out_luma if no map area is set
+static bool
+set_map_area (
+    const SmartPtr<ImageHandler::Parameters> &param, XCamSoftTasks::GeoMapTask::Args &args,
+    uint32_t &width, uint32_t &height)
+{
+    width = args.out_luma->get_width ();
+    height = args.out_luma->get_height ();
+
+    SmartPtr<SoftGeoMapper::DirectParam> direct_param = param.dynamic_cast_ptr<SoftGeoMapper::DirectParam> ();
+    if (!direct_param.ptr () || direct_param->map_area.width <= 0 || direct_param->map_area.height <= 0)
+        return true;
+
+    const Rect &area = direct_param->map_area;
+    uint32_t x0 = XCAM_CLAMP (area.pos_x, 0, (int32_t)width);
+    uint32_t y0 = XCAM_CLAMP (area.pos_y, 0, (int32_t)height);
+    uint32_t x1 = XCAM_CLAMP (area.pos_x + area.width, 0, (int32_t)width);
+    uint32_t y1 = XCAM_CLAMP (area.pos_y + area.height, 0, (int32_t)height);
+
+    args.origin_x = x0 / XCAM_SOFT_WORKUNIT_PIXELS;
+    args.origin_y = y0 / 2;
+    width = x1 > x0 ? x1 - args.origin_x * XCAM_SOFT_WORKUNIT_PIXELS : 0;
+    height = y1 > y0 ? y1 - args.origin_y * 2 : 0;
+    return width && height;
+}
+
 XCamReturn
 SoftGeoMapper::start_remap_task (const SmartPtr<ImageHandler::Parameters> &param)
 {
@@ -199,13 +281,22 @@ SoftGeoMapper::start_remap_task (const SmartPtr<ImageHandler::Parameters> &param
     args->lookup_table = _lookup_table;
     args->factors = factors;
 
+    XCamReturn ret = set_direct_outs (param, *args.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "SoftGeoMapper(%s) set direct outputs failed", XCAM_STR (get_name ()));
+
     uint32_t thread_x = 2;
     uint32_t thread_y = 2;
     get_thread_count (thread_x, thread_y);
     if (thread_x == 0) thread_x = 2;
     if (thread_y == 0) thread_y = 2;
 
-    set_work_size (thread_x, thread_y, args->out_luma->get_width (), args->out_luma->get_height ());
+    uint32_t map_width, map_height;
+    XCAM_FAIL_RETURN (
+        ERROR, set_map_area (param, *args.ptr (), map_width, map_height), XCAM_RETURN_ERROR_PARAM,
+        "SoftGeoMapper(%s) map area is outside of output", XCAM_STR (get_name ()));
+    set_work_size (thread_x, thread_y, map_width, map_height);
 
     param->in_buf.release ();
     return _map_task->work (args);
@@ -375,13 +466,32 @@ SoftDualConstGeoMapper::prepare_arguments (
 
     args->lookup_table = lookup_table;
 
+    SmartPtr<XCamSoftTasks::GeoMapDualConstTask> map_task =
+        get_map_task ().dynamic_cast_ptr<XCamSoftTasks::GeoMapDualConstTask> ();
+    XCAM_ASSERT (map_task.ptr ());
+    args->map_table = map_task->get_map_table (
+        lookup_table, args->out_luma->get_width (), args->out_luma->get_height (),
+        args->left_factor, args->right_factor);
+    XCAM_FAIL_RETURN (
+        ERROR, args->map_table.ptr (), XCAM_RETURN_ERROR_MEM,
+        "SoftGeoMapper(%s) get map table failed", XCAM_STR (get_name ()));
+
+    XCamReturn ret = set_direct_outs (param, *args.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "SoftGeoMapper(%s) set direct outputs failed", XCAM_STR (get_name ()));
+
     uint32_t thread_x = 2;
     uint32_t thread_y = 2;
     get_thread_count (thread_x, thread_y);
     if (thread_x == 0) thread_x = 2;
     if (thread_y == 0) thread_y = 2;
 
-    set_work_size (thread_x, thread_y, args->out_luma->get_width (), args->out_luma->get_height ());
+    uint32_t map_width, map_height;
+    XCAM_FAIL_RETURN (
+        ERROR, set_map_area (param, *args.ptr (), map_width, map_height), XCAM_RETURN_ERROR_PARAM,
+        "SoftGeoMapper(%s) map area is outside of output", XCAM_STR (get_name ()));
+    set_work_size (thread_x, thread_y, map_width, map_height);
 
     param->in_buf.release ();
     return XCAM_RETURN_NO_ERROR;
@@ -397,7 +507,10 @@ SoftDualConstGeoMapper::start_remap_task (const SmartPtr<ImageHandler::Parameter
         new XCamSoftTasks::GeoMapDualConstTask::Args (param);
     XCAM_ASSERT (args.ptr ());
 
-    prepare_arguments (args, param);
+    XCamReturn ret = prepare_arguments (args, param);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "SoftGeoMapper(%s) prepare arguments failed", XCAM_STR (get_name ()));
 
     return map_task->work (args);
 }
@@ -459,7 +572,10 @@ SoftDualCurveGeoMapper::start_remap_task (const SmartPtr<ImageHandler::Parameter
         new XCamSoftTasks::GeoMapDualCurveTask::Args (param);
     XCAM_ASSERT (args.ptr ());
 
-    prepare_arguments (args, param);
+    XCamReturn ret = prepare_arguments (args, param);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "SoftGeoMapper(%s) prepare arguments failed", XCAM_STR (get_name ()));
 
     return map_task->work (args);
 }
@@ -25,6 +25,7 @@
 #include <interface/geo_mapper.h>
 #include <soft/soft_handler.h>
 #include <soft/soft_image.h>
+#include <vector>
 
 namespace XCam {
 
@@ -34,9 +35,39 @@ class GeoMapDualConstTask;
 class GeoMapDualCurveTask;
 };
 
+struct SoftGeoMapDirectArea {
+    Rect     in_area;   // area of remapped image
+    Rect     out_area;  // area of direct output buffer, same size as in_area
+    bool     shared;    // in_area is still needed in out_buf
+
+    SoftGeoMapDirectArea () : shared (false) {}
+};
+typedef std::vector<SoftGeoMapDirectArea> SoftGeoMapDirectAreas;
+
 class SoftGeoMapper
     : public SoftHandler, public GeoMapper
 {
+public:
+    /*
+     * Remapped pixels inside direct areas are written into direct_buf as well,
+     * exclusive areas are left unwritten in out_buf, which saves a copy pass for
+     * callers like stitcher composing several remapped images into one buffer.
+     * Areas must be 2 pixels aligned.
+     * A non-empty map_area limits remapping to that part of out_buf, the rest of
+     * out_buf is left unwritten, direct areas are expected inside it.
+     */
+    struct DirectParam
+        : ImageHandler::Parameters
+    {
+        SmartPtr<VideoBuffer>    direct_buf;
+        SoftGeoMapDirectAreas    direct_areas;
+        Rect                     map_area;
+
+        DirectParam (const SmartPtr<VideoBuffer> &in = NULL, const SmartPtr<VideoBuffer> &out = NULL)
+            : ImageHandler::Parameters (in, out)
+        {}
+    };
+
 public:
     SoftGeoMapper (const char *name = "SoftGeoMapper");
     ~SoftGeoMapper ();
@@ -233,6 +233,87 @@ static void map_image (
 
 }
 
+struct MapDest {
+    UcharImage    *luma;
+    Uchar2Image   *uv;
+    UcharImage    *u, *v;
+    uint32_t       x, y;
+};
+
+static inline bool
+in_direct_area (const Rect &area, uint32_t out_x, uint32_t out_y)
+{
+    return (int32_t)out_x >= area.pos_x && (int32_t)out_x + XCAM_SOFT_WORKUNIT_PIXELS <= area.pos_x + area.width &&
+           (int32_t)out_y >= area.pos_y && (int32_t)out_y + 2 <= area.pos_y + area.height;
+}
+
+// work unit fully inside an exclusive direct area is written to the direct output only
+static bool
+select_map_dest (const GeoMapTask::Args *args, uint32_t out_x, uint32_t out_y, MapDest &dest)
+{
+    for (uint32_t i = 0; i < args->direct_outs.size (); ++i) {
+        const GeoMapTask::DirectOut &direct = args->direct_outs[i];
+        if (direct.shared || !in_direct_area (direct.area, out_x, out_y))
+            continue;
+
+        dest.luma = direct.luma.ptr ();
+        dest.uv = direct.uv.ptr ();
+        dest.u = direct.u.ptr ();
+        dest.v = direct.v.ptr ();
+        dest.x = out_x - direct.area.pos_x;
+        dest.y = out_y - direct.area.pos_y;
+        return true;
+    }
+
+    dest.luma = args->out_luma.ptr ();
+    dest.uv = args->out_uv.ptr ();
+    dest.u = args->out_u.ptr ();
+    dest.v = args->out_v.ptr ();
+    dest.x = out_x;
+    dest.y = out_y;
+    return false;
+}
+
+template <typename T>
+static inline void
+copy_row (const SoftImage<T> *src, uint32_t src_x, uint32_t src_y, SoftImage<T> *dst, uint32_t dst_x, uint32_t dst_y, uint32_t len)
+{
+    memcpy ((void *)dst->get_buf_ptr (dst_x, dst_y), (const void *)src->get_buf_ptr (src_x, src_y), sizeof (T) * len);
+}
+
+// copy the part of a work unit written to out images into direct areas it covers
+static void
+copy_to_direct_outs (const GeoMapTask::Args *args, uint32_t out_x, uint32_t out_y)
+{
+    for (uint32_t i = 0; i < args->direct_outs.size (); ++i) {
+        const GeoMapTask::DirectOut &direct = args->direct_outs[i];
+        const Rect &area = direct.area;
+        int32_t x0 = XCAM_MAX ((int32_t)out_x, area.pos_x);
+        int32_t x1 = XCAM_MIN ((int32_t)out_x + XCAM_SOFT_WORKUNIT_PIXELS, area.pos_x + area.width);
+        int32_t y0 = XCAM_MAX ((int32_t)out_y, area.pos_y);
+        int32_t y1 = XCAM_MIN ((int32_t)out_y + 2, area.pos_y + area.height);
+        if (x0 >= x1 || y0 >= y1)
+            continue;
+
+        for (int32_t y = y0; y < y1; ++y) {
+            copy_row (args->out_luma.ptr (), x0, y, direct.luma.ptr (), x0 - area.pos_x, y - area.pos_y, x1 - x0);
+        }
+
+        // direct areas are 2 pixels aligned, chroma row is copied with its first luma row
+        if (y0 % 2)
+            continue;
+        x0 /= 2;
+        x1 /= 2;
+        y0 /= 2;
+        if (direct.uv.ptr ()) {
+            copy_row (args->out_uv.ptr (), x0, y0, direct.uv.ptr (), x0 - area.pos_x / 2, y0 - area.pos_y / 2, x1 - x0);
+        } else if (direct.u.ptr () && direct.v.ptr ()) {
+            copy_row (args->out_u.ptr (), x0, y0, direct.u.ptr (), x0 - area.pos_x / 2, y0 - area.pos_y / 2, x1 - x0);
+            copy_row (args->out_v.ptr (), x0, y0, direct.v.ptr (), x0 - area.pos_x / 2, y0 - area.pos_y / 2, x1 - x0);
+        }
+    }
+}
+
 XCamReturn
 GeoMapTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 {
@@ -288,7 +369,7 @@ GeoMapTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 
     for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
         for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x) {
-            uint32_t out_x = x * XCAM_SOFT_WORKUNIT_PIXELS, out_y = y * 2;
+            uint32_t out_x = (x + args->origin_x) * XCAM_SOFT_WORKUNIT_PIXELS, out_y = (y + args->origin_y) * 2;
 
             // calculate XCAM_SOFT_WORKUNIT_PIXELS * 2 luma, center aligned
             Float2 out_pos (out_x, out_y);
@@ -297,44 +378,154 @@ GeoMapTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
             first += lut_center;
 
             Float2 interp_pos[XCAM_SOFT_WORKUNIT_PIXELS] = { Float2(0.0f, 0.0f) };
+            MapDest dest;
+            bool direct = select_map_dest (args.ptr (), out_x, out_y, dest);
 
             if (NULL != in_u && NULL != in_v) {
                 interp_sample_pos (lut, interp_pos, first, step);
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y, zero_luma_byte);
+                map_image (in_luma, dest.luma, interp_pos, luma_w, luma_h,
+                           dest.x, dest.y, zero_luma_byte);
 
                 for (uint32_t i = 0; i < XCAM_SOFT_WORKUNIT_PIXELS; i += 2) {
                     interp_pos[i / 2] = interp_pos[i] / 2.0f;
                 }
-                map_image (in_u, out_u, interp_pos, chroma_w, chroma_h,
-                           out_x / 2, out_y / 2, zero_chroma_byte, true);
+                map_image (in_u, dest.u, interp_pos, chroma_w, chroma_h,
+                           dest.x / 2, dest.y / 2, zero_chroma_byte, true);
 
-                map_image (in_v, out_v, interp_pos, chroma_w, chroma_h,
-                           out_x / 2, out_y / 2, zero_chroma_byte, true);
+                map_image (in_v, dest.v, interp_pos, chroma_w, chroma_h,
+                           dest.x / 2, dest.y / 2, zero_chroma_byte, true);
 
                 first.y = first.y + step.y;
                 interp_sample_pos (lut, interp_pos, first, step);
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y + 1, zero_luma_byte);
+                map_image (in_luma, dest.luma, interp_pos, luma_w, luma_h,
+                           dest.x, dest.y + 1, zero_luma_byte);
             } else if (NULL != in_uv) {
                 interp_sample_pos (lut, interp_pos, first, step);
 
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y, zero_luma_byte);
+                map_image (in_luma, dest.luma, interp_pos, luma_w, luma_h,
+                           dest.x, dest.y, zero_luma_byte);
 
-                map_image (in_uv, out_uv, interp_pos, chroma_w, chroma_h,
-                           out_x / 2, out_y / 2, zero_uv_byte);
+                map_image (in_uv, dest.uv, interp_pos, chroma_w, chroma_h,
+                           dest.x / 2, dest.y / 2, zero_uv_byte);
 
                 first.y = first.y + step.y;
                 interp_sample_pos (lut, interp_pos, first, step);
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y + 1, zero_luma_byte);
+                map_image (in_luma, dest.luma, interp_pos, luma_w, luma_h,
+                           dest.x, dest.y + 1, zero_luma_byte);
             }
+
+            if (!direct && !args->direct_outs.empty ())
+                copy_to_direct_outs (args.ptr (), out_x, out_y);
         }
     }
     return XCAM_RETURN_NO_ERROR;
 }
 
+GeoMapDualConstTask::GeoMapDualConstTask (const SmartPtr<Worker::Callback> &cb)
+    : GeoMapTask (cb)
+    , _cur_table (0)
+{
+    set_work_unit (XCAM_SOFT_WORKUNIT_PIXELS, 2);
+}
+
+bool
+GeoMapDualConstTask::calc_row_factors (const Float2 &factor, bool is_left, Float2 *factors, uint32_t rows)
+{
+    XCAM_UNUSED (is_left);
+
+    for (uint32_t y = 0; y < rows; ++y) {
+        factors[y] = factor;
+    }
+    return true;
+}
+
+static void
+calc_map_table_columns (
+    const Float2Image *lut, const Float2 *row_factors,
+    uint32_t width, uint32_t height, uint32_t start_x, uint32_t end_x, Float2Image *table)
+{
+    Float2 out_center ((width - 1.0f ) / 2.0f, (height - 1.0f ) / 2.0f);
+    Float2 lut_center ((lut->get_width () - 1.0f) / 2.0f, (lut->get_height () - 1.0f) / 2.0f);
+
+    for (uint32_t out_y = 0; out_y < table->get_height (); out_y += 2) {
+        const Float2 &factor = row_factors[out_y];
+        Float2 step = Float2(1.0f, 1.0f) / factor;
+
+        for (uint32_t out_x = start_x; out_x < end_x; out_x += XCAM_SOFT_WORKUNIT_PIXELS) {
+            Float2 out_pos (out_x, out_y);
+            out_pos -= out_center;
+            Float2 first = out_pos / factor;
+            first += lut_center;
+
+            interp_sample_pos (lut, table->get_buf_ptr (out_x, out_y), first, step);
+            first.y = first.y + step.y;
+            interp_sample_pos (lut, table->get_buf_ptr (out_x, out_y + 1), first, step);
+        }
+    }
+}
+
+SmartPtr<Float2Image>
+GeoMapDualConstTask::get_map_table (
+    const SmartPtr<Float2Image> &lut, uint32_t width, uint32_t height,
+    const Float2 &left_factor, const Float2 &right_factor)
+{
+    XCAM_ASSERT (lut.ptr () && width && height);
+
+    SmartLock locker (_table_mutex);
+
+    MapTable &cur = _tables[_cur_table];
+    if (cur.table.ptr () && cur.lut.ptr () == lut.ptr () &&
+            cur.left_valid && cur.right_valid &&
+            cur.left_factor == left_factor && cur.right_factor == right_factor &&
+            cur.table->get_width () == XCAM_ALIGN_UP (width, XCAM_SOFT_WORKUNIT_PIXELS) &&
+            cur.table->get_height () == XCAM_ALIGN_UP (height, 2))
+        return cur.table;
+
+    MapTable &next = _tables[1 - _cur_table];
+    uint32_t table_w = XCAM_ALIGN_UP (width, XCAM_SOFT_WORKUNIT_PIXELS);
+    uint32_t table_h = XCAM_ALIGN_UP (height, 2);
+    if (!next.table.ptr () || next.table->get_width () != table_w || next.table->get_height () != table_h ||
+            next.table.ref_count () > 1) {
+        // still read by in-flight frames
+        next.table = new Float2Image (table_w, table_h);
+        XCAM_FAIL_RETURN (
+            ERROR, next.table.ptr () && next.table->is_valid (), NULL,
+            "GeoMapDualConstTask allocate map table(%dx%d) failed", table_w, table_h);
+        next.left_valid = next.right_valid = false;
+    }
+    if (next.lut.ptr () != lut.ptr ()) {
+        next.lut = lut;
+        next.left_valid = next.right_valid = false;
+    }
+
+    // same left/right selection as work units in work_range
+    float center_x = (width - 1.0f) / 2.0f;
+    uint32_t split_x = 0;
+    while (split_x < table_w && split_x + XCAM_SOFT_WORKUNIT_PIXELS / 2 < center_x)
+        split_x += XCAM_SOFT_WORKUNIT_PIXELS;
+
+    _row_factors.resize (table_h);
+    if (!next.left_valid || !(next.left_factor == left_factor)) {
+        XCAM_FAIL_RETURN (
+            ERROR, calc_row_factors (left_factor, true, _row_factors.data (), table_h), NULL,
+            "GeoMapDualConstTask calculate left row factors failed");
+        calc_map_table_columns (lut.ptr (), _row_factors.data (), width, height, 0, split_x, next.table.ptr ());
+        next.left_factor = left_factor;
+        next.left_valid = true;
+    }
+    if (!next.right_valid || !(next.right_factor == right_factor)) {
+        XCAM_FAIL_RETURN (
+            ERROR, calc_row_factors (right_factor, false, _row_factors.data (), table_h), NULL,
+            "GeoMapDualConstTask calculate right row factors failed");
+        calc_map_table_columns (lut.ptr (), _row_factors.data (), width, height, split_x, table_w, next.table.ptr ());
+        next.right_factor = right_factor;
+        next.right_valid = true;
+    }
+
+    _cur_table = 1 - _cur_table;
+    return next.table;
+}
+
 XCamReturn
 GeoMapDualConstTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 {
@@ -348,36 +539,20 @@ GeoMapDualConstTask::work_range (const SmartPtr<Arguments> &base, const WorkRang
     UcharImage *in_luma = args->in_luma.ptr ();
     UcharImage *out_luma = args->out_luma.ptr ();
     Uchar2Image *in_uv = NULL;
-    Uchar2Image *out_uv = NULL;
     UcharImage *in_u = NULL;
     UcharImage *in_v = NULL;
-    UcharImage *out_u = NULL;
-    UcharImage *out_v = NULL;
     if (NULL != args->in_uv.ptr ()) {
         in_uv = args->in_uv.ptr ();
-        out_uv = args->out_uv.ptr ();
     } else if (NULL != args->in_u.ptr () && NULL != args->in_v.ptr ()) {
         in_u = args->in_u.ptr ();
-        out_u = args->out_u.ptr ();
         in_v = args->in_v.ptr ();
-        out_v = args->out_v.ptr ();
     }
-    Float2Image *lut = args->lookup_table.ptr ();
+    Float2Image *table = args->map_table.ptr ();
     XCAM_ASSERT (in_luma && (in_uv || (in_u && in_v)));
-    XCAM_ASSERT (out_luma && (out_uv || (out_u && out_v)));
-    XCAM_ASSERT (lut);
-
-    Float2 left_factor = args->left_factor;
-    Float2 right_factor = args->right_factor;
-    XCAM_ASSERT (
-        !XCAM_DOUBLE_EQUAL_AROUND (left_factor.x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (left_factor.y, 0.0f) &&
-        !XCAM_DOUBLE_EQUAL_AROUND (right_factor.x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (right_factor.y, 0.0f));
-
-    Float2 left_step = Float2(1.0f, 1.0f) / left_factor;
-    Float2 right_step = Float2(1.0f, 1.0f) / right_factor;
-
-    Float2 out_center ((out_luma->get_width () - 1.0f ) / 2.0f, (out_luma->get_height () - 1.0f ) / 2.0f);
-    Float2 lut_center ((lut->get_width () - 1.0f) / 2.0f, (lut->get_height () - 1.0f) / 2.0f);
+    XCAM_ASSERT (out_luma && (args->out_uv.ptr () || (args->out_u.ptr () && args->out_v.ptr ())));
+    XCAM_ASSERT (table);
+    XCAM_ASSERT (table->get_width () >= XCAM_ALIGN_UP (out_luma->get_width (), XCAM_SOFT_WORKUNIT_PIXELS));
+    XCAM_UNUSED (out_luma);
 
     uint32_t luma_w = in_luma->get_width ();
     uint32_t luma_h = in_luma->get_height ();
@@ -393,48 +568,45 @@ GeoMapDualConstTask::work_range (const SmartPtr<Arguments> &base, const WorkRang
 
     for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
         for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x) {
-            uint32_t out_x = x * XCAM_SOFT_WORKUNIT_PIXELS, out_y = y * 2;
-            Float2 &factor = (out_x + XCAM_SOFT_WORKUNIT_PIXELS / 2 < out_center.x) ? left_factor : right_factor;
-            Float2 &step = (out_x + XCAM_SOFT_WORKUNIT_PIXELS / 2 < out_center.x) ? left_step : right_step;
+            uint32_t out_x = (x + args->origin_x) * XCAM_SOFT_WORKUNIT_PIXELS, out_y = (y + args->origin_y) * 2;
 
-            // calculate XCAM_SOFT_WORKUNIT_PIXELS * 2 luma, center aligned
-            Float2 out_pos (out_x, out_y);
-            out_pos -= out_center;
-            Float2 first = out_pos / factor;
-            first += lut_center;
+            // positions are modified in place by chroma mapping, read a copy
+            Float2 interp_pos[XCAM_SOFT_WORKUNIT_PIXELS];
+            MapDest dest;
+            bool direct = select_map_dest (args.ptr (), out_x, out_y, dest);
 
-            Float2 interp_pos[XCAM_SOFT_WORKUNIT_PIXELS] = { Float2(0.0f, 0.0f) };
             if (NULL != in_u && NULL != in_v) {
-                interp_sample_pos (lut, interp_pos, first, step);
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y, zero_luma_byte);
+                memcpy ((void *)interp_pos, (const void *)table->get_buf_ptr (out_x, out_y), sizeof (interp_pos));
+                map_image (in_luma, dest.luma, interp_pos, luma_w, luma_h,
+                           dest.x, dest.y, zero_luma_byte);
 
                 for (uint32_t i = 0; i < XCAM_SOFT_WORKUNIT_PIXELS; i += 2) {
                     interp_pos[i / 2] = interp_pos[i] / 2.0f;
                 }
-                map_image (in_u, out_u, interp_pos, chroma_w, chroma_h,
-                           out_x / 2, out_y / 2, zero_chroma_byte, true);
+                map_image (in_u, dest.u, interp_pos, chroma_w, chroma_h,
+                           dest.x / 2, dest.y / 2, zero_chroma_byte, true);
 
-                map_image (in_v, out_v, interp_pos, chroma_w, chroma_h,
-                           out_x / 2, out_y / 2, zero_chroma_byte, true);
+                map_image (in_v, dest.v, interp_pos, chroma_w, chroma_h,
+                           dest.x / 2, dest.y / 2, zero_chroma_byte, true);
 
-                first.y = first.y + step.y;
-                interp_sample_pos (lut, interp_pos, first, step);
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y + 1, zero_luma_byte);
+                memcpy ((void *)interp_pos, (const void *)table->get_buf_ptr (out_x, out_y + 1), sizeof (interp_pos));
+                map_image (in_luma, dest.luma, interp_pos, luma_w, luma_h,
+                           dest.x, dest.y + 1, zero_luma_byte);
             } else if (NULL != in_uv) {
-                interp_sample_pos (lut, interp_pos, first, step);
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y, zero_luma_byte);
+                memcpy ((void *)interp_pos, (const void *)table->get_buf_ptr (out_x, out_y), sizeof (interp_pos));
+                map_image (in_luma, dest.luma, interp_pos, luma_w, luma_h,
+                           dest.x, dest.y, zero_luma_byte);
 
-                map_image (in_uv, out_uv, interp_pos, chroma_w, chroma_h,
-                           out_x / 2, out_y / 2, zero_uv_byte);
+                map_image (in_uv, dest.uv, interp_pos, chroma_w, chroma_h,
+                           dest.x / 2, dest.y / 2, zero_uv_byte);
 
-                first.y = first.y + step.y;
-                interp_sample_pos (lut, interp_pos, first, step);
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y + 1, zero_luma_byte);
+                memcpy ((void *)interp_pos, (const void *)table->get_buf_ptr (out_x, out_y + 1), sizeof (interp_pos));
+                map_image (in_luma, dest.luma, interp_pos, luma_w, luma_h,
+                           dest.x, dest.y + 1, zero_luma_byte);
             }
+
+            if (!direct && !args->direct_outs.empty ())
+                copy_to_direct_outs (args.ptr (), out_x, out_y);
         }
     }
     return XCAM_RETURN_NO_ERROR;
@@ -445,34 +617,10 @@ GeoMapDualCurveTask::GeoMapDualCurveTask (const SmartPtr<Worker::Callback> &cb)
     , _scaled_height (0.0f)
     , _left_std_factor (0.0f, 0.0f)
     , _right_std_factor (0.0f, 0.0f)
-    , _left_factors (NULL)
-    , _right_factors (NULL)
-    , _left_steps (NULL)
-    , _right_steps (NULL)
-    , _initialized (false)
 {
     set_work_unit (XCAM_SOFT_WORKUNIT_PIXELS, 2);
 }
 
-GeoMapDualCurveTask::~GeoMapDualCurveTask () {
-    if (_left_factors) {
-        delete [] _left_factors;
-        _left_factors = NULL;
-    }
-    if (_right_factors) {
-        delete [] _right_factors;
-        _right_factors = NULL;
-    }
-    if (_left_steps) {
-        delete [] _left_steps;
-        _left_steps = NULL;
-    }
-    if (_right_steps) {
-        delete [] _right_steps;
-        _right_steps = NULL;
-    }
-}
-
 void
 GeoMapDualCurveTask::set_left_std_factor (float x, float y) {
     XCAM_ASSERT (!XCAM_DOUBLE_EQUAL_AROUND (x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (y, 0.0f));
@@ -504,155 +652,25 @@ static void calc_cur_row_factor (
 }
 
 bool
-GeoMapDualCurveTask::set_factors (SmartPtr<GeoMapDualCurveTask::Args> args, uint32_t size) {
-    if (!_initialized) {
-        SmartLock locker (_mutex);
-
-        if (_left_factors == NULL) {
-            _left_factors = new Float2[size];
-            XCAM_ASSERT (_left_factors);
-        }
-        if (_right_factors == NULL) {
-            _right_factors = new Float2[size];
-            XCAM_ASSERT (_right_factors);
-        }
-        if (_left_steps == NULL) {
-            _left_steps =  new Float2[size];
-            XCAM_ASSERT (_left_steps);
-        }
-        if (_right_steps == NULL) {
-            _right_steps =  new Float2[size];
-            XCAM_ASSERT (_right_steps);
-        }
-        _initialized = true;
-    }
+GeoMapDualCurveTask::calc_row_factors (const Float2 &factor, bool is_left, Float2 *factors, uint32_t rows)
+{
+    const Float2 &std_factor = is_left ? _left_std_factor : _right_std_factor;
 
     float ym = _scaled_height * 0.5f;
-    for (uint32_t y = 0; y < size; ++y) {
-        calc_cur_row_factor (y, ym, _left_std_factor, _scaled_height, args->left_factor, _left_factors[y]);
-        calc_cur_row_factor (y, ym, _right_std_factor, _scaled_height, args->right_factor, _right_factors[y]);
-    }
+    for (uint32_t y = 0; y < rows; ++y) {
+        calc_cur_row_factor (y, ym, std_factor, _scaled_height, factor, factors[y]);
 
-    for (uint32_t y = 0; y < size; ++y) {
         XCAM_FAIL_RETURN (
             ERROR,
-            !XCAM_DOUBLE_EQUAL_AROUND (_left_factors[y].x, 0.0f) &&
-            !XCAM_DOUBLE_EQUAL_AROUND (_left_factors[y].y, 0.0f) &&
-            !XCAM_DOUBLE_EQUAL_AROUND (_right_factors[y].x, 0.0f) &&
-            !XCAM_DOUBLE_EQUAL_AROUND (_right_factors[y].y, 0.0f),
+            !XCAM_DOUBLE_EQUAL_AROUND (factors[y].x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (factors[y].y, 0.0f),
             false,
-            "GeoMapDualCurveTask invalid factor(row:%d): left_factor(x:%f, y:%f) right_factor(x:%f, y:%f)",
-            y, _left_factors[y].x, _left_factors[y].y, _right_factors[y].x, _right_factors[y].y);
-
-        _left_steps[y] = Float2(1.0f, 1.0f) / _left_factors[y];
-        _right_steps[y] = Float2(1.0f, 1.0f) / _right_factors[y];
+            "GeoMapDualCurveTask invalid %s factor(row:%d): x:%f, y:%f",
+            is_left ? "left" : "right", y, factors[y].x, factors[y].y);
     }
 
     return true;
 }
 
-XCamReturn
-GeoMapDualCurveTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
-{
-    static const Uchar zero_luma_byte[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-    static const Uchar2 zero_uv_byte[8] = {{128, 128}, {128, 128}, {128, 128}, {128, 128}, {128, 128}, {128, 128}, {128, 128}, {128, 128}};
-    static const Uchar zero_chroma_byte[8] = {128, 128, 128, 128, 128, 128, 128, 128};
-
-    SmartPtr<GeoMapDualCurveTask::Args> args = base.dynamic_cast_ptr<GeoMapDualCurveTask::Args> ();
-    XCAM_ASSERT (args.ptr ());
-    XCAM_ASSERT (
-        !XCAM_DOUBLE_EQUAL_AROUND (args->left_factor.x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (args->left_factor.y, 0.0f) &&
-        !XCAM_DOUBLE_EQUAL_AROUND (args->right_factor.x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (args->right_factor.y, 0.0f));
-
-    UcharImage *in_luma = args->in_luma.ptr ();
-    UcharImage *out_luma = args->out_luma.ptr ();
-    Uchar2Image *in_uv = NULL;
-    Uchar2Image *out_uv = NULL;
-    UcharImage *in_u = NULL;
-    UcharImage *in_v = NULL;
-    UcharImage *out_u = NULL;
-    UcharImage *out_v = NULL;
-    if (NULL != args->in_uv.ptr ()) {
-        in_uv = args->in_uv.ptr ();
-        out_uv = args->out_uv.ptr ();
-    } else if (NULL != args->in_u.ptr () && NULL != args->in_v.ptr ()) {
-        in_u = args->in_u.ptr ();
-        out_u = args->out_u.ptr ();
-        in_v = args->in_v.ptr ();
-        out_v = args->out_v.ptr ();
-    }
-
-    Float2Image *lut = args->lookup_table.ptr ();
-    XCAM_ASSERT (in_luma && (in_uv || (in_u && in_v)));
-    XCAM_ASSERT (out_luma && (out_uv || (out_u && out_v)));
-    XCAM_ASSERT (lut);
-
-    set_factors (args, out_luma->get_height ());
-
-    Float2 out_center ((out_luma->get_width () - 1.0f ) / 2.0f, (out_luma->get_height () - 1.0f ) / 2.0f);
-    Float2 lut_center ((lut->get_width () - 1.0f) / 2.0f, (lut->get_height () - 1.0f) / 2.0f);
-
-    uint32_t luma_w = in_luma->get_width ();
-    uint32_t luma_h = in_luma->get_height ();
-    uint32_t chroma_w = luma_w / 2;
-    uint32_t chroma_h = luma_h / 2;
-    if (NULL != in_uv) {
-        chroma_w = in_uv->get_width ();
-        chroma_h = in_uv->get_height ();
-    } else if (NULL != in_u && NULL != in_v) {
-        chroma_w = in_u->get_width ();
-        chroma_h = in_u->get_height ();
-    }
-
-    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
-        for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x) {
-            uint32_t out_x = x * XCAM_SOFT_WORKUNIT_PIXELS, out_y = y * 2;
-            Float2 &factor = (out_x + XCAM_SOFT_WORKUNIT_PIXELS / 2 < out_center.x) ? _left_factors[out_y] : _right_factors[out_y];
-            Float2 &step = (out_x + XCAM_SOFT_WORKUNIT_PIXELS / 2 < out_center.x) ? _left_steps[out_y] : _right_steps[out_y];
-
-            // calculate XCAM_SOFT_WORKUNIT_PIXELS * 2 luma, center aligned
-            Float2 out_pos (out_x, out_y);
-            out_pos -= out_center;
-            Float2 first = out_pos / factor;
-            first += lut_center;
-
-            Float2 interp_pos[XCAM_SOFT_WORKUNIT_PIXELS] = { Float2(0.0f, 0.0f) };
-            if (NULL != in_u && NULL != in_v) {
-                interp_sample_pos (lut, interp_pos, first, step);
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y, zero_luma_byte);
-
-                for (uint32_t i = 0; i < XCAM_SOFT_WORKUNIT_PIXELS; i += 2) {
-                    interp_pos[i / 2] = interp_pos[i] / 2.0f;
-                }
-                map_image (in_u, out_u, interp_pos, chroma_w, chroma_h,
-                           out_x / 2, out_y / 2, zero_chroma_byte, true);
-
-                map_image (in_v, out_v, interp_pos, chroma_w, chroma_h,
-                           out_x / 2, out_y / 2, zero_chroma_byte, true);
-
-                first.y = first.y + step.y;
-                interp_sample_pos (lut, interp_pos, first, step);
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y + 1, zero_luma_byte);
-            } else if (NULL != in_uv) {
-                interp_sample_pos (lut, interp_pos, first, step);
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y, zero_luma_byte);
-
-                map_image (in_uv, out_uv, interp_pos, chroma_w, chroma_h,
-                           out_x / 2, out_y / 2, zero_uv_byte);
-
-                first.y = first.y + step.y;
-                interp_sample_pos (lut, interp_pos, first, step);
-                map_image (in_luma, out_luma, interp_pos, luma_w, luma_h,
-                           out_x, out_y + 1, zero_luma_byte);
-            }
-        }
-    }
-    return XCAM_RETURN_NO_ERROR;
-}
-
 }
 
 }
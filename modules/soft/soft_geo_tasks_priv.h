@@ -22,9 +22,11 @@
 #define XCAM_SOFT_GEO_TASKS_PRIV_H
 
 #include <xcam_std.h>
+#include <interface/data_types.h>
 #include <soft/soft_worker.h>
 #include <soft/soft_image.h>
 #include <soft/soft_handler.h>
+#include <vector>
 
 namespace XCam {
 
@@ -34,16 +36,35 @@ class GeoMapTask
     : public SoftWorker
 {
 public:
+    /*
+     * Views over a direct output buffer, area is in out_luma coordinates.
+     * Exclusive areas are not written to out images, shared areas are written to both.
+     */
+    struct DirectOut {
+        Rect                        area;
+        bool                        shared;
+        SmartPtr<UcharImage>        luma;
+        SmartPtr<Uchar2Image>       uv;
+        SmartPtr<UcharImage>        u, v;
+
+        DirectOut () : shared (false) {}
+    };
+
     struct Args : SoftArgs {
         SmartPtr<UcharImage>        in_luma, out_luma;
         SmartPtr<Uchar2Image>       in_uv, out_uv;
         SmartPtr<UcharImage>        in_u, in_v, out_u, out_v;
         SmartPtr<Float2Image>       lookup_table;
         Float2                      factors;
+        std::vector<DirectOut>      direct_outs;
+        // work unit the global size starts from
+        uint32_t                    origin_x, origin_y;
 
         Args (
             const SmartPtr<ImageHandler::Parameters> &param)
             : SoftArgs (param)
+            , origin_x (0)
+            , origin_y (0)
         {}
     };
 
@@ -63,8 +84,9 @@ class GeoMapDualConstTask
 {
 public:
     struct Args : GeoMapTask::Args {
-        Float2    left_factor;
-        Float2    right_factor;
+        Float2                   left_factor;
+        Float2                   right_factor;
+        SmartPtr<Float2Image>    map_table;
 
         Args (
             const SmartPtr<ImageHandler::Parameters> &param)
@@ -73,14 +95,41 @@ public:
     };
 
 public:
-    explicit GeoMapDualConstTask (const SmartPtr<Worker::Callback> &cb)
-        : GeoMapTask (cb)
-    {
-        set_work_unit (XCAM_SOFT_WORKUNIT_PIXELS, 2);
-    }
+    explicit GeoMapDualConstTask (const SmartPtr<Worker::Callback> &cb);
+
+    /*
+     * Input positions of each output pixel with left and right factors applied.
+     * Two tables are kept, a factor change only recomputes columns of its own half
+     * in the table not being read by in-flight frames, then the tables swap.
+     */
+    SmartPtr<Float2Image> get_map_table (
+        const SmartPtr<Float2Image> &lut, uint32_t width, uint32_t height,
+        const Float2 &left_factor, const Float2 &right_factor);
+
+protected:
+    virtual bool calc_row_factors (const Float2 &factor, bool is_left, Float2 *factors, uint32_t rows);
 
 private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+
+    XCAM_DEAD_COPY (GeoMapDualConstTask);
+
+private:
+    struct MapTable {
+        SmartPtr<Float2Image>    table;
+        SmartPtr<Float2Image>    lut;
+        Float2                   left_factor;
+        Float2                   right_factor;
+        bool                     left_valid;
+        bool                     right_valid;
+
+        MapTable () : left_valid (false), right_valid (false) {}
+    };
+
+    MapTable                     _tables[2];
+    uint32_t                     _cur_table;
+    std::vector<Float2>          _row_factors;
+    Mutex                        _table_mutex;
 };
 
 class GeoMapDualCurveTask
@@ -96,7 +145,6 @@ public:
 
 public:
     explicit GeoMapDualCurveTask (const SmartPtr<Worker::Callback> &cb);
-    ~GeoMapDualCurveTask ();
 
     void set_scaled_height (float scaled_height) {
         XCAM_ASSERT (!XCAM_DOUBLE_EQUAL_AROUND (scaled_height, 0.0f));
@@ -106,23 +154,16 @@ public:
     void set_left_std_factor (float x, float y);
     void set_right_std_factor (float x, float y);
 
-private:
-    bool set_factors (SmartPtr<GeoMapDualCurveTask::Args> args, uint32_t size);
-
-    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+protected:
+    virtual bool calc_row_factors (const Float2 &factor, bool is_left, Float2 *factors, uint32_t rows);
 
+private:
     XCAM_DEAD_COPY (GeoMapDualCurveTask);
 
 private:
     float        _scaled_height;
     Float2       _left_std_factor;
     Float2       _right_std_factor;
-    Float2       *_left_factors;
-    Float2       *_right_factors;
-    Float2       *_left_steps;
-    Float2       *_right_steps;
-    bool         _initialized;
-    Mutex        _mutex;
 };
 
 }
@@ -31,6 +31,8 @@ class SyncMeta
     : public MetaBase
 {
 public:
+    XCAM_SLOT_TYPE (SyncMeta, MetaBase);
+
     SyncMeta ()
         : _done (false)
         , _error (XCAM_RETURN_NO_ERROR) {}
@@ -133,19 +135,23 @@ SoftHandler::execute_buffer (const SmartPtr<ImageHandler::Parameters> &param, bo
         ERROR, param.ptr (), XCAM_RETURN_ERROR_PARAM,
         "soft_hander(%s) execute buffer failed, params is null",
         XCAM_STR (get_name ()));
-
-    if (_need_configure) {
-        ret = configure_resource (param);
-        XCAM_FAIL_RETURN (
-            WARNING, xcam_ret_is_ok (ret), ret,
-            "soft_hander(%s) configure resource failed", XCAM_STR (get_name ()));
-
-        ret = configure_rest ();
-        XCAM_FAIL_RETURN (
-            WARNING, xcam_ret_is_ok (ret), ret,
-            "soft_hander(%s) confirm configure failed", XCAM_STR (get_name ()));
-
-        _need_configure = false;
+    param->start_time = LatencyStats::now_us ();
+
+    {
+        SmartLock locker (_exec_mutex);
+        if (_need_configure) {
+            ret = configure_resource (param);
+            XCAM_FAIL_RETURN (
+                WARNING, xcam_ret_is_ok (ret), ret,
+                "soft_hander(%s) configure resource failed", XCAM_STR (get_name ()));
+
+            ret = configure_rest ();
+            XCAM_FAIL_RETURN (
+                WARNING, xcam_ret_is_ok (ret), ret,
+                "soft_hander(%s) confirm configure failed", XCAM_STR (get_name ()));
+
+            _need_configure = false;
+        }
     }
 
     if (!param->out_buf.ptr () && _enable_allocator) {
@@ -182,17 +188,24 @@ SoftHandler::execute_buffer (const SmartPtr<ImageHandler::Parameters> &param, bo
 
     if (!xcam_ret_is_ok (ret)) {
         _params.erase (param);
+        record_latency (param, ret);
         XCAM_LOG_WARNING ("soft_hander(%s) execute buffer failed in starting workers", XCAM_STR (get_name ()));
         return ret;
     }
 
     ++_wip_buf_count;
-    _cur_sync = sync_meta;
+    {
+        SmartLock locker (_exec_mutex);
+        _cur_sync = sync_meta;
+    }
 
     if (sync) {
         XCAM_ASSERT (sync_meta.ptr ());
         ret = sync_meta->signal_wait_ret ();
-        _cur_sync.release ();
+
+        SmartLock locker (_exec_mutex);
+        if (_cur_sync.ptr () == sync_meta.ptr ())
+            _cur_sync.release ();
     }
 
     return ret;
@@ -202,7 +215,11 @@ XCamReturn
 SoftHandler::finish ()
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
-    SmartPtr<SyncMeta> sync = _cur_sync;
+    SmartPtr<SyncMeta> sync;
+    {
+        SmartLock locker (_exec_mutex);
+        sync = _cur_sync;
+    }
     if (sync.ptr ()) {
         ret = sync->signal_wait_ret ();
     }
@@ -217,7 +234,11 @@ SoftHandler::finish ()
 XCamReturn
 SoftHandler::terminate ()
 {
-    SmartPtr<SyncMeta> sync = _cur_sync;
+    SmartPtr<SyncMeta> sync;
+    {
+        SmartLock locker (_exec_mutex);
+        sync = _cur_sync;
+    }
     if (sync.ptr ()) {
         sync->wakeup ();
         sync.release ();
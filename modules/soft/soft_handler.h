@@ -25,11 +25,11 @@
 #include <image_handler.h>
 #include <video_buffer.h>
 #include <worker.h>
+#include <thread_pool.h>
 
 namespace XCam {
 
 class SoftHandler;
-class ThreadPool;
 class SyncMeta;
 class SoftWorker;
 
@@ -49,6 +49,25 @@ public:
     }
 };
 
+/*
+ * Scheduling of a frame, attached to the parameters of every handler running it.
+ * Work items of a smaller priority are dispatched first; with threads set, all
+ * stages of the frame queue on that shared pool instead of per-worker pools.
+ */
+struct SoftScheduleMeta
+    : MetaBase
+{
+    XCAM_SLOT_TYPE (SoftScheduleMeta, MetaBase);
+
+    int64_t                 priority;
+    SmartPtr<ThreadPool>    threads;
+
+    explicit SoftScheduleMeta (int64_t p = 0, const SmartPtr<ThreadPool> &t = NULL)
+        : priority (p)
+        , threads (t)
+    {}
+};
+
 class SoftHandler
     : public ImageHandler
 {
@@ -85,6 +104,7 @@ private:
 private:
     SmartPtr<ThreadPool>    _threads;
     SmartPtr<SyncMeta>      _cur_sync;
+    Mutex                   _exec_mutex;
     SafeList<Parameters>    _params;
     mutable std::atomic<int32_t>  _wip_buf_count;
 };
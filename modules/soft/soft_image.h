@@ -45,6 +45,8 @@ typedef Vector2<uint8_t> Uchar2;
 typedef Vector2<int8_t> Char2;
 typedef Vector2<float> Float2;
 typedef Vector2<int> Int2;
+typedef int16_t Short;
+typedef Vector2<int16_t> Short2;
 
 enum BorderType {
     BorderTypeNearest,
@@ -187,7 +189,7 @@ public:
     template<uint32_t N>
     inline void write_array_no_check (int32_t x, int32_t y, const T *array) {
         T *t_ptr = (T *)(_buf_ptr + y * _pitch);
-        memcpy (t_ptr + x, array, sizeof (T) * N);
+        memcpy ((void *)(t_ptr + x), array, sizeof (T) * N);
     }
 
     template<uint32_t N>
@@ -305,10 +307,34 @@ inline void convert_to_uchar2_N (const Vec2 *in, Uchar2 *out) {
     }
 }
 
+template <typename T>
+inline Short convert_to_short (const T& v) {
+    if (v < -32768.0f) return -32768;
+    else if (v > 32767.0f) return 32767;
+    return (Short)(v < 0.0f ? v - 0.5f : v + 0.5f);
+}
+
+template <typename T, uint32_t N>
+inline void convert_to_short_N (const T *in, Short *out) {
+    for (uint32_t i = 0; i < N; ++i) {
+        out[i] = convert_to_short<T> (in[i]);
+    }
+}
+
+template <typename Vec2, uint32_t N>
+inline void convert_to_short2_N (const Vec2 *in, Short2 *out) {
+    for (uint32_t i = 0; i < N; ++i) {
+        out[i].x = convert_to_short (in[i].x);
+        out[i].y = convert_to_short (in[i].y);
+    }
+}
+
 typedef SoftImage<Uchar> UcharImage;
 typedef SoftImage<Uchar2> Uchar2Image;
 typedef SoftImage<float> FloatImage;
 typedef SoftImage<Float2> Float2Image;
+typedef SoftImage<Short> ShortImage;
+typedef SoftImage<Short2> Short2Image;
 
 template <class SoftImageT>
 class SoftImageFile
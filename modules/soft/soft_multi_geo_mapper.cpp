@@ -0,0 +1,390 @@
+/*
+ * soft_multi_geo_mapper.cpp - CPU geometry mapper from multiple camera inputs
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <unistd.h>
+
+#include <thread_pool.h>
+#include <xcam_mutex.h>
+
+#include "soft_multi_geo_mapper.h"
+
+#define SOFT_MULTI_GEOMAP_MAX_THREADS 8
+
+namespace XCam {
+
+class SoftMultiGeoMapSync {
+public:
+    explicit SoftMultiGeoMapSync (uint32_t items)
+        : _remain_items (items)
+    {}
+
+    void dec () {
+        SmartLock locker (_mutex);
+        XCAM_ASSERT (_remain_items > 0);
+        if (--_remain_items == 0)
+            _cond.broadcast ();
+    }
+    void wait () {
+        SmartLock locker (_mutex);
+        while (_remain_items > 0)
+            _cond.wait (_mutex);
+    }
+
+private:
+    XCAM_DEAD_COPY (SoftMultiGeoMapSync);
+
+private:
+    uint32_t    _remain_items;
+    Mutex       _mutex;
+    Cond        _cond;
+};
+
+class SoftMultiGeoMapTask
+    : public ThreadPool::UserData
+{
+public:
+    SoftMultiGeoMapTask (
+        SoftMultiGeoMapper *mapper, uint32_t start, uint32_t end, const SmartPtr<SoftMultiGeoMapSync> &sync)
+        : _mapper (mapper)
+        , _start (start)
+        , _end (end)
+        , _sync (sync)
+    {}
+
+    virtual XCamReturn run () {
+        _mapper->remap_rows (_start, _end);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    virtual void done (XCamReturn) {
+        _sync->dec ();
+    }
+
+private:
+    SoftMultiGeoMapper             *_mapper;
+    uint32_t                        _start;
+    uint32_t                        _end;
+    SmartPtr<SoftMultiGeoMapSync>   _sync;
+};
+
+// interpolate table rows at grid position y, one point per table column
+static inline void
+interp_table_row (const Stitcher::ComposedMap &map, float y, std::vector<PointFloat2> &row)
+{
+    y = XCAM_CLAMP (y, 0.0f, map.table_height - 1.0f);
+    uint32_t y0 = XCAM_MIN ((uint32_t)y, map.table_height - 2);
+    float wy = y - y0;
+
+    const PointFloat2 *top = &map.table[y0 * map.table_width];
+    const PointFloat2 *bottom = top + map.table_width;
+    for (uint32_t i = 0; i < map.table_width; ++i) {
+        row[i].x = top[i].x + (bottom[i].x - top[i].x) * wy;
+        row[i].y = top[i].y + (bottom[i].y - top[i].y) * wy;
+    }
+}
+
+static inline PointFloat2
+interp_row_pos (const std::vector<PointFloat2> &row, uint32_t width, float x)
+{
+    x = XCAM_CLAMP (x, 0.0f, width - 1.0f);
+    uint32_t x0 = XCAM_MIN ((uint32_t)x, width - 2);
+    float wx = x - x0;
+
+    PointFloat2 pos;
+    pos.x = row[x0].x + (row[x0 + 1].x - row[x0].x) * wx;
+    pos.y = row[x0].y + (row[x0 + 1].y - row[x0].y) * wx;
+    return pos;
+}
+
+// bilinear sample of one channel, positions out of plane give invalid_value as SoftGeoMapper does
+static inline uint32_t
+sample_pixel (
+    const uint8_t *plane, uint32_t pitch, uint32_t width, uint32_t height, uint32_t pixel_bytes,
+    float x, float y, uint32_t invalid_value)
+{
+    if (x < 0.0f || y < 0.0f || x > width - 1.0f || y > height - 1.0f)
+        return invalid_value;
+
+    uint32_t x0 = XCAM_MIN ((uint32_t)x, width - 2);
+    uint32_t y0 = XCAM_MIN ((uint32_t)y, height - 2);
+    uint32_t wx = (uint32_t)((x - x0) * 256.0f);
+    uint32_t wy = (uint32_t)((y - y0) * 256.0f);
+
+    const uint8_t *top = plane + y0 * pitch + x0 * pixel_bytes;
+    const uint8_t *bottom = top + pitch;
+    uint32_t t = top[0] * (256 - wx) + top[pixel_bytes] * wx;
+    uint32_t b = bottom[0] * (256 - wx) + bottom[pixel_bytes] * wx;
+    return (t * (256 - wy) + b * wy + (1 << 15)) >> 16;
+}
+
+SoftMultiGeoMapper::SoftMultiGeoMapper (uint32_t thread_num)
+    : _thread_num (thread_num)
+    , _out_width (0)
+    , _out_height (0)
+    , _out_mem (NULL)
+{
+    if (_thread_num == 0) {
+        long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+        _thread_num = XCAM_CLAMP (cpus, 1, SOFT_MULTI_GEOMAP_MAX_THREADS);
+    }
+}
+
+SoftMultiGeoMapper::~SoftMultiGeoMapper ()
+{
+    stop ();
+}
+
+void
+SoftMultiGeoMapper::stop ()
+{
+    if (_threads.ptr ()) {
+        _threads->stop ();
+        _threads.release ();
+    }
+}
+
+XCamReturn
+SoftMultiGeoMapper::set_camera_maps (
+    const Stitcher::ComposedMapArray &maps, uint32_t out_width, uint32_t out_height)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !maps.empty () && out_width >= 2 && out_height >= 2, XCAM_RETURN_ERROR_PARAM,
+        "SoftMultiGeoMapper needs camera maps and output size, maps:%d output:%dx%d",
+        (int)maps.size (), out_width, out_height);
+
+    for (uint32_t i = 0; i < maps.size (); ++i) {
+        const Stitcher::ComposedMap &map = maps[i];
+        const Rect &area = map.area;
+        XCAM_FAIL_RETURN (
+            ERROR,
+            map.cam_idx < XCAM_STITCH_MAX_CAMERAS && map.table_factor > 0 &&
+            map.table_width >= 2 && map.table_height >= 2 &&
+            map.table.size () == map.table_width * map.table_height &&
+            map.weights.size () == (uint32_t)(area.width * area.height),
+            XCAM_RETURN_ERROR_PARAM,
+            "SoftMultiGeoMapper camera map(%d) of camera(%d) is invalid", i, map.cam_idx);
+        XCAM_FAIL_RETURN (
+            ERROR,
+            area.pos_x >= 0 && area.pos_y >= 0 && area.width > 0 && area.height > 0 &&
+            area.pos_x % 2 == 0 && area.pos_y % 2 == 0 && area.width % 2 == 0 && area.height % 2 == 0 &&
+            (uint32_t)(area.pos_x + area.width) <= out_width && (uint32_t)(area.pos_y + area.height) <= out_height,
+            XCAM_RETURN_ERROR_PARAM,
+            "SoftMultiGeoMapper camera map(%d) area(x:%d, y:%d, w:%d, h:%d) doesn't fit output(%dx%d) or isn't even",
+            i, area.pos_x, area.pos_y, area.width, area.height, out_width, out_height);
+    }
+
+    _maps = maps;
+    _out_width = out_width;
+    _out_height = out_height;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftMultiGeoMapper::remap (const VideoBufferList &in_bufs, const SmartPtr<VideoBuffer> &out)
+{
+    XCAM_ASSERT (out.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, !_maps.empty (), XCAM_RETURN_ERROR_ORDER,
+        "SoftMultiGeoMapper camera maps were not set");
+
+    std::vector<SmartPtr<VideoBuffer> > bufs (in_bufs.begin (), in_bufs.end ());
+    for (uint32_t i = 0; i < _maps.size (); ++i) {
+        uint32_t idx = _maps[i].cam_idx;
+        XCAM_FAIL_RETURN (
+            ERROR, idx < bufs.size () && bufs[idx].ptr (), XCAM_RETURN_ERROR_PARAM,
+            "SoftMultiGeoMapper input buffer of camera(%d) is missing, inputs:%d", idx, (int)bufs.size ());
+    }
+
+    _out_info = out->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        _out_info.format == V4L2_PIX_FMT_NV12 &&
+        _out_info.width >= _out_width && _out_info.height >= _out_height,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftMultiGeoMapper output(%s %dx%d) needs NV12 and at least %dx%d",
+        xcam_fourcc_to_string (_out_info.format), _out_info.width, _out_info.height, _out_width, _out_height);
+
+    _in_infos.resize (bufs.size ());
+    _in_mems.assign (bufs.size (), NULL);
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    for (uint32_t i = 0; i < bufs.size (); ++i) {
+        if (!bufs[i].ptr ())
+            continue;
+        _in_infos[i] = bufs[i]->get_video_info ();
+        if (_in_infos[i].format != V4L2_PIX_FMT_NV12 || _in_infos[i].width < 2 || _in_infos[i].height < 2) {
+            XCAM_LOG_ERROR (
+                "SoftMultiGeoMapper input(%d) %s %dx%d is not supported, needs NV12",
+                i, xcam_fourcc_to_string (_in_infos[i].format), _in_infos[i].width, _in_infos[i].height);
+            ret = XCAM_RETURN_ERROR_PARAM;
+            break;
+        }
+        _in_mems[i] = bufs[i]->map ();
+        if (!_in_mems[i]) {
+            XCAM_LOG_ERROR ("SoftMultiGeoMapper map input(%d) failed", i);
+            ret = XCAM_RETURN_ERROR_MEM;
+            break;
+        }
+    }
+
+    if (xcam_ret_is_ok (ret)) {
+        _out_mem = out->map ();
+        if (!_out_mem) {
+            XCAM_LOG_ERROR ("SoftMultiGeoMapper map output failed");
+            ret = XCAM_RETURN_ERROR_MEM;
+        }
+    }
+
+    if (xcam_ret_is_ok (ret)) {
+        // bands hold even rows so that chroma rows don't straddle bands
+        const uint32_t rows = _out_height;
+        uint32_t bands = XCAM_MIN (_thread_num, rows / 2);
+        if (bands > 1 && !_threads.ptr ()) {
+            _threads = new ThreadPool ("soft-multi-geomap");
+            _threads->set_threads (bands, bands);
+            if (!xcam_ret_is_ok (_threads->start ())) {
+                _threads.release ();
+                XCAM_LOG_WARNING ("SoftMultiGeoMapper start threads failed, remap in caller thread");
+            }
+        }
+
+        if (bands <= 1 || !_threads.ptr ()) {
+            remap_rows (0, rows);
+        } else {
+            SmartPtr<SoftMultiGeoMapSync> sync = new SoftMultiGeoMapSync (bands);
+            uint32_t rows_per_band = XCAM_ALIGN_UP (xcam_ceil (rows, bands) / bands, 2);
+            uint32_t start = 0;
+            for (uint32_t i = 0; i < bands; ++i) {
+                uint32_t end = XCAM_MIN (start + rows_per_band, rows);
+                SmartPtr<SoftMultiGeoMapTask> task = new SoftMultiGeoMapTask (this, start, end, sync);
+                if (start >= end || !xcam_ret_is_ok (_threads->queue (task))) {
+                    if (start < end)
+                        remap_rows (start, end);
+                    sync->dec ();
+                }
+                start = end;
+            }
+            sync->wait ();
+        }
+        out->unmap ();
+        out->set_timestamp (bufs[_maps[0].cam_idx]->get_timestamp ());
+    }
+    _out_mem = NULL;
+
+    for (uint32_t i = 0; i < bufs.size (); ++i) {
+        if (_in_mems[i])
+            bufs[i]->unmap ();
+    }
+    _in_mems.clear ();
+
+    return ret;
+}
+
+void
+SoftMultiGeoMapper::remap_rows (uint32_t start, uint32_t end)
+{
+    XCAM_ASSERT (start % 2 == 0);
+
+    const uint32_t width = _out_width;
+    uint8_t *out_y = _out_mem + _out_info.offsets[0];
+    uint8_t *out_uv = _out_mem + _out_info.offsets[1];
+    const uint32_t out_y_pitch = _out_info.strides[0];
+    const uint32_t out_uv_pitch = _out_info.strides[1];
+
+    std::vector<uint32_t> acc (width);
+    std::vector<uint32_t> acc_uv (width);
+    std::vector<uint32_t> weight_sum (width / 2);
+    std::vector<PointFloat2> table_row;
+
+    for (uint32_t y = start; y < end; ++y) {
+        acc.assign (width, 0);
+
+        for (uint32_t m = 0; m < _maps.size (); ++m) {
+            const Stitcher::ComposedMap &map = _maps[m];
+            const Rect &area = map.area;
+            if ((int32_t)y < area.pos_y || (int32_t)y >= area.pos_y + area.height)
+                continue;
+
+            const VideoBufferInfo &in_info = _in_infos[map.cam_idx];
+            const uint8_t *in_y = _in_mems[map.cam_idx] + in_info.offsets[0];
+            const uint8_t *weights = &map.weights[(y - area.pos_y) * area.width];
+            const float step = 1.0f / map.table_factor;
+
+            table_row.resize (map.table_width);
+            interp_table_row (map, (y - area.pos_y) * step, table_row);
+            for (int32_t i = 0; i < area.width; ++i) {
+                if (!weights[i])
+                    continue;
+                PointFloat2 pos = interp_row_pos (table_row, map.table_width, i * step);
+                acc[area.pos_x + i] += weights[i] * sample_pixel (
+                                           in_y, in_info.strides[0], in_info.width, in_info.height, 1, pos.x, pos.y, 0);
+            }
+        }
+
+        uint8_t *dst = out_y + y * out_y_pitch;
+        for (uint32_t x = 0; x < width; ++x)
+            dst[x] = (uint8_t)((acc[x] + 127) / 255);
+
+        if (y % 2)
+            continue;
+
+        // chroma(x, y) sits at luma(2x + 0.5, 2y + 0.5) and takes the weight of luma(2x, 2y)
+        acc_uv.assign (width, 0);
+        weight_sum.assign (width / 2, 0);
+        for (uint32_t m = 0; m < _maps.size (); ++m) {
+            const Stitcher::ComposedMap &map = _maps[m];
+            const Rect &area = map.area;
+            if ((int32_t)y < area.pos_y || (int32_t)y >= area.pos_y + area.height)
+                continue;
+
+            const VideoBufferInfo &in_info = _in_infos[map.cam_idx];
+            const uint8_t *in_uv = _in_mems[map.cam_idx] + in_info.offsets[1];
+            const uint32_t in_uv_width = in_info.width / 2;
+            const uint32_t in_uv_height = in_info.height / 2;
+            const uint8_t *weights = &map.weights[(y - area.pos_y) * area.width];
+            const float step = 1.0f / map.table_factor;
+
+            table_row.resize (map.table_width);
+            interp_table_row (map, (y + 0.5f - area.pos_y) * step, table_row);
+            for (int32_t i = 0; i < area.width; i += 2) {
+                uint32_t w = weights[i];
+                if (!w)
+                    continue;
+                PointFloat2 pos = interp_row_pos (table_row, map.table_width, (i + 0.5f) * step);
+                float cx = (pos.x - 0.5f) / 2.0f;
+                float cy = (pos.y - 0.5f) / 2.0f;
+                uint32_t x = area.pos_x + i;
+                acc_uv[x] += w * sample_pixel (
+                                 in_uv, in_info.strides[1], in_uv_width, in_uv_height, 2, cx, cy, 128);
+                acc_uv[x + 1] += w * sample_pixel (
+                                     in_uv + 1, in_info.strides[1], in_uv_width, in_uv_height, 2, cx, cy, 128);
+                weight_sum[x / 2] += w;
+            }
+        }
+
+        dst = out_uv + (y / 2) * out_uv_pitch;
+        for (uint32_t x = 0; x < width; x += 2) {
+            uint32_t uncovered = 128 * (255 - XCAM_MIN (weight_sum[x / 2], 255u));
+            dst[x] = (uint8_t)((acc_uv[x] + uncovered + 127) / 255);
+            dst[x + 1] = (uint8_t)((acc_uv[x + 1] + uncovered + 127) / 255);
+        }
+    }
+}
+
+}
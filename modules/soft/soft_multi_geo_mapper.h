@@ -0,0 +1,75 @@
+/*
+ * soft_multi_geo_mapper.h - CPU geometry mapper from multiple camera inputs
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SOFT_MULTI_GEO_MAPPER_H
+#define XCAM_SOFT_MULTI_GEO_MAPPER_H
+
+#include <xcam_std.h>
+#include <video_buffer.h>
+#include <interface/stitcher.h>
+#include <vector>
+
+namespace XCam {
+
+class ThreadPool;
+class SoftMultiGeoMapTask;
+
+/*
+ * Renders NV12 output straight from the fisheye inputs with composed camera maps,
+ * see BowlModel::get_topview_camera_maps and CubeMapModel::get_cubemap_camera_maps.
+ * Each output pixel is the weighted sum of bilinear samples of the covering cameras,
+ * so topview or cubemap needs neither the stitched image nor a second resampling.
+ * Rows are split into bands which run on a thread pool.
+ */
+class SoftMultiGeoMapper
+{
+    friend class SoftMultiGeoMapTask;
+
+public:
+    explicit SoftMultiGeoMapper (uint32_t thread_num = 0);
+    ~SoftMultiGeoMapper ();
+
+    XCamReturn set_camera_maps (const Stitcher::ComposedMapArray &maps, uint32_t out_width, uint32_t out_height);
+    // in_bufs are indexed by ComposedMap::cam_idx
+    XCamReturn remap (const VideoBufferList &in_bufs, const SmartPtr<VideoBuffer> &out);
+    void stop ();
+
+private:
+    void remap_rows (uint32_t start, uint32_t end);
+
+    XCAM_DEAD_COPY (SoftMultiGeoMapper);
+
+private:
+    uint32_t                       _thread_num;
+    uint32_t                       _out_width;
+    uint32_t                       _out_height;
+    Stitcher::ComposedMapArray     _maps;
+
+    std::vector<VideoBufferInfo>   _in_infos;
+    std::vector<const uint8_t *>   _in_mems;
+    VideoBufferInfo                _out_info;
+    uint8_t                       *_out_mem;
+
+    SmartPtr<ThreadPool>           _threads;
+};
+
+}
+
+#endif //XCAM_SOFT_MULTI_GEO_MAPPER_H
@@ -25,9 +25,11 @@
 #include "soft_geo_mapper.h"
 #include "soft_video_buf_allocator.h"
 #include "interface/feature_match.h"
-#include "soft_copy_task.h"
 #include "xcam_utils.h"
 #include <map>
+#include <algorithm>
+#include <vector>
+#include <unistd.h>
 
 #define ENABLE_FEATURE_MATCH HAVE_OPENCV
 
@@ -44,6 +46,9 @@
 #define MAP_FACTOR_X  16
 #define MAP_FACTOR_Y  16
 
+#define SOFT_STITCHER_MAX_FRAMES 2
+#define SOFT_STITCHER_MAX_THREADS 64
+
 // 打开后可在本地生成各种调试文件（拼接输出、LUT 等），默认关闭以免影响性能。
 #define DUMP_STITCHER 1
 #define DUMP_STITCHER_FOLDER "."
@@ -86,7 +91,6 @@ namespace SoftStitcherPriv {
 
 DECLARE_HANDLER_CALLBACK (CbGeoMap, SoftStitcher, geomap_done);
 DECLARE_HANDLER_CALLBACK (CbBlender, SoftStitcher, blender_done);
-DECLARE_WORK_CALLBACK (CbCopyTask, SoftStitcher, copy_task_done);
 
 struct BlenderParam
     : SoftBlender::BlenderParam
@@ -105,29 +109,29 @@ struct BlenderParam
 };
 
 typedef std::map<void*, SmartPtr<BlenderParam>> BlenderParams;
-typedef std::map<void*, int32_t> BlendCopyTaskNums;
+typedef std::map<void*, int32_t> BlendTaskNums;
 
-struct HandlerParam
-    : ImageHandler::Parameters
-{
-    SmartPtr<SoftStitcher::StitcherParam>  stitch_param;
-    uint32_t idx;
+// frame finished out of order, held until all earlier frames are handed over
+struct EndedFrame {
+    SmartPtr<SoftStitcher::StitcherParam>  param;
+    XCamReturn                             error;
+    bool                                   deliver;
 
-    HandlerParam (uint32_t i)
-        : idx (i)
+    EndedFrame ()
+        : error (XCAM_RETURN_NO_ERROR)
+        , deliver (false)
     {}
 };
+typedef std::map<int64_t, EndedFrame> EndedFrames;
 
-struct StitcherCopyArgs
-    : XCamSoftTasks::CopyTask::Args
+struct HandlerParam
+    : SoftGeoMapper::DirectParam
 {
+    SmartPtr<SoftStitcher::StitcherParam>  stitch_param;
     uint32_t idx;
 
-    StitcherCopyArgs (
-        uint32_t i,
-        const SmartPtr<ImageHandler::Parameters> &param)
-        : XCamSoftTasks::CopyTask::Args (param)
-        , idx (i)
+    HandlerParam (uint32_t i)
+        : idx (i)
     {}
 };
 
@@ -147,6 +151,9 @@ struct Overlap {
     SmartPtr<FeatureMatch>       matcher;
     SmartPtr<SoftBlender>        blender;
     BlenderParams                param_map;
+    // merge window in output, geomap areas of left and right cameras read by blender and matcher
+    Rect                         out_area;
+    Rect                         in_areas[2];
 
     SmartPtr<BlenderParam> find_blender_param_in_map (
         const SmartPtr<SoftStitcher::StitcherParam> &key,
@@ -157,23 +164,49 @@ struct Overlap {
 struct FisheyeMap {
     SmartPtr<SoftGeoMapper>      mapper;
     SmartPtr<BufferPool>         buf_pool;
-    FisheyeDewarpMode            dewarp_mode;
-    FisheyeInfo                  fisheye_info;
     Factor                       left_match_factor, right_match_factor;
+    // non-overlap areas remapped into stitched output directly
+    SoftGeoMapDirectAreas        direct_areas;
 
     XCamReturn set_map_table (
-        SoftStitcher *stitcher, const Stitcher::RoundViewSlice &view_slice, uint32_t cam_idx);
+        SoftStitcher *stitcher, Stitcher *geo, const Stitcher::RoundViewSlice &view_slice, uint32_t cam_idx);
 };
 
-struct Copier {
-    SmartPtr<XCamSoftTasks::CopyTask>    copy_task;
-    Stitcher::CopyArea                   copy_area;
+// fisheye maps and overlaps of one calibration, swapped in as a whole
+struct StitchTables
+    : Stitcher::CalibrationTables
+{
+    FisheyeMap              fisheye [XCAM_STITCH_MAX_CAMERAS];
+    Overlap                 overlaps [XCAM_STITCH_MAX_CAMERAS];
+};
 
-    XCamReturn start_copy_task (
-        const SmartPtr<ImageHandler::Parameters> &param,
-        const uint32_t idx, const SmartPtr<VideoBuffer> &buf);
+// viewport work of a frame, shared by frames with the same viewport and tables
+struct StitchRoi
+    : MetaBase
+{
+    XCAM_SLOT_TYPE (StitchRoi, MetaBase);
+
+    Rect                    viewport;
+    bool                    camera [XCAM_STITCH_MAX_CAMERAS];
+    bool                    overlap [XCAM_STITCH_MAX_CAMERAS];
+    Rect                    map_area [XCAM_STITCH_MAX_CAMERAS];
+    SoftGeoMapDirectAreas   direct_areas [XCAM_STITCH_MAX_CAMERAS];
+    // blends, plus cameras feeding no blend
+    int32_t                 task_num;
+
+    explicit StitchRoi (const Rect &vp)
+        : viewport (vp)
+        , task_num (0)
+    {
+        xcam_mem_clear (camera);
+        xcam_mem_clear (overlap);
+    }
+
+    // camera written to output by direct areas only
+    bool is_lone (uint32_t idx, uint32_t camera_num) const {
+        return camera[idx] && !overlap[idx] && !overlap[(idx + camera_num - 1) % camera_num];
+    }
 };
-typedef std::vector<Copier>    Copiers;
 
 class StitcherImpl {
     friend class XCam::SoftStitcher;
@@ -182,9 +215,24 @@ public:
     StitcherImpl (SoftStitcher *handler)
         : _stitcher (handler)
         , _pixel_format (V4L2_PIX_FMT_NV12)
+        , _thread_count (0)
+        , _max_frames (SOFT_STITCHER_MAX_FRAMES)
+        , _frames_in_flight (0)
+        , _next_frame_seq (0)
+        , _next_end_seq (0)
+        , _ending (false)
+        , _frames_stopped (false)
     {}
 
     XCamReturn init_config (uint32_t count);
+    XCamReturn init_reduced_pools (uint32_t width, uint32_t height);
+
+    XCamReturn start_frame (const SmartPtr<SoftStitcher::StitcherParam> &param);
+    SmartPtr<StitchRoi> get_roi ();
+    XCamReturn attach_reduced_outputs (const SmartPtr<SoftStitcher::StitcherParam> &param);
+    void fill_reduced_outputs (const SmartPtr<SoftStitcher::StitcherParam> &param);
+    bool end_frame (const SmartPtr<SoftStitcher::StitcherParam> &param, XCamReturn err, bool deliver);
+    bool pop_ended_frame (EndedFrame &frame);
 
     bool remove_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param);
     int32_t dec_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param);
@@ -194,18 +242,19 @@ public:
     XCamReturn start_overlap_tasks (
         const SmartPtr<SoftStitcher::StitcherParam> &param,
         const uint32_t idx, const SmartPtr<VideoBuffer> &buf);
-    XCamReturn start_copy_tasks (
-        const SmartPtr<SoftStitcher::StitcherParam> &param,
-        const uint32_t idx, const SmartPtr<VideoBuffer> &buf);
 
     XCamReturn start_overlap_task (uint32_t idx, const SmartPtr<BlenderParam> &param);
     XCamReturn stop ();
 
     XCamReturn gen_geomap_table ();
+    XCamReturn prepare_tables (Stitcher *geo, SmartPtr<StitchTables> &tables);
+    void swap_tables (StitchTables &tables);
     XCamReturn start_feature_match (
         const SmartPtr<VideoBuffer> &left_buf, const SmartPtr<VideoBuffer> &right_buf, const uint32_t idx);
 
     bool get_and_reset_feature_match_factors (uint32_t idx, Factor &left, Factor &right);
+    void get_pool_metrics (BufferPool::Metrics &metrics);
+    void reset_pool_metrics ();
     void set_pixel_format (uint32_t format) {
         _pixel_format = format;
     };
@@ -214,85 +263,67 @@ public:
     };
 
 private:
-    SmartPtr<SoftGeoMapper> create_geo_mapper (const Stitcher::RoundViewSlice &view_slice);
-
-    XCamReturn init_fisheye (uint32_t idx);
-    XCamReturn init_blender (uint32_t idx);
-    XCamReturn init_copier (Stitcher::CopyArea area);
+    SmartPtr<SoftGeoMapper> create_geo_mapper (Stitcher *geo, const Stitcher::RoundViewSlice &view_slice);
+
+    XCamReturn init_threads ();
+    // builds tables of geo geometry into fisheye and overlaps
+    XCamReturn init_tables (Stitcher *geo, FisheyeMap *fisheye, Overlap *overlaps);
+    XCamReturn gen_geomap_table (Stitcher *geo, FisheyeMap *fisheye);
+    XCamReturn init_fisheye (Stitcher *geo, FisheyeMap &fisheye, uint32_t idx);
+    XCamReturn init_blender (Stitcher *geo, Overlap &ovl, uint32_t idx);
+    XCamReturn init_direct_area (Stitcher *geo, FisheyeMap *fisheye, Stitcher::CopyArea area);
     bool init_geomap_factors (uint32_t idx);
-    XCamReturn create_copier (Stitcher::CopyArea area);
 
     void calc_factors (
         const uint32_t &idx, const Factor &last_left_factor, const Factor &last_right_factor,
         Factor &cur_left, Factor &cur_right);
 
-    void init_feature_match (uint32_t idx);
+    void init_feature_match (Stitcher *geo, Overlap &ovl, uint32_t idx);
+    SmartPtr<StitchRoi> build_roi (const Rect &viewport);
 
 private:
     StitchInfo              _stitch_info;
     FisheyeMap              _fisheye [XCAM_STITCH_MAX_CAMERAS];
     Overlap                 _overlaps [XCAM_STITCH_MAX_CAMERAS];
-    Copiers                 _copiers;
     SmartPtr<BufferPool>    _geomap_pool;
+    SmartPtr<BufferPool>    _reduced_pools [XCAM_STITCH_MAX_REDUCED_LEVEL + 1];
 
     Mutex                   _map_mutex;
-    BlendCopyTaskNums       _task_counts;
+    BlendTaskNums           _task_counts;
 
     SoftStitcher           *_stitcher;
     uint32_t               _pixel_format;
+
+    // shared by geomap and blender workers, see SoftScheduleMeta
+    SmartPtr<ThreadPool>    _threads;
+    uint32_t                _thread_count;
+
+    Mutex                   _frame_mutex;
+    Cond                    _frame_cond;
+    uint32_t                _max_frames;
+    uint32_t                _frames_in_flight;
+    int64_t                 _next_frame_seq;
+    int64_t                 _next_end_seq;
+    EndedFrames             _ended_frames;
+    bool                    _ending;
+    bool                    _frames_stopped;
+    SmartPtr<StitchRoi>     _roi;
 };
 
 XCamReturn
 FisheyeMap::set_map_table (
-    SoftStitcher *stitcher, const Stitcher::RoundViewSlice &view_slice, uint32_t cam_idx)
+    SoftStitcher *stitcher, Stitcher *geo, const Stitcher::RoundViewSlice &view_slice, uint32_t cam_idx)
 {
-    // 根据去畸变模式选择 PolyBowl/Sphere 实现，并生成当前摄像头的查找表。
-    SmartPtr<FisheyeDewarp> dewarper;
-    if(dewarp_mode == DewarpBowl) {
-        BowlDataConfig bowl = stitcher->get_bowl_config ();
-        bowl.angle_start = view_slice.hori_angle_start;
-        bowl.angle_end = format_angle (view_slice.hori_angle_start + view_slice.hori_angle_range);
-        if (bowl.angle_end < bowl.angle_start)
-            bowl.angle_start -= 360.0f;
-
-        XCAM_LOG_DEBUG (
-            "soft-stitcher:%s camera(idx:%d) info(angle start:%.2f, range:%.2f), bowl_info(angle start%.2f, end:%.2f)",
-            XCAM_STR (stitcher->get_name ()), cam_idx,
-            view_slice.hori_angle_start, view_slice.hori_angle_range, bowl.angle_start, bowl.angle_end);
-
-        CameraInfo cam_info;
-        stitcher->get_camera_info (cam_idx, cam_info);
-
-        SmartPtr<PolyBowlFisheyeDewarp> fd = new PolyBowlFisheyeDewarp ();
-        fd->set_intr_param (cam_info.calibration.intrinsic);
-        fd->set_extr_param (cam_info.calibration.extrinsic);
-        fd->set_bowl_config (bowl);
-        dewarper = fd;
-    } else {
-        float max_dst_latitude = (fisheye_info.intrinsic.fov > 180.0f) ? 180.0f : fisheye_info.intrinsic.fov;
-        float max_dst_longitude;
-
-        max_dst_longitude = max_dst_latitude * view_slice.width / view_slice.height;
-
-        SmartPtr<SphereFisheyeDewarp> fd = new SphereFisheyeDewarp ();
-        fd->set_fisheye_info (fisheye_info);
-        fd->set_dst_range (max_dst_longitude, max_dst_latitude);
-        dewarper = fd;
-    }
-    XCAM_FAIL_RETURN (
-        ERROR, dewarper.ptr (), XCAM_RETURN_ERROR_MEM,
-        "soft-stitcher:%s fisheye dewarper is NULL", XCAM_STR (stitcher->get_name ()));
-
-    dewarper->set_out_size (view_slice.width, view_slice.height);
-
     uint32_t table_width = view_slice.width / MAP_FACTOR_X;
     table_width = XCAM_ALIGN_UP (table_width, 4);
     uint32_t table_height = view_slice.height / MAP_FACTOR_Y;
     table_height = XCAM_ALIGN_UP (table_height, 2);
-    dewarper->set_table_size (table_width, table_height);
 
-    FisheyeDewarp::MapTable map_table (table_width * table_height);
-    dewarper->gen_table (map_table);
+    FisheyeDewarp::MapTable map_table;
+    XCamReturn ret = geo->gen_fisheye_table (cam_idx, table_width, table_height, map_table);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s gen fisheye table failed, idx:%d", XCAM_STR (stitcher->get_name ()), cam_idx);
 
     char prefix[XCAM_MAX_STR_SIZE] = {0};
     snprintf (prefix, XCAM_MAX_STR_SIZE, "fisheye-lut-%dx%d", table_width, table_height);
@@ -380,19 +411,19 @@ StitcherImpl::get_and_reset_feature_match_factors (uint32_t idx, Factor &left, F
 }
 
 SmartPtr<SoftGeoMapper>
-StitcherImpl::create_geo_mapper (const Stitcher::RoundViewSlice &view_slice)
+StitcherImpl::create_geo_mapper (Stitcher *geo, const Stitcher::RoundViewSlice &view_slice)
 {
     SmartPtr<SoftGeoMapper> mapper;
     // 根据缩放模式选择不同 GeoMapper 实现：SingleConst/ DualConst/ DualCurve。
-    if (_stitcher->get_scale_mode () == ScaleSingleConst)
+    if (geo->get_scale_mode () == ScaleSingleConst)
         mapper = new SoftGeoMapper ("stitcher_remapper");
-    else if (_stitcher->get_scale_mode () == ScaleDualConst)
+    else if (geo->get_scale_mode () == ScaleDualConst)
         mapper = new SoftDualConstGeoMapper ("stitcher_dualconst_remapper");
     else {
         SmartPtr<SoftDualCurveGeoMapper> geomap = new SoftDualCurveGeoMapper ("stitcher_dualcurve_remapper");
         XCAM_ASSERT (geomap.ptr ());
 
-        BowlDataConfig bowl = _stitcher->get_bowl_config ();
+        BowlDataConfig bowl = geo->get_bowl_config ();
         float scaled_height = (bowl.wall_height + bowl.ground_length / 2.0f) /
                               (bowl.wall_height + bowl.ground_length) * view_slice.height;
 
@@ -405,18 +436,12 @@ StitcherImpl::create_geo_mapper (const Stitcher::RoundViewSlice &view_slice)
 }
 
 XCamReturn
-StitcherImpl::init_fisheye (uint32_t idx)
+StitcherImpl::init_fisheye (Stitcher *geo, FisheyeMap &fisheye, uint32_t idx)
 {
-    FisheyeMap &fisheye = _fisheye[idx];
-    fisheye.dewarp_mode = _stitcher->get_dewarp_mode ();
-    if (fisheye.dewarp_mode == DewarpSphere) {
-        fisheye.fisheye_info = _stitch_info.fisheye_info[idx];
-    }
-
-    Stitcher::RoundViewSlice view_slice = _stitcher->get_round_view_slice (idx);
+    Stitcher::RoundViewSlice view_slice = geo->get_round_view_slice (idx);
 
     SmartPtr<ImageHandler::Callback> geomap_cb = new CbGeoMap (_stitcher);
-    fisheye.mapper = create_geo_mapper (view_slice);
+    fisheye.mapper = create_geo_mapper (geo, view_slice);
     fisheye.mapper->set_callback (geomap_cb);
 
     VideoBufferInfo buf_info;
@@ -430,72 +455,50 @@ StitcherImpl::init_fisheye (uint32_t idx)
     XCAM_ASSERT (pool.ptr ());
     fisheye.buf_pool = pool;
     XCAM_FAIL_RETURN (
-        ERROR, fisheye.buf_pool->reserve (2), XCAM_RETURN_ERROR_MEM,
+        ERROR, fisheye.buf_pool->reserve (XCAM_MAX (_max_frames, 2u)), XCAM_RETURN_ERROR_MEM,
         "stitcher:%s reserve geomap buffer pool(w:%d,h:%d) failed",
         XCAM_STR (_stitcher->get_name ()), buf_info.width, buf_info.height);
 
     return XCAM_RETURN_NO_ERROR;
 }
 
-XCamReturn
-StitcherImpl::create_copier (Stitcher::CopyArea area)
-{
-    XCAM_FAIL_RETURN (
-        ERROR,
-        area.in_idx != INVALID_INDEX &&
-        area.in_area.width == area.out_area.width && area.in_area.height == area.out_area.height,
-        XCAM_RETURN_ERROR_PARAM,
-        "stitcher: copy area (idx:%d) is invalid", area.in_idx);
-
-    SmartPtr<Worker::Callback> copy_cb = new CbCopyTask (_stitcher);
-    XCAM_ASSERT (copy_cb.ptr ());
-
-    Copier copier;
-    copier.copy_task = new XCamSoftTasks::CopyTask (copy_cb);
-    XCAM_ASSERT (copier.copy_task.ptr ());
-    copier.copy_area = area;
-    _copiers.push_back (copier);
-
-    return XCAM_RETURN_NO_ERROR;
-}
-
 void
-StitcherImpl::init_feature_match (uint32_t idx)
+StitcherImpl::init_feature_match (Stitcher *geo, Overlap &ovl, uint32_t idx)
 {
 #if ENABLE_FEATURE_MATCH
 
     // 按命令行指定的模式创建不同的特征匹配器（默认/聚类/C API），并配置裁剪区域。
 #ifndef ANDROID
-    FeatureMatchMode fm_mode = _stitcher->get_fm_mode ();
+    FeatureMatchMode fm_mode = geo->get_fm_mode ();
     if (fm_mode == FMNone)
         return ;
     else if (fm_mode == FMDefault)
-        _overlaps[idx].matcher = FeatureMatch::create_default_feature_match ();
+        ovl.matcher = FeatureMatch::create_default_feature_match ();
     else if (fm_mode == FMCluster)
-        _overlaps[idx].matcher = FeatureMatch::create_cluster_feature_match ();
+        ovl.matcher = FeatureMatch::create_cluster_feature_match ();
 #if OPENCV_VERSION3
     else if (fm_mode == FMCapi)
-        _overlaps[idx].matcher = FeatureMatch::create_capi_feature_match ();
+        ovl.matcher = FeatureMatch::create_capi_feature_match ();
 #endif
     else {
         XCAM_LOG_ERROR ("unsupported FeatureMatchMode: %d", fm_mode);
         XCAM_ASSERT (false);
     }
 #else
-    _overlaps[idx].matcher = new CVCapiFeatureMatch;
+    ovl.matcher = new CVCapiFeatureMatch;
 #endif
-    XCAM_ASSERT (_overlaps[idx].matcher.ptr ());
+    XCAM_ASSERT (ovl.matcher.ptr ());
 
-    _overlaps[idx].matcher->set_config (_stitcher->get_fm_config ());
-    _overlaps[idx].matcher->set_fm_index (idx);
+    ovl.matcher->set_config (geo->get_fm_config ());
+    ovl.matcher->set_fm_index (idx);
 
-    const BowlDataConfig bowl = _stitcher->get_bowl_config ();
-    const Stitcher::ImageOverlapInfo &info = _stitcher->get_overlap (idx);
+    const BowlDataConfig bowl = geo->get_bowl_config ();
+    const Stitcher::ImageOverlapInfo &info = geo->get_overlap (idx);
     Rect left_ovlap = info.left;
     Rect right_ovlap = info.right;
 
-    if (_stitcher->get_dewarp_mode () == DewarpSphere) {
-        const FMRegionRatio &ratio = _stitcher->get_fm_region_ratio ();
+    if (geo->get_dewarp_mode () == DewarpSphere) {
+        const FMRegionRatio &ratio = geo->get_fm_region_ratio ();
 
         left_ovlap.pos_y = left_ovlap.height * ratio.pos_y;
         left_ovlap.height = left_ovlap.height * ratio.height;
@@ -507,7 +510,7 @@ StitcherImpl::init_feature_match (uint32_t idx)
         right_ovlap.pos_y = 0;
         right_ovlap.height = left_ovlap.height;
     }
-    _overlaps[idx].matcher->set_crop_rect (left_ovlap, right_ovlap);
+    ovl.matcher->set_crop_rect (left_ovlap, right_ovlap);
 #else
     XCAM_LOG_ERROR ("FeatureMatch unsupported");
     XCAM_ASSERT (false);
@@ -515,20 +518,20 @@ StitcherImpl::init_feature_match (uint32_t idx)
 }
 
 XCamReturn
-StitcherImpl::init_blender (uint32_t idx)
+StitcherImpl::init_blender (Stitcher *geo, Overlap &ovl, uint32_t idx)
 {
-    _overlaps[idx].blender = create_soft_blender ().dynamic_cast_ptr<SoftBlender>();
-    XCAM_ASSERT (_overlaps[idx].blender.ptr ());
+    ovl.blender = create_soft_blender ().dynamic_cast_ptr<SoftBlender>();
+    XCAM_ASSERT (ovl.blender.ptr ());
 
-    _overlaps[idx].blender->set_pyr_levels (_stitcher->get_blend_pyr_levels ());
+    ovl.blender->set_pyr_levels (geo->get_blend_pyr_levels ());
 
     uint32_t out_width, out_height;
-    _stitcher->get_output_size (out_width, out_height);
-    _overlaps[idx].blender->set_output_size (out_width, out_height);
+    geo->get_output_size (out_width, out_height);
+    ovl.blender->set_output_size (out_width, out_height);
 
-    const Stitcher::ImageOverlapInfo overlap_info = _stitcher->get_overlap (idx);
+    const Stitcher::ImageOverlapInfo overlap_info = geo->get_overlap (idx);
     Stitcher::ImageOverlapInfo overlap = overlap_info;
-    if (_stitcher->get_dewarp_mode () == DewarpSphere && _stitch_info.merge_width[idx] > 0) {
+    if (geo->get_dewarp_mode () == DewarpSphere && _stitch_info.merge_width[idx] > 0) {
         uint32_t specific_merge_width = _stitch_info.merge_width[idx];
         XCAM_ASSERT (uint32_t (overlap.left.width) >= specific_merge_width);
 
@@ -542,27 +545,38 @@ StitcherImpl::init_blender (uint32_t idx)
         overlap.out_area.pos_x += ext_width;
         overlap.out_area.width = specific_merge_width;
     }
-    _overlaps[idx].blender->set_merge_window (overlap.out_area);
-    _overlaps[idx].blender->set_input_valid_area (overlap.left, 0);
-    _overlaps[idx].blender->set_input_valid_area (overlap.right, 1);
-    _overlaps[idx].blender->set_input_merge_area (overlap.left, 0);
-    _overlaps[idx].blender->set_input_merge_area (overlap.right, 1);
+    ovl.out_area = overlap.out_area;
+    ovl.in_areas[0] = overlap_info.left;
+    ovl.in_areas[1] = overlap_info.right;
+
+    ovl.blender->set_merge_window (overlap.out_area);
+    ovl.blender->set_input_valid_area (overlap.left, 0);
+    ovl.blender->set_input_valid_area (overlap.right, 1);
+    ovl.blender->set_input_merge_area (overlap.left, 0);
+    ovl.blender->set_input_merge_area (overlap.right, 1);
 
     SmartPtr<ImageHandler::Callback> blender_cb = new CbBlender (_stitcher);
     XCAM_ASSERT (blender_cb.ptr ());
-    _overlaps[idx].blender->set_callback (blender_cb);
+    ovl.blender->set_callback (blender_cb);
 
-    _overlaps[idx].param_map.clear ();
+    ovl.param_map.clear ();
 
     return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
-StitcherImpl::init_copier (Stitcher::CopyArea area)
+StitcherImpl::init_direct_area (Stitcher *geo, FisheyeMap *fisheye, Stitcher::CopyArea area)
 {
-    if (_stitcher->get_dewarp_mode () == DewarpSphere && _stitch_info.merge_width[area.in_idx] > 0) {
+    XCAM_FAIL_RETURN (
+        ERROR,
+        area.in_idx != INVALID_INDEX &&
+        area.in_area.width == area.out_area.width && area.in_area.height == area.out_area.height,
+        XCAM_RETURN_ERROR_PARAM,
+        "stitcher: copy area (idx:%d) is invalid", area.in_idx);
+
+    if (geo->get_dewarp_mode () == DewarpSphere && _stitch_info.merge_width[area.in_idx] > 0) {
         uint32_t specific_merge_width = _stitch_info.merge_width[area.in_idx];
-        const Stitcher::ImageOverlapInfo overlap_info = _stitcher->get_overlap (area.in_idx);
+        const Stitcher::ImageOverlapInfo overlap_info = geo->get_overlap (area.in_idx);
         XCAM_ASSERT (uint32_t (overlap_info.left.width) >= specific_merge_width);
 
         uint32_t ext_width = (overlap_info.left.width - specific_merge_width) / 2;
@@ -577,59 +591,612 @@ StitcherImpl::init_copier (Stitcher::CopyArea area)
         }
     }
 
-    XCAM_LOG_DEBUG ("soft-stitcher:copy area (idx:%d) input area(%d, %d, %d, %d) output area(%d, %d, %d, %d)",
-                    area.in_idx,
-                    area.in_area.pos_x, area.in_area.pos_y, area.in_area.width, area.in_area.height,
-                    area.out_area.pos_x, area.out_area.pos_y, area.out_area.width, area.out_area.height);
+    // columns also read by blender and feature match stay in the geomap buffer,
+    // split them out as shared areas
+    uint32_t camera_num = geo->get_camera_num ();
+    const Rect tail_ovlap = geo->get_overlap (area.in_idx).left;
+    const Rect head_ovlap = geo->get_overlap ((area.in_idx + camera_num - 1) % camera_num).right;
+
+    int32_t start = area.in_area.pos_x;
+    int32_t end = area.in_area.pos_x + area.in_area.width;
+    int32_t cuts[] = {
+        head_ovlap.pos_x, head_ovlap.pos_x + head_ovlap.width,
+        tail_ovlap.pos_x, tail_ovlap.pos_x + tail_ovlap.width, end
+    };
+    const uint32_t cut_num = sizeof (cuts) / sizeof (cuts[0]);
+    std::sort (cuts, cuts + cut_num);
+
+    for (uint32_t i = 0; i < cut_num && start < end; ++i) {
+        if (cuts[i] <= start)
+            continue;
+
+        int32_t cut = XCAM_MIN (cuts[i], end);
+        int32_t mid = (start + cut) / 2;
+        SoftGeoMapDirectArea direct;
+        direct.in_area = Rect (start, area.in_area.pos_y, cut - start, area.in_area.height);
+        direct.out_area = Rect (
+            area.out_area.pos_x + start - area.in_area.pos_x, area.out_area.pos_y, cut - start, area.out_area.height);
+        direct.shared =
+            (mid >= head_ovlap.pos_x && mid < head_ovlap.pos_x + head_ovlap.width) ||
+            (mid >= tail_ovlap.pos_x && mid < tail_ovlap.pos_x + tail_ovlap.width);
+        fisheye[area.in_idx].direct_areas.push_back (direct);
 
-    XCamReturn ret = create_copier (area);
-    XCAM_FAIL_RETURN (
-        ERROR, xcam_ret_is_ok (ret), ret,
-        "soft-stitcher::%s create copier failed, idx:%d.", XCAM_STR (_stitcher->get_name ()), area.in_idx);
+        XCAM_LOG_DEBUG (
+            "soft-stitcher:direct area (idx:%d) input area(%d, %d, %d, %d) output area(%d, %d, %d, %d)%s",
+            area.in_idx,
+            direct.in_area.pos_x, direct.in_area.pos_y, direct.in_area.width, direct.in_area.height,
+            direct.out_area.pos_x, direct.out_area.pos_y, direct.out_area.width, direct.out_area.height,
+            direct.shared ? " shared" : "");
+        start = cut;
+    }
 
     return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
-StitcherImpl::init_config (uint32_t count)
+StitcherImpl::init_threads ()
 {
-    if (_stitcher->get_dewarp_mode () == DewarpSphere) {
-        _stitch_info = _stitcher->get_stitch_info ();
+    uint32_t count = _thread_count;
+    if (count == 0) {
+        long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+        count = XCAM_CLAMP (cpus, 1, SOFT_STITCHER_MAX_THREADS);
     }
 
+    if (_threads.ptr ())
+        _threads->stop ();
+    _threads = new ThreadPool ("soft-stitch-thrs");
+    XCAM_ASSERT (_threads.ptr ());
+    _threads->set_threads (count, count);
+    _threads->set_role (ThreadRoleStitch);
+    XCamReturn ret = _threads->start ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s start %d threads failed", XCAM_STR (_stitcher->get_name ()), count);
+
+    SmartLock locker (_frame_mutex);
+    _frames_stopped = false;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::init_tables (Stitcher *geo, FisheyeMap *fisheye, Overlap *overlaps)
+{
+    uint32_t count = geo->get_camera_num ();
     for (uint32_t i = 0; i < count; ++i) {
-        XCamReturn ret = init_fisheye (i);
+        XCamReturn ret = init_fisheye (geo, fisheye[i], i);
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
             "soft-stitcher:%s init fisheye failed, idx:%d.", XCAM_STR (_stitcher->get_name ()), i);
 
 #if ENABLE_FEATURE_MATCH
-        init_feature_match (i);
+        init_feature_match (geo, overlaps[i], i);
 #endif
 
-        init_blender (i);
+        init_blender (geo, overlaps[i], i);
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        fisheye[i].direct_areas.clear ();
     }
 
-    Stitcher::CopyAreaArray areas = _stitcher->get_copy_area ();
+    Stitcher::CopyAreaArray areas = geo->get_copy_area ();
     uint32_t size = areas.size ();
     for (uint32_t i = 0; i < size; ++i) {
-        XCAM_ASSERT (areas[i].in_idx < size);
+        XCAM_ASSERT (areas[i].in_idx < count);
 
-        XCamReturn ret = init_copier (areas[i]);
+        XCamReturn ret = init_direct_area (geo, fisheye, areas[i]);
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
-            "soft-stitcher:%s init copyer failed, idx:%d.", XCAM_STR (_stitcher->get_name ()), areas[i].in_idx);
+            "soft-stitcher:%s init direct area failed, idx:%d.", XCAM_STR (_stitcher->get_name ()), areas[i].in_idx);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::init_config (uint32_t count)
+{
+    XCAM_ASSERT (count == _stitcher->get_camera_num ());
+    XCAM_UNUSED (count);
+
+    if (_stitcher->get_dewarp_mode () == DewarpSphere) {
+        _stitch_info = _stitcher->get_stitch_info ();
     }
 
+    XCamReturn ret = init_threads ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s init threads failed", XCAM_STR (_stitcher->get_name ()));
+
+    return init_tables (_stitcher, _fisheye, _overlaps);
+}
+
+XCamReturn
+StitcherImpl::init_reduced_pools (uint32_t width, uint32_t height)
+{
+    uint32_t levels = _stitcher->get_reduced_outputs ();
+    for (uint32_t level = 1; level <= XCAM_STITCH_MAX_REDUCED_LEVEL; ++level) {
+        if (!(levels & (1 << level)))
+            continue;
+
+        // reduced chroma stays whole
+        uint32_t align = 2 << level;
+        XCAM_FAIL_RETURN (
+            ERROR, !(width % align) && !(height % align), XCAM_RETURN_ERROR_PARAM,
+            "soft-stitcher:%s output size(%dx%d) does not fit reduced output level:%d",
+            XCAM_STR (_stitcher->get_name ()), width, height, level);
+
+        VideoBufferInfo info;
+        uint32_t reduced_width = width >> level;
+        uint32_t reduced_height = height >> level;
+        info.init (
+            get_pixel_format (), reduced_width, reduced_height,
+            XCAM_ALIGN_UP (reduced_width, SOFT_STITCHER_ALIGNMENT_X),
+            XCAM_ALIGN_UP (reduced_height, SOFT_STITCHER_ALIGNMENT_Y));
+
+        SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+        XCAM_ASSERT (pool.ptr ());
+        _reduced_pools[level] = pool;
+        XCAM_FAIL_RETURN (
+            ERROR, pool->reserve (XCAM_MAX (_max_frames, 2u)), XCAM_RETURN_ERROR_MEM,
+            "soft-stitcher:%s reserve reduced buffer pool(w:%d,h:%d) failed",
+            XCAM_STR (_stitcher->get_name ()), info.width, info.height);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::prepare_tables (Stitcher *geo, SmartPtr<StitchTables> &tables)
+{
+    SmartPtr<StitchTables> staged = new StitchTables;
+    XCAM_ASSERT (staged.ptr ());
+
+    XCamReturn ret = init_tables (geo, staged->fisheye, staged->overlaps);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s init staged tables failed", XCAM_STR (_stitcher->get_name ()));
+
+    ret = gen_geomap_table (geo, staged->fisheye);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s gen staged geomap table failed", XCAM_STR (_stitcher->get_name ()));
+
+    tables = staged;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+StitcherImpl::swap_tables (StitchTables &tables)
+{
+    uint32_t cam_num = _stitcher->get_camera_num ();
+    for (uint32_t i = 0; i < cam_num; ++i) {
+        std::swap (_fisheye[i], tables.fisheye[i]);
+        std::swap (_overlaps[i], tables.overlaps[i]);
+
+        // no frame in flight, retired handlers are idle
+        if (tables.fisheye[i].mapper.ptr ())
+            tables.fisheye[i].mapper->terminate ();
+        if (tables.fisheye[i].buf_pool.ptr ())
+            tables.fisheye[i].buf_pool->stop ();
+        if (tables.overlaps[i].blender.ptr ())
+            tables.overlaps[i].blender->terminate ();
+    }
+    _roi.release ();
+}
+
+static inline bool
+is_same_rect (const Rect &a, const Rect &b)
+{
+    return a.pos_x == b.pos_x && a.pos_y == b.pos_y && a.width == b.width && a.height == b.height;
+}
+
+static inline bool
+clip_rect (const Rect &area, const Rect &clip, Rect &out)
+{
+    int32_t x0 = XCAM_MAX (area.pos_x, clip.pos_x);
+    int32_t y0 = XCAM_MAX (area.pos_y, clip.pos_y);
+    int32_t x1 = XCAM_MIN (area.pos_x + area.width, clip.pos_x + clip.width);
+    int32_t y1 = XCAM_MIN (area.pos_y + area.height, clip.pos_y + clip.height);
+    if (x0 >= x1 || y0 >= y1)
+        return false;
+
+    out = Rect (x0, y0, x1 - x0, y1 - y0);
+    return true;
+}
+
+// grows area to the bounding box of area and other
+static inline void
+merge_rect (Rect &area, const Rect &other)
+{
+    if (area.width <= 0 || area.height <= 0) {
+        area = other;
+        return;
+    }
+
+    int32_t x0 = XCAM_MIN (area.pos_x, other.pos_x);
+    int32_t y0 = XCAM_MIN (area.pos_y, other.pos_y);
+    int32_t x1 = XCAM_MAX (area.pos_x + area.width, other.pos_x + other.width);
+    int32_t y1 = XCAM_MAX (area.pos_y + area.height, other.pos_y + other.height);
+    area = Rect (x0, y0, x1 - x0, y1 - y0);
+}
+
+// viewport aligned to 2 pixels, split in two where it wraps around the right edge
+static uint32_t
+split_viewport (const Rect &viewport, uint32_t out_width, uint32_t out_height, Rect *rects)
+{
+    int32_t width = out_width, height = out_height;
+    int32_t pos_x = viewport.pos_x % width;
+    int32_t x0 = XCAM_ALIGN_DOWN (pos_x, 2);
+    int32_t x1 = XCAM_MIN (XCAM_ALIGN_UP (pos_x + viewport.width, 2), x0 + width);
+    int32_t y0 = XCAM_MIN (XCAM_ALIGN_DOWN (viewport.pos_y, 2), height);
+    int32_t y1 = XCAM_MIN (XCAM_ALIGN_UP (viewport.pos_y + viewport.height, 2), height);
+    if (y0 >= y1)
+        return 0;
+
+    if (x1 <= width) {
+        rects[0] = Rect (x0, y0, x1 - x0, y1 - y0);
+        return 1;
+    }
+
+    rects[0] = Rect (x0, y0, width - x0, y1 - y0);
+    rects[1] = Rect (0, y0, x1 - width, y1 - y0);
+    return 2;
+}
+
+SmartPtr<StitchRoi>
+StitcherImpl::build_roi (const Rect &viewport)
+{
+    uint32_t out_width, out_height;
+    _stitcher->get_output_size (out_width, out_height);
+    Rect rects[2];
+    uint32_t rect_num = split_viewport (viewport, out_width, out_height, rects);
+
+    SmartPtr<StitchRoi> roi = new StitchRoi (viewport);
+    XCAM_ASSERT (roi.ptr ());
+
+    // an overlap intersecting the viewport is blended whole, with both cameras
+    Rect clipped;
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        for (uint32_t r = 0; r < rect_num && !roi->overlap[i]; ++r)
+            roi->overlap[i] = clip_rect (_overlaps[i].out_area, rects[r], clipped);
+        if (!roi->overlap[i])
+            continue;
+
+        uint32_t next_idx = (i + 1) % camera_num;
+        roi->camera[i] = true;
+        roi->camera[next_idx] = true;
+        merge_rect (roi->map_area[i], _overlaps[i].in_areas[0]);
+        merge_rect (roi->map_area[next_idx], _overlaps[i].in_areas[1]);
+        ++roi->task_num;
+    }
+
+    // direct areas are clipped to the viewport
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        const SoftGeoMapDirectAreas &areas = _fisheye[i].direct_areas;
+        for (uint32_t a = 0; a < areas.size (); ++a) {
+            for (uint32_t r = 0; r < rect_num; ++r) {
+                if (!clip_rect (areas[a].out_area, rects[r], clipped))
+                    continue;
+
+                SoftGeoMapDirectArea direct = areas[a];
+                direct.in_area = Rect (
+                    areas[a].in_area.pos_x + clipped.pos_x - areas[a].out_area.pos_x,
+                    areas[a].in_area.pos_y + clipped.pos_y - areas[a].out_area.pos_y,
+                    clipped.width, clipped.height);
+                direct.out_area = clipped;
+                roi->direct_areas[i].push_back (direct);
+                merge_rect (roi->map_area[i], direct.in_area);
+            }
+        }
+
+        if (!roi->camera[i] && !roi->direct_areas[i].empty ()) {
+            roi->camera[i] = true;
+            ++roi->task_num;
+        }
+    }
+
+    XCAM_LOG_DEBUG (
+        "soft-stitcher:%s viewport(%d, %d, %d, %d) takes %d tasks",
+        XCAM_STR (_stitcher->get_name ()),
+        viewport.pos_x, viewport.pos_y, viewport.width, viewport.height, roi->task_num);
+
+    return roi;
+}
+
+SmartPtr<StitchRoi>
+StitcherImpl::get_roi ()
+{
+    Rect viewport;
+    if (!_stitcher->complete_stitch () || !_stitcher->get_viewport (viewport))
+        return NULL;
+
+    if (!_roi.ptr () || !is_same_rect (_roi->viewport, viewport))
+        _roi = build_roi (viewport);
+
+    return _roi;
+}
+
+XCamReturn
+StitcherImpl::attach_reduced_outputs (const SmartPtr<SoftStitcher::StitcherParam> &param)
+{
+    uint32_t levels = _stitcher->get_reduced_outputs ();
+    if (!levels || !_stitcher->complete_stitch ())
+        return XCAM_RETURN_NO_ERROR;
+
+    const SmartPtr<VideoBuffer> &out_buf = param->out_buf;
+    XCAM_ASSERT (out_buf.ptr ());
+    const VideoBufferInfo &out_info = out_buf->get_video_info ();
+
+    SmartPtr<StitchReducedOutputs> reduced = out_buf->find_typed_metadata<StitchReducedOutputs> ();
+    if (!reduced.ptr ()) {
+        reduced = new StitchReducedOutputs;
+        XCAM_ASSERT (reduced.ptr ());
+        out_buf->add_metadata (reduced);
+    }
+
+    for (uint32_t level = 1; level <= XCAM_STITCH_MAX_REDUCED_LEVEL; ++level) {
+        if (!(levels & (1 << level)))
+            continue;
+
+        SmartPtr<VideoBuffer> &buf = reduced->bufs[level];
+        if (!buf.ptr ()) {
+            XCAM_ASSERT (_reduced_pools[level].ptr ());
+            buf = _reduced_pools[level]->get_buffer ();
+            XCAM_FAIL_RETURN (
+                ERROR, buf.ptr (), XCAM_RETURN_ERROR_MEM,
+                "soft-stitcher:%s get reduced buffer of level:%d failed",
+                XCAM_STR (_stitcher->get_name ()), level);
+        }
+
+        const VideoBufferInfo &info = buf->get_video_info ();
+        XCAM_FAIL_RETURN (
+            ERROR,
+            info.format == out_info.format &&
+            info.width >= (out_info.width >> level) && info.height >= (out_info.height >> level),
+            XCAM_RETURN_ERROR_PARAM,
+            "soft-stitcher:%s reduced buffer of level:%d invalid, format:%s size(%dx%d)",
+            XCAM_STR (_stitcher->get_name ()), level,
+            xcam_fourcc_to_string (info.format), info.width, info.height);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+struct ReducedPlane {
+    uint8_t    *ptr;
+    uint32_t    stride;
+
+    ReducedPlane () : ptr (NULL), stride (0) {}
+};
+
+/*
+ * One read of the plane: 2x2 block sums are folded level by level, 255 * 4^4 still
+ * fits uint16, so every level is the rounded mean of its 2^level x 2^level block.
+ * area is in samples of the plane, aligned to 2^max_level.
+ */
+static void
+reduce_plane (
+    const uint8_t *src, uint32_t src_stride, const Rect &area, uint32_t channels,
+    const ReducedPlane *dsts, uint32_t max_level, std::vector<uint16_t> *sums)
+{
+    uint32_t width = (area.width >> 1) * channels;
+    uint32_t height = area.height >> 1;
+    std::vector<uint16_t> *cur = &sums[0], *next = &sums[1];
+
+    cur->resize (width * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t *row0 = src + (area.pos_y + 2 * y) * src_stride + area.pos_x * channels;
+        const uint8_t *row1 = row0 + src_stride;
+        uint16_t *out = cur->data () + y * width;
+        for (uint32_t x = 0; x < width; x += channels) {
+            for (uint32_t c = 0; c < channels; ++c) {
+                uint32_t i = 2 * x + c;
+                out[x + c] = row0[i] + row0[i + channels] + row1[i] + row1[i + channels];
+            }
+        }
+    }
+
+    for (uint32_t level = 1; level <= max_level; ++level) {
+        if (level > 1) {
+            uint32_t next_width = (width >> 1) / channels * channels;
+            uint32_t next_height = height >> 1;
+            next->resize (next_width * next_height);
+            for (uint32_t y = 0; y < next_height; ++y) {
+                const uint16_t *row0 = cur->data () + 2 * y * width;
+                const uint16_t *row1 = row0 + width;
+                uint16_t *out = next->data () + y * next_width;
+                for (uint32_t x = 0; x < next_width; x += channels) {
+                    for (uint32_t c = 0; c < channels; ++c) {
+                        uint32_t i = 2 * x + c;
+                        out[x + c] = row0[i] + row0[i + channels] + row1[i] + row1[i + channels];
+                    }
+                }
+            }
+            std::swap (cur, next);
+            width = next_width;
+            height = next_height;
+        }
+
+        const ReducedPlane &dst = dsts[level];
+        if (!dst.ptr)
+            continue;
+
+        uint32_t shift = 2 * level;
+        uint32_t half = 1 << (shift - 1);
+        for (uint32_t y = 0; y < height; ++y) {
+            const uint16_t *in = cur->data () + y * width;
+            uint8_t *out = dst.ptr + ((area.pos_y >> level) + y) * dst.stride + (area.pos_x >> level) * channels;
+            for (uint32_t x = 0; x < width; ++x)
+                out[x] = (in[x] + half) >> shift;
+        }
+    }
+}
+
+void
+StitcherImpl::fill_reduced_outputs (const SmartPtr<SoftStitcher::StitcherParam> &param)
+{
+    if (!_stitcher->get_reduced_outputs () || !_stitcher->complete_stitch ())
+        return;
+
+    const SmartPtr<VideoBuffer> &out_buf = param->out_buf;
+    SmartPtr<StitchReducedOutputs> reduced = out_buf->find_typed_metadata<StitchReducedOutputs> ();
+    if (!reduced.ptr ())
+        return;
+
+    uint32_t max_level = 0;
+    for (uint32_t level = 1; level <= XCAM_STITCH_MAX_REDUCED_LEVEL; ++level) {
+        if (reduced->bufs[level].ptr ())
+            max_level = level;
+    }
+    if (!max_level)
+        return;
+
+    uint32_t out_width, out_height;
+    _stitcher->get_output_size (out_width, out_height);
+
+    // blocks on the viewport edge also average what the output holds outside it
+    Rect rects[2];
+    uint32_t rect_num = 1;
+    rects[0] = Rect (0, 0, out_width, out_height);
+    SmartPtr<StitchRoi> roi = param->find_meta<StitchRoi> ();
+    if (roi.ptr ())
+        rect_num = split_viewport (roi->viewport, out_width, out_height, rects);
+
+    // output size is a multiple of 2^(max_level + 1), so is each rect and its chroma
+    int32_t align = 2 << max_level;
+    for (uint32_t r = 0; r < rect_num; ++r) {
+        int32_t x0 = XCAM_ALIGN_DOWN (rects[r].pos_x, align);
+        int32_t y0 = XCAM_ALIGN_DOWN (rects[r].pos_y, align);
+        int32_t x1 = XCAM_ALIGN_UP (rects[r].pos_x + rects[r].width, align);
+        int32_t y1 = XCAM_ALIGN_UP (rects[r].pos_y + rects[r].height, align);
+        rects[r] = Rect (x0, y0, x1 - x0, y1 - y0);
+    }
+
+    ReducedPlane planes[3][XCAM_STITCH_MAX_REDUCED_LEVEL + 1];
+    for (uint32_t level = 1; level <= max_level; ++level) {
+        const SmartPtr<VideoBuffer> &buf = reduced->bufs[level];
+        if (!buf.ptr ())
+            continue;
+
+        const VideoBufferInfo &info = buf->get_video_info ();
+        uint8_t *ptr = buf->map ();
+        XCAM_ASSERT (ptr);
+        for (uint32_t plane = 0; plane < info.components && plane < 3; ++plane) {
+            planes[plane][level].ptr = ptr + info.offsets[plane];
+            planes[plane][level].stride = info.strides[plane];
+        }
+    }
+
+    const VideoBufferInfo &out_info = out_buf->get_video_info ();
+    const uint8_t *src = out_buf->map ();
+    XCAM_ASSERT (src);
+
+    std::vector<uint16_t> sums[2];
+    for (uint32_t r = 0; r < rect_num; ++r) {
+        const Rect &rect = rects[r];
+        Rect chroma (rect.pos_x / 2, rect.pos_y / 2, rect.width / 2, rect.height / 2);
+
+        reduce_plane (src + out_info.offsets[0], out_info.strides[0], rect, 1, planes[0], max_level, sums);
+        if (V4L2_PIX_FMT_NV12 == out_info.format) {
+            reduce_plane (src + out_info.offsets[1], out_info.strides[1], chroma, 2, planes[1], max_level, sums);
+        } else if (V4L2_PIX_FMT_YUV420 == out_info.format) {
+            for (uint32_t plane = 1; plane <= 2; ++plane)
+                reduce_plane (
+                    src + out_info.offsets[plane], out_info.strides[plane], chroma, 1, planes[plane], max_level, sums);
+        }
+    }
+
+    out_buf->unmap ();
+    for (uint32_t level = 1; level <= max_level; ++level) {
+        if (reduced->bufs[level].ptr ())
+            reduced->bufs[level]->unmap ();
+    }
+}
+
+XCamReturn
+StitcherImpl::start_frame (const SmartPtr<SoftStitcher::StitcherParam> &param)
+{
+    SmartLock locker (_frame_mutex);
+    if (_stitcher->is_calibration_ready ()) {
+        // tables are swapped with the pipeline drained, later frames wait here
+        while (!_frames_stopped && _frames_in_flight > 0)
+            _frame_cond.wait (_frame_mutex);
+        if (!_frames_stopped)
+            _stitcher->apply_ready_calibration ();
+    }
+
+    while (!_frames_stopped && _frames_in_flight >= _max_frames)
+        _frame_cond.wait (_frame_mutex);
+
+    XCAM_FAIL_RETURN (
+        WARNING, !_frames_stopped, XCAM_RETURN_ERROR_THREAD,
+        "soft-stitcher:%s start frame failed, stitcher stopped", XCAM_STR (_stitcher->get_name ()));
+
+    // frame sequence is the priority of all its work items, earlier frame first
+    SmartPtr<SoftScheduleMeta> schedule = new SoftScheduleMeta (_next_frame_seq++, _threads);
+    XCAM_ASSERT (schedule.ptr ());
+    param->add_meta (schedule);
+
+    // viewport is taken with the tables, they change between frames only
+    SmartPtr<StitchRoi> roi = get_roi ();
+    if (roi.ptr ())
+        param->add_meta (roi);
+    ++_frames_in_flight;
+
     return XCAM_RETURN_NO_ERROR;
 }
 
+bool
+StitcherImpl::end_frame (const SmartPtr<SoftStitcher::StitcherParam> &param, XCamReturn err, bool deliver)
+{
+    SmartPtr<SoftScheduleMeta> schedule = param->find_meta<SoftScheduleMeta> ();
+    XCAM_ASSERT (schedule.ptr ());
+    int64_t seq = schedule->priority;
+
+    SmartLock locker (_frame_mutex);
+    if (seq < _next_end_seq || _ended_frames.find (seq) != _ended_frames.end ()) {
+        // already broken by another task
+        return false;
+    }
+
+    EndedFrame &frame = _ended_frames[seq];
+    frame.param = param;
+    frame.error = err;
+    frame.deliver = deliver;
+
+    // only one thread hands over ended frames at a time, which keeps the order
+    if (_ending)
+        return false;
+    _ending = true;
+    return true;
+}
+
+bool
+StitcherImpl::pop_ended_frame (EndedFrame &frame)
+{
+    SmartLock locker (_frame_mutex);
+    EndedFrames::iterator i = _ended_frames.begin ();
+    if (i == _ended_frames.end () || i->first != _next_end_seq) {
+        _ending = false;
+        return false;
+    }
+
+    frame = i->second;
+    _ended_frames.erase (i);
+    ++_next_end_seq;
+    --_frames_in_flight;
+    _frame_cond.broadcast ();
+    return true;
+}
+
 bool
 StitcherImpl::remove_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param)
 {
     XCAM_ASSERT (param.ptr ());
     SmartLock locker (_map_mutex);
-    BlendCopyTaskNums::iterator i = _task_counts.find (param.ptr ());
+    BlendTaskNums::iterator i = _task_counts.find (param.ptr ());
     if (i == _task_counts.end ())
         return false;
 
@@ -643,7 +1210,7 @@ StitcherImpl::dec_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param
 {
     XCAM_ASSERT (param.ptr ());
     SmartLock locker (_map_mutex);
-    BlendCopyTaskNums::iterator i = _task_counts.find (param.ptr ());
+    BlendTaskNums::iterator i = _task_counts.find (param.ptr ());
     if (i == _task_counts.end ())
         return -1;
 
@@ -661,12 +1228,18 @@ StitcherImpl::dec_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param
 XCamReturn
 StitcherImpl::gen_geomap_table ()
 {
-    uint32_t camera_num = _stitcher->get_camera_num ();
+    return gen_geomap_table (_stitcher, _fisheye);
+}
+
+XCamReturn
+StitcherImpl::gen_geomap_table (Stitcher *geo, FisheyeMap *fisheye)
+{
+    uint32_t camera_num = geo->get_camera_num ();
     for (uint32_t i = 0; i < camera_num; ++i) {
-        const Stitcher::RoundViewSlice view_slice = _stitcher->get_round_view_slice (i);
-        _fisheye[i].mapper->set_output_size (view_slice.width, view_slice.height);
+        const Stitcher::RoundViewSlice view_slice = geo->get_round_view_slice (i);
+        fisheye[i].mapper->set_output_size (view_slice.width, view_slice.height);
 
-        XCamReturn ret = _fisheye[i].set_map_table (_stitcher, view_slice, i);
+        XCamReturn ret = fisheye[i].set_map_table (_stitcher, geo, view_slice, i);
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
             "stitcher:%s generate geomap table failed, idx:%d", XCAM_STR (_stitcher->get_name ()), i);
@@ -679,14 +1252,27 @@ XCamReturn
 StitcherImpl::start_geomap_works (const SmartPtr<SoftStitcher::StitcherParam> &param)
 {
     uint32_t camera_num = _stitcher->get_camera_num ();
+    SmartPtr<StitchRoi> roi = param->find_meta<StitchRoi> ();
 
     // 依次对每路相机执行 GeoMapper：将输入鱼眼 remap 到中间缓冲，作为后续拼接的基础。
     for (uint32_t i = 0; i < camera_num; ++i) {
+        if (roi.ptr () && !roi->camera[i])
+            continue;
+
         SmartPtr<VideoBuffer> out_buf = _fisheye[i].buf_pool->get_buffer ();
         SmartPtr<HandlerParam> geomap_params = new HandlerParam (i);
         geomap_params->in_buf = param->in_bufs[i];
         geomap_params->out_buf = out_buf;
         geomap_params->stitch_param = param;
+        geomap_params->add_meta (param->find_meta<SoftScheduleMeta> ());
+        if (_stitcher->complete_stitch ()) {
+            geomap_params->direct_buf = param->out_buf;
+            geomap_params->direct_areas = _fisheye[i].direct_areas;
+        }
+        if (roi.ptr ()) {
+            geomap_params->direct_areas = roi->direct_areas[i];
+            geomap_params->map_area = roi->map_area[i];
+        }
 
         init_geomap_factors (i);
         XCamReturn ret = _fisheye[i].mapper->execute_buffer (geomap_params, false);
@@ -709,6 +1295,7 @@ Overlap::find_blender_param_in_map (
         param = new BlenderParam (idx, NULL, NULL, NULL);
         XCAM_ASSERT (param.ptr ());
         param->stitch_param = key;
+        param->add_meta (key->find_meta<SoftScheduleMeta> ());
         param_map.insert (std::make_pair ((void*)key.ptr (), param));
     } else {
         param = (*i).second;
@@ -779,7 +1366,9 @@ StitcherImpl::start_overlap_task (uint32_t idx, const SmartPtr<BlenderParam> &pa
 
 #if ENABLE_FEATURE_MATCH
     if (_stitcher->need_feature_match ()) {
+        int64_t fm_start = LatencyStats::now_us ();
         ret = start_feature_match (param->in_buf, param->in1_buf, idx);
+        _stitcher->record_stage (Stitcher::StageFeatureMatch, fm_start, ret);
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
             "soft-stitcher:%s feature match idx:%d failed", XCAM_STR (_stitcher->get_name ()), idx);
@@ -798,22 +1387,31 @@ StitcherImpl::start_overlap_tasks (
     const uint32_t camera_num = _stitcher->get_camera_num ();
     uint32_t pre_idx = (idx + camera_num - 1) % camera_num;
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    // overlaps outside of the viewport wait for no buffer
+    SmartPtr<StitchRoi> roi = param->find_meta<StitchRoi> ();
+    bool cur_active = !roi.ptr () || roi->overlap[idx];
+    bool prev_active = !roi.ptr () || roi->overlap[pre_idx];
     {
         SmartPtr<BlenderParam> param_b;
 
         SmartLock locker (_map_mutex);
-        param_b = _overlaps[idx].find_blender_param_in_map (param, idx);
-        param_b->in_buf = buf;
-        if (param_b->in_buf.ptr () && param_b->in1_buf.ptr ()) {
-            cur_param = param_b;
-            _overlaps[idx].param_map.erase (param.ptr ());
+        if (cur_active) {
+            param_b = _overlaps[idx].find_blender_param_in_map (param, idx);
+            param_b->in_buf = buf;
+            if (param_b->in_buf.ptr () && param_b->in1_buf.ptr ()) {
+                cur_param = param_b;
+                _overlaps[idx].param_map.erase (param.ptr ());
+            }
         }
 
-        param_b = _overlaps[pre_idx].find_blender_param_in_map (param, pre_idx);
-        param_b->in1_buf = buf;
-        if (param_b->in_buf.ptr () && param_b->in1_buf.ptr ()) {
-            prev_param = param_b;
-            _overlaps[pre_idx].param_map.erase (param.ptr ());
+        if (prev_active) {
+            param_b = _overlaps[pre_idx].find_blender_param_in_map (param, pre_idx);
+            param_b->in1_buf = buf;
+            if (param_b->in_buf.ptr () && param_b->in1_buf.ptr ()) {
+                prev_param = param_b;
+                _overlaps[pre_idx].param_map.erase (param.ptr ());
+            }
         }
     }
 
@@ -837,78 +1435,36 @@ StitcherImpl::start_overlap_tasks (
     return XCAM_RETURN_NO_ERROR;
 }
 
-XCamReturn
-Copier::start_copy_task (
-    const SmartPtr<ImageHandler::Parameters> &param,
-    const uint32_t idx, const SmartPtr<VideoBuffer> &buf)
+void
+StitcherImpl::get_pool_metrics (BufferPool::Metrics &metrics)
 {
-    XCAM_ASSERT (copy_task.ptr ());
-
-    SmartPtr<VideoBuffer> in_buf = buf, out_buf = param->out_buf;
-    const VideoBufferInfo &in_info = in_buf->get_video_info ();
-    const VideoBufferInfo &out_info = out_buf->get_video_info ();
-
-    SmartPtr<StitcherCopyArgs> args = new StitcherCopyArgs (idx, param);
-    args->in_luma = new UcharImage (
-        in_buf, copy_area.in_area.width, copy_area.in_area.height, in_info.strides[0],
-        in_info.offsets[0] + copy_area.in_area.pos_x + copy_area.in_area.pos_y * in_info.strides[0]);
-
-    args->out_luma = new UcharImage (
-        out_buf, copy_area.out_area.width, copy_area.out_area.height, out_info.strides[0],
-        out_info.offsets[0] + copy_area.out_area.pos_x + copy_area.out_area.pos_y * out_info.strides[0]);
-
-    if ((V4L2_PIX_FMT_NV12 == in_info.format) && (V4L2_PIX_FMT_NV12 == out_info.format)) {
-        args->in_uv = new Uchar2Image (
-            in_buf, copy_area.in_area.width / 2, copy_area.in_area.height / 2, in_info.strides[1],
-            in_info.offsets[1] + copy_area.in_area.pos_x + copy_area.in_area.pos_y / 2 * in_info.strides[1]);
-        args->out_uv = new Uchar2Image (
-            out_buf, copy_area.out_area.width / 2, copy_area.out_area.height / 2, out_info.strides[1],
-            out_info.offsets[1] + copy_area.out_area.pos_x + copy_area.out_area.pos_y / 2 * out_info.strides[1]);
-    } else if ((V4L2_PIX_FMT_YUV420 == in_info.format) && (V4L2_PIX_FMT_YUV420 == out_info.format)) {
-        args->in_u = new UcharImage (
-            in_buf, copy_area.in_area.width / 2, copy_area.in_area.height / 2, in_info.strides[1],
-            in_info.offsets[1] + copy_area.in_area.pos_x / 2 + copy_area.in_area.pos_y / 2 * in_info.strides[1]);
-        args->in_v = new UcharImage (
-            in_buf, copy_area.in_area.width / 2, copy_area.in_area.height / 2, in_info.strides[2],
-            in_info.offsets[2] + copy_area.in_area.pos_x / 2 + copy_area.in_area.pos_y / 2 * in_info.strides[2]);
-        args->out_u = new UcharImage (
-            out_buf, copy_area.out_area.width / 2, copy_area.out_area.height / 2, out_info.strides[1],
-            out_info.offsets[1] + copy_area.out_area.pos_x / 2 + copy_area.out_area.pos_y / 2 * out_info.strides[1]);
-        args->out_v = new UcharImage (
-            out_buf, copy_area.out_area.width / 2, copy_area.out_area.height / 2, out_info.strides[2],
-            out_info.offsets[2] + copy_area.out_area.pos_x / 2 + copy_area.out_area.pos_y / 2 * out_info.strides[2]);
-    } else {
-        XCAM_LOG_ERROR ("copy_task buffer pixel format:%d unsupported!", in_info.format);
+    BufferPool::Metrics pool_metrics;
+    uint32_t cam_num = _stitcher->get_camera_num ();
+    // pools are swapped with tables under frame mutex
+    SmartLock locker (_frame_mutex);
+    for (uint32_t i = 0; i < cam_num; ++i) {
+        if (_fisheye[i].buf_pool.ptr ()) {
+            _fisheye[i].buf_pool->get_metrics (pool_metrics);
+            metrics.merge (pool_metrics);
+        }
+    }
+    if (_geomap_pool.ptr ()) {
+        _geomap_pool->get_metrics (pool_metrics);
+        metrics.merge (pool_metrics);
     }
-
-    uint32_t thread_x = 1, thread_y = 16;
-    WorkSize global_size (1, xcam_ceil (copy_area.in_area.height, 2) / 2);
-    WorkSize local_size (
-        xcam_ceil (global_size.value[0], thread_x) / thread_x,
-        xcam_ceil (global_size.value[1], thread_y) / thread_y);
-
-    copy_task->set_local_size (local_size);
-    copy_task->set_global_size (global_size);
-
-    return copy_task->work (args);
 }
 
-XCamReturn
-StitcherImpl::start_copy_tasks (
-    const SmartPtr<SoftStitcher::StitcherParam> &param,
-    const uint32_t idx, const SmartPtr<VideoBuffer> &buf)
+void
+StitcherImpl::reset_pool_metrics ()
 {
-    uint32_t size = _stitcher->get_copy_area ().size ();
-    for (uint32_t i = 0; i < size; ++i) {
-        if(_copiers[i].copy_area.in_idx == idx) {
-            XCamReturn ret = _copiers[i].start_copy_task (param, idx, buf);
-            XCAM_FAIL_RETURN (
-                ERROR, xcam_ret_is_ok (ret), ret,
-                "soft-stitcher:%s start copy task failed, idx:%d", XCAM_STR (_stitcher->get_name ()), idx);
-        }
+    uint32_t cam_num = _stitcher->get_camera_num ();
+    SmartLock locker (_frame_mutex);
+    for (uint32_t i = 0; i < cam_num; ++i) {
+        if (_fisheye[i].buf_pool.ptr ())
+            _fisheye[i].buf_pool->reset_metrics ();
     }
-
-    return XCAM_RETURN_NO_ERROR;
+    if (_geomap_pool.ptr ())
+        _geomap_pool->reset_metrics ();
 }
 
 XCamReturn
@@ -930,17 +1486,28 @@ StitcherImpl::stop ()
         }
     }
 
-    for (Copiers::iterator i_copy = _copiers.begin (); i_copy != _copiers.end (); ++i_copy) {
-        Copier &copy = *i_copy;
-        if (copy.copy_task.ptr ()) {
-            copy.copy_task->stop ();
-            copy.copy_task.release ();
-        }
-    }
-
     if (_geomap_pool.ptr ()) {
         _geomap_pool->stop ();
     }
+    for (uint32_t level = 1; level <= XCAM_STITCH_MAX_REDUCED_LEVEL; ++level) {
+        if (_reduced_pools[level].ptr ())
+            _reduced_pools[level]->stop ();
+    }
+
+    if (_threads.ptr ()) {
+        _threads->stop ();
+    }
+
+    {
+        // frames in flight are dropped, wake up callers waiting for a free slot
+        SmartLock locker (_frame_mutex);
+        _roi.release ();
+        _frames_stopped = true;
+        _frames_in_flight = 0;
+        _next_end_seq = _next_frame_seq;
+        _ended_frames.clear ();
+        _frame_cond.broadcast ();
+    }
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -1005,9 +1572,84 @@ SoftStitcher::stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuff
     return ret;
 }
 
+bool
+SoftStitcher::set_max_frames_in_flight (uint32_t frames)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, frames > 0, false,
+        "soft-stitcher:%s max frames in flight must be positive", XCAM_STR (get_name ()));
+
+    SmartLock locker (_impl->_frame_mutex);
+    _impl->_max_frames = frames;
+    _impl->_frame_cond.broadcast ();
+    return true;
+}
+
+bool
+SoftStitcher::set_worker_threads (uint32_t threads)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, threads <= SOFT_STITCHER_MAX_THREADS, false,
+        "soft-stitcher:%s worker threads(%d) exceed max(%d)",
+        XCAM_STR (get_name ()), threads, SOFT_STITCHER_MAX_THREADS);
+
+    _impl->_thread_count = threads;
+    return true;
+}
+
+void
+SoftStitcher::get_stitch_metrics (Stitcher::Metrics &metrics)
+{
+    Stitcher::get_stitch_metrics (metrics);
+
+    {
+        SmartLock locker (_impl->_frame_mutex);
+        metrics.frames_in_flight = _impl->_frames_in_flight;
+    }
+
+    ImageHandler::Metrics handler_metrics;
+    get_metrics (handler_metrics);
+    metrics.pools = handler_metrics.out_pool;
+    _impl->get_pool_metrics (metrics.pools);
+}
+
+void
+SoftStitcher::reset_stitch_metrics ()
+{
+    Stitcher::reset_stitch_metrics ();
+    reset_metrics ();
+    _impl->reset_pool_metrics ();
+}
+
+XCamReturn
+SoftStitcher::prepare_calibration (Stitcher &staged, SmartPtr<CalibrationTables> &tables)
+{
+    SmartPtr<SoftStitcherPriv::StitchTables> soft_tables;
+    XCamReturn ret = _impl->prepare_tables (&staged, soft_tables);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s prepare calibration tables failed", XCAM_STR (get_name ()));
+
+    tables = soft_tables;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftStitcher::commit_calibration (const SmartPtr<CalibrationTables> &tables)
+{
+    SmartPtr<SoftStitcherPriv::StitchTables> soft_tables = tables.dynamic_cast_ptr<SoftStitcherPriv::StitchTables> ();
+    XCAM_FAIL_RETURN (
+        ERROR, soft_tables.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "soft-stitcher:%s commit calibration without tables", XCAM_STR (get_name ()));
+
+    _impl->swap_tables (*soft_tables.ptr ());
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 SoftStitcher::terminate ()
 {
+    stop_calibration ();
     _impl->stop ();
     return SoftHandler::terminate ();
 }
@@ -1029,10 +1671,10 @@ SoftStitcher::start_task_count (const SmartPtr<SoftStitcher::StitcherParam> &par
         return XCAM_RETURN_ERROR_UNKNOWN;
     }
 
-    int32_t count = get_camera_num ();
-    if (complete_stitch ()) {
-        count += get_copy_area ().size ();
-    }
+    SmartPtr<SoftStitcherPriv::StitchRoi> roi = param->find_meta<SoftStitcherPriv::StitchRoi> ();
+    int32_t count = roi.ptr () ? roi->task_num : get_camera_num ();
+    if (!count)
+        return XCAM_RETURN_BYPASS;
 
     XCAM_LOG_DEBUG ("stitcher :%s start task count :%d", XCAM_STR(get_name ()), count);
     _impl->_task_counts.insert (std::make_pair((void*)param.ptr(), count));
@@ -1051,6 +1693,7 @@ SoftStitcher::geomap_done (
     SmartPtr<SoftStitcher::StitcherParam> param = geomap_param->stitch_param;
     XCAM_ASSERT (param.ptr ());
     XCAM_UNUSED (handler);
+    record_stage (StageGeoMap, geomap_param->start_time, error);
 
     if (!check_work_continue (param, error))
         return;
@@ -1064,12 +1707,9 @@ SoftStitcher::geomap_done (
         work_broken (param, ret);
     }
 
-    if (complete_stitch ()) {
-        ret = _impl->start_copy_tasks (param, geomap_param->idx, geomap_param->out_buf);
-        if (!xcam_ret_is_ok (ret)) {
-            work_broken (param, ret);
-        }
-    } else {
+    // a camera only copied into the viewport has no blender to end its task
+    SmartPtr<SoftStitcherPriv::StitchRoi> roi = param->find_meta<SoftStitcherPriv::StitchRoi> ();
+    if (!complete_stitch () || (roi.ptr () && roi->is_lone (geomap_param->idx, get_camera_num ()))) {
         if (!check_work_continue (param, error)) {
             _impl->remove_task_count (param);
             return;
@@ -1091,6 +1731,7 @@ SoftStitcher::blender_done (
     SmartPtr<SoftStitcher::StitcherParam> param = blender_param->stitch_param;
     XCAM_ASSERT (param.ptr ());
     XCAM_UNUSED (handler);
+    record_stage (StageBlend, blender_param->start_time, error);
 
     if (!check_work_continue (param, error)) {
         _impl->remove_task_count (param);
@@ -1106,27 +1747,39 @@ SoftStitcher::blender_done (
 }
 
 void
-SoftStitcher::copy_task_done (
-    const SmartPtr<Worker> &worker,
-    const SmartPtr<Worker::Arguments> &base,
-    const XCamReturn error)
+SoftStitcher::work_well_done (const SmartPtr<ImageHandler::Parameters> &param, XCamReturn err)
+{
+    end_frame (param, err, true);
+}
+
+void
+SoftStitcher::work_broken (const SmartPtr<ImageHandler::Parameters> &param, XCamReturn err)
+{
+    end_frame (param, err, true);
+}
+
+void
+SoftStitcher::end_frame (const SmartPtr<ImageHandler::Parameters> &base, XCamReturn err, bool deliver)
 {
-    XCAM_UNUSED (worker);
-    XCAM_ASSERT (worker.ptr ());
-    SmartPtr<SoftStitcherPriv::StitcherCopyArgs> args = base.dynamic_cast_ptr<SoftStitcherPriv::StitcherCopyArgs> ();
-    XCAM_ASSERT (args.ptr ());
-    const SmartPtr<SoftStitcher::StitcherParam> param =
-        args->get_param ().dynamic_cast_ptr<SoftStitcher::StitcherParam> ();
+    SmartPtr<StitcherParam> param = base.dynamic_cast_ptr<StitcherParam> ();
     XCAM_ASSERT (param.ptr ());
 
-    if (!check_work_continue (param, error)) {
-        _impl->remove_task_count (param);
+    if (deliver && xcam_ret_is_ok (err))
+        _impl->fill_reduced_outputs (param);
+
+    if (!_impl->end_frame (param, err, deliver))
         return;
-    }
-    XCAM_LOG_DEBUG ("soft-stitcher:%s camera(idx:%d) copy done", XCAM_STR (get_name ()), args->idx);
 
-    if (_impl->dec_task_count (param) == 0) {
-        work_well_done (param, error);
+    SoftStitcherPriv::EndedFrame frame;
+    while (_impl->pop_ended_frame (frame)) {
+        record_stage (StageFrame, frame.param->start_time, frame.error);
+        if (!frame.deliver)
+            continue;
+
+        if (xcam_ret_is_ok (frame.error))
+            SoftHandler::work_well_done (frame.param, frame.error);
+        else
+            SoftHandler::work_broken (frame.param, frame.error);
     }
 }
 
@@ -1190,6 +1843,11 @@ SoftStitcher::configure_resource (const SmartPtr<Parameters> &param)
         XCAM_ALIGN_UP (out_height, SOFT_STITCHER_ALIGNMENT_Y));
     set_out_video_info (out_info);
 
+    ret = _impl->init_reduced_pools (out_width, out_height);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s init reduced output pools failed", XCAM_STR (get_name ()));
+
     return ret;
 }
 
@@ -1203,15 +1861,31 @@ SoftStitcher::start_work (const SmartPtr<Parameters> &base)
         "soft_stitcher:%s start_work failed, params or in_bufs are empty",
         XCAM_STR (get_name ()));
 
-    XCamReturn ret = start_task_count (param);
+    XCamReturn ret = _impl->attach_reduced_outputs (param);
     XCAM_FAIL_RETURN (
-        ERROR, xcam_ret_is_ok (ret), XCAM_RETURN_ERROR_PARAM,
-        "soft_stitcher:%s start blender count failed", XCAM_STR (get_name ()));
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft_stitcher:%s attach reduced outputs failed", XCAM_STR (get_name ()));
 
-    ret = _impl->start_geomap_works (param);
+    ret = _impl->start_frame (param);
     XCAM_FAIL_RETURN (
-        ERROR, xcam_ret_is_ok (ret), XCAM_RETURN_ERROR_PARAM,
-        "soft_stitcher:%s start geomap works failed", XCAM_STR (get_name ()));
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft_stitcher:%s start frame failed", XCAM_STR (get_name ()));
+
+    ret = start_task_count (param);
+    if (ret == XCAM_RETURN_BYPASS) {
+        // viewport covers nothing stitched
+        end_frame (param, XCAM_RETURN_NO_ERROR, true);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    if (xcam_ret_is_ok (ret))
+        ret = _impl->start_geomap_works (param);
+
+    if (!xcam_ret_is_ok (ret)) {
+        // release the frame slot, execute_buffer reports the error to caller
+        end_frame (param, ret, false);
+        XCAM_LOG_ERROR ("soft_stitcher:%s start tasks or geomap works failed", XCAM_STR (get_name ()));
+        return XCAM_RETURN_ERROR_PARAM;
+    }
 
     return ret;
 }
@@ -61,15 +61,34 @@ public:
     //derived from SoftHandler
     virtual XCamReturn terminate ();
 
+    /*
+     * Frames from concurrent stitch_buffers callers (or async execute_buffer) are
+     * pipelined, stages of earlier frames are dispatched first on a shared pool and
+     * frames complete in submission order. Set both before the first frame.
+     */
+    bool set_max_frames_in_flight (uint32_t frames);
+    // 0 for online cpu count
+    bool set_worker_threads (uint32_t threads);
+
+    //derived from Stitcher
+    virtual void get_stitch_metrics (Stitcher::Metrics &metrics);
+    virtual void reset_stitch_metrics ();
+
 protected:
     // interface derive from Stitcher
     XCamReturn stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf);
+    XCamReturn prepare_calibration (Stitcher &staged, SmartPtr<CalibrationTables> &tables);
+    XCamReturn commit_calibration (const SmartPtr<CalibrationTables> &tables);
 
     //derived from SoftHandler
     XCamReturn configure_resource (const SmartPtr<Parameters> &param);
     XCamReturn start_work (const SmartPtr<Parameters> &param);
+    void work_well_done (const SmartPtr<ImageHandler::Parameters> &param, XCamReturn err);
+    void work_broken (const SmartPtr<ImageHandler::Parameters> &param, XCamReturn err);
 
 private:
+    void end_frame (const SmartPtr<ImageHandler::Parameters> &param, XCamReturn err, bool deliver);
+
     // handler done, call back functions
     XCamReturn start_task_count (
         const SmartPtr<SoftStitcher::StitcherParam> &param);
@@ -79,9 +98,6 @@ private:
     void blender_done (
         const SmartPtr<ImageHandler> &handler,
         const SmartPtr<ImageHandler::Parameters> &param, const XCamReturn error);
-    void copy_task_done (
-        const SmartPtr<Worker> &worker,
-        const SmartPtr<Worker::Arguments> &base, const XCamReturn error);
 
 private:
     SmartPtr<SoftStitcherPriv::StitcherImpl> _impl;
@@ -0,0 +1,630 @@
+/*
+ * soft_video_stabilizer.cpp - CPU image warp and gyro based video stabilizer
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include <unistd.h>
+
+#include <thread_pool.h>
+#include <xcam_mutex.h>
+
+#include "soft_video_stabilizer.h"
+#include "soft_video_buf_allocator.h"
+
+#if ENABLE_AVX512
+#include <immintrin.h>
+#endif
+
+#define SOFT_WARP_MAX_THREADS 8
+
+namespace XCam {
+
+class SoftImageWarpSync {
+public:
+    explicit SoftImageWarpSync (uint32_t items)
+        : _remain_items (items)
+    {}
+
+    void dec () {
+        SmartLock locker (_mutex);
+        XCAM_ASSERT (_remain_items > 0);
+        if (--_remain_items == 0)
+            _cond.broadcast ();
+    }
+    void wait () {
+        SmartLock locker (_mutex);
+        while (_remain_items > 0)
+            _cond.wait (_mutex);
+    }
+
+private:
+    XCAM_DEAD_COPY (SoftImageWarpSync);
+
+private:
+    uint32_t    _remain_items;
+    Mutex       _mutex;
+    Cond        _cond;
+};
+
+class SoftImageWarpTask
+    : public ThreadPool::UserData
+{
+public:
+    SoftImageWarpTask (
+        SoftImageWarp *warp, const uint8_t *in_mem, uint8_t *out_mem,
+        uint32_t start, uint32_t end, const SmartPtr<SoftImageWarpSync> &sync)
+        : _warp (warp)
+        , _in_mem (in_mem)
+        , _out_mem (out_mem)
+        , _start (start)
+        , _end (end)
+        , _sync (sync)
+    {}
+
+    virtual XCamReturn run () {
+        _warp->warp_rows (_in_mem, _out_mem, _start, _end);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    virtual void done (XCamReturn) {
+        _sync->dec ();
+    }
+
+private:
+    SoftImageWarp               *_warp;
+    const uint8_t               *_in_mem;
+    uint8_t                     *_out_mem;
+    uint32_t                     _start;
+    uint32_t                     _end;
+    SmartPtr<SoftImageWarpSync>  _sync;
+};
+
+struct SoftStabFrame
+{
+    SmartPtr<VideoBuffer>   buf;
+    int64_t                 timestamp;
+    DevicePoseList          poses;
+
+    SoftStabFrame () : timestamp (0) {}
+};
+
+// source position clamped to edge, (x0, y0) keeps (x0 + 1, y0 + 1) inside plane
+struct WarpSample {
+    int32_t  offset;
+    uint32_t wx;
+    uint32_t wy;
+};
+
+static inline void
+calc_warp_sample (
+    const float *mat, float x, float y, float max_x, float max_y, uint32_t pitch, uint32_t pixel_bytes,
+    WarpSample &sample)
+{
+    float w = mat[6] * x + mat[7] * y + mat[8];
+    w = (w != 0.0f ? 1.0f / w : 0.0f);
+    float sx = (mat[0] * x + mat[1] * y + mat[2]) * w;
+    float sy = (mat[3] * x + mat[4] * y + mat[5]) * w;
+    sx = XCAM_CLAMP (sx, 0.0f, max_x);
+    sy = XCAM_CLAMP (sy, 0.0f, max_y);
+
+    int32_t x0 = XCAM_MIN ((int32_t)sx, (int32_t)max_x - 1);
+    int32_t y0 = XCAM_MIN ((int32_t)sy, (int32_t)max_y - 1);
+    sample.wx = (uint32_t)((sx - x0) * 256.0f);
+    sample.wy = (uint32_t)((sy - y0) * 256.0f);
+    sample.offset = y0 * pitch + x0 * pixel_bytes;
+}
+
+static inline uint8_t
+interp_pixel (const uint8_t *top, uint32_t pitch, uint32_t pixel_bytes, uint32_t wx, uint32_t wy)
+{
+    const uint8_t *bottom = top + pitch;
+    uint32_t t = top[0] * (256 - wx) + top[pixel_bytes] * wx;
+    uint32_t b = bottom[0] * (256 - wx) + bottom[pixel_bytes] * wx;
+    return (uint8_t)((t * (256 - wy) + b * wy + (1 << 15)) >> 16);
+}
+
+static void
+warp_luma_row (
+    const uint8_t *in, uint32_t in_pitch, uint32_t in_width, uint32_t in_height,
+    uint8_t *out, uint32_t out_width, uint32_t y, const float *mat)
+{
+    const float max_x = in_width - 1;
+    const float max_y = in_height - 1;
+    uint32_t x = 0;
+
+#if ENABLE_AVX512
+    const __m512 step = _mm512_setr_ps (0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f,
+                                        8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f);
+    const __m512 row_x = _mm512_set1_ps (mat[1] * y + mat[2]);
+    const __m512 row_y = _mm512_set1_ps (mat[4] * y + mat[5]);
+    const __m512 row_w = _mm512_set1_ps (mat[7] * y + mat[8]);
+    const __m512 zero = _mm512_setzero_ps ();
+    const __m512 one = _mm512_set1_ps (1.0f);
+    const __m512 vmax_x = _mm512_set1_ps (max_x);
+    const __m512 vmax_y = _mm512_set1_ps (max_y);
+    const __m512i vlast_x = _mm512_set1_epi32 ((int32_t)in_width - 2);
+    const __m512i vlast_y = _mm512_set1_epi32 ((int32_t)in_height - 2);
+    const __m512i vpitch = _mm512_set1_epi32 (in_pitch);
+    const __m512i byte_mask = _mm512_set1_epi32 (0xFF);
+
+    for (; x + 16 <= out_width; x += 16) {
+        __m512 dx = _mm512_add_ps (_mm512_set1_ps ((float)x), step);
+        __m512 w = _mm512_fmadd_ps (_mm512_set1_ps (mat[6]), dx, row_w);
+        w = _mm512_maskz_div_ps (_mm512_cmp_ps_mask (w, zero, _CMP_NEQ_OQ), one, w);
+        __m512 sx = _mm512_mul_ps (_mm512_fmadd_ps (_mm512_set1_ps (mat[0]), dx, row_x), w);
+        __m512 sy = _mm512_mul_ps (_mm512_fmadd_ps (_mm512_set1_ps (mat[3]), dx, row_y), w);
+        sx = _mm512_min_ps (_mm512_max_ps (sx, zero), vmax_x);
+        sy = _mm512_min_ps (_mm512_max_ps (sy, zero), vmax_y);
+
+        __m512i x0 = _mm512_min_epi32 (_mm512_cvttps_epi32 (sx), vlast_x);
+        __m512i y0 = _mm512_min_epi32 (_mm512_cvttps_epi32 (sy), vlast_y);
+        __m512 wx = _mm512_sub_ps (sx, _mm512_cvtepi32_ps (x0));
+        __m512 wy = _mm512_sub_ps (sy, _mm512_cvtepi32_ps (y0));
+
+        // one 32bit gather loads two neighbour pixels of a row
+        __m512i offset = _mm512_add_epi32 (_mm512_mullo_epi32 (y0, vpitch), x0);
+        __m512i top = _mm512_i32gather_epi32 (offset, in, 1);
+        __m512i bottom = _mm512_i32gather_epi32 (_mm512_add_epi32 (offset, vpitch), in, 1);
+
+        __m512 p00 = _mm512_cvtepi32_ps (_mm512_and_si512 (top, byte_mask));
+        __m512 p01 = _mm512_cvtepi32_ps (_mm512_and_si512 (_mm512_srli_epi32 (top, 8), byte_mask));
+        __m512 p10 = _mm512_cvtepi32_ps (_mm512_and_si512 (bottom, byte_mask));
+        __m512 p11 = _mm512_cvtepi32_ps (_mm512_and_si512 (_mm512_srli_epi32 (bottom, 8), byte_mask));
+
+        __m512 t = _mm512_fmadd_ps (_mm512_sub_ps (p01, p00), wx, p00);
+        __m512 b = _mm512_fmadd_ps (_mm512_sub_ps (p11, p10), wx, p10);
+        __m512 value = _mm512_fmadd_ps (_mm512_sub_ps (b, t), wy, t);
+
+        _mm_storeu_si128 ((__m128i *)(out + x), _mm512_cvtusepi32_epi8 (_mm512_cvtps_epi32 (value)));
+    }
+#endif
+
+    WarpSample sample;
+    for (; x < out_width; ++x) {
+        calc_warp_sample (mat, x, y, max_x, max_y, in_pitch, 1, sample);
+        out[x] = interp_pixel (in + sample.offset, in_pitch, 1, sample.wx, sample.wy);
+    }
+}
+
+static void
+warp_chroma_row (
+    const uint8_t *in, uint32_t in_pitch, uint32_t in_width, uint32_t in_height,
+    uint8_t *out, uint32_t out_width, uint32_t y, const float *mat)
+{
+    const float max_x = in_width - 1;
+    const float max_y = in_height - 1;
+    uint32_t x = 0;
+
+#if ENABLE_AVX512
+    const __m512 step = _mm512_setr_ps (0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f,
+                                        8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f);
+    const __m512 row_x = _mm512_set1_ps (mat[1] * y + mat[2]);
+    const __m512 row_y = _mm512_set1_ps (mat[4] * y + mat[5]);
+    const __m512 row_w = _mm512_set1_ps (mat[7] * y + mat[8]);
+    const __m512 zero = _mm512_setzero_ps ();
+    const __m512 one = _mm512_set1_ps (1.0f);
+    const __m512 vmax_x = _mm512_set1_ps (max_x);
+    const __m512 vmax_y = _mm512_set1_ps (max_y);
+    const __m512i vlast_x = _mm512_set1_epi32 ((int32_t)in_width - 2);
+    const __m512i vlast_y = _mm512_set1_epi32 ((int32_t)in_height - 2);
+    const __m512i vpitch = _mm512_set1_epi32 (in_pitch);
+    const __m512i byte_mask = _mm512_set1_epi32 (0xFF);
+
+    for (; x + 16 <= out_width; x += 16) {
+        __m512 dx = _mm512_add_ps (_mm512_set1_ps ((float)x), step);
+        __m512 w = _mm512_fmadd_ps (_mm512_set1_ps (mat[6]), dx, row_w);
+        w = _mm512_maskz_div_ps (_mm512_cmp_ps_mask (w, zero, _CMP_NEQ_OQ), one, w);
+        __m512 sx = _mm512_mul_ps (_mm512_fmadd_ps (_mm512_set1_ps (mat[0]), dx, row_x), w);
+        __m512 sy = _mm512_mul_ps (_mm512_fmadd_ps (_mm512_set1_ps (mat[3]), dx, row_y), w);
+        sx = _mm512_min_ps (_mm512_max_ps (sx, zero), vmax_x);
+        sy = _mm512_min_ps (_mm512_max_ps (sy, zero), vmax_y);
+
+        __m512i x0 = _mm512_min_epi32 (_mm512_cvttps_epi32 (sx), vlast_x);
+        __m512i y0 = _mm512_min_epi32 (_mm512_cvttps_epi32 (sy), vlast_y);
+        __m512 wx = _mm512_sub_ps (sx, _mm512_cvtepi32_ps (x0));
+        __m512 wy = _mm512_sub_ps (sy, _mm512_cvtepi32_ps (y0));
+
+        // one 32bit gather loads u0 v0 u1 v1
+        __m512i offset = _mm512_add_epi32 (_mm512_mullo_epi32 (y0, vpitch), _mm512_slli_epi32 (x0, 1));
+        __m512i top = _mm512_i32gather_epi32 (offset, in, 1);
+        __m512i bottom = _mm512_i32gather_epi32 (_mm512_add_epi32 (offset, vpitch), in, 1);
+
+        __m512 u00 = _mm512_cvtepi32_ps (_mm512_and_si512 (top, byte_mask));
+        __m512 v00 = _mm512_cvtepi32_ps (_mm512_and_si512 (_mm512_srli_epi32 (top, 8), byte_mask));
+        __m512 u01 = _mm512_cvtepi32_ps (_mm512_and_si512 (_mm512_srli_epi32 (top, 16), byte_mask));
+        __m512 v01 = _mm512_cvtepi32_ps (_mm512_srli_epi32 (top, 24));
+        __m512 u10 = _mm512_cvtepi32_ps (_mm512_and_si512 (bottom, byte_mask));
+        __m512 v10 = _mm512_cvtepi32_ps (_mm512_and_si512 (_mm512_srli_epi32 (bottom, 8), byte_mask));
+        __m512 u11 = _mm512_cvtepi32_ps (_mm512_and_si512 (_mm512_srli_epi32 (bottom, 16), byte_mask));
+        __m512 v11 = _mm512_cvtepi32_ps (_mm512_srli_epi32 (bottom, 24));
+
+        __m512 ut = _mm512_fmadd_ps (_mm512_sub_ps (u01, u00), wx, u00);
+        __m512 ub = _mm512_fmadd_ps (_mm512_sub_ps (u11, u10), wx, u10);
+        __m512 vt = _mm512_fmadd_ps (_mm512_sub_ps (v01, v00), wx, v00);
+        __m512 vb = _mm512_fmadd_ps (_mm512_sub_ps (v11, v10), wx, v10);
+        __m512i u = _mm512_cvtps_epi32 (_mm512_fmadd_ps (_mm512_sub_ps (ub, ut), wy, ut));
+        __m512i v = _mm512_cvtps_epi32 (_mm512_fmadd_ps (_mm512_sub_ps (vb, vt), wy, vt));
+        __m512i uv = _mm512_or_si512 (_mm512_and_si512 (u, byte_mask), _mm512_slli_epi32 (_mm512_and_si512 (v, byte_mask), 8));
+
+        _mm256_storeu_si256 ((__m256i *)(out + 2 * x), _mm512_cvtepi32_epi16 (uv));
+    }
+#endif
+
+    WarpSample sample;
+    for (; x < out_width; ++x) {
+        calc_warp_sample (mat, x, y, max_x, max_y, in_pitch, 2, sample);
+        const uint8_t *top = in + sample.offset;
+        out[2 * x] = interp_pixel (top, in_pitch, 2, sample.wx, sample.wy);
+        out[2 * x + 1] = interp_pixel (top + 1, in_pitch, 2, sample.wx, sample.wy);
+    }
+}
+
+SoftImageWarp::SoftImageWarp (uint32_t thread_num)
+    : _thread_num (thread_num)
+    , _rows_step (0)
+{
+    if (_thread_num == 0) {
+        long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+        _thread_num = XCAM_CLAMP (cpus, 1, SOFT_WARP_MAX_THREADS);
+    }
+}
+
+SoftImageWarp::~SoftImageWarp ()
+{
+    stop ();
+}
+
+void
+SoftImageWarp::stop ()
+{
+    if (_threads.ptr ()) {
+        _threads->stop ();
+        _threads.release ();
+    }
+}
+
+XCamReturn
+SoftImageWarp::warp (
+    const SmartPtr<VideoBuffer> &in, const SmartPtr<VideoBuffer> &out,
+    const std::vector<Mat3d> &proj_mats, uint32_t rows_step)
+{
+    XCAM_ASSERT (in.ptr () && out.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, !proj_mats.empty (), XCAM_RETURN_ERROR_PARAM,
+        "SoftImageWarp needs at least one projective matrix");
+
+    _in_info = in->get_video_info ();
+    _out_info = out->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        _in_info.format == V4L2_PIX_FMT_NV12 && _out_info.format == V4L2_PIX_FMT_NV12,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftImageWarp only supports NV12, in:%s out:%s",
+        xcam_fourcc_to_string (_in_info.format), xcam_fourcc_to_string (_out_info.format));
+    XCAM_FAIL_RETURN (
+        ERROR, _in_info.width >= 4 && _in_info.height >= 4, XCAM_RETURN_ERROR_PARAM,
+        "SoftImageWarp input(%dx%d) is too small", _in_info.width, _in_info.height);
+
+    _rows_step = (proj_mats.size () > 1 ? XCAM_MAX (rows_step, 1u) : _out_info.height);
+    XCAM_FAIL_RETURN (
+        ERROR, proj_mats.size () * _rows_step >= _out_info.height, XCAM_RETURN_ERROR_PARAM,
+        "SoftImageWarp %d matrices with rows step(%d) don't cover output height(%d)",
+        (int)proj_mats.size (), _rows_step, _out_info.height);
+
+    // chroma(x, y) sits at luma(2x + 0.5, 2y + 0.5) in NV12
+    const Mat3d to_luma (Vec3d (2.0, 0.0, 0.5), Vec3d (0.0, 2.0, 0.5), Vec3d (0.0, 0.0, 1.0));
+    const Mat3d to_chroma (Vec3d (0.5, 0.0, -0.25), Vec3d (0.0, 0.5, -0.25), Vec3d (0.0, 0.0, 1.0));
+
+    _luma_mats.resize (proj_mats.size () * 9);
+    _chroma_mats.resize (proj_mats.size () * 9);
+    for (uint32_t i = 0; i < proj_mats.size (); ++i) {
+        Mat3d luma = proj_mats[i];
+        Mat3d chroma = to_chroma * luma * to_luma;
+        for (uint32_t j = 0; j < 9; ++j) {
+            _luma_mats[i * 9 + j] = luma (j / 3, j % 3);
+            _chroma_mats[i * 9 + j] = chroma (j / 3, j % 3);
+        }
+    }
+
+    const uint8_t *in_mem = in->map ();
+    uint8_t *out_mem = out->map ();
+    if (!in_mem || !out_mem) {
+        if (in_mem)
+            in->unmap ();
+        if (out_mem)
+            out->unmap ();
+        XCAM_LOG_ERROR ("SoftImageWarp map buffers failed");
+        return XCAM_RETURN_ERROR_MEM;
+    }
+
+    // bands hold even luma rows so that chroma rows don't straddle bands
+    const uint32_t rows = _out_info.height;
+    uint32_t bands = XCAM_MIN (_thread_num, rows / 2);
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (bands <= 1) {
+        warp_rows (in_mem, out_mem, 0, rows);
+    } else {
+        if (!_threads.ptr ()) {
+            _threads = new ThreadPool ("soft-image-warp");
+            _threads->set_threads (bands, bands);
+            ret = _threads->start ();
+            if (!xcam_ret_is_ok (ret)) {
+                _threads.release ();
+                XCAM_LOG_ERROR ("SoftImageWarp start threads failed");
+            }
+        }
+
+        if (_threads.ptr ()) {
+            SmartPtr<SoftImageWarpSync> sync = new SoftImageWarpSync (bands);
+            uint32_t rows_per_band = XCAM_ALIGN_UP (xcam_ceil (rows, bands) / bands, 2);
+            uint32_t start = 0;
+            for (uint32_t i = 0; i < bands; ++i) {
+                uint32_t end = XCAM_MIN (start + rows_per_band, rows);
+                SmartPtr<SoftImageWarpTask> task = new SoftImageWarpTask (
+                    this, in_mem, out_mem, start, end, sync);
+                if (start >= end || !xcam_ret_is_ok (_threads->queue (task))) {
+                    sync->dec ();
+                }
+                start = end;
+            }
+            sync->wait ();
+        }
+    }
+    in->unmap ();
+    out->unmap ();
+
+    if (xcam_ret_is_ok (ret))
+        out->set_timestamp (in->get_timestamp ());
+    return ret;
+}
+
+void
+SoftImageWarp::warp_rows (const uint8_t *in_mem, uint8_t *out_mem, uint32_t start, uint32_t end)
+{
+    const uint8_t *in_y = in_mem + _in_info.offsets[0];
+    const uint8_t *in_uv = in_mem + _in_info.offsets[1];
+    uint8_t *out_y = out_mem + _out_info.offsets[0];
+    uint8_t *out_uv = out_mem + _out_info.offsets[1];
+
+    for (uint32_t y = start; y < end; ++y) {
+        const float *mat = &_luma_mats[(y / _rows_step) * 9];
+        warp_luma_row (
+            in_y, _in_info.strides[0], _in_info.width, _in_info.height,
+            out_y + y * _out_info.strides[0], _out_info.width, y, mat);
+    }
+
+    for (uint32_t y = start / 2; y < (end + 1) / 2; ++y) {
+        const float *mat = &_chroma_mats[((2 * y) / _rows_step) * 9];
+        warp_chroma_row (
+            in_uv, _in_info.strides[1], _in_info.width / 2, _in_info.height / 2,
+            out_uv + y * _out_info.strides[1], _out_info.width / 2, y, mat);
+    }
+}
+
+SoftVideoStabilizer::SoftVideoStabilizer (uint32_t thread_num)
+    : _world_to_device (AXIS_X, AXIS_MINUS_Z, AXIS_NONE)
+    , _device_to_image (AXIS_X, AXIS_Y, AXIS_Y)
+    , _filter_radius (15)
+    , _rs_rows (0)
+    , _input_frame_id (-1)
+{
+    _projector = new ImageProjector ();
+    _motion_filter = new MotionFilter (_filter_radius, 10);
+    _warp = new SoftImageWarp (thread_num);
+}
+
+SoftVideoStabilizer::~SoftVideoStabilizer ()
+{
+    stop ();
+}
+
+XCamReturn
+SoftVideoStabilizer::set_camera_calibration (CalibrationParams &params)
+{
+    _calib_params = params;
+    return _projector->set_camera_calibration (params);
+}
+
+XCamReturn
+SoftVideoStabilizer::set_camera_intrinsics (
+    double focal_x,
+    double focal_y,
+    double offset_x,
+    double offset_y,
+    double skew)
+{
+    return _projector->set_camera_intrinsics (focal_x, focal_y, offset_x, offset_y, skew);
+}
+
+XCamReturn
+SoftVideoStabilizer::align_coordinate_system (
+    CoordinateSystemConv &world_to_device,
+    CoordinateSystemConv &device_to_image)
+{
+    _world_to_device = world_to_device;
+    _device_to_image = device_to_image;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftVideoStabilizer::set_motion_filter (uint32_t radius, float stdev)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _input_frame_id < 0, XCAM_RETURN_ERROR_ORDER,
+        "SoftVideoStabilizer set motion filter failed, reset it first");
+
+    _filter_radius = radius;
+    _motion_filter->set_filters (radius, stdev);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+SoftVideoStabilizer::set_rolling_shutter_rows (uint32_t rows)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, rows % 2 == 0, false,
+        "SoftVideoStabilizer rolling shutter rows(%d) must be even", rows);
+
+    _rs_rows = rows;
+    return true;
+}
+
+XCamReturn
+SoftVideoStabilizer::prepare (const VideoBufferInfo &info, uint32_t buf_count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, info.format == V4L2_PIX_FMT_NV12, XCAM_RETURN_ERROR_PARAM,
+        "SoftVideoStabilizer unsupported format(%s)", xcam_fourcc_to_string (info.format));
+
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+    XCAM_ASSERT (pool.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, pool->reserve (buf_count), XCAM_RETURN_ERROR_MEM,
+        "SoftVideoStabilizer reserve output buffers failed");
+    _pool = pool;
+
+    reset ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+SoftVideoStabilizer::reset ()
+{
+    XCAM_LOG_DEBUG ("reset soft video stabilizer");
+
+    _input_frame_id = -1;
+    _last_frame.release ();
+    _frames.clear ();
+    _motions.clear ();
+}
+
+void
+SoftVideoStabilizer::stop ()
+{
+    if (_pool.ptr ())
+        _pool->stop ();
+    _warp->stop ();
+    reset ();
+}
+
+XCamReturn
+SoftVideoStabilizer::stabilize (const SmartPtr<VideoBuffer> &in, SmartPtr<VideoBuffer> &out)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _pool.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "SoftVideoStabilizer stabilize failed, prepare it first");
+    XCAM_ASSERT (in.ptr ());
+
+    SmartPtr<SoftStabFrame> frame = new SoftStabFrame;
+    frame->buf = in;
+    frame->timestamp = in->get_timestamp ();
+
+    SmartPtr<DevicePose> data = in->find_typed_metadata<DevicePose> ();
+    while (data.ptr ()) {
+        frame->poses.push_back (data);
+        in->remove_metadata (data);
+        data = in->find_typed_metadata<DevicePose> ();
+    }
+
+    _input_frame_id++;
+    if (_last_frame.ptr ()) {
+        Mat3d homography = analyze_motion (
+                               _last_frame->timestamp, _last_frame->poses,
+                               frame->timestamp, frame->poses);
+        if (_motions.size () >= 2 * _filter_radius + 1) {
+            _motions.pop_front ();
+        }
+        _motions.push_back (homography);
+    }
+    _last_frame = frame;
+    _frames.push_back (frame);
+
+    if (_frames.size () <= _filter_radius) {
+        return XCAM_RETURN_BYPASS;
+    }
+
+    SmartPtr<SoftStabFrame> stab_frame = _frames.front ();
+    _frames.pop_front ();
+
+    int32_t stab_pos = (int32_t)_motions.size () - (int32_t)_filter_radius;
+    XCAM_LOG_DEBUG (
+        "input id(%ld), stab id(%ld), stab pos(%d), filter r(%d)",
+        _input_frame_id, _input_frame_id - _filter_radius, stab_pos, _filter_radius);
+
+    Mat3d proj_mat = _motion_filter->stabilize (stab_pos, _motions, _motions.size ());
+    calc_warp_mats (stab_frame, proj_mat);
+
+    SmartPtr<VideoBuffer> out_buf = _pool->get_buffer (_pool);
+    XCAM_FAIL_RETURN (
+        WARNING, out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+        "SoftVideoStabilizer output pool stopped");
+
+    XCamReturn ret = _warp->warp (stab_frame->buf, out_buf, _warp_mats, _rs_rows);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "SoftVideoStabilizer warp frame(%ld) failed", _input_frame_id - _filter_radius);
+
+    out = out_buf;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+Mat3d
+SoftVideoStabilizer::analyze_motion (
+    int64_t frame0_ts,
+    DevicePoseList &pose0_list,
+    int64_t frame1_ts,
+    DevicePoseList &pose1_list)
+{
+    if (pose0_list.empty () || pose1_list.empty ()) {
+        return Mat3d ();
+    }
+
+    Mat3d ext0 = _projector->calc_camera_extrinsics (frame0_ts, pose0_list);
+    Mat3d ext1 = _projector->calc_camera_extrinsics (frame1_ts, pose1_list);
+
+    Mat3d extrinsic0 = _projector->align_coordinate_system (_world_to_device, ext0, _device_to_image);
+    Mat3d extrinsic1 = _projector->align_coordinate_system (_world_to_device, ext1, _device_to_image);
+
+    return _projector->calc_projective (extrinsic0, extrinsic1);
+}
+
+void
+SoftVideoStabilizer::calc_warp_mats (const SmartPtr<SoftStabFrame> &frame, const Mat3d &proj_mat)
+{
+    // stabilized output back to the frame at readout start
+    Mat3d stab_inv = proj_mat;
+    stab_inv = stab_inv.inverse ();
+
+    const uint32_t height = _pool->get_video_info ().height;
+    if (!_rs_rows || _calib_params.readout_time <= 0.0 || frame->poses.empty ()) {
+        _warp_mats.assign (1, stab_inv);
+        return;
+    }
+
+    // then to the pose when the middle row of each block was read out
+    uint32_t blocks = xcam_ceil (height, _rs_rows) / _rs_rows;
+    _warp_mats.resize (blocks);
+    for (uint32_t i = 0; i < blocks; ++i) {
+        double row = XCAM_MIN (i * _rs_rows + _rs_rows / 2, height - 1);
+        // readout_time and timestamps are both in microseconds
+        int64_t row_ts = frame->timestamp + (int64_t)(_calib_params.readout_time * row / height);
+        Mat3d rs_mat = analyze_motion (frame->timestamp, frame->poses, row_ts, frame->poses);
+        _warp_mats[i] = rs_mat * stab_inv;
+    }
+}
+
+}
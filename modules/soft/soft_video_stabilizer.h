@@ -0,0 +1,137 @@
+/*
+ * soft_video_stabilizer.h - CPU image warp and gyro based video stabilizer
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SOFT_VIDEO_STABILIZER_H
+#define XCAM_SOFT_VIDEO_STABILIZER_H
+
+#include <xcam_std.h>
+#include <video_buffer.h>
+#include <buffer_pool.h>
+#include <meta_data.h>
+#include <vec_mat.h>
+#include <image_projector.h>
+#include <vector>
+
+namespace XCam {
+
+class ThreadPool;
+class SoftImageWarpTask;
+struct SoftStabFrame;
+
+/*
+ * Warps NV12 frames by homographies which map output pixels to input pixels,
+ * bilinear sampled and clamped to edge as CLImageWarpHandler does.
+ * One matrix covers rows_step output rows, so a single matrix gives a per-frame
+ * warp and a matrix per row block corrects rolling shutter.
+ * Rows are split into bands which run on a thread pool.
+ */
+class SoftImageWarp
+{
+    friend class SoftImageWarpTask;
+
+public:
+    explicit SoftImageWarp (uint32_t thread_num = 0);
+    ~SoftImageWarp ();
+
+    XCamReturn warp (
+        const SmartPtr<VideoBuffer> &in, const SmartPtr<VideoBuffer> &out,
+        const std::vector<Mat3d> &proj_mats, uint32_t rows_step);
+    void stop ();
+
+private:
+    void warp_rows (const uint8_t *in_mem, uint8_t *out_mem, uint32_t start, uint32_t end);
+
+    XCAM_DEAD_COPY (SoftImageWarp);
+
+private:
+    uint32_t                  _thread_num;
+    VideoBufferInfo           _in_info;
+    VideoBufferInfo           _out_info;
+    // row major 3x3 matrices for luma and chroma planes
+    std::vector<float>        _luma_mats;
+    std::vector<float>        _chroma_mats;
+    uint32_t                  _rows_step;
+    SmartPtr<ThreadPool>      _threads;
+};
+
+/*
+ * CPU counterpart of CLVideoStabilizer, DevicePose metadata attached to input
+ * buffers drives the motion analysis, output is delayed by the motion filter
+ * radius. With rolling shutter rows set, each block of rows is also corrected
+ * to the pose at the start of frame readout, using calibration readout_time
+ * in microseconds.
+ */
+class SoftVideoStabilizer
+{
+public:
+    explicit SoftVideoStabilizer (uint32_t thread_num = 0);
+    ~SoftVideoStabilizer ();
+
+    XCamReturn set_camera_calibration (CalibrationParams &params);
+    XCamReturn set_camera_intrinsics (
+        double focal_x,
+        double focal_y,
+        double offset_x,
+        double offset_y,
+        double skew);
+    XCamReturn align_coordinate_system (
+        CoordinateSystemConv &world_to_device,
+        CoordinateSystemConv &device_to_image);
+    XCamReturn set_motion_filter (uint32_t radius, float stdev);
+    // rows of each rolling shutter correction block, 0 disables correction
+    bool set_rolling_shutter_rows (uint32_t rows);
+
+    XCamReturn prepare (const VideoBufferInfo &info, uint32_t buf_count = 4);
+    // returns XCAM_RETURN_BYPASS until filter radius frames are queued
+    XCamReturn stabilize (const SmartPtr<VideoBuffer> &in, SmartPtr<VideoBuffer> &out);
+    void reset ();
+    void stop ();
+
+private:
+    Mat3d analyze_motion (
+        int64_t frame0_ts,
+        DevicePoseList &pose0_list,
+        int64_t frame1_ts,
+        DevicePoseList &pose1_list);
+    void calc_warp_mats (const SmartPtr<SoftStabFrame> &frame, const Mat3d &proj_mat);
+
+    XCAM_DEAD_COPY (SoftVideoStabilizer);
+
+private:
+    SmartPtr<ImageProjector>              _projector;
+    SmartPtr<MotionFilter>                _motion_filter;
+    SmartPtr<SoftImageWarp>               _warp;
+    SmartPtr<BufferPool>                  _pool;
+    CalibrationParams                     _calib_params;
+    CoordinateSystemConv                  _world_to_device;
+    CoordinateSystemConv                  _device_to_image;
+    uint32_t                              _filter_radius;
+    uint32_t                              _rs_rows;
+
+    int64_t                               _input_frame_id;
+    SmartPtr<SoftStabFrame>               _last_frame;
+    std::list<SmartPtr<SoftStabFrame> >   _frames;
+    std::list<Mat3d>                      _motions; //motions[i] calculated from frame i to i+1
+    std::vector<Mat3d>                    _warp_mats;
+};
+
+}
+
+#endif //XCAM_SOFT_VIDEO_STABILIZER_H
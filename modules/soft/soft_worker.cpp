@@ -19,6 +19,7 @@
  */
 
 #include "soft_worker.h"
+#include "soft_handler.h"
 #include "thread_pool.h"
 #include "xcam_mutex.h"
 
@@ -56,11 +57,11 @@ class WorkItem
 public:
     WorkItem (
         const SmartPtr<SoftWorker> &worker,
-        const SmartPtr<Worker::Arguments> &args,
+        SmartPtr<Worker::Arguments> args,
         const WorkSize &item,
         SmartPtr<ItemSynch> &sync)
         : _worker (worker)
-        , _args (args)
+        , _args (std::move (args))
         , _item (item)
         , _sync (sync)
     {
@@ -145,6 +146,13 @@ SoftWorker::stop ()
 
 XCamReturn
 SoftWorker::work (const SmartPtr<Worker::Arguments> &args)
+{
+    SmartPtr<Worker::Arguments> work_args = args;
+    return work (std::move (work_args));
+}
+
+XCamReturn
+SoftWorker::work (SmartPtr<Worker::Arguments> &&args)
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
@@ -172,27 +180,44 @@ SoftWorker::work (const SmartPtr<Worker::Arguments> &args)
         return ret;
     }
 
-    if (!_threads.ptr ()) {
+    SmartPtr<ThreadPool> threads = _threads;
+    int64_t priority = 0;
+    SmartPtr<SoftArgs> soft_args = args.dynamic_cast_ptr<SoftArgs> ();
+    if (soft_args.ptr () && soft_args->get_param ().ptr ()) {
+        SmartPtr<SoftScheduleMeta> schedule = soft_args->get_param ()->find_meta<SoftScheduleMeta> ();
+        if (schedule.ptr ()) {
+            priority = schedule->priority;
+            if (schedule->threads.ptr ())
+                threads = schedule->threads;
+        }
+    }
+
+    if (!threads.ptr ()) {
         char thr_name [XCAM_MAX_STR_SIZE];
         snprintf (thr_name, XCAM_MAX_STR_SIZE, "%s-thrs", XCAM_STR(get_name ()));
 
-        SmartPtr<ThreadPool> threads = new ThreadPool (thr_name);
-        XCAM_ASSERT (threads.ptr ());
-        _threads = threads;
+        _threads = new ThreadPool (thr_name);
+        XCAM_ASSERT (_threads.ptr ());
         _threads->set_threads (max_items, max_items + 1); //extra thread to process all_items_done
         ret = _threads->start ();
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
             "SoftWorker(%s) work failed when starting threads", XCAM_STR(get_name()));
+        threads = _threads;
     }
 
-    SmartPtr<ItemSynch> sync = new ItemSynch (max_items);
+    SmartPtr<ItemSynch> sync = make_smart_ptr<ItemSynch> (max_items);
+    uint32_t remain_items = max_items;
     for (uint32_t z = 0; z < items.value[2]; ++z)
         for (uint32_t y = 0; y < items.value[1]; ++y)
             for (uint32_t x = 0; x < items.value[0]; ++x)
             {
-                SmartPtr<WorkItem> item = new WorkItem (this, args, WorkSize(x, y, z), sync);
-                ret = _threads->queue (item);
+                // the last item takes over args
+                SmartPtr<WorkItem> item = (--remain_items) ?
+                                          make_smart_ptr<WorkItem> (this, args, WorkSize(x, y, z), sync) :
+                                          make_smart_ptr<WorkItem> (this, std::move (args), WorkSize(x, y, z), sync);
+                item->set_priority (priority);
+                ret = threads->queue (item);
                 if (!xcam_ret_is_ok (ret)) {
                     //consider half queued but half failed
                     sync->update_error (ret);
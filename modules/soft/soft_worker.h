@@ -57,6 +57,7 @@ public:
 
     // derived from Worker
     virtual XCamReturn work (const SmartPtr<Arguments> &args);
+    virtual XCamReturn work (SmartPtr<Arguments> &&args);
     virtual XCamReturn stop ();
 
 private:
@@ -0,0 +1,217 @@
+/*
+ * test-buffer-pool.cpp - test buffer pool timeout, growth and shrink
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include <buffer_pool.h>
+#include <xcam_metrics.h>
+#include <unistd.h>
+#include <vector>
+
+#define TEST_POOL_WIDTH 64
+#define TEST_POOL_HEIGHT 32
+#define TEST_POOL_RESERVE 2
+#define TEST_POOL_MAX_EXTRA 3
+#define TEST_POOL_TIMEOUT 20000        // us
+#define TEST_POOL_TIMEOUT_SLACK 500000 // us
+#define TEST_POOL_SHRINK_IDLE 50       // ms
+
+using namespace XCam;
+
+class TestMemData
+    : public BufferData
+{
+public:
+    explicit TestMemData (uint32_t size)
+        : _data (size)
+    {}
+
+    virtual uint8_t *map () {
+        return _data.data ();
+    }
+    virtual bool unmap () {
+        return true;
+    }
+
+private:
+    std::vector<uint8_t> _data;
+};
+
+class TestMemPool
+    : public BufferPool
+{
+protected:
+    virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &info, const void *in_data) {
+        XCAM_UNUSED (in_data);
+        return new TestMemData (info.size);
+    }
+};
+
+typedef std::vector<SmartPtr<VideoBuffer>> BufferVector;
+
+static SmartPtr<BufferPool>
+create_pool ()
+{
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_NV12, TEST_POOL_WIDTH, TEST_POOL_HEIGHT);
+
+    SmartPtr<BufferPool> pool = new TestMemPool;
+    if (!pool->set_video_info (info) || !pool->reserve (TEST_POOL_RESERVE))
+        return NULL;
+    return pool;
+}
+
+static int
+take_buffers (const SmartPtr<BufferPool> &pool, uint32_t count, BufferVector &bufs)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        SmartPtr<VideoBuffer> buf = pool->get_buffer (pool, 0);
+        CHECK_EXP (buf.ptr (), "get buffer %d of %d failed", i, count);
+        bufs.push_back (buf);
+    }
+    return 0;
+}
+
+// elapsed time of a get_buffer expected to time out, -1 if it returned a buffer
+static int64_t
+time_out_get (const SmartPtr<BufferPool> &pool, bool pool_timeout)
+{
+    int64_t start = LatencyStats::now_us ();
+    SmartPtr<VideoBuffer> buf =
+        pool_timeout ? pool->get_buffer (pool) : pool->get_buffer (pool, TEST_POOL_TIMEOUT);
+    if (buf.ptr ())
+        return -1;
+    return LatencyStats::now_us () - start;
+}
+
+static int
+test_timeout ()
+{
+    SmartPtr<BufferPool> pool = create_pool ();
+    CHECK_EXP (pool.ptr (), "create pool failed");
+
+    BufferVector bufs;
+    CHECK_EXP (take_buffers (pool, TEST_POOL_RESERVE, bufs) == 0, "take reserved buffers failed");
+    CHECK_EXP (!pool->has_free_buffers (), "pool still has free buffers after taking all");
+
+    // timeout given per call
+    int64_t elapsed = time_out_get (pool, false);
+    CHECK_EXP (elapsed >= 0, "get_buffer returned a buffer from an exhausted pool");
+    CHECK_EXP (
+        elapsed >= TEST_POOL_TIMEOUT && elapsed < TEST_POOL_TIMEOUT + TEST_POOL_TIMEOUT_SLACK,
+        "get_buffer timed out after %" PRId64 "us, expected %dus", elapsed, TEST_POOL_TIMEOUT);
+
+    // timeout set on the pool
+    pool->set_acquire_timeout (TEST_POOL_TIMEOUT);
+    elapsed = time_out_get (pool, true);
+    CHECK_EXP (elapsed >= 0, "get_buffer returned a buffer from an exhausted pool");
+    CHECK_EXP (
+        elapsed >= TEST_POOL_TIMEOUT && elapsed < TEST_POOL_TIMEOUT + TEST_POOL_TIMEOUT_SLACK,
+        "pool acquire timeout after %" PRId64 "us, expected %dus", elapsed, TEST_POOL_TIMEOUT);
+
+    // a released buffer is handed out again
+    bufs.pop_back ();
+    CHECK_EXP (pool->get_free_buffer_size () == 1, "released buffer not back in pool");
+    SmartPtr<VideoBuffer> buf = pool->get_buffer (pool, TEST_POOL_TIMEOUT);
+    CHECK_EXP (buf.ptr (), "get released buffer failed");
+
+    BufferPool::Metrics metrics;
+    pool->get_metrics (metrics);
+    CHECK_EXP (
+        metrics.acquired == TEST_POOL_RESERVE + 1,
+        "acquired %" PRIu64 " buffers, expected %d", metrics.acquired, TEST_POOL_RESERVE + 1);
+    CHECK_EXP (
+        metrics.starved_wait.errors == 2 && metrics.grown == 0,
+        "starved errors:%" PRIu64 " grown:%" PRIu64 ", expected 2 and 0",
+        metrics.starved_wait.errors, metrics.grown);
+
+    printf ("get_buffer timeout passed\n");
+    return 0;
+}
+
+static int
+test_growth_and_shrink ()
+{
+    SmartPtr<BufferPool> pool = create_pool ();
+    CHECK_EXP (pool.ptr (), "create pool failed");
+    pool->set_growth (TEST_POOL_MAX_EXTRA, TEST_POOL_SHRINK_IDLE);
+
+    // starved gets allocate instead of waiting, up to max_extra
+    BufferVector bufs;
+    const uint32_t total = TEST_POOL_RESERVE + TEST_POOL_MAX_EXTRA;
+    CHECK_EXP (take_buffers (pool, total, bufs) == 0, "take reserved and extra buffers failed");
+    CHECK_EXP (time_out_get (pool, false) >= 0, "pool grew beyond max_extra");
+
+    BufferPool::Metrics metrics;
+    pool->get_metrics (metrics);
+    CHECK_EXP (
+        metrics.grown == TEST_POOL_MAX_EXTRA && metrics.starved_wait.errors == 1,
+        "grown:%" PRIu64 " starved errors:%" PRIu64 ", expected %d and 1",
+        metrics.grown, metrics.starved_wait.errors, TEST_POOL_MAX_EXTRA);
+
+    // released right after starving, extra buffers stay in the pool
+    bufs.clear ();
+    pool->get_metrics (metrics);
+    CHECK_EXP (
+        metrics.shrunk == 0 && pool->get_free_buffer_size () == total,
+        "pool shrunk %" PRIu64 " buffers with %d free right after starving, expected 0 and %d",
+        metrics.shrunk, pool->get_free_buffer_size (), total);
+
+    // without starving for shrink_idle, released extra buffers are freed
+    usleep (TEST_POOL_SHRINK_IDLE * 2 * 1000);
+    CHECK_EXP (take_buffers (pool, total, bufs) == 0, "take kept extra buffers failed");
+    bufs.clear ();
+    pool->get_metrics (metrics);
+    CHECK_EXP (
+        metrics.shrunk == TEST_POOL_MAX_EXTRA && pool->get_free_buffer_size () == TEST_POOL_RESERVE,
+        "pool shrunk %" PRIu64 " buffers with %d free after idle, expected %d and %d",
+        metrics.shrunk, pool->get_free_buffer_size (), TEST_POOL_MAX_EXTRA, TEST_POOL_RESERVE);
+
+    // a shrunk pool grows again on the next burst
+    CHECK_EXP (take_buffers (pool, total, bufs) == 0, "take buffers after shrink failed");
+    pool->get_metrics (metrics);
+    CHECK_EXP (
+        metrics.grown == TEST_POOL_MAX_EXTRA * 2,
+        "grown %" PRIu64 " buffers after shrink, expected %d", metrics.grown, TEST_POOL_MAX_EXTRA * 2);
+
+    printf ("buffer pool growth and shrink passed\n");
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s\n"
+            "\ttests get_buffer timeout, growth up to max_extra and shrink on idle\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1) {
+        usage (argv[0]);
+        return 0;
+    }
+
+    CHECK_EXP (test_timeout () == 0, "buffer pool timeout test failed");
+    CHECK_EXP (test_growth_and_shrink () == 0, "buffer pool growth test failed");
+
+    printf ("buffer pool tests passed\n");
+    return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * test-capture-reactor.cpp - test capture reactor on raw file sources
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include <capture_reactor.h>
+#include <time.h>
+#include <vector>
+
+#define TEST_REACTOR_MAX_SOURCES 4
+#define TEST_REACTOR_WIDTH 64
+#define TEST_REACTOR_HEIGHT 32
+#define TEST_REACTOR_FILE_FRAMES 4
+#define TEST_REACTOR_RUN_TIME 300000   // us
+
+using namespace XCam;
+
+class TestMemData
+    : public BufferData
+{
+public:
+    explicit TestMemData (uint32_t size)
+        : _data (size)
+    {}
+
+    virtual uint8_t *map () {
+        return _data.data ();
+    }
+    virtual bool unmap () {
+        return true;
+    }
+
+private:
+    std::vector<uint8_t> _data;
+};
+
+class TestMemPool
+    : public BufferPool
+{
+protected:
+    virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &info, const void *in_data) {
+        XCAM_UNUSED (in_data);
+        return new TestMemData (info.size);
+    }
+};
+
+// checks every set as it comes, holding its buffers if asked
+class TestReactorCallback
+    : public CaptureReactorCallback
+{
+public:
+    TestReactorCallback (uint32_t source_num, int64_t skew, bool hold)
+        : _source_num (source_num)
+        , _skew (skew)
+        , _hold (hold)
+        , _last_timestamp (-1)
+        , _set_num (0)
+        , _dropped_num (0)
+        , _error_num (0)
+    {}
+
+    virtual XCamReturn frame_set_ready (CaptureReactor *reactor, const VideoBufferList &bufs) {
+        XCAM_UNUSED (reactor);
+        ++_set_num;
+        if (bufs.size () != _source_num) {
+            ++_error_num;
+            return XCAM_RETURN_ERROR_PARAM;
+        }
+
+        int64_t timestamp = bufs.front ()->get_timestamp ();
+        uint32_t index = 0;
+        for (VideoBufferList::const_iterator i = bufs.begin (); i != bufs.end (); ++i, ++index) {
+            const SmartPtr<VideoBuffer> &buf = *i;
+            int64_t diff = buf->get_timestamp () - timestamp;
+            // sets are ordered by source index
+            if (buf->map ()[0] != index || diff > _skew || diff < -_skew)
+                ++_error_num;
+            buf->unmap ();
+        }
+        if (timestamp <= _last_timestamp)
+            ++_error_num;
+        _last_timestamp = timestamp;
+
+        if (_hold)
+            _held.insert (_held.end (), bufs.begin (), bufs.end ());
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    virtual void frame_set_dropped (CaptureReactor *reactor, int64_t timestamp, uint32_t ready_num) {
+        XCAM_UNUSED (reactor);
+        XCAM_UNUSED (timestamp);
+        ++_dropped_num;
+        if (!ready_num || ready_num >= _source_num)
+            ++_error_num;
+    }
+
+    uint32_t get_set_num () const {
+        return _set_num;
+    }
+    uint32_t get_dropped_num () const {
+        return _dropped_num;
+    }
+    uint32_t get_error_num () const {
+        return _error_num;
+    }
+
+private:
+    uint32_t         _source_num;
+    int64_t          _skew;
+    bool             _hold;
+    int64_t          _last_timestamp;
+    uint32_t         _set_num;
+    uint32_t         _dropped_num;
+    uint32_t         _error_num;
+    VideoBufferList  _held;
+};
+
+static int64_t
+get_monotonic_time ()
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return XCAM_TIMESPEC_2_USEC (now);
+}
+
+static void
+get_raw_name (char *name, uint32_t size, uint32_t index)
+{
+    snprintf (name, size, "test-capture-reactor-%d.nv12", index);
+}
+
+// first byte of a frame is the source index, the second the frame in the file
+static bool
+write_raw_file (uint32_t index, const VideoBufferInfo &info)
+{
+    char name[XCAM_MAX_STR_SIZE];
+    get_raw_name (name, sizeof (name), index);
+    FILE *fp = fopen (name, "wb");
+    if (!fp)
+        return false;
+
+    std::vector<uint8_t> frame (info.width * info.height * 3 / 2, 128);
+    bool ret = true;
+    for (uint32_t i = 0; i < TEST_REACTOR_FILE_FRAMES && ret; ++i) {
+        frame[0] = index;
+        frame[1] = i;
+        ret = fwrite (frame.data (), 1, frame.size (), fp) == frame.size ();
+    }
+    fclose (fp);
+    return ret;
+}
+
+static int
+add_sources (
+    CaptureReactor &reactor, const VideoBufferInfo &info,
+    const uint32_t *fps, uint32_t num, uint32_t reserve)
+{
+    for (uint32_t i = 0; i < num; ++i) {
+        char name[XCAM_MAX_STR_SIZE];
+        get_raw_name (name, sizeof (name), i);
+
+        SmartPtr<BufferPool> pool = new TestMemPool;
+        CHECK_EXP (pool->set_video_info (info) && pool->reserve (reserve), "reserve pool of source %d failed", i);
+        CHECK_EXP (reactor.add_raw_source (name, pool, fps[i]) == (int) i, "add raw source %d failed", i);
+    }
+    return 0;
+}
+
+static int
+run_reactor (
+    const VideoBufferInfo &info, const uint32_t *fps, uint32_t num, uint32_t reserve,
+    bool hold, SmartPtr<TestReactorCallback> &callback)
+{
+    CaptureReactor reactor;
+    CHECK_EXP (add_sources (reactor, info, fps, num, reserve) == 0, "add sources failed");
+
+    callback = new TestReactorCallback (num, 5000, hold);
+    CHECK_EXP (reactor.set_skew_tolerance (5000), "set skew tolerance failed");
+    CHECK_EXP (reactor.set_callback (callback), "set callback failed");
+    CHECK (reactor.start (), "start reactor failed");
+    CHECK_EXP (!reactor.set_callback (callback), "set callback on a started reactor");
+
+    usleep (TEST_REACTOR_RUN_TIME);
+
+    int64_t begin = get_monotonic_time ();
+    CHECK (reactor.stop (), "stop reactor failed");
+    CHECK_EXP (get_monotonic_time () - begin < 1000000, "stop reactor took over 1s");
+
+    return 0;
+}
+
+static int
+test_same_rate (const VideoBufferInfo &info)
+{
+    const uint32_t fps[] = {100, 100, 100};
+    SmartPtr<TestReactorCallback> callback;
+    CHECK_EXP (run_reactor (info, fps, 3, 4, false, callback) == 0, "run same rate sources failed");
+
+    printf ("same rate: %d sets, %d dropped\n", callback->get_set_num (), callback->get_dropped_num ());
+    CHECK_EXP (callback->get_error_num () == 0, "same rate sets got %d errors", callback->get_error_num ());
+    // 30 sets expected, keep margin for a loaded host
+    CHECK_EXP (callback->get_set_num () >= 10, "same rate sources gave only %d sets", callback->get_set_num ());
+    return 0;
+}
+
+static int
+test_mixed_rate (const VideoBufferInfo &info)
+{
+    const uint32_t fps[] = {100, 100, 50};
+    SmartPtr<TestReactorCallback> callback;
+    CHECK_EXP (run_reactor (info, fps, 3, 4, false, callback) == 0, "run mixed rate sources failed");
+
+    // every other frame of the fast sources lacks a slow one
+    printf ("mixed rate: %d sets, %d dropped\n", callback->get_set_num (), callback->get_dropped_num ());
+    CHECK_EXP (callback->get_error_num () == 0, "mixed rate sets got %d errors", callback->get_error_num ());
+    CHECK_EXP (callback->get_set_num () >= 5, "mixed rate sources gave only %d sets", callback->get_set_num ());
+    CHECK_EXP (callback->get_dropped_num () >= 5, "mixed rate sources dropped only %d sets", callback->get_dropped_num ());
+    return 0;
+}
+
+// raw frames are skipped while the pools are empty, the reactor never waits on them
+static int
+test_exhausted_pool (const VideoBufferInfo &info)
+{
+    const uint32_t fps[] = {100, 100};
+    SmartPtr<TestReactorCallback> callback;
+    CHECK_EXP (run_reactor (info, fps, 2, 2, true, callback) == 0, "run sources with held buffers failed");
+
+    printf ("exhausted pool: %d sets, %d dropped\n", callback->get_set_num (), callback->get_dropped_num ());
+    CHECK_EXP (callback->get_error_num () == 0, "held sets got %d errors", callback->get_error_num ());
+    CHECK_EXP (callback->get_set_num () == 2, "got %d sets from pools of 2 buffers", callback->get_set_num ());
+    return 0;
+}
+
+static int
+test_invalid_setup (const VideoBufferInfo &info)
+{
+    CaptureReactor reactor;
+    SmartPtr<BufferPool> pool = new TestMemPool;
+    CHECK_EXP (pool->set_video_info (info) && pool->reserve (2), "reserve pool failed");
+
+    CHECK_EXP (reactor.add_raw_source ("none.nv12", pool, 0) < 0, "added a raw source of 0 fps");
+    CHECK_EXP (reactor.start () != XCAM_RETURN_NO_ERROR, "started without sources");
+
+    CHECK_EXP (reactor.add_raw_source ("test-capture-reactor-missing.nv12", pool, 30) == 0, "add raw source failed");
+    CHECK_EXP (reactor.start () != XCAM_RETURN_NO_ERROR, "started without callback");
+
+    CHECK_EXP (reactor.set_callback (new TestReactorCallback (1, 5000, false)), "set callback failed");
+    CHECK_EXP (reactor.start () != XCAM_RETURN_NO_ERROR, "started with a missing raw file");
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s\n"
+            "\t--help              usage\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1) {
+        usage (argv[0]);
+        return strcmp (argv[1], "--help") ? -1 : 0;
+    }
+
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_NV12, TEST_REACTOR_WIDTH, TEST_REACTOR_HEIGHT);
+    for (uint32_t i = 0; i < TEST_REACTOR_MAX_SOURCES; ++i)
+        CHECK_EXP (write_raw_file (i, info), "write raw file %d failed", i);
+
+    int ret = 0;
+    if (test_same_rate (info) || test_mixed_rate (info) || test_exhausted_pool (info) || test_invalid_setup (info))
+        ret = -1;
+
+    for (uint32_t i = 0; i < TEST_REACTOR_MAX_SOURCES; ++i) {
+        char name[XCAM_MAX_STR_SIZE];
+        get_raw_name (name, sizeof (name), i);
+        unlink (name);
+    }
+
+    CHECK_EXP (ret == 0, "capture reactor tests failed");
+    printf ("capture reactor tests passed\n");
+    return 0;
+}
@@ -0,0 +1,306 @@
+/*
+ * test-partitioned-stitcher.cpp - test panorama stitched in strips by worker processes
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include "test_sv_params.h"
+#include <partitioned_stitcher.h>
+#include <image_file.h>
+#include <soft/soft_video_buf_allocator.h>
+#include <vector>
+
+#define TEST_PARTITION_CAMERAS 4
+
+using namespace XCam;
+
+typedef std::vector<uint8_t> FrameData;
+
+static SmartPtr<Stitcher>
+create_stitcher (uint32_t out_width, uint32_t out_height)
+{
+    SmartPtr<Stitcher> stitcher = Stitcher::create_soft_stitcher ();
+    XCAM_ASSERT (stitcher.ptr ());
+
+    float range[XCAM_STITCH_FISHEYE_MAX_NUM];
+    stitcher->set_camera_num (TEST_PARTITION_CAMERAS);
+    stitcher->set_output_size (out_width, out_height);
+    stitcher->set_dewarp_mode (DewarpBowl);
+    stitcher->set_blend_pyr_levels (2);
+    stitcher->set_viewpoints_range (viewpoints_range (CamB4C1080P, range));
+    stitcher->set_intrinsic_names (intrinsic_names);
+    stitcher->set_extrinsic_names (extrinsic_names);
+    return stitcher;
+}
+
+class TestStripFactory
+    : public PartitionedStitcher::StripFactory
+{
+public:
+    TestStripFactory (uint32_t out_width, uint32_t out_height)
+        : _out_width (out_width)
+        , _out_height (out_height)
+        , _fail_strip (-1)
+    {}
+
+    void set_fail_strip (int32_t strip) {
+        _fail_strip = strip;
+    }
+
+    virtual SmartPtr<Stitcher> create_stitcher (uint32_t strip, uint32_t strip_count) {
+        XCAM_UNUSED (strip_count);
+        if ((int32_t) strip == _fail_strip)
+            return NULL;
+        return ::create_stitcher (_out_width, _out_height);
+    }
+
+private:
+    uint32_t     _out_width;
+    uint32_t     _out_height;
+    int32_t      _fail_strip;
+};
+
+// a band changing with the frame, so frames out of order are told apart
+static void
+mark_frame (const SmartPtr<VideoBuffer> &buf, uint32_t frame)
+{
+    const VideoBufferInfo &info = buf->get_video_info ();
+    uint32_t row = (info.height / 4 + frame * 8) % info.height;
+    memset (buf->map () + info.strides[0] * row, frame * 30, info.strides[0] * 8);
+    buf->unmap ();
+}
+
+static XCamReturn
+read_inputs (const char **files, const VideoBufferInfo &info, VideoBufferList &ins)
+{
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+    XCAM_FAIL_RETURN (ERROR, pool->reserve (TEST_PARTITION_CAMERAS), XCAM_RETURN_ERROR_MEM, "reserve buffers failed");
+
+    for (uint32_t i = 0; i < TEST_PARTITION_CAMERAS; ++i) {
+        SmartPtr<VideoBuffer> buf = pool->get_buffer ();
+        XCAM_FAIL_RETURN (ERROR, buf.ptr (), XCAM_RETURN_ERROR_MEM, "get buffer failed");
+
+        ImageFile file;
+        XCamReturn ret = file.open (files[i], "rb");
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "open input file(%s) failed", files[i]);
+        ret = file.read_buf (buf);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "read input file(%s) failed", files[i]);
+
+        buf->set_timestamp (100 + i);
+        ins.push_back (buf);
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static int
+stitch_reference (
+    const char **files, const VideoBufferInfo &in_info, const VideoBufferInfo &out_info,
+    uint32_t frames, std::vector<FrameData> &refs)
+{
+    VideoBufferList ins;
+    CHECK (read_inputs (files, in_info, ins), "read inputs failed");
+
+    SmartPtr<Stitcher> stitcher = create_stitcher (out_info.width, out_info.height);
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        mark_frame (ins.front (), frame);
+
+        SmartPtr<VideoBuffer> out;
+        CHECK (stitcher->stitch_buffers (ins, out), "reference stitch frame %d failed", frame);
+        const uint8_t *ptr = out->map ();
+        refs.push_back (FrameData (ptr, ptr + out_info.size));
+        out->unmap ();
+    }
+    return 0;
+}
+
+static bool
+check_output (const SmartPtr<VideoBuffer> &out, const FrameData &ref)
+{
+    bool same = !memcmp (out->map (), ref.data (), ref.size ());
+    out->unmap ();
+    return same && out->get_timestamp () == 100;
+}
+
+static int
+test_strips (
+    const char **files, const VideoBufferInfo &in_info, const VideoBufferInfo &out_info,
+    uint32_t strips, const std::vector<FrameData> &refs)
+{
+    printf ("partitioned stitch in %d strips\n", strips);
+
+    VideoBufferList ins;
+    CHECK (read_inputs (files, in_info, ins), "read inputs failed");
+
+    VideoBufferInfo in_infos[TEST_PARTITION_CAMERAS];
+    for (uint32_t i = 0; i < TEST_PARTITION_CAMERAS; ++i)
+        in_infos[i] = in_info;
+
+    SmartPtr<TestStripFactory> factory = new TestStripFactory (out_info.width, out_info.height);
+    PartitionedStitcher stitcher (factory);
+    CHECK_EXP (stitcher.set_strip_count (strips), "set strip count %d failed", strips);
+    CHECK (stitcher.start (in_infos, TEST_PARTITION_CAMERAS, out_info), "start %d strips failed", strips);
+
+    // one frame stays in flight while the previous one is checked, an output held
+    // by the caller counts against the queue depth, so each is dropped before the next push
+    uint32_t popped = 0;
+    for (uint32_t frame = 0; frame < refs.size (); ++frame) {
+        mark_frame (ins.front (), frame);
+        CHECK (stitcher.push_frame (ins), "push frame %d failed", frame);
+        if (frame == 0)
+            continue;
+
+        SmartPtr<VideoBuffer> out;
+        CHECK (stitcher.pop_frame (out), "pop frame %d failed", popped);
+        CHECK_EXP (check_output (out, refs[popped]), "%d strips frame %d differs from single stitch", strips, popped);
+        ++popped;
+    }
+    SmartPtr<VideoBuffer> out;
+    CHECK (stitcher.pop_frame (out), "pop frame %d failed", popped);
+    SmartPtr<VideoBuffer> none;
+    CHECK_EXP (stitcher.pop_frame (none, 0) != XCAM_RETURN_NO_ERROR, "popped a frame never pushed");
+
+    // output stays mapped after the workers are gone
+    stitcher.stop ();
+    CHECK_EXP (check_output (out, refs[popped]), "%d strips frame %d differs from single stitch", strips, popped);
+
+    return 0;
+}
+
+static int
+test_failed_strip (const VideoBufferInfo &in_info, const VideoBufferInfo &out_info, uint32_t strips)
+{
+    VideoBufferInfo in_infos[TEST_PARTITION_CAMERAS];
+    for (uint32_t i = 0; i < TEST_PARTITION_CAMERAS; ++i)
+        in_infos[i] = in_info;
+
+    SmartPtr<TestStripFactory> factory = new TestStripFactory (out_info.width, out_info.height);
+    factory->set_fail_strip (strips - 1);
+
+    PartitionedStitcher stitcher (factory);
+    CHECK_EXP (stitcher.set_strip_count (strips), "set strip count %d failed", strips);
+    CHECK_EXP (
+        stitcher.start (in_infos, TEST_PARTITION_CAMERAS, out_info) != XCAM_RETURN_NO_ERROR,
+        "started with a strip lacking its stitcher");
+
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s --input front.nv12 --input right.nv12 --input rear.nv12 --input left.nv12\n"
+            "\t                    read calibration files from exported path $FISHEYE_CONFIG_PATH\n"
+            "\t--input             input image(NV12), one per camera: front, right, rear, left\n"
+            "\t--in-w              optional, input width, default: 1280\n"
+            "\t--in-h              optional, input height, default: 720\n"
+            "\t--out-w             optional, output width, default: 1920\n"
+            "\t--out-h             optional, output height, default: 640\n"
+            "\t--strips            optional, strip count, default: 1, 2, 4 and 8 in turn\n"
+            "\t--frames            optional, frames of each run, default: 4\n"
+            "\t--help              usage\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    const char *files[TEST_PARTITION_CAMERAS] = {NULL};
+    uint32_t input_count = 0;
+    uint32_t input_width = 1280;
+    uint32_t input_height = 720;
+    uint32_t output_width = 1920;
+    uint32_t output_height = 640;
+    uint32_t strips = 0;
+    uint32_t frames = 4;
+
+    const struct option long_opts[] = {
+        {"input", required_argument, NULL, 'i'},
+        {"in-w", required_argument, NULL, 'w'},
+        {"in-h", required_argument, NULL, 'h'},
+        {"out-w", required_argument, NULL, 'W'},
+        {"out-h", required_argument, NULL, 'H'},
+        {"strips", required_argument, NULL, 's'},
+        {"frames", required_argument, NULL, 'f'},
+        {"help", no_argument, NULL, 'e'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int opt = -1;
+    while ((opt = getopt_long (argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'i':
+            XCAM_ASSERT (optarg);
+            CHECK_EXP (input_count < TEST_PARTITION_CAMERAS, "too many inputs, expect %d", TEST_PARTITION_CAMERAS);
+            files[input_count++] = optarg;
+            break;
+        case 'w':
+            input_width = atoi (optarg);
+            break;
+        case 'h':
+            input_height = atoi (optarg);
+            break;
+        case 'W':
+            output_width = atoi (optarg);
+            break;
+        case 'H':
+            output_height = atoi (optarg);
+            break;
+        case 's':
+            strips = atoi (optarg);
+            break;
+        case 'f':
+            frames = atoi (optarg);
+            break;
+        case 'e':
+            usage (argv[0]);
+            return 0;
+        default:
+            XCAM_LOG_ERROR ("getopt_long return unknown value:%c", opt);
+            usage (argv[0]);
+            return -1;
+        }
+    }
+
+    if (optind < argc || input_count != TEST_PARTITION_CAMERAS) {
+        XCAM_LOG_ERROR ("partitioned stitcher needs %d inputs", TEST_PARTITION_CAMERAS);
+        usage (argv[0]);
+        return -1;
+    }
+    CHECK_EXP (strips <= XCAM_PARTITION_MAX_STRIPS, "strip count should not be greater than %d", XCAM_PARTITION_MAX_STRIPS);
+    CHECK_EXP (frames > 0, "frames should be greater than 0");
+
+    VideoBufferInfo in_info;
+    in_info.init (V4L2_PIX_FMT_NV12, input_width, input_height);
+    VideoBufferInfo out_info;
+    out_info.init (V4L2_PIX_FMT_NV12, output_width, output_height);
+
+    std::vector<FrameData> refs;
+    CHECK_EXP (stitch_reference (files, in_info, out_info, frames, refs) == 0, "single stitch failed");
+
+    const uint32_t strip_counts[] = {1, 2, 4, 8};
+    for (uint32_t i = 0; i < sizeof (strip_counts) / sizeof (strip_counts[0]); ++i) {
+        uint32_t count = strips ? strips : strip_counts[i];
+        CHECK_EXP (test_strips (files, in_info, out_info, count, refs) == 0, "partitioned stitch in %d strips failed", count);
+        if (strips)
+            break;
+    }
+
+    CHECK_EXP (test_failed_strip (in_info, out_info, strips ? strips : 2) == 0, "partitioned stitcher failed strip check failed");
+
+    printf ("partitioned stitcher tests passed\n");
+    return 0;
+}
@@ -0,0 +1,293 @@
+/*
+ * test-record-file.cpp - test indexed multi-camera recording file
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include <record_file.h>
+#include <meta_data.h>
+#include <vector>
+
+#define TEST_RECORD_CAMERAS 2
+#define TEST_RECORD_FRAMES 12
+#define TEST_RECORD_WIDTH 320
+#define TEST_RECORD_HEIGHT 240
+#define TEST_RECORD_INTERVAL 33333   // us
+
+using namespace XCam;
+
+class TestMemBuffer
+    : public VideoBuffer
+{
+public:
+    explicit TestMemBuffer (const VideoBufferInfo &info)
+        : VideoBuffer (info)
+        , _data (info.size)
+    {}
+
+    virtual uint8_t *map () {
+        return _data.data ();
+    }
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+
+private:
+    std::vector<uint8_t> _data;
+};
+
+static int64_t
+get_frame_timestamp (uint32_t frame)
+{
+    return 1000000 + (int64_t) frame * TEST_RECORD_INTERVAL;
+}
+
+// smooth pattern with noise in the chroma, so planes compress differently
+static uint8_t
+get_pixel (uint32_t frame, uint32_t camera, uint32_t pos, uint32_t luma_size)
+{
+    if (pos < luma_size)
+        return (uint8_t) ((pos / TEST_RECORD_WIDTH + frame * 3 + camera * 50) & 0xFF);
+    return (uint8_t) (((pos * 2654435761u) >> 13) + frame + camera);
+}
+
+static void
+fill_frame (uint32_t frame, VideoBufferList &bufs, const VideoBufferInfo &info)
+{
+    bufs.clear ();
+    for (uint32_t camera = 0; camera < TEST_RECORD_CAMERAS; ++camera) {
+        SmartPtr<VideoBuffer> buf = new TestMemBuffer (info);
+        uint8_t *ptr = buf->map ();
+        for (uint32_t pos = 0; pos < info.size; ++pos)
+            ptr[pos] = get_pixel (frame, camera, pos, info.offsets[1]);
+        buf->set_timestamp (get_frame_timestamp (frame) + camera);
+
+        if (camera == 0) {
+            SmartPtr<DevicePose> pose = new DevicePose ();
+            pose->orientation[3] = 1.0;
+            pose->translation[0] = frame;
+            pose->confidence = frame + 1;
+            buf->add_metadata (pose);
+        }
+        bufs.push_back (buf);
+    }
+}
+
+static bool
+check_frame (uint32_t frame, const VideoBufferList &bufs, const VideoBufferInfo &info)
+{
+    if (bufs.size () != TEST_RECORD_CAMERAS)
+        return false;
+
+    uint32_t camera = 0;
+    for (VideoBufferList::const_iterator i = bufs.begin (); i != bufs.end (); ++i, ++camera) {
+        const SmartPtr<VideoBuffer> &buf = *i;
+        if (buf->get_timestamp () != get_frame_timestamp (frame) + camera)
+            return false;
+
+        const uint8_t *ptr = buf->map ();
+        for (uint32_t pos = 0; pos < info.size; ++pos) {
+            if (ptr[pos] != get_pixel (frame, camera, pos, info.offsets[1]))
+                return false;
+        }
+        buf->unmap ();
+
+        SmartPtr<DevicePose> pose = buf->find_typed_metadata<DevicePose> ();
+        if (camera == 0 && (!pose.ptr () || pose->translation[0] != frame || pose->confidence != frame + 1))
+            return false;
+        if (camera != 0 && pose.ptr ())
+            return false;
+    }
+    return true;
+}
+
+static int
+write_recording (const char *name, const VideoBufferInfo &info, bool compress)
+{
+    VideoBufferInfo infos[TEST_RECORD_CAMERAS];
+    for (uint32_t i = 0; i < TEST_RECORD_CAMERAS; ++i)
+        infos[i] = info;
+
+    RecordFileWriter writer;
+    CHECK_EXP (writer.set_compression (compress), "set compression failed");
+    CHECK (writer.open (name, infos, TEST_RECORD_CAMERAS), "open %s to write failed", name);
+
+    VideoBufferList bufs;
+    for (uint32_t frame = 0; frame < TEST_RECORD_FRAMES; ++frame) {
+        fill_frame (frame, bufs, info);
+        CHECK (writer.write_frame (bufs), "write frame %d failed", frame);
+    }
+
+    // frames must come with increasing timestamps
+    CHECK_EXP (writer.write_frame (bufs) != XCAM_RETURN_NO_ERROR, "writer took a repeated timestamp");
+    VideoBufferList one;
+    one.push_back (bufs.front ());
+    CHECK_EXP (writer.write_frame (one) != XCAM_RETURN_NO_ERROR, "writer took a frame missing a camera");
+
+    CHECK_EXP (writer.get_frame_count () == TEST_RECORD_FRAMES, "writer counted %d frames", writer.get_frame_count ());
+    CHECK (writer.close (), "close %s failed", name);
+    return 0;
+}
+
+static int
+read_recording (const char *name, const VideoBufferInfo &info, uint32_t frame_count)
+{
+    RecordFileReader reader;
+    CHECK (reader.open (name), "open %s to read failed", name);
+    CHECK_EXP (reader.get_camera_num () == TEST_RECORD_CAMERAS, "reader got %d cameras", reader.get_camera_num ());
+    CHECK_EXP (
+        reader.get_frame_count () == frame_count,
+        "reader got %d frames, expect %d", reader.get_frame_count (), frame_count);
+
+    for (uint32_t frame = 0; frame < frame_count; ++frame) {
+        VideoBufferList bufs;
+        CHECK (reader.read_frame (frame, bufs), "read frame %d failed", frame);
+        CHECK_EXP (check_frame (frame, bufs, info), "frame %d read back differs", frame);
+    }
+
+    // into buffers of the caller
+    VideoBufferList given;
+    for (uint32_t i = 0; i < TEST_RECORD_CAMERAS; ++i)
+        given.push_back (new TestMemBuffer (info));
+    CHECK (reader.read_frame (frame_count - 1, given), "read frame into given buffers failed");
+    CHECK_EXP (check_frame (frame_count - 1, given, info), "frame read into given buffers differs");
+
+    // seeking
+    uint32_t index = 0;
+    CHECK (reader.find_frame (get_frame_timestamp (3), index), "find frame 3 failed");
+    CHECK_EXP (index == 3, "find exact timestamp of frame 3 got %d", index);
+    CHECK (reader.find_frame (get_frame_timestamp (3) + 1, index), "find frame after 3 failed");
+    CHECK_EXP (index == 4, "find timestamp after frame 3 got %d", index);
+    CHECK (reader.find_frame (0, index), "find first frame failed");
+    CHECK_EXP (index == 0, "find timestamp before the recording got %d", index);
+    CHECK_EXP (
+        reader.find_frame (get_frame_timestamp (frame_count), index) == XCAM_RETURN_BYPASS,
+        "found a frame past the recording");
+    CHECK_EXP (
+        reader.get_frame_timestamp (frame_count - 1) == get_frame_timestamp (frame_count - 1),
+        "timestamp of the last frame differs");
+
+    VideoBufferList bufs;
+    CHECK_EXP (reader.read_frame (frame_count, bufs) != XCAM_RETURN_NO_ERROR, "read a frame past the recording");
+    return 0;
+}
+
+static long
+get_file_size (const char *name)
+{
+    FILE *fp = fopen (name, "rb");
+    if (!fp)
+        return -1;
+    fseek (fp, 0, SEEK_END);
+    long size = ftell (fp);
+    fclose (fp);
+    return size;
+}
+
+// index entries are 16 bytes, behind them comes a 24 bytes footer
+static bool
+corrupt_index_entry (const char *name, uint32_t entry)
+{
+    long size = get_file_size (name);
+    FILE *fp = fopen (name, "r+b");
+    if (size <= 0 || !fp)
+        return false;
+
+    uint64_t offset = ((uint64_t) 1 << 40);
+    bool ret = fseek (fp, size - 24 - (TEST_RECORD_FRAMES - entry) * 16 + 8, SEEK_SET) == 0 &&
+               fwrite (&offset, sizeof (offset), 1, fp) == 1;
+    fclose (fp);
+    return ret;
+}
+
+static int
+test_recording (const char *name, const VideoBufferInfo &info, bool compress)
+{
+    printf ("recording %s, %s\n", name, compress ? "lz4 compressed" : "raw");
+
+    CHECK_EXP (write_recording (name, info, compress) == 0, "write recording failed");
+    CHECK_EXP (read_recording (name, info, TEST_RECORD_FRAMES) == 0, "read recording failed");
+
+    // a broken index entry falls back to scanning
+    CHECK_EXP (corrupt_index_entry (name, 2), "corrupt index of %s failed", name);
+    CHECK_EXP (read_recording (name, info, TEST_RECORD_FRAMES) == 0, "read recording with a broken index failed");
+
+    // drop the index and cut into the last frame, as a crashed writer leaves it
+    long size = get_file_size (name);
+    long cut = TEST_RECORD_FRAMES * 16 + 24 + 4096;
+    CHECK_EXP (size > cut && truncate (name, size - cut) == 0, "truncate %s failed", name);
+    CHECK_EXP (read_recording (name, info, TEST_RECORD_FRAMES - 1) == 0, "read recording without index failed");
+
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s --output file\n"
+            "\t--output            optional, recording file, default: test-record-file.xcr\n"
+            "\t--help              usage\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    const char *name = "test-record-file.xcr";
+
+    const struct option long_opts[] = {
+        {"output", required_argument, NULL, 'o'},
+        {"help", no_argument, NULL, 'e'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int opt = -1;
+    while ((opt = getopt_long (argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'o':
+            XCAM_ASSERT (optarg);
+            name = optarg;
+            break;
+        case 'e':
+            usage (argv[0]);
+            return 0;
+        default:
+            XCAM_LOG_ERROR ("getopt_long return unknown value:%c", opt);
+            usage (argv[0]);
+            return -1;
+        }
+    }
+
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_NV12, TEST_RECORD_WIDTH, TEST_RECORD_HEIGHT);
+
+    CHECK_EXP (test_recording (name, info, false) == 0, "raw recording test failed");
+
+    RecordFileWriter writer;
+    if (writer.set_compression (true)) {
+        CHECK_EXP (test_recording (name, info, true) == 0, "compressed recording test failed");
+    } else {
+        printf ("lz4 disabled, compressed recording not tested\n");
+    }
+
+    unlink (name);
+    printf ("record file tests passed\n");
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * test-shm-frame-ring.cpp - test shared memory frame ring
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include <shm_frame_ring.h>
+#include <xcam_thread.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#define TEST_RING_SLOTS 4
+#define TEST_RING_WIDTH 64
+#define TEST_RING_HEIGHT 32
+#define TEST_RING_TIMEOUT 500000   // us
+
+using namespace XCam;
+
+static SmartPtr<ShmFrameRing>
+create_ring (const VideoBufferInfo &info)
+{
+    SmartPtr<ShmFrameRing> ring = new ShmFrameRing (TEST_RING_SLOTS);
+    if (!ring->set_video_info (info) || !ring->reserve (TEST_RING_SLOTS))
+        return NULL;
+    ring->set_acquire_timeout (TEST_RING_TIMEOUT);
+    return ring;
+}
+
+static XCamReturn
+publish_frame (const SmartPtr<ShmFrameRing> &ring, int64_t timestamp)
+{
+    SmartPtr<VideoBuffer> buf = ring->get_buffer ();
+    XCAM_FAIL_RETURN (ERROR, buf.ptr (), XCAM_RETURN_ERROR_MEM, "ring get buffer failed");
+
+    memset (buf->map (), (uint8_t) timestamp, buf->get_size ());
+    buf->unmap ();
+    buf->set_timestamp (timestamp);
+    return ring->publish (buf);
+}
+
+static bool
+check_frame (const SmartPtr<VideoBuffer> &buf)
+{
+    const uint8_t *ptr = buf->map ();
+    uint8_t value = (uint8_t) buf->get_timestamp ();
+    return ptr[0] == value && ptr[buf->get_size () - 1] == value;
+}
+
+// drops the frame it holds after a while, a reader done reading
+class TestReleaseThread
+    : public Thread
+{
+public:
+    explicit TestReleaseThread (const SmartPtr<VideoBuffer> &buf)
+        : Thread ("test-release")
+        , _buf (buf)
+    {}
+
+protected:
+    virtual bool loop () {
+        usleep (100000);
+        _buf.release ();
+        return false;
+    }
+
+private:
+    SmartPtr<VideoBuffer> _buf;
+};
+
+static int
+test_publish_read (const VideoBufferInfo &info)
+{
+    SmartPtr<ShmFrameRing> ring = create_ring (info);
+    CHECK_EXP (ring.ptr (), "create ring failed");
+
+    ShmFrameReader reader;
+    CHECK (reader.open (ring->get_fd ()), "reader open ring failed");
+
+    SmartPtr<VideoBuffer> frame;
+    CHECK_EXP (
+        reader.read_frame (frame, 0) == XCAM_RETURN_ERROR_TIMEOUT,
+        "reader got a frame from an empty ring");
+
+    // read every frame as it comes
+    for (int64_t i = 1; i <= 10; ++i) {
+        CHECK (publish_frame (ring, i), "publish frame %d failed", (int) i);
+        CHECK (reader.read_frame (frame, 0), "read frame %d failed", (int) i);
+        CHECK_EXP (frame->get_timestamp () == i && check_frame (frame), "frame %d corrupted", (int) i);
+        frame.release ();
+    }
+    CHECK_EXP (reader.get_dropped_count () == 0, "reader dropped frames it read in time");
+
+    // a slow reader gets the held frames and counts the retired ones as dropped
+    for (int64_t i = 11; i <= 20; ++i)
+        CHECK (publish_frame (ring, i), "publish frame %d failed", (int) i);
+    int64_t last = 10;
+    while (reader.read_frame (frame, 0) == XCAM_RETURN_NO_ERROR) {
+        CHECK_EXP (frame->get_timestamp () > last && check_frame (frame), "slow reader got frames out of order");
+        last = frame->get_timestamp ();
+        frame.release ();
+    }
+    CHECK_EXP (last == 20, "slow reader missed the newest frame");
+    CHECK_EXP (reader.get_dropped_count () > 0, "slow reader dropped no frame");
+
+    SmartPtr<VideoBuffer> buf = ring->get_buffer ();
+    CHECK_EXP (buf.ptr (), "ring get buffer failed");
+    CHECK (ring->publish (buf), "publish failed");
+    CHECK_EXP (ring->publish (buf) != XCAM_RETURN_NO_ERROR, "ring published a slot twice");
+
+    ring->close ();
+    CHECK_EXP (reader.read_frame (frame, 0) == XCAM_RETURN_NO_ERROR, "reader lost the frame published last");
+    frame.release ();
+    CHECK_EXP (reader.read_frame (frame, 0) == XCAM_RETURN_BYPASS, "reader didn't see the ring closed");
+
+    return 0;
+}
+
+static int
+test_pinned_reader (const VideoBufferInfo &info)
+{
+    SmartPtr<ShmFrameRing> ring = create_ring (info);
+    CHECK_EXP (ring.ptr (), "create ring failed");
+
+    ShmFrameReader reader;
+    CHECK (reader.open (ring->get_fd ()), "reader open ring failed");
+
+    // the reader keeps all but one slot pinned, the producer keeps the last one
+    SmartPtr<VideoBuffer> pinned[TEST_RING_SLOTS - 1];
+    for (int i = 0; i < TEST_RING_SLOTS - 1; ++i) {
+        CHECK (publish_frame (ring, i + 1), "publish frame %d failed", i + 1);
+        CHECK (reader.read_frame (pinned[i], 0), "read frame %d failed", i + 1);
+    }
+    SmartPtr<VideoBuffer> kept = ring->get_buffer ();
+    CHECK_EXP (kept.ptr (), "ring get buffer failed");
+    CHECK_EXP (!ring->get_buffer ().ptr (), "ring handed out a slot the reader pins");
+
+    // no publish comes, the waiting producer has to reclaim the slot itself
+    SmartPtr<Thread> release = new TestReleaseThread (pinned[0]);
+    pinned[0].release ();
+    CHECK_EXP (release->start (), "start release thread failed");
+    SmartPtr<VideoBuffer> buf = ring->get_buffer ();
+    release->stop ();
+    CHECK_EXP (buf.ptr (), "ring didn't reclaim the slot released by the reader");
+
+    ring->close ();
+    return 0;
+}
+
+static int
+test_dead_reader (const VideoBufferInfo &info)
+{
+    SmartPtr<ShmFrameRing> ring = create_ring (info);
+    CHECK_EXP (ring.ptr (), "create ring failed");
+    CHECK_EXP (ring->set_hold_count (TEST_RING_SLOTS - 1), "set hold count failed");
+
+    for (int64_t i = 1; i < TEST_RING_SLOTS; ++i)
+        CHECK (publish_frame (ring, i), "publish frame %d failed", (int) i);
+
+    fflush (NULL);
+    pid_t pid = fork ();
+    CHECK_EXP (pid >= 0, "fork reader failed");
+    if (pid == 0) {
+        // pins every held frame and dies without releasing them
+        ShmFrameReader reader;
+        SmartPtr<VideoBuffer> frames[TEST_RING_SLOTS];
+        if (reader.open (ring->get_fd ()) != XCAM_RETURN_NO_ERROR)
+            _exit (1);
+        for (int i = 0; i < TEST_RING_SLOTS; ++i) {
+            if (reader.read_frame (frames[i], 0) != XCAM_RETURN_NO_ERROR)
+                break;
+        }
+        kill (getpid (), SIGKILL);
+    }
+    int status = 0;
+    waitpid (pid, &status, 0);
+    CHECK_EXP (WIFSIGNALED (status), "reader exited before pinning frames");
+
+    for (int64_t i = 0; i < TEST_RING_SLOTS * 4; ++i)
+        CHECK (publish_frame (ring, TEST_RING_SLOTS + i), "publish frame %d after reader died failed", (int) i);
+
+    // with the slots of the dead reader back, the ring holds as many frames as before
+    ShmFrameReader reader;
+    CHECK (reader.open (ring->get_fd ()), "reader open ring failed");
+    SmartPtr<VideoBuffer> frame;
+    int count = 0;
+    for (; reader.read_frame (frame, 0) == XCAM_RETURN_NO_ERROR; ++count)
+        frame.release ();
+    CHECK_EXP (
+        count == TEST_RING_SLOTS - 1,
+        "ring holds %d frames, expect %d, slots of the dead reader leaked", count, TEST_RING_SLOTS - 1);
+
+    ring->close ();
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s\n"
+            "\t--help              usage\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1) {
+        usage (argv[0]);
+        return strcmp (argv[1], "--help") ? -1 : 0;
+    }
+
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_NV12, TEST_RING_WIDTH, TEST_RING_HEIGHT);
+
+    CHECK_EXP (test_publish_read (info) == 0, "shm frame ring publish and read failed");
+    CHECK_EXP (test_pinned_reader (info) == 0, "shm frame ring pinned reader failed");
+    CHECK_EXP (test_dead_reader (info) == 0, "shm frame ring dead reader failed");
+
+    printf ("shm frame ring tests passed\n");
+    return 0;
+}
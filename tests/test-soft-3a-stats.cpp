@@ -0,0 +1,339 @@
+/*
+ * test-soft-3a-stats.cpp - test CPU 3a statistics against a scalar reference
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include <soft/soft_3a_stats.h>
+#include <soft/soft_video_buf_allocator.h>
+#include <time.h>
+#include <vector>
+
+#define TEST_STATS_PERF_FRAMES 20
+
+using namespace XCam;
+
+struct TestStatsCase {
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t grid;
+    uint32_t subsample;
+    uint32_t bit_depth;
+    uint32_t threads;
+};
+
+static uint32_t
+next_random (uint32_t &seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) & 0xFFFF;
+}
+
+// random pixels, some of them at and around saturation
+static uint32_t
+get_pixel (uint32_t &seed, uint32_t color_bits)
+{
+    const uint32_t max_value = (1 << color_bits) - 1;
+    uint32_t r = next_random (seed);
+    if (r % 16 == 0)
+        return max_value - (r >> 4) % 4;
+    // stray bits above color bits in 16-bit containers
+    if (color_bits > 8 && color_bits < 16 && r % 97 == 0)
+        return max_value + 1 + (r >> 8) % 64;
+    return r % (max_value + 1);
+}
+
+static SmartPtr<VideoBuffer>
+create_buffer (const VideoBufferInfo &info, uint32_t seed)
+{
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+    if (!pool->reserve (1))
+        return NULL;
+    SmartPtr<VideoBuffer> buf = pool->get_buffer ();
+    if (!buf.ptr ())
+        return NULL;
+
+    uint8_t *mem = buf->map ();
+    for (uint32_t y = 0; y < info.height; ++y) {
+        uint8_t *row = mem + info.offsets[0] + y * info.strides[0];
+        for (uint32_t x = 0; x < info.width; ++x) {
+            if (info.color_bits == 8)
+                row[x] = get_pixel (seed, 8);
+            else
+                ((uint16_t *)row)[x] = get_pixel (seed, info.color_bits);
+        }
+    }
+    if (info.format == V4L2_PIX_FMT_NV12) {
+        for (uint32_t y = 0; y < info.height / 2; ++y) {
+            uint8_t *row = mem + info.offsets[1] + y * info.strides[1];
+            for (uint32_t x = 0; x < info.width; ++x)
+                row[x] = get_pixel (seed, 8);
+        }
+    }
+    buf->unmap ();
+    return buf;
+}
+
+static uint32_t
+clamp_pixel (int32_t value)
+{
+    return (uint32_t) XCAM_CLAMP (value, 0, 255);
+}
+
+// bayer pixel at position (row << 1 | column) of a 2x2 block, per format
+static uint32_t
+get_bayer_position (uint32_t format, uint32_t channel)
+{
+    // channels r, gr, gb, b
+    static const uint32_t bggr[] = {3, 2, 1, 0};
+    static const uint32_t grbg[] = {1, 0, 3, 2};
+    return (format == V4L2_PIX_FMT_SBGGR8 ? bggr : grbg)[channel];
+}
+
+static void
+calculate_reference (
+    const TestStatsCase &c, const SmartPtr<VideoBuffer> &buf, std::vector<XCamGridStat> &grids,
+    uint32_t &grid_cols, uint32_t &grid_rows)
+{
+    const VideoBufferInfo &info = buf->get_video_info ();
+    const uint8_t *mem = buf->map ();
+    const uint32_t shift = info.color_bits - c.bit_depth;
+    const uint32_t max_value = (1 << c.bit_depth) - 1;
+    const uint32_t saturation = (info.format == V4L2_PIX_FMT_NV12) ? 255 : (1 << info.color_bits) - 1;
+    const uint32_t width = info.width / 2 * 2;
+    const uint32_t height = info.height / 2 * 2;
+
+    grid_cols = xcam_ceil (info.width, c.grid) / c.grid;
+    grid_rows = xcam_ceil (info.height, c.grid) / c.grid;
+    grids.resize (grid_cols * grid_rows);
+
+    for (uint32_t gy = 0; gy < grid_rows; ++gy) {
+        for (uint32_t gx = 0; gx < grid_cols; ++gx) {
+            XCamGridStat &grid = grids[gy * grid_cols + gx];
+            uint64_t sum[4] = {0, 0, 0, 0}, sum_u = 0, sum_v = 0;
+            uint32_t count = 0, valid = 0;
+
+            for (uint32_t y = gy * c.grid; y < XCAM_MIN ((gy + 1) * c.grid, height); y += 2 * c.subsample) {
+                for (uint32_t x = gx * c.grid; x < XCAM_MIN ((gx + 1) * c.grid, width); x += 2 * c.subsample) {
+                    uint32_t block[4], max = 0;
+                    for (uint32_t i = 0; i < 4; ++i) {
+                        const uint8_t *row = mem + info.offsets[0] + (y + i / 2) * info.strides[0];
+                        block[i] = (info.color_bits == 8) ? row[x + i % 2] : ((const uint16_t *)row)[x + i % 2];
+                        sum[i] += block[i];
+                        max = XCAM_MAX (max, block[i]);
+                    }
+                    if (info.format == V4L2_PIX_FMT_NV12) {
+                        const uint8_t *uv = mem + info.offsets[1] + y / 2 * info.strides[1];
+                        sum_u += uv[x];
+                        sum_v += uv[x + 1];
+                    }
+                    ++count;
+                    valid += (max < saturation);
+                }
+            }
+
+            xcam_mem_clear (grid);
+            if (!count)
+                continue;
+
+            grid.valid_wb_count = valid;
+            if (info.format == V4L2_PIX_FMT_NV12) {
+                uint32_t y = (sum[0] + sum[1] + sum[2] + sum[3]) / (count * 4);
+                int32_t u = (int32_t)(sum_u / count) - 128;
+                int32_t v = (int32_t)(sum_v / count) - 128;
+                uint32_t g = clamp_pixel ((int32_t)y - ((88 * u + 183 * v) >> 8));
+                grid.avg_y = y >> shift;
+                grid.avg_r = clamp_pixel ((int32_t)y + ((359 * v) >> 8)) >> shift;
+                grid.avg_gr = g >> shift;
+                grid.avg_gb = g >> shift;
+                grid.avg_b = clamp_pixel ((int32_t)y + ((454 * u) >> 8)) >> shift;
+            } else {
+                uint32_t avg[4];
+                for (uint32_t i = 0; i < 4; ++i) {
+                    uint64_t value = (sum[get_bayer_position (info.format, i)] / count) >> shift;
+                    avg[i] = (uint32_t) XCAM_MIN (value, (uint64_t)max_value);
+                }
+                grid.avg_r = avg[0];
+                grid.avg_gr = avg[1];
+                grid.avg_gb = avg[2];
+                grid.avg_b = avg[3];
+                grid.avg_y = (avg[0] + avg[1] + avg[2] + avg[3]) / 4;
+            }
+        }
+    }
+    buf->unmap ();
+}
+
+static bool
+grid_equal (const XCamGridStat &a, const XCamGridStat &b)
+{
+    return a.avg_y == b.avg_y && a.avg_r == b.avg_r && a.avg_gr == b.avg_gr &&
+           a.avg_gb == b.avg_gb && a.avg_b == b.avg_b && a.valid_wb_count == b.valid_wb_count;
+}
+
+static int
+calculate_stats (const TestStatsCase &c, const SmartPtr<VideoBuffer> &buf, SmartPtr<X3aStats> &stats)
+{
+    Soft3aStatsCalculator calculator (c.threads);
+    CHECK_EXP (
+        calculator.set_grid_size (c.grid) && calculator.set_subsample (c.subsample) &&
+        calculator.set_bit_depth (c.bit_depth), "configure calculator failed");
+    CHECK (calculator.prepare (buf->get_video_info (), 1), "prepare calculator failed");
+    CHECK (calculator.calculate (buf, stats), "calculate stats failed");
+    return 0;
+}
+
+static int
+test_against_reference (const TestStatsCase &c)
+{
+    VideoBufferInfo info;
+    info.init (c.format, c.width, c.height);
+    SmartPtr<VideoBuffer> buf = create_buffer (info, c.width * c.height + c.grid);
+    CHECK_EXP (buf.ptr (), "create %s buffer failed", xcam_fourcc_to_string (c.format));
+
+    SmartPtr<X3aStats> stats;
+    CHECK_EXP (calculate_stats (c, buf, stats) == 0, "calculate %s stats failed", xcam_fourcc_to_string (c.format));
+    const XCam3AStats *out = stats->get_stats ();
+
+    std::vector<XCamGridStat> ref;
+    uint32_t grid_cols = 0, grid_rows = 0;
+    calculate_reference (c, buf, ref, grid_cols, grid_rows);
+    CHECK_EXP (
+        out->info.aligned_width == grid_cols && out->info.aligned_height == grid_rows,
+        "grid layout %dx%d, expected %dx%d", out->info.aligned_width, out->info.aligned_height, grid_cols, grid_rows);
+
+    std::vector<uint32_t> hist_y (1 << c.bit_depth, 0);
+    for (uint32_t gy = 0; gy < grid_rows; ++gy) {
+        for (uint32_t gx = 0; gx < grid_cols; ++gx) {
+            const XCamGridStat &a = out->stats[gy * grid_cols + gx];
+            const XCamGridStat &b = ref[gy * grid_cols + gx];
+            CHECK_EXP (
+                grid_equal (a, b),
+                "%s %dx%d grid(%d,%d) y:%d r:%d gr:%d gb:%d b:%d valid:%d, reference y:%d r:%d gr:%d gb:%d b:%d valid:%d",
+                xcam_fourcc_to_string (c.format), c.width, c.height, gx, gy,
+                a.avg_y, a.avg_r, a.avg_gr, a.avg_gb, a.avg_b, a.valid_wb_count,
+                b.avg_y, b.avg_r, b.avg_gr, b.avg_gb, b.avg_b, b.valid_wb_count);
+            if (gx < out->info.width && gy < out->info.height)
+                hist_y[b.avg_y]++;
+        }
+    }
+    for (uint32_t i = 0; i < hist_y.size (); ++i)
+        CHECK_EXP (out->hist_y[i] == hist_y[i], "hist_y[%d] is %d, expected %d", i, out->hist_y[i], hist_y[i]);
+
+    printf ("%s %dx%d grid:%d subsample:%d bits:%d threads:%d matches the reference\n",
+            xcam_fourcc_to_string (c.format), c.width, c.height, c.grid, c.subsample, c.bit_depth, c.threads);
+    return 0;
+}
+
+// blocks at the top code of 10-bit input are saturated, the codes below are not
+static int
+test_saturation ()
+{
+    const TestStatsCase c = {V4L2_PIX_FMT_SGRBG10, 64, 32, 16, 1, 8, 1};
+    const uint16_t values[] = {1020, 1022, 1023};
+    const uint32_t expected[] = {64, 64, 0};
+
+    VideoBufferInfo info;
+    info.init (c.format, c.width, c.height);
+    for (uint32_t i = 0; i < sizeof (values) / sizeof (values[0]); ++i) {
+        SmartPtr<VideoBuffer> buf = create_buffer (info, 0);
+        CHECK_EXP (buf.ptr (), "create bayer buffer failed");
+        uint8_t *mem = buf->map ();
+        for (uint32_t y = 0; y < info.height; ++y) {
+            uint16_t *row = (uint16_t *)(mem + info.offsets[0] + y * info.strides[0]);
+            for (uint32_t x = 0; x < info.width; ++x)
+                row[x] = values[i];
+        }
+        buf->unmap ();
+
+        SmartPtr<X3aStats> stats;
+        CHECK_EXP (calculate_stats (c, buf, stats) == 0, "calculate saturation stats failed");
+        const XCamGridStat &grid = stats->get_stats ()->stats[0];
+        CHECK_EXP (
+            grid.valid_wb_count == expected[i] && grid.avg_r == (uint32_t)(values[i] >> 2),
+            "pixels of %d gave %d valid blocks and avg %d, expected %d blocks", values[i],
+            grid.valid_wb_count, grid.avg_r, expected[i]);
+    }
+
+    printf ("saturation of 10-bit input passed\n");
+    return 0;
+}
+
+static int
+test_performance ()
+{
+    const TestStatsCase c = {V4L2_PIX_FMT_NV12, 1920, 1080, 16, 1, 8, 1};
+
+    VideoBufferInfo info;
+    info.init (c.format, c.width, c.height);
+    SmartPtr<VideoBuffer> buf = create_buffer (info, 1);
+    CHECK_EXP (buf.ptr (), "create nv12 buffer failed");
+
+    Soft3aStatsCalculator calculator (c.threads);
+    CHECK_EXP (calculator.set_grid_size (c.grid), "set grid size failed");
+    CHECK (calculator.prepare (info, 2), "prepare calculator failed");
+
+    struct timespec begin, end;
+    clock_gettime (CLOCK_MONOTONIC, &begin);
+    for (uint32_t i = 0; i < TEST_STATS_PERF_FRAMES; ++i) {
+        SmartPtr<X3aStats> stats;
+        CHECK (calculator.calculate (buf, stats), "calculate stats failed");
+    }
+    clock_gettime (CLOCK_MONOTONIC, &end);
+
+    int64_t elapsed = XCAM_TIMESPEC_2_USEC (end) - XCAM_TIMESPEC_2_USEC (begin);
+    printf ("1080p nv12 on one thread: %.3f ms per frame\n", elapsed / 1000.0f / TEST_STATS_PERF_FRAMES);
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s\n"
+            "\t--help              usage\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1) {
+        usage (argv[0]);
+        return strcmp (argv[1], "--help") ? -1 : 0;
+    }
+
+    const TestStatsCase cases[] = {
+        {V4L2_PIX_FMT_NV12, 1920, 1080, 16, 1, 8, 1},
+        {V4L2_PIX_FMT_NV12, 1920, 1080, 16, 2, 8, 1},
+        {V4L2_PIX_FMT_NV12, 333, 181, 32, 1, 8, 3},
+        {V4L2_PIX_FMT_SBGGR8, 640, 480, 8, 1, 8, 2},
+        {V4L2_PIX_FMT_SBGGR8, 250, 98, 16, 3, 8, 1},
+        {V4L2_PIX_FMT_SGRBG10, 256, 128, 16, 1, 8, 1},
+        {V4L2_PIX_FMT_SGRBG10, 202, 150, 32, 1, 10, 2},
+        {V4L2_PIX_FMT_SGRBG10, 256, 128, 16, 2, 8, 1},
+    };
+
+    for (uint32_t i = 0; i < sizeof (cases) / sizeof (cases[0]); ++i) {
+        CHECK_EXP (test_against_reference (cases[i]) == 0, "stats case %d failed", i);
+    }
+    CHECK_EXP (test_saturation () == 0, "saturation test failed");
+    CHECK_EXP (test_performance () == 0, "performance test failed");
+
+    printf ("soft 3a stats tests passed\n");
+    return 0;
+}
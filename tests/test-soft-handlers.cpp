@@ -0,0 +1,180 @@
+/*
+ * test-soft-handlers.cpp - test standalone soft geo mapper and blender
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include <interface/geo_mapper.h>
+#include <interface/blender.h>
+#include <soft/soft_video_buf_allocator.h>
+#include <vector>
+
+#define TEST_HANDLER_WIDTH 256
+#define TEST_HANDLER_HEIGHT 128
+#define TEST_HANDLER_LUT_STEP 8
+#define TEST_HANDLER_FRAMES 3
+
+using namespace XCam;
+
+// smooth, so interpolation at the sample positions stays close to the pixels
+static uint8_t
+get_pixel (uint32_t x, uint32_t y, uint32_t frame)
+{
+    return (uint8_t) (16 + (x / 2 + y + frame * 8) % 200);
+}
+
+static void
+fill_buffer (const SmartPtr<VideoBuffer> &buf, uint32_t frame)
+{
+    const VideoBufferInfo &info = buf->get_video_info ();
+    uint8_t *ptr = buf->map ();
+    for (uint32_t y = 0; y < info.height; ++y) {
+        for (uint32_t x = 0; x < info.width; ++x)
+            ptr[info.offsets[0] + y * info.strides[0] + x] = get_pixel (x, y, frame);
+    }
+    for (uint32_t y = 0; y < info.height / 2; ++y) {
+        for (uint32_t x = 0; x < info.width; ++x)
+            ptr[info.offsets[1] + y * info.strides[1] + x] = (x % 2) ? 96 : 160;
+    }
+    buf->unmap ();
+}
+
+static int
+check_buffer (const SmartPtr<VideoBuffer> &buf, uint32_t frame, int tolerance)
+{
+    const VideoBufferInfo &info = buf->get_video_info ();
+    const uint8_t *ptr = buf->map ();
+    int max_diff = 0;
+    for (uint32_t y = 0; y < TEST_HANDLER_HEIGHT; ++y) {
+        for (uint32_t x = 0; x < TEST_HANDLER_WIDTH; ++x) {
+            int diff = abs (ptr[info.offsets[0] + y * info.strides[0] + x] - get_pixel (x, y, frame));
+            max_diff = XCAM_MAX (max_diff, diff);
+        }
+    }
+    for (uint32_t y = 0; y < TEST_HANDLER_HEIGHT / 2; ++y) {
+        for (uint32_t x = 0; x < TEST_HANDLER_WIDTH; ++x) {
+            int diff = abs (ptr[info.offsets[1] + y * info.strides[1] + x] - ((x % 2) ? 96 : 160));
+            max_diff = XCAM_MAX (max_diff, diff);
+        }
+    }
+    buf->unmap ();
+
+    CHECK_EXP (max_diff <= tolerance, "frame %d differs from input by %d", frame, max_diff);
+    return 0;
+}
+
+static SmartPtr<VideoBuffer>
+create_input (uint32_t frame)
+{
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_NV12, TEST_HANDLER_WIDTH, TEST_HANDLER_HEIGHT);
+
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+    if (!pool->reserve (1))
+        return NULL;
+
+    SmartPtr<VideoBuffer> buf = pool->get_buffer ();
+    if (buf.ptr ())
+        fill_buffer (buf, frame);
+    return buf;
+}
+
+// many work items, so the worker runs them on its own thread pool
+static int
+test_geo_mapper ()
+{
+    const uint32_t lut_width = TEST_HANDLER_WIDTH / TEST_HANDLER_LUT_STEP + 1;
+    const uint32_t lut_height = TEST_HANDLER_HEIGHT / TEST_HANDLER_LUT_STEP + 1;
+    std::vector<PointFloat2> lut (lut_width * lut_height);
+    for (uint32_t y = 0; y < lut_height; ++y) {
+        for (uint32_t x = 0; x < lut_width; ++x) {
+            lut[y * lut_width + x].x = x * (TEST_HANDLER_WIDTH - 1.0f) / (lut_width - 1.0f);
+            lut[y * lut_width + x].y = y * (TEST_HANDLER_HEIGHT - 1.0f) / (lut_height - 1.0f);
+        }
+    }
+
+    SmartPtr<GeoMapper> mapper = GeoMapper::create_soft_geo_mapper ();
+    XCAM_ASSERT (mapper.ptr ());
+    mapper->set_output_size (TEST_HANDLER_WIDTH, TEST_HANDLER_HEIGHT);
+    CHECK_EXP (mapper->set_lookup_table (lut.data (), lut_width, lut_height), "set lookup table failed");
+
+    for (uint32_t frame = 0; frame < TEST_HANDLER_FRAMES; ++frame) {
+        SmartPtr<VideoBuffer> in = create_input (frame);
+        CHECK_EXP (in.ptr (), "create input failed");
+
+        SmartPtr<VideoBuffer> out;
+        CHECK (mapper->remap (in, out), "remap frame %d failed", frame);
+        CHECK_EXP (out.ptr (), "remap frame %d gave no output", frame);
+        CHECK_EXP (check_buffer (out, frame, 2) == 0, "identity remap frame %d failed", frame);
+    }
+
+    return 0;
+}
+
+static int
+test_blender ()
+{
+    SmartPtr<Blender> blender = Blender::create_soft_blender ();
+    XCAM_ASSERT (blender.ptr ());
+    blender->set_output_size (TEST_HANDLER_WIDTH, TEST_HANDLER_HEIGHT);
+
+    Rect area;
+    area.pos_x = 0;
+    area.pos_y = 0;
+    area.width = TEST_HANDLER_WIDTH;
+    area.height = TEST_HANDLER_HEIGHT;
+    CHECK_EXP (blender->set_merge_window (area), "set merge window failed");
+    CHECK_EXP (blender->set_input_merge_area (area, 0), "set merge area 0 failed");
+    CHECK_EXP (blender->set_input_merge_area (area, 1), "set merge area 1 failed");
+
+    // blending an image with itself gives the image back
+    for (uint32_t frame = 0; frame < TEST_HANDLER_FRAMES; ++frame) {
+        SmartPtr<VideoBuffer> in0 = create_input (frame);
+        SmartPtr<VideoBuffer> in1 = create_input (frame);
+        CHECK_EXP (in0.ptr () && in1.ptr (), "create inputs failed");
+
+        SmartPtr<VideoBuffer> out;
+        CHECK (blender->blend (in0, in1, out), "blend frame %d failed", frame);
+        CHECK_EXP (out.ptr (), "blend frame %d gave no output", frame);
+        CHECK_EXP (check_buffer (out, frame, 2) == 0, "self blend frame %d failed", frame);
+    }
+
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s\n"
+            "\t--help              usage\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1) {
+        usage (argv[0]);
+        return strcmp (argv[1], "--help") ? -1 : 0;
+    }
+
+    CHECK_EXP (test_geo_mapper () == 0, "soft geo mapper failed");
+    CHECK_EXP (test_blender () == 0, "soft blender failed");
+
+    printf ("soft handlers tests passed\n");
+    return 0;
+}
@@ -0,0 +1,303 @@
+/*
+ * test-soft-video-stabilizer.cpp - test soft image warp and gyro video stabilizer
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include <soft/soft_video_stabilizer.h>
+#include <soft/soft_video_buf_allocator.h>
+#include <math.h>
+
+#define TEST_STAB_WIDTH 320
+#define TEST_STAB_HEIGHT 240
+#define TEST_STAB_FOCAL 500.0
+#define TEST_STAB_FRAME_TIME 33333     // us
+#define TEST_STAB_RADIUS 4
+#define TEST_STAB_FRAMES 24
+#define TEST_STAB_JITTER 8             // pixels
+#define TEST_STAB_MAX_SHIFT 24
+
+using namespace XCam;
+
+// texture with no period over the frame, so shifts are told apart
+static uint8_t
+pattern (int32_t x, int32_t y)
+{
+    uint32_t h = (uint32_t)(x * 73856093) ^ (uint32_t)(y * 19349663);
+    return (uint8_t)((h >> 7) ^ (h >> 17));
+}
+
+// luma and chroma of the pattern, shifted left by offset_x
+static void
+fill_frame (const SmartPtr<VideoBuffer> &buf, int32_t offset_x)
+{
+    const VideoBufferInfo &info = buf->get_video_info ();
+    uint8_t *mem = buf->map ();
+    for (uint32_t y = 0; y < info.height; ++y) {
+        uint8_t *row = mem + info.offsets[0] + y * info.strides[0];
+        for (uint32_t x = 0; x < info.width; ++x)
+            row[x] = pattern (x + offset_x, y);
+    }
+    for (uint32_t y = 0; y < info.height / 2; ++y) {
+        uint8_t *row = mem + info.offsets[1] + y * info.strides[1];
+        for (uint32_t x = 0; x < info.width; ++x)
+            row[x] = pattern (x + offset_x, y + info.height);
+    }
+    buf->unmap ();
+}
+
+// output (x, y) maps to input (x + dx, y + dy)
+static Mat3d
+translation (float dx, float dy)
+{
+    return Mat3d (Vec3d (1.0, 0.0, dx), Vec3d (0.0, 1.0, dy), Vec3d (0.0, 0.0, 1.0));
+}
+
+static uint8_t
+sample_clamped (const uint8_t *plane, uint32_t stride, uint32_t pixel_bytes, int32_t x, int32_t y, int32_t w, int32_t h)
+{
+    x = XCAM_CLAMP (x, 0, w - 1);
+    y = XCAM_CLAMP (y, 0, h - 1);
+    return plane[y * stride + x * pixel_bytes];
+}
+
+// integer translation clamped to edge, luma by (dx, dy) and chroma by half of it
+static uint32_t
+count_translation_errors (const SmartPtr<VideoBuffer> &in, const SmartPtr<VideoBuffer> &out, int32_t dx, int32_t dy)
+{
+    const VideoBufferInfo &in_info = in->get_video_info ();
+    const VideoBufferInfo &out_info = out->get_video_info ();
+    const uint8_t *src = in->map ();
+    const uint8_t *dst = out->map ();
+    int32_t w = in_info.width, h = in_info.height;
+    uint32_t errors = 0;
+
+    for (int32_t y = 0; y < (int32_t)out_info.height; ++y) {
+        const uint8_t *row = dst + out_info.offsets[0] + y * out_info.strides[0];
+        for (int32_t x = 0; x < (int32_t)out_info.width; ++x) {
+            if (row[x] != sample_clamped (src + in_info.offsets[0], in_info.strides[0], 1, x + dx, y + dy, w, h))
+                ++errors;
+        }
+    }
+    for (int32_t y = 0; y < (int32_t)out_info.height / 2; ++y) {
+        const uint8_t *row = dst + out_info.offsets[1] + y * out_info.strides[1];
+        for (int32_t x = 0; x < (int32_t)out_info.width / 2; ++x) {
+            for (int32_t c = 0; c < 2; ++c) {
+                const uint8_t *plane = src + in_info.offsets[1] + c;
+                if (row[2 * x + c] != sample_clamped (plane, in_info.strides[1], 2, x + dx / 2, y + dy / 2, w / 2, h / 2))
+                    ++errors;
+            }
+        }
+    }
+
+    out->unmap ();
+    in->unmap ();
+    return errors;
+}
+
+static int
+test_warp_translation (uint32_t thread_num)
+{
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_NV12, TEST_STAB_WIDTH, TEST_STAB_HEIGHT);
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+    CHECK_EXP (pool->reserve (2), "reserve warp buffers failed");
+
+    SmartPtr<VideoBuffer> in = pool->get_buffer ();
+    SmartPtr<VideoBuffer> out = pool->get_buffer ();
+    fill_frame (in, 0);
+    in->set_timestamp (1234);
+
+    const int32_t shifts[][2] = {{0, 0}, {6, -4}, {-30, 12}, {TEST_STAB_WIDTH, 0}};
+    SoftImageWarp warp (thread_num);
+    for (uint32_t i = 0; i < sizeof (shifts) / sizeof (shifts[0]); ++i) {
+        int32_t dx = shifts[i][0], dy = shifts[i][1];
+        std::vector<Mat3d> mats (1, translation (dx, dy));
+        CHECK (warp.warp (in, out, mats, 0), "warp by (%d, %d) failed", dx, dy);
+
+        uint32_t errors = count_translation_errors (in, out, dx, dy);
+        CHECK_EXP (errors == 0, "warp by (%d, %d) with %d threads: %d samples differ", dx, dy, thread_num, errors);
+    }
+    CHECK_EXP (out->get_timestamp () == 1234, "warp lost input timestamp");
+
+    // a matrix per row block, top half kept and bottom half moved
+    std::vector<Mat3d> mats;
+    mats.push_back (translation (0, 0));
+    mats.push_back (translation (4, 0));
+    CHECK (warp.warp (in, out, mats, TEST_STAB_HEIGHT / 2), "warp by row blocks failed");
+
+    const uint8_t *src = in->map ();
+    const uint8_t *dst = out->map ();
+    uint32_t errors = 0;
+    for (uint32_t y = 0; y < TEST_STAB_HEIGHT; ++y) {
+        int32_t dx = y < TEST_STAB_HEIGHT / 2 ? 0 : 4;
+        for (int32_t x = 0; x < TEST_STAB_WIDTH; ++x) {
+            if (dst[info.offsets[0] + y * info.strides[0] + x] !=
+                    sample_clamped (src + info.offsets[0], info.strides[0], 1, x + dx, y, TEST_STAB_WIDTH, TEST_STAB_HEIGHT))
+                ++errors;
+        }
+    }
+    out->unmap ();
+    in->unmap ();
+    CHECK_EXP (errors == 0, "warp by row blocks: %d luma samples differ", errors);
+
+    warp.stop ();
+    printf ("warp translation with %d threads passed\n", thread_num);
+    return 0;
+}
+
+// horizontal shift d where a(x) best matches b(x + d) in the middle of the frames
+static int32_t
+find_shift (const SmartPtr<VideoBuffer> &a, const SmartPtr<VideoBuffer> &b)
+{
+    const VideoBufferInfo &info = a->get_video_info ();
+    const uint8_t *pa = a->map () + info.offsets[0];
+    const uint8_t *pb = b->map () + info.offsets[0];
+
+    int32_t best = 0;
+    uint64_t best_sad = UINT64_MAX;
+    for (int32_t d = -TEST_STAB_MAX_SHIFT; d <= TEST_STAB_MAX_SHIFT; ++d) {
+        uint64_t sad = 0;
+        for (uint32_t y = info.height / 4; y < info.height * 3 / 4; ++y) {
+            for (int32_t x = TEST_STAB_MAX_SHIFT; x < (int32_t)info.width - TEST_STAB_MAX_SHIFT; ++x) {
+                int32_t diff = pa[y * info.strides[0] + x] - pb[y * info.strides[0] + x + d];
+                sad += diff < 0 ? -diff : diff;
+            }
+        }
+        if (sad < best_sad) {
+            best_sad = sad;
+            best = d;
+        }
+    }
+
+    b->unmap ();
+    a->unmap ();
+    return best;
+}
+
+// a pose turned by angle about z sees the scene moved right by focal * tan (angle)
+static void
+add_pose (const SmartPtr<VideoBuffer> &buf, double angle, int64_t timestamp)
+{
+    SmartPtr<DevicePose> pose = new DevicePose;
+    pose->orientation[2] = sin (angle / 2);
+    pose->orientation[3] = cos (angle / 2);
+    pose->timestamp = timestamp;
+    buf->add_metadata (pose);
+}
+
+/*
+ * Frames shake left and right by jitter pixels, with poses telling the same.
+ * Returns the largest shift between consecutive outputs.
+ */
+static int
+run_stabilizer (int32_t jitter, bool pose_moves, int32_t &max_out_shift)
+{
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_NV12, TEST_STAB_WIDTH, TEST_STAB_HEIGHT);
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+    CHECK_EXP (pool->reserve (TEST_STAB_RADIUS + 2), "reserve input buffers failed");
+
+    SoftVideoStabilizer stabilizer (2);
+    CHECK (
+        stabilizer.set_camera_intrinsics (
+            TEST_STAB_FOCAL, TEST_STAB_FOCAL, TEST_STAB_WIDTH / 2, TEST_STAB_HEIGHT / 2, 0.0),
+        "set camera intrinsics failed");
+    CHECK (stabilizer.set_motion_filter (TEST_STAB_RADIUS, 0.0f), "set motion filter failed");
+    CHECK (stabilizer.prepare (info, 2), "prepare stabilizer failed");
+
+    double angle = atan (jitter / TEST_STAB_FOCAL);
+    SmartPtr<VideoBuffer> last_out;
+    uint32_t bypass = 0;
+    max_out_shift = 0;
+    for (uint32_t frame = 0; frame < TEST_STAB_FRAMES; ++frame) {
+        int32_t sign = (frame % 2) ? 1 : -1;
+        int64_t timestamp = (frame + 1) * TEST_STAB_FRAME_TIME;
+
+        SmartPtr<VideoBuffer> in = pool->get_buffer ();
+        CHECK_EXP (in.ptr (), "get input buffer %d failed", frame);
+        fill_frame (in, -sign * jitter);
+        in->set_timestamp (timestamp);
+        double pose_angle = pose_moves ? sign * angle : 0.0;
+        add_pose (in, pose_angle, timestamp - TEST_STAB_FRAME_TIME / 2);
+        add_pose (in, pose_angle, timestamp + TEST_STAB_FRAME_TIME / 2);
+
+        SmartPtr<VideoBuffer> out;
+        XCamReturn ret = stabilizer.stabilize (in, out);
+        if (ret == XCAM_RETURN_BYPASS) {
+            ++bypass;
+            continue;
+        }
+        CHECK (ret, "stabilize frame %d failed", frame);
+        CHECK_EXP (out.ptr (), "frame %d gave no output", frame);
+
+        int64_t expected_ts = (frame + 1 - TEST_STAB_RADIUS) * TEST_STAB_FRAME_TIME;
+        CHECK_EXP (
+            out->get_timestamp () == expected_ts, "output of frame %d has timestamp %" PRId64 ", expect %" PRId64,
+            frame, out->get_timestamp (), expected_ts);
+
+        if (last_out.ptr ()) {
+            int32_t shift = find_shift (last_out, out);
+            max_out_shift = XCAM_MAX (max_out_shift, shift < 0 ? -shift : shift);
+        }
+        last_out = out;
+    }
+    CHECK_EXP (bypass == TEST_STAB_RADIUS, "stabilizer held %d frames, expect %d", bypass, TEST_STAB_RADIUS);
+
+    stabilizer.stop ();
+    return 0;
+}
+
+static int
+test_stabilizer ()
+{
+    int32_t max_shift = 0;
+
+    // poses standing still leave frames as they are, delayed by the filter radius
+    CHECK_EXP (run_stabilizer (TEST_STAB_JITTER, false, max_shift) == 0, "run stabilizer with still poses failed");
+    printf ("still poses: largest output shift %d pixels\n", max_shift);
+    CHECK_EXP (max_shift == 2 * TEST_STAB_JITTER, "still poses moved frames, shift %d", max_shift);
+
+    CHECK_EXP (run_stabilizer (TEST_STAB_JITTER, true, max_shift) == 0, "run stabilizer with shaking poses failed");
+    printf ("shaking poses: input shift %d pixels, largest output shift %d pixels\n", 2 * TEST_STAB_JITTER, max_shift);
+    CHECK_EXP (max_shift <= 1, "stabilized frames still shift %d pixels", max_shift);
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s\n"
+            "\t--help              usage\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1) {
+        usage (argv[0]);
+        return strcmp (argv[1], "--help") ? -1 : 0;
+    }
+
+    CHECK_EXP (test_warp_translation (1) == 0, "warp translation on one thread failed");
+    CHECK_EXP (test_warp_translation (3) == 0, "warp translation on three threads failed");
+    CHECK_EXP (test_stabilizer () == 0, "video stabilizer failed");
+
+    printf ("soft video stabilizer tests passed\n");
+    return 0;
+}
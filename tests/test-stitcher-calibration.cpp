@@ -0,0 +1,238 @@
+/*
+ * test-stitcher-calibration.cpp - test calibration update of soft stitcher while stitching
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include "test_sv_params.h"
+#include <interface/stitcher.h>
+#include <image_file.h>
+#include <soft/soft_video_buf_allocator.h>
+#include <vector>
+
+#define TEST_CALIB_CAMERAS 4
+#define TEST_CALIB_MAX_FRAMES 200
+
+using namespace XCam;
+
+typedef std::vector<uint8_t> FrameData;
+
+static SmartPtr<Stitcher>
+create_stitcher (uint32_t out_width, uint32_t out_height)
+{
+    SmartPtr<Stitcher> stitcher = Stitcher::create_soft_stitcher ();
+    XCAM_ASSERT (stitcher.ptr ());
+
+    float range[XCAM_STITCH_FISHEYE_MAX_NUM];
+    stitcher->set_camera_num (TEST_CALIB_CAMERAS);
+    stitcher->set_output_size (out_width, out_height);
+    stitcher->set_dewarp_mode (DewarpBowl);
+    stitcher->set_blend_pyr_levels (2);
+    stitcher->set_viewpoints_range (viewpoints_range (CamB4C1080P, range));
+    stitcher->set_intrinsic_names (intrinsic_names);
+    stitcher->set_extrinsic_names (extrinsic_names);
+    return stitcher;
+}
+
+static XCamReturn
+read_inputs (const char **files, const VideoBufferInfo &info, VideoBufferList &ins)
+{
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+    XCAM_FAIL_RETURN (ERROR, pool->reserve (TEST_CALIB_CAMERAS), XCAM_RETURN_ERROR_MEM, "reserve buffers failed");
+
+    for (uint32_t i = 0; i < TEST_CALIB_CAMERAS; ++i) {
+        SmartPtr<VideoBuffer> buf = pool->get_buffer ();
+        XCAM_FAIL_RETURN (ERROR, buf.ptr (), XCAM_RETURN_ERROR_MEM, "get buffer failed");
+
+        ImageFile file;
+        XCamReturn ret = file.open (files[i], "rb");
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "open input file(%s) failed", files[i]);
+        ret = file.read_buf (buf);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "read input file(%s) failed", files[i]);
+        ins.push_back (buf);
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+// stitch_buffers is synchronous, a frame without output is a dropped one
+static int
+stitch_frame (
+    const SmartPtr<Stitcher> &stitcher, const VideoBufferList &ins, uint32_t frame, FrameData &data)
+{
+    SmartPtr<VideoBuffer> out;
+    CHECK (stitcher->stitch_buffers (ins, out), "stitch frame %d failed", frame);
+    CHECK_EXP (out.ptr (), "frame %d dropped", frame);
+
+    const VideoBufferInfo &info = out->get_video_info ();
+    const uint8_t *ptr = out->map ();
+    data.assign (ptr, ptr + info.size);
+    out->unmap ();
+    return 0;
+}
+
+// a small turn of the front camera and a shift of the rear one
+static void
+shift_calibration (Stitcher::Calibration &calib)
+{
+    calib.cameras[0].extrinsic.yaw += 2.0f;
+    calib.cameras[2].extrinsic.trans_x += 50.0f;
+}
+
+static int
+test_update_while_stitching (
+    const char **files, const VideoBufferInfo &in_info, uint32_t out_width, uint32_t out_height,
+    uint32_t update_frame)
+{
+    VideoBufferList ins;
+    CHECK (read_inputs (files, in_info, ins), "read inputs failed");
+
+    SmartPtr<Stitcher> stitcher = create_stitcher (out_width, out_height);
+    FrameData old_ref;
+    CHECK_EXP (stitch_frame (stitcher, ins, 0, old_ref) == 0, "stitch first frame failed");
+
+    Stitcher::Calibration calib;
+    CHECK (stitcher->get_calibration (calib), "get calibration failed");
+    shift_calibration (calib);
+
+    // a stitcher configured with the new calibration from its first frame
+    FrameData new_ref;
+    SmartPtr<Stitcher> fresh = create_stitcher (out_width, out_height);
+    CHECK (fresh->update_calibration (calib), "set calibration of fresh stitcher failed");
+    CHECK_EXP (stitch_frame (fresh, ins, 0, new_ref) == 0, "stitch with fresh stitcher failed");
+    CHECK_EXP (old_ref != new_ref, "new calibration changes no output pixel");
+
+    uint32_t frame = 1;
+    uint32_t swap_frame = 0;
+    uint32_t after_swap = 0;
+    for (; frame < TEST_CALIB_MAX_FRAMES && after_swap < 3; ++frame) {
+        if (frame == update_frame)
+            CHECK (stitcher->update_calibration (calib), "update calibration at frame %d failed", frame);
+
+        FrameData out;
+        CHECK_EXP (stitch_frame (stitcher, ins, frame, out) == 0, "stitch frame %d failed", frame);
+
+        if (swap_frame) {
+            CHECK_EXP (out == new_ref, "frame %d after swap at frame %d differs from fresh stitcher", frame, swap_frame);
+            ++after_swap;
+        } else if (out == new_ref) {
+            CHECK_EXP (frame >= update_frame, "frame %d took calibration updated at frame %d", frame, update_frame);
+            swap_frame = frame;
+            ++after_swap;
+        } else {
+            // neither calibration means frames mixed both
+            CHECK_EXP (out == old_ref, "frame %d matches neither calibration", frame);
+        }
+    }
+
+    CHECK_EXP (swap_frame, "calibration not swapped in after %d frames", TEST_CALIB_MAX_FRAMES);
+    CHECK_EXP (!stitcher->is_calibration_pending (), "calibration still pending after swap");
+
+    Stitcher::Calibration current;
+    CHECK (stitcher->get_calibration (current), "get calibration after swap failed");
+    CHECK_EXP (
+        current.cameras[0].extrinsic.yaw == calib.cameras[0].extrinsic.yaw,
+        "get_calibration returned the old calibration after swap");
+
+    printf ("calibration updated at frame %d, swapped in at frame %d, %d frames without drop\n",
+            update_frame, swap_frame, frame);
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s --input front.nv12 --input right.nv12 --input rear.nv12 --input left.nv12\n"
+            "\t                    read calibration files from exported path $FISHEYE_CONFIG_PATH\n"
+            "\t--input             input image(NV12), one per camera: front, right, rear, left\n"
+            "\t--in-w              optional, input width, default: 1280\n"
+            "\t--in-h              optional, input height, default: 720\n"
+            "\t--out-w             optional, output width, default: 1920\n"
+            "\t--out-h             optional, output height, default: 640\n"
+            "\t--help              usage\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    const char *files[TEST_CALIB_CAMERAS] = {NULL};
+    uint32_t input_count = 0;
+    uint32_t input_width = 1280;
+    uint32_t input_height = 720;
+    uint32_t output_width = 1920;
+    uint32_t output_height = 640;
+
+    const struct option long_opts[] = {
+        {"input", required_argument, NULL, 'i'},
+        {"in-w", required_argument, NULL, 'w'},
+        {"in-h", required_argument, NULL, 'h'},
+        {"out-w", required_argument, NULL, 'W'},
+        {"out-h", required_argument, NULL, 'H'},
+        {"help", no_argument, NULL, 'e'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int opt = -1;
+    while ((opt = getopt_long (argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'i':
+            XCAM_ASSERT (optarg);
+            CHECK_EXP (input_count < TEST_CALIB_CAMERAS, "too many inputs, expect %d", TEST_CALIB_CAMERAS);
+            files[input_count++] = optarg;
+            break;
+        case 'w':
+            input_width = atoi (optarg);
+            break;
+        case 'h':
+            input_height = atoi (optarg);
+            break;
+        case 'W':
+            output_width = atoi (optarg);
+            break;
+        case 'H':
+            output_height = atoi (optarg);
+            break;
+        case 'e':
+            usage (argv[0]);
+            return 0;
+        default:
+            XCAM_LOG_ERROR ("getopt_long return unknown value:%c", opt);
+            usage (argv[0]);
+            return -1;
+        }
+    }
+
+    if (optind < argc || input_count != TEST_CALIB_CAMERAS) {
+        XCAM_LOG_ERROR ("stitcher calibration test needs %d inputs", TEST_CALIB_CAMERAS);
+        usage (argv[0]);
+        return -1;
+    }
+
+    VideoBufferInfo in_info;
+    in_info.init (V4L2_PIX_FMT_NV12, input_width, input_height);
+
+    // right after the first frame, and with the pipeline warmed up
+    CHECK_EXP (
+        test_update_while_stitching (files, in_info, output_width, output_height, 1) == 0,
+        "update calibration at frame 1 failed");
+    CHECK_EXP (
+        test_update_while_stitching (files, in_info, output_width, output_height, 4) == 0,
+        "update calibration at frame 4 failed");
+
+    printf ("stitcher calibration tests passed\n");
+    return 0;
+}
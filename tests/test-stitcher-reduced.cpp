@@ -0,0 +1,273 @@
+/*
+ * test-stitcher-reduced.cpp - test reduced outputs of soft stitcher against a downscaled output
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include "test_sv_params.h"
+#include <interface/stitcher.h>
+#include <image_file.h>
+#include <soft/soft_video_buf_allocator.h>
+
+#define TEST_REDUCED_CAMERAS 4
+#define TEST_REDUCED_ALL_LEVELS 0x1E
+
+using namespace XCam;
+
+static SmartPtr<Stitcher>
+create_stitcher (uint32_t out_width, uint32_t out_height, uint32_t levels)
+{
+    SmartPtr<Stitcher> stitcher = Stitcher::create_soft_stitcher ();
+    XCAM_ASSERT (stitcher.ptr ());
+
+    float range[XCAM_STITCH_FISHEYE_MAX_NUM];
+    stitcher->set_camera_num (TEST_REDUCED_CAMERAS);
+    stitcher->set_output_size (out_width, out_height);
+    stitcher->set_dewarp_mode (DewarpBowl);
+    stitcher->set_blend_pyr_levels (2);
+    stitcher->set_viewpoints_range (viewpoints_range (CamB4C1080P, range));
+    stitcher->set_intrinsic_names (intrinsic_names);
+    stitcher->set_extrinsic_names (extrinsic_names);
+    stitcher->set_reduced_outputs (levels);
+    return stitcher;
+}
+
+static XCamReturn
+read_inputs (const char **files, const VideoBufferInfo &info, VideoBufferList &ins)
+{
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+    XCAM_FAIL_RETURN (ERROR, pool->reserve (TEST_REDUCED_CAMERAS), XCAM_RETURN_ERROR_MEM, "reserve buffers failed");
+
+    for (uint32_t i = 0; i < TEST_REDUCED_CAMERAS; ++i) {
+        SmartPtr<VideoBuffer> buf = pool->get_buffer ();
+        XCAM_FAIL_RETURN (ERROR, buf.ptr (), XCAM_RETURN_ERROR_MEM, "get buffer failed");
+
+        ImageFile file;
+        XCamReturn ret = file.open (files[i], "rb");
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "open input file(%s) failed", files[i]);
+        ret = file.read_buf (buf);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "read input file(%s) failed", files[i]);
+        ins.push_back (buf);
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+// rounded mean of 2^level x 2^level blocks, counts pixels of [x0, x1) x [y0, y1) differing
+static uint32_t
+compare_plane (
+    const uint8_t *full, uint32_t full_stride, const uint8_t *reduced, uint32_t reduced_stride,
+    uint32_t channels, uint32_t level, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    uint32_t block = 1 << level;
+    uint32_t diff = 0;
+    for (uint32_t y = y0; y < y1; ++y) {
+        for (uint32_t x = x0; x < x1; ++x) {
+            for (uint32_t c = 0; c < channels; ++c) {
+                uint32_t sum = 0;
+                for (uint32_t j = 0; j < block; ++j)
+                    for (uint32_t i = 0; i < block; ++i)
+                        sum += full[((y << level) + j) * full_stride + ((x << level) + i) * channels + c];
+
+                uint8_t expected = (sum + block * block / 2) >> (2 * level);
+                if (reduced[y * reduced_stride + x * channels + c] != expected)
+                    ++diff;
+            }
+        }
+    }
+    return diff;
+}
+
+// reduced pixels covering area of the output, area is 2^(level+1) aligned
+static uint32_t
+compare_reduced (
+    const SmartPtr<VideoBuffer> &full_buf, const SmartPtr<VideoBuffer> &reduced_buf,
+    uint32_t level, const Rect &area)
+{
+    const VideoBufferInfo &full_info = full_buf->get_video_info ();
+    const VideoBufferInfo &info = reduced_buf->get_video_info ();
+    const uint8_t *full = full_buf->map ();
+    const uint8_t *reduced = reduced_buf->map ();
+
+    uint32_t x0 = area.pos_x >> level, y0 = area.pos_y >> level;
+    uint32_t x1 = (area.pos_x + area.width) >> level, y1 = (area.pos_y + area.height) >> level;
+    uint32_t diff = compare_plane (
+                        full + full_info.offsets[0], full_info.strides[0],
+                        reduced + info.offsets[0], info.strides[0], 1, level, x0, y0, x1, y1);
+    diff += compare_plane (
+                full + full_info.offsets[1], full_info.strides[1],
+                reduced + info.offsets[1], info.strides[1], 2, level, x0 / 2, y0 / 2, x1 / 2, y1 / 2);
+
+    reduced_buf->unmap ();
+    full_buf->unmap ();
+    return diff;
+}
+
+static int
+test_whole_output (const VideoBufferList &ins, uint32_t out_width, uint32_t out_height)
+{
+    SmartPtr<Stitcher> stitcher = create_stitcher (out_width, out_height, TEST_REDUCED_ALL_LEVELS);
+
+    // level 2 comes from the caller, the others from the stitcher
+    VideoBufferInfo out_info, caller_info;
+    out_info.init (V4L2_PIX_FMT_NV12, out_width, out_height);
+    caller_info.init (V4L2_PIX_FMT_NV12, out_width >> 2, out_height >> 2);
+    SmartPtr<BufferPool> out_pool = new SoftVideoBufAllocator (out_info);
+    SmartPtr<BufferPool> caller_pool = new SoftVideoBufAllocator (caller_info);
+    CHECK_EXP (out_pool->reserve (1) && caller_pool->reserve (1), "reserve output buffers failed");
+
+    SmartPtr<VideoBuffer> out = out_pool->get_buffer ();
+    SmartPtr<StitchReducedOutputs> meta = new StitchReducedOutputs;
+    meta->bufs[2] = caller_pool->get_buffer ();
+    SmartPtr<VideoBuffer> caller_buf = meta->bufs[2];
+    out->add_metadata (meta);
+
+    for (uint32_t frame = 0; frame < 2; ++frame) {
+        CHECK (stitcher->stitch_buffers (ins, out), "stitch frame %d failed", frame);
+
+        SmartPtr<StitchReducedOutputs> reduced = out->find_typed_metadata<StitchReducedOutputs> ();
+        CHECK_EXP (reduced.ptr (), "frame %d has no reduced outputs", frame);
+        CHECK_EXP (reduced->bufs[2].ptr () == caller_buf.ptr (), "caller buffer of level 2 replaced");
+
+        for (uint32_t level = 1; level <= XCAM_STITCH_MAX_REDUCED_LEVEL; ++level) {
+            const SmartPtr<VideoBuffer> &buf = reduced->bufs[level];
+            CHECK_EXP (buf.ptr (), "frame %d misses reduced output of level %d", frame, level);
+
+            uint32_t diff = compare_reduced (out, buf, level, Rect (0, 0, out_width, out_height));
+            CHECK_EXP (diff == 0, "frame %d level %d: %d samples differ from downscaled output", frame, level, diff);
+        }
+    }
+
+    printf ("whole output: levels 1-%d match downscaled output\n", XCAM_STITCH_MAX_REDUCED_LEVEL);
+    return 0;
+}
+
+// a viewport wrapping around the right edge
+static int
+test_viewport (const VideoBufferList &ins, uint32_t out_width, uint32_t out_height)
+{
+    uint32_t levels = (1 << 1) | (1 << 3);
+    SmartPtr<Stitcher> stitcher = create_stitcher (out_width, out_height, levels);
+    Rect viewport (out_width - 320, 64, 640, out_height / 2);
+    CHECK_EXP (stitcher->set_viewport (viewport), "set viewport failed");
+
+    SmartPtr<VideoBuffer> out;
+    CHECK (stitcher->stitch_buffers (ins, out), "stitch with viewport failed");
+    SmartPtr<StitchReducedOutputs> reduced = out->find_typed_metadata<StitchReducedOutputs> ();
+    CHECK_EXP (reduced.ptr (), "viewport output has no reduced outputs");
+
+    Rect rects[2] = {
+        Rect (viewport.pos_x, viewport.pos_y, out_width - viewport.pos_x, viewport.height),
+        Rect (0, viewport.pos_y, viewport.pos_x + viewport.width - out_width, viewport.height)
+    };
+    for (uint32_t level = 1; level <= XCAM_STITCH_MAX_REDUCED_LEVEL; ++level) {
+        if (!(levels & (1 << level))) {
+            CHECK_EXP (!reduced->bufs[level].ptr (), "reduced output of level %d not asked for", level);
+            continue;
+        }
+        CHECK_EXP (reduced->bufs[level].ptr (), "viewport output misses reduced level %d", level);
+
+        for (uint32_t r = 0; r < sizeof (rects) / sizeof (rects[0]); ++r) {
+            uint32_t diff = compare_reduced (out, reduced->bufs[level], level, rects[r]);
+            CHECK_EXP (diff == 0, "viewport part %d level %d: %d samples differ", r, level, diff);
+        }
+    }
+
+    printf ("viewport: reduced outputs match downscaled viewport\n");
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s --input front.nv12 --input right.nv12 --input rear.nv12 --input left.nv12\n"
+            "\t                    read calibration files from exported path $FISHEYE_CONFIG_PATH\n"
+            "\t--input             input image(NV12), one per camera: front, right, rear, left\n"
+            "\t--in-w              optional, input width, default: 1280\n"
+            "\t--in-h              optional, input height, default: 720\n"
+            "\t--out-w             optional, output width, multiple of %d, default: 1920\n"
+            "\t--out-h             optional, output height, multiple of %d, default: 640\n"
+            "\t--help              usage\n",
+            arg0, 2 << XCAM_STITCH_MAX_REDUCED_LEVEL, 2 << XCAM_STITCH_MAX_REDUCED_LEVEL);
+}
+
+int main (int argc, char *argv[])
+{
+    const char *files[TEST_REDUCED_CAMERAS] = {NULL};
+    uint32_t input_count = 0;
+    uint32_t input_width = 1280;
+    uint32_t input_height = 720;
+    uint32_t output_width = 1920;
+    uint32_t output_height = 640;
+
+    const struct option long_opts[] = {
+        {"input", required_argument, NULL, 'i'},
+        {"in-w", required_argument, NULL, 'w'},
+        {"in-h", required_argument, NULL, 'h'},
+        {"out-w", required_argument, NULL, 'W'},
+        {"out-h", required_argument, NULL, 'H'},
+        {"help", no_argument, NULL, 'e'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int opt = -1;
+    while ((opt = getopt_long (argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'i':
+            XCAM_ASSERT (optarg);
+            CHECK_EXP (input_count < TEST_REDUCED_CAMERAS, "too many inputs, expect %d", TEST_REDUCED_CAMERAS);
+            files[input_count++] = optarg;
+            break;
+        case 'w':
+            input_width = atoi (optarg);
+            break;
+        case 'h':
+            input_height = atoi (optarg);
+            break;
+        case 'W':
+            output_width = atoi (optarg);
+            break;
+        case 'H':
+            output_height = atoi (optarg);
+            break;
+        case 'e':
+            usage (argv[0]);
+            return 0;
+        default:
+            XCAM_LOG_ERROR ("getopt_long return unknown value:%c", opt);
+            usage (argv[0]);
+            return -1;
+        }
+    }
+
+    if (optind < argc || input_count != TEST_REDUCED_CAMERAS) {
+        XCAM_LOG_ERROR ("stitcher reduced output test needs %d inputs", TEST_REDUCED_CAMERAS);
+        usage (argv[0]);
+        return -1;
+    }
+
+    VideoBufferInfo in_info;
+    in_info.init (V4L2_PIX_FMT_NV12, input_width, input_height);
+    VideoBufferList ins;
+    CHECK (read_inputs (files, in_info, ins), "read inputs failed");
+
+    CHECK_EXP (test_whole_output (ins, output_width, output_height) == 0, "reduced whole output failed");
+    CHECK_EXP (test_viewport (ins, output_width, output_height) == 0, "reduced viewport output failed");
+
+    printf ("stitcher reduced output tests passed\n");
+    return 0;
+}
@@ -26,6 +26,7 @@
 #include <calibration_parser.h>
 #include <fisheye_image_file.h>
 #include <soft/soft_video_buf_allocator.h>
+#include <soft/soft_multi_geo_mapper.h>
 #include <dma_video_buffer.h>
 #if HAVE_GLES
 #include <gles/gl_video_buffer.h>
@@ -68,6 +69,9 @@ struct SVOutConfig {
 
     bool save_topview = false;
     uint32_t topview_index;
+    // 顶视图直接由鱼眼输入生成，不经过拼接图二次重采样
+    bool topview_direct = false;
+    SmartPtr<SoftMultiGeoMapper> topview_mapper;
 
     bool save_cubemap = false;
     uint32_t cubemap_index;
@@ -75,6 +79,10 @@ struct SVOutConfig {
     bool is_save() const {
         return save_output || save_topview || save_cubemap;
     }
+    // 仅输出直接顶视图时无需完整拼接
+    bool need_stitch() const {
+        return save_output || save_cubemap || !topview_direct;
+    }
 };
 
 #if HAVE_GLES
@@ -410,6 +418,51 @@ remap_buf (const SmartPtr<SVStream> &stitch, const SmartPtr<SVStream> &topview)
     return XCAM_RETURN_NO_ERROR;
 }
 
+// 由 Bowl 模型与鱼眼查找表合成每路相机的顶视图 LUT，直接从输入生成顶视图。
+static XCamReturn
+create_topview_direct_mapper (
+    const SmartPtr<Stitcher> &stitcher, const SmartPtr<SVStream> &stitch,
+    const SmartPtr<SVStream> &topview, SVOutConfig &out_config)
+{
+    BowlModel bowl_model (stitcher->get_bowl_config (), stitch->get_width (), stitch->get_height ());
+    Stitcher::ComposedMapArray maps;
+
+    float length_mm = 0.0f, width_mm = 0.0f;
+    bowl_model.get_max_topview_area_mm (length_mm, width_mm);
+    XCAM_LOG_INFO ("Max Topview Area (L%.2fmm, W%.2fmm)", length_mm, width_mm);
+
+    XCAM_FAIL_RETURN (
+        ERROR,
+        bowl_model.get_topview_camera_maps (
+            stitcher, maps, topview->get_width (), topview->get_height (), length_mm, width_mm),
+        XCAM_RETURN_ERROR_PARAM, "get topview camera maps failed");
+
+    SmartPtr<SoftMultiGeoMapper> mapper = new SoftMultiGeoMapper ();
+    XCamReturn ret = mapper->set_camera_maps (maps, topview->get_width (), topview->get_height ());
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "set topview camera maps failed");
+
+    out_config.topview_mapper = mapper;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static XCamReturn
+remap_direct_buf (const SVStreams &ins, const SmartPtr<SVStream> &topview, const SVOutConfig &out_config)
+{
+    XCAM_ASSERT (out_config.topview_mapper.ptr ());
+
+    VideoBufferList in_buffers;
+    for (uint32_t i = 0; i < ins.size (); ++i)
+        in_buffers.push_back (ins[i]->get_buf ());
+
+    XCamReturn ret = out_config.topview_mapper->remap (in_buffers, topview->get_buf ());
+    if (ret != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_ERROR ("remap fisheye images to topview failed.");
+        return ret;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 // 构建 Cubemap 重映射器，核心区别在于使用 CubeMapModel 生成六面展开 LUT。
 static XCamReturn
 create_cubemap_mapper (
@@ -518,7 +571,10 @@ write_image (
 
     if (out_config.save_topview) {
         // Topview 2D
-        remap_buf (outs[out_config.stitch_index], outs[out_config.topview_index]);
+        if (out_config.topview_direct)
+            remap_direct_buf (ins, outs[out_config.topview_index], out_config);
+        else
+            remap_buf (outs[out_config.stitch_index], outs[out_config.topview_index]);
         write_out_image (outs[out_config.topview_index], frame_num);
     }
 
@@ -585,7 +641,7 @@ single_frame (
 #else
             XCAM_LOG_ERROR ("GLES module is unsupported");
 #endif
-        } else {
+        } else if (out_config.need_stitch ()) {
             CHECK (stitcher->stitch_buffers (in_buffers, outs[out_config.stitch_index]->get_buf ()), "stitch buffer failed.");
         }
 
@@ -645,9 +701,11 @@ multi_frame (
 
             XCAM_OBJ_PROFILING_START;                                 // 性能统计起始
 
-            CHECK (
-                stitcher->stitch_buffers (in_buffers, outs[out_config.stitch_index]->get_buf ()),
-                "stitch buffer failed.");                             // 将当前帧输入传给 Stitcher 完成拼接
+            if (out_config.need_stitch ()) {
+                CHECK (
+                    stitcher->stitch_buffers (in_buffers, outs[out_config.stitch_index]->get_buf ()),
+                    "stitch buffer failed.");                         // 将当前帧输入传给 Stitcher 完成拼接
+            }
 
             XCAM_OBJ_PROFILING_END ("stitch-buffers", XCAM_OBJ_DUR_FRAME_NUM);
 
@@ -692,6 +750,26 @@ run_stitcher (
 }
 
 // 打印命令行帮助信息，列出所有可配置的拼接参数。
+static void
+print_stitch_metrics (const SmartPtr<Stitcher> &stitcher)
+{
+    Stitcher::Metrics metrics;
+    stitcher->get_stitch_metrics (metrics);
+
+    printf ("stage\t\tcount\terrors\tmean(us)\tp99(us)\tmax(us)\n");
+    for (uint32_t i = 0; i < Stitcher::StageCount; ++i) {
+        const LatencyHistogram &hist = metrics.stages[i];
+        if (!hist.count && !hist.errors)
+            continue;
+        printf ("%-14s\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t\t%" PRIu64 "\t%" PRIu64 "\n",
+                Stitcher::get_stage_name ((Stitcher::Stage)i), hist.count, hist.errors,
+                hist.mean_us (), hist.percentile_us (0.99f), hist.max_us);
+    }
+    printf ("buffers acquired:%" PRIu64 " starved:%" PRIu64 " exhausted:%" PRIu64 " grown:%" PRIu64 " shrunk:%" PRIu64 "\n",
+            metrics.pools.acquired, metrics.pools.starved_wait.count + metrics.pools.starved_wait.errors,
+            metrics.pools.starved_wait.errors, metrics.pools.grown, metrics.pools.shrunk);
+}
+
 static void usage(const char* arg0)
 {
     printf ("Usage:\n"
@@ -731,6 +809,8 @@ static void usage(const char* arg0)
             "\t--frame-mode        optional, times of buffer reading, select from [single/multi], default: multi\n"
             "\t--save              optional, save file or not, select from [true/false], default: true\n"
             "\t--save-topview      optional, save top view video, select from [true/false], default: false\n"
+            "\t--topview-direct    optional, render top view from fisheye inputs, only for soft module and bowl dewarp,\n"
+            "\t                    stitching is skipped if top view is the only output, select from [true/false], default: false\n"
             "\t--save-cubemap      optional, save cubemap video, select from [true/false], default: false\n"
             "\t--loop              optional, how many loops need to run, default: 1\n"
             "\t--help              usage\n",
@@ -815,6 +895,7 @@ int main (int argc, char *argv[])
         {"frame-mode", required_argument, NULL, 'f'},
         {"save", required_argument, NULL, 's'},
         {"save-topview", required_argument, NULL, 't'},
+        {"topview-direct", required_argument, NULL, 'g'},
         {"save-cubemap", required_argument, NULL, 'q'},
         {"loop", required_argument, NULL, 'L'},
         {"repeat", required_argument, NULL, 'R'},
@@ -1015,6 +1096,9 @@ int main (int argc, char *argv[])
         case 't':
             out_config.save_topview = (strcasecmp (optarg, "false") == 0 ? false : true);
             break;
+        case 'g':
+            out_config.topview_direct = (strcasecmp (optarg, "false") == 0 ? false : true);
+            break;
         case 'q':
             out_config.save_cubemap = (strcasecmp (optarg, "false") == 0 ? false : true);
             break;
@@ -1055,6 +1139,15 @@ int main (int argc, char *argv[])
     CHECK_EXP (outs.size () == 1 && outs[out_config.stitch_index].ptr (), "surrond view needs 1 output stream");
     CHECK_EXP (strlen (outs[out_config.stitch_index]->get_file_name ()), "output file name was not set");
 
+    if (out_config.topview_direct) {
+        CHECK_EXP (
+            module == SVModuleSoft && dewarp_mode == DewarpBowl && !enable_dmabuf,
+            "topview-direct only supports soft module and bowl dewarp mode without dmabuf");
+        CHECK_EXP (
+            ins.size () == fisheye_num && input_format == V4L2_PIX_FMT_NV12,
+            "topview-direct needs one NV12 input stream for each fisheye");
+    }
+
     // 输出当前配置，便于在命令行查看最终生效的参数组合。
     for (uint32_t i = 0; i < ins.size (); ++i) {
         printf ("input%d file:\t\t%s\n", i, ins[i]->get_file_name ());
@@ -1094,6 +1187,7 @@ int main (int argc, char *argv[])
     printf ("save output:\t\t%s\n", out_config.save_output ? "true" : "false");
     printf ("save topview:\t\t%s\n", out_config.save_topview ? "true" : "false");
     printf ("save cubemap:\t\t%s\n", out_config.save_cubemap ? "true" : "false");
+    printf ("topview direct:\t\t%s\n", out_config.topview_direct ? "true" : "false");
     printf ("loop count:\t\t%d\n", loop);
     printf ("repeat count:\t\t%d\n", repeat);
 
@@ -1283,8 +1377,18 @@ int main (int argc, char *argv[])
                    "%s: estimate file format failed", outs[out_config.topview_index]->get_file_name ());
             CHECK (outs[out_config.topview_index]->open_writer ("wb"), "open output file(%s) failed", outs[out_config.topview_index]->get_file_name ());
 
-            // 为顶视图输出配置独立的 GeoMapper，以便在主循环中直接 remap。
-            create_topview_mapper (stitcher, outs[out_config.stitch_index], outs[out_config.topview_index], module);
+            if (out_config.topview_direct) {
+                // 直接顶视图需要自备输出缓冲，拼接输出缓冲不再参与。
+                outs[out_config.topview_index]->set_module (module);
+                CHECK (outs[out_config.topview_index]->create_buf_pool (2, V4L2_PIX_FMT_NV12), "create buffer pool failed");
+                CHECK (
+                    create_topview_direct_mapper (
+                        stitcher, outs[out_config.stitch_index], outs[out_config.topview_index], out_config),
+                    "create topview direct mapper failed");
+            } else {
+                // 为顶视图输出配置独立的 GeoMapper，以便在主循环中直接 remap。
+                create_topview_mapper (stitcher, outs[out_config.stitch_index], outs[out_config.topview_index], module);
+            }
         }
 
         if (out_config.save_cubemap) {
@@ -1304,6 +1408,7 @@ int main (int argc, char *argv[])
         CHECK_EXP (
             run_stitcher (stitcher, ins, outs, frame_mode, out_config, loop, enable_dmabuf) == 0,
             "run stitcher failed");
+        print_stitch_metrics (stitcher);
     }
 
     return 0;
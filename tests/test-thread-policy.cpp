@@ -0,0 +1,252 @@
+/*
+ * test-thread-policy.cpp - test thread policies parsed by role
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include <thread_policy.h>
+#include <xcam_thread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+using namespace XCam;
+
+struct TestPolicyCase {
+    const char *config;
+    bool        valid;
+};
+
+static const TestPolicyCase policy_cases[] = {
+    {"capture:sched=fifo:prio=50", true},
+    {"capture:prio=50:sched=rr", true},
+    {"stitch:nice=-5:cpus=0;worker:nice=19", true},
+    {"process:cpus=0-1,3", true},
+    {"capture:sched=fifo", false},
+    {"capture:sched=fifo:prio=0", false},
+    {"capture:sched=rr:prio=100", false},
+    {"capture:prio=50", false},
+    {"capture:sched=idle", false},
+    {"stitch:nice=-21", false},
+    {"stitch:nice=20", false},
+    {"stitch:nice=5x", false},
+    {"stitch:nice=", false},
+    {"process:cpus=3-1", false},
+    {"process:cpus=a", false},
+    {"process:affinity=0", false},
+    {"display:nice=5", false},
+    {"stitch:nice=5;display:nice=5", false},
+};
+
+// records what the policy of its role did to it
+class TestPolicyThread
+    : public Thread
+{
+public:
+    TestPolicyThread (const char *name, ThreadRole role)
+        : Thread (name, role)
+        , _nice (0)
+    {
+        xcam_mem_clear (_thread_name);
+        CPU_ZERO (&_cpus);
+    }
+
+    const char *get_thread_name () const {
+        return _thread_name;
+    }
+    int get_nice () const {
+        return _nice;
+    }
+    const cpu_set_t &get_cpus () const {
+        return _cpus;
+    }
+
+protected:
+    // runs right after the policy is applied, even if stop comes first
+    virtual bool started () {
+#ifdef __USE_GNU
+        pthread_getname_np (pthread_self (), _thread_name, sizeof (_thread_name));
+#endif
+        _nice = getpriority (PRIO_PROCESS, (pid_t) syscall (SYS_gettid));
+        pthread_getaffinity_np (pthread_self (), sizeof (_cpus), &_cpus);
+        return false;
+    }
+    virtual bool loop () {
+        return false;
+    }
+
+private:
+    char         _thread_name[16];
+    int          _nice;
+    cpu_set_t    _cpus;
+};
+
+static bool
+is_same_policy (const ThreadPolicy &a, const ThreadPolicy &b)
+{
+    return a.sched_policy == b.sched_policy && a.priority == b.priority && a.nice == b.nice &&
+           a.pinned == b.pinned && CPU_EQUAL (&a.cpus, &b.cpus);
+}
+
+static int
+test_parse_policies ()
+{
+    SmartPtr<ThreadPolicyManager> manager = ThreadPolicyManager::instance ();
+
+    for (uint32_t i = 0; i < sizeof (policy_cases) / sizeof (policy_cases[0]); ++i) {
+        const TestPolicyCase &test = policy_cases[i];
+
+        ThreadPolicy before[ThreadRoleCount];
+        for (int role = 0; role < ThreadRoleCount; ++role)
+            before[role] = manager->get_policy ((ThreadRole) role);
+
+        bool ret = manager->parse_policies (test.config);
+        CHECK_EXP (ret == test.valid, "parse \"%s\" returned %d, expect %d", test.config, ret, test.valid);
+
+        // a rejected config changes no role, not even the roles before the bad one
+        for (int role = 0; !ret && role < ThreadRoleCount; ++role) {
+            CHECK_EXP (
+                is_same_policy (before[role], manager->get_policy ((ThreadRole) role)),
+                "rejected \"%s\" changed role:%s", test.config, ThreadPolicyManager::role_name ((ThreadRole) role));
+        }
+    }
+
+    CHECK_EXP (manager->parse_policies ("capture:prio=50:sched=fifo"), "parse fifo policy failed");
+    ThreadPolicy policy = manager->get_policy (ThreadRoleCapture);
+    CHECK_EXP (
+        policy.sched_policy == SCHED_FIFO && policy.priority == 50,
+        "capture policy got sched:%d prio:%d", policy.sched_policy, policy.priority);
+
+    CHECK_EXP (manager->parse_policies ("process:cpus=0-1,3"), "parse cpu list failed");
+    policy = manager->get_policy (ThreadRoleProcess);
+    CHECK_EXP (
+        policy.pinned && CPU_COUNT (&policy.cpus) == 3 && CPU_ISSET (0, &policy.cpus) &&
+        CPU_ISSET (1, &policy.cpus) && CPU_ISSET (3, &policy.cpus),
+        "cpu list 0-1,3 parsed wrong");
+
+    // reset the roles used above
+    CHECK_EXP (
+        manager->parse_policies ("capture;stitch;worker;process"),
+        "reset policies failed");
+    CHECK_EXP (
+        is_same_policy (manager->get_policy (ThreadRoleCapture), ThreadPolicy ()),
+        "role without fields didn't get the default policy");
+
+    return 0;
+}
+
+static int
+test_set_policy ()
+{
+    SmartPtr<ThreadPolicyManager> manager = ThreadPolicyManager::instance ();
+
+    ThreadPolicy policy;
+    policy.sched_policy = SCHED_RR;
+    policy.priority = sched_get_priority_max (SCHED_RR);
+    CHECK_EXP (policy.is_valid () && manager->set_policy (ThreadRoleEvent, policy), "set rr policy failed");
+
+    policy.priority = sched_get_priority_max (SCHED_RR) + 1;
+    CHECK_EXP (!manager->set_policy (ThreadRoleEvent, policy), "set rr policy with priority out of range");
+
+    policy = ThreadPolicy ();
+    policy.priority = 1;
+    CHECK_EXP (!manager->set_policy (ThreadRoleEvent, policy), "set priority on sched other");
+
+    policy = ThreadPolicy ();
+    policy.nice = -21;
+    CHECK_EXP (!manager->set_policy (ThreadRoleEvent, policy), "set nice out of range");
+
+    CHECK_EXP (manager->get_policy (ThreadRoleEvent).sched_policy == SCHED_RR, "invalid policy replaced a valid one");
+    CHECK_EXP (manager->set_policy (ThreadRoleEvent, ThreadPolicy ()), "reset event policy failed");
+
+    ThreadPolicy cpus;
+    CHECK_EXP (cpus.set_cpus ("1,0"), "set cpus 1,0 failed");
+    CHECK_EXP (!cpus.set_cpus ("3-1"), "set reversed cpu range");
+    CHECK_EXP (!cpus.set_cpus ("0-a"), "set cpu range without an end");
+
+    return 0;
+}
+
+static int
+test_apply_policy ()
+{
+    SmartPtr<ThreadPolicyManager> manager = ThreadPolicyManager::instance ();
+
+    // raising nice and pinning to a cpu we already run on need no privilege
+    cpu_set_t allowed;
+    CPU_ZERO (&allowed);
+    CHECK_EXP (sched_getaffinity (0, sizeof (allowed), &allowed) == 0, "get process affinity failed");
+    int cpu = 0;
+    while (cpu < CPU_SETSIZE && !CPU_ISSET (cpu, &allowed))
+        ++cpu;
+    CHECK_EXP (cpu < CPU_SETSIZE, "process allowed on no cpu");
+
+    char config[64];
+    snprintf (config, sizeof (config), "worker:nice=5:cpus=%d", cpu);
+    CHECK_EXP (manager->parse_policies (config), "parse \"%s\" failed", config);
+
+    SmartPtr<TestPolicyThread> thread = new TestPolicyThread ("soft-stitch-thrs-12", ThreadRoleWorker);
+    CHECK_EXP (thread->start (), "start worker thread failed");
+    thread->stop ();
+
+    CHECK_EXP (thread->get_nice () == 5, "worker thread got nice %d, expect 5", thread->get_nice ());
+    CHECK_EXP (
+        CPU_COUNT (&thread->get_cpus ()) == 1 && CPU_ISSET (cpu, &thread->get_cpus ()),
+        "worker thread not pinned to cpu %d", cpu);
+#ifdef __USE_GNU
+    // cut to 15 characters, the pool index stays
+    CHECK_EXP (
+        !strcmp (thread->get_thread_name (), "xc:soft-stit-12"),
+        "worker thread named \"%s\", expect \"xc:soft-stit-12\"", thread->get_thread_name ());
+#endif
+
+    // threads of other roles keep what they inherit
+    thread = new TestPolicyThread ("plain", ThreadRoleDefault);
+    CHECK_EXP (thread->start (), "start default thread failed");
+    thread->stop ();
+    CHECK_EXP (thread->get_nice () == getpriority (PRIO_PROCESS, 0), "default thread nice changed");
+    CHECK_EXP (CPU_EQUAL (&thread->get_cpus (), &allowed), "default thread affinity changed");
+#ifdef __USE_GNU
+    CHECK_EXP (!strcmp (thread->get_thread_name (), "xc:plain"), "default thread named \"%s\"", thread->get_thread_name ());
+#endif
+
+    CHECK_EXP (manager->parse_policies ("worker"), "reset worker policy failed");
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s\n"
+            "\t--help              usage\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1) {
+        usage (argv[0]);
+        return strcmp (argv[1], "--help") ? -1 : 0;
+    }
+
+    CHECK_EXP (test_parse_policies () == 0, "thread policy parsing failed");
+    CHECK_EXP (test_set_policy () == 0, "thread policy setting failed");
+    CHECK_EXP (test_apply_policy () == 0, "thread policy applying failed");
+
+    printf ("thread policy tests passed\n");
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * test-typed-slots.cpp - test lookup order of typed slots
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include <typed_slots.h>
+#include <meta_data.h>
+#include <video_buffer.h>
+
+using namespace XCam;
+
+struct TestPose
+    : DevicePose
+{
+    int id;
+    explicit TestPose (int i) : id (i) {}
+};
+
+struct TestSubPose
+    : TestPose
+{
+    explicit TestSubPose (int i) : TestPose (i) {}
+};
+
+struct TestOther
+    : MetaData
+{
+};
+
+// declared chain up to MetaBase, matched by key
+struct TestDeclPose
+    : DevicePose
+{
+    XCAM_SLOT_TYPE (TestDeclPose, DevicePose);
+
+    int id;
+    explicit TestDeclPose (int i) : id (i) {}
+};
+
+struct TestDeclSubPose
+    : TestDeclPose
+{
+    XCAM_SLOT_TYPE (TestDeclSubPose, TestDeclPose);
+
+    explicit TestDeclSubPose (int i) : TestDeclPose (i) {}
+};
+
+// inherits the declaration of its parent, so counts as undeclared
+struct TestUndeclSubPose
+    : TestDeclPose
+{
+    explicit TestUndeclSubPose (int i) : TestDeclPose (i) {}
+};
+
+// metadata holder only, never mapped
+class TestBuffer
+    : public VideoBuffer
+{
+public:
+    explicit TestBuffer (const VideoBufferInfo &info)
+        : VideoBuffer (info)
+    {}
+
+    virtual uint8_t *map () {
+        return NULL;
+    }
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+};
+
+// two inline slots, so some cases run on the spilled ones
+typedef TypedSlots<MetaData, 2> TestSlots;
+
+static int
+get_pose_id (const TestSlots &slots)
+{
+    SmartPtr<TestPose> pose = slots.find<TestPose> ();
+    return pose.ptr () ? pose->id : -1;
+}
+
+static int
+test_lookup_order ()
+{
+    TestSlots slots;
+    CHECK_EXP (!slots.find<TestPose> ().ptr (), "empty slots found a pose");
+
+    // keyed match and subclass match, whichever comes first wins
+    slots.add (SmartPtr<TestSubPose> (new TestSubPose (1)));
+    slots.add (SmartPtr<TestPose> (new TestPose (2)));
+    CHECK_EXP (get_pose_id (slots) == 1, "find<TestPose> got %d, expect the earlier subclass 1", get_pose_id (slots));
+
+    SmartPtr<TestSubPose> sub = slots.find<TestSubPose> ();
+    CHECK_EXP (sub.ptr () && sub->id == 1, "find<TestSubPose> missed the keyed object");
+
+    SmartPtr<DevicePose> base = slots.find<DevicePose> ();
+    CHECK_EXP (base.ptr () && base.dynamic_cast_ptr<TestPose> ()->id == 1, "find<DevicePose> didn't return the first pose");
+
+    SmartPtr<MetaData> first = slots.find<MetaData> ();
+    CHECK_EXP (first.ptr () == slots.at (0).ptr (), "find<MetaData> didn't return the first slot");
+
+    slots.clear ();
+    slots.add (SmartPtr<TestPose> (new TestPose (3)));
+    slots.add (SmartPtr<TestSubPose> (new TestSubPose (4)));
+    CHECK_EXP (get_pose_id (slots) == 3, "find<TestPose> got %d, expect the earlier keyed 3", get_pose_id (slots));
+
+    return 0;
+}
+
+static int
+test_spilled_slots ()
+{
+    TestSlots slots;
+    SmartPtr<TestOther> other = new TestOther;
+    SmartPtr<TestPose> spilled = new TestPose (5);
+
+    slots.add (other);
+    slots.add (SmartPtr<TestOther> (new TestOther));
+    slots.add (SmartPtr<TestOther> (new TestOther));
+    slots.add (spilled);
+    slots.add (SmartPtr<TestSubPose> (new TestSubPose (6)));
+    CHECK_EXP (slots.size () == 5, "slots size %d, expect 5", slots.size ());
+    CHECK_EXP (get_pose_id (slots) == 5, "find<TestPose> on spilled slots got %d, expect 5", get_pose_id (slots));
+
+    // removing moves later objects up and keeps their order
+    CHECK_EXP (slots.remove (other.ptr ()), "remove first object failed");
+    CHECK_EXP (slots.at (2).ptr () == spilled.ptr (), "remove didn't keep the order");
+    CHECK_EXP (slots.remove (spilled.ptr ()), "remove spilled object failed");
+    CHECK_EXP (get_pose_id (slots) == 6, "find<TestPose> after remove got %d, expect 6", get_pose_id (slots));
+    CHECK_EXP (!slots.remove (spilled.ptr ()), "removed an object twice");
+
+    TestSlots copy;
+    copy.add (SmartPtr<TestPose> (new TestPose (7)));
+    copy.append (slots);
+    CHECK_EXP (copy.size () == 4, "appended slots size %d, expect 4", copy.size ());
+    CHECK_EXP (get_pose_id (copy) == 7, "find<TestPose> after append got %d, expect 7", get_pose_id (copy));
+    SmartPtr<TestSubPose> sub = copy.find<TestSubPose> ();
+    CHECK_EXP (sub.ptr () && sub->id == 6, "appended slots lost the subclass key");
+
+    return 0;
+}
+
+static int
+test_buffer_metadata ()
+{
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_NV12, 64, 32);
+    SmartPtr<VideoBuffer> buf = new TestBuffer (info);
+
+    SmartPtr<DevicePose> pose = new DevicePose;
+    buf->add_metadata (SmartPtr<TestOther> (new TestOther));
+    buf->add_metadata (pose);
+    buf->add_metadata (SmartPtr<TestPose> (new TestPose (8)));
+    CHECK_EXP (buf->find_typed_metadata<DevicePose> ().ptr () == pose.ptr (), "buffer metadata lookup out of order");
+
+    CHECK_EXP (buf->remove_metadata (pose), "remove buffer metadata failed");
+    SmartPtr<DevicePose> found = buf->find_typed_metadata<DevicePose> ();
+    CHECK_EXP (found.ptr () && found.dynamic_cast_ptr<TestPose> ().ptr (), "buffer metadata lookup missed the subclass");
+
+    return 0;
+}
+
+static int
+get_decl_pose_id (const TypedSlots<MetaBase, 2> &slots)
+{
+    SmartPtr<TestDeclPose> pose = slots.find<TestDeclPose> ();
+    return pose.ptr () ? pose->id : -1;
+}
+
+static int
+test_declared_types ()
+{
+    const SlotTypeInfo *info = get_slot_type_info<MetaBase, TestDeclSubPose> ();
+    CHECK_EXP (
+        info->complete && info->count == 5 && info->keys[2] == get_type_key<DevicePose> () &&
+        info->keys[4] == get_type_key<MetaBase> (),
+        "declared chain of TestDeclSubPose wrong, count:%d", info->count);
+    info = get_slot_type_info<MetaBase, TestUndeclSubPose> ();
+    CHECK_EXP (!info->complete, "undeclared subclass got a complete chain");
+    info = get_slot_type_info<MetaBase, TestPose> ();
+    CHECK_EXP (!info->complete, "undeclared pose got a complete chain");
+    info = get_slot_type_info<MetaData, DevicePose> ();
+    CHECK_EXP (info->complete && info->count == 2, "chain didn't stop at the slots base");
+
+    // ancestor keys and dynamic_cast fallback keep the first match
+    TypedSlots<MetaBase, 2> slots;
+    slots.add (SmartPtr<TestUndeclSubPose> (new TestUndeclSubPose (1)));
+    slots.add (SmartPtr<TestDeclSubPose> (new TestDeclSubPose (2)));
+    CHECK_EXP (get_decl_pose_id (slots) == 1, "find<TestDeclPose> got %d, expect the undeclared 1", get_decl_pose_id (slots));
+
+    slots.clear ();
+    slots.add (SmartPtr<TestOther> (new TestOther));
+    slots.add (SmartPtr<TestDeclSubPose> (new TestDeclSubPose (3)));
+    slots.add (SmartPtr<TestDeclPose> (new TestDeclPose (4)));
+    CHECK_EXP (get_decl_pose_id (slots) == 3, "find<TestDeclPose> got %d, expect the subclass 3", get_decl_pose_id (slots));
+    CHECK_EXP (slots.find<MetaData> ().ptr () == slots.at (0).ptr (), "find<MetaData> didn't return the first slot");
+    CHECK_EXP (!slots.find<TestUndeclSubPose> ().ptr (), "find<TestUndeclSubPose> matched other objects");
+
+    // added as an ancestor, found by downcast
+    slots.clear ();
+    slots.add (SmartPtr<DevicePose> (new DevicePose));
+    slots.add (SmartPtr<DevicePose> (new TestDeclPose (5)));
+    CHECK_EXP (get_decl_pose_id (slots) == 5, "find<TestDeclPose> got %d, expect the one added as DevicePose", get_decl_pose_id (slots));
+    SmartPtr<TestDeclSubPose> sub = slots.find<TestDeclSubPose> ();
+    CHECK_EXP (!sub.ptr (), "find<TestDeclSubPose> matched its parent");
+
+    return 0;
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s\n"
+            "\t--help              usage\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1) {
+        usage (argv[0]);
+        return strcmp (argv[1], "--help") ? -1 : 0;
+    }
+
+    CHECK_EXP (test_lookup_order () == 0, "typed slots lookup order failed");
+    CHECK_EXP (test_spilled_slots () == 0, "typed slots spilled objects failed");
+    CHECK_EXP (test_buffer_metadata () == 0, "typed slots buffer metadata failed");
+    CHECK_EXP (test_declared_types () == 0, "typed slots declared types failed");
+
+    printf ("typed slots tests passed\n");
+    return 0;
+}
@@ -20,6 +20,9 @@
 
 #include "buffer_pool.h"
 
+// interval of get_buffer checking pools which reclaim buffers, in microseconds
+#define XCAM_POOL_RECLAIM_INTERVAL 1000
+
 namespace XCam {
 
 BufferProxy::BufferProxy (const VideoBufferInfo &info, const SmartPtr<BufferData> &data)
@@ -68,6 +71,14 @@ BufferPool::BufferPool ()
     : _allocated_num (0)
     , _max_count (0)
     , _started (false)
+    , _acquire_timeout (-1)
+    , _max_extra (0)
+    , _shrink_idle_us (0)
+    , _extra_num (0)
+    , _last_starved_us (0)
+    , _acquired_count (0)
+    , _grown_count (0)
+    , _shrunk_count (0)
 {
 }
 
@@ -128,6 +139,21 @@ BufferPool::reserve (uint32_t max_count)
     return true;
 }
 
+void
+BufferPool::set_acquire_timeout (int32_t timeout)
+{
+    // read on every get_buffer without taking _mutex
+    _acquire_timeout = timeout;
+}
+
+void
+BufferPool::set_growth (uint32_t max_extra, uint32_t shrink_idle_ms)
+{
+    SmartLock lock (_mutex);
+    _max_extra = max_extra;
+    _shrink_idle_us = (int64_t)shrink_idle_ms * 1000;
+}
+
 SmartPtr<VideoBuffer>
 BufferPool::create_buffer_from_external_data (const void* data)
 {
@@ -157,15 +183,38 @@ BufferPool::add_data_unsafe (const SmartPtr<BufferData> &data)
 
 SmartPtr<VideoBuffer>
 BufferPool::get_buffer (const SmartPtr<BufferPool> &self)
+{
+    SmartPtr<BufferPool> pool = self;
+    return acquire (std::move (pool), _acquire_timeout);
+}
+
+SmartPtr<VideoBuffer>
+BufferPool::get_buffer (SmartPtr<BufferPool> &&self)
+{
+    return acquire (std::move (self), _acquire_timeout);
+}
+
+SmartPtr<VideoBuffer>
+BufferPool::get_buffer (const SmartPtr<BufferPool> &self, int32_t timeout)
+{
+    SmartPtr<BufferPool> pool = self;
+    return acquire (std::move (pool), timeout);
+}
+
+SmartPtr<VideoBuffer>
+BufferPool::get_buffer ()
+{
+    return acquire (SmartPtr<BufferPool>(this), _acquire_timeout);
+}
+
+SmartPtr<VideoBuffer>
+BufferPool::acquire (SmartPtr<BufferPool> &&self, int32_t timeout)
 {
     SmartPtr<BufferProxy> ret_buf;
     SmartPtr<BufferData> data;
 
-    {
-        SmartLock lock (_mutex);
-        if (!_started)
-            return NULL;
-    }
+    if (!_started.load (std::memory_order_acquire))
+        return NULL;
 
     XCAM_ASSERT (self.ptr () == this);
     XCAM_FAIL_RETURN(
@@ -174,21 +223,86 @@ BufferPool::get_buffer (const SmartPtr<BufferPool> &self)
         NULL,
         "BufferPool get_buffer failed since parameter<self> not this");
 
-    data = _buf_list.pop ();
+    bool starved = _buf_list.is_empty ();
+    int64_t wait_start = 0;
+    if (starved) {
+        wait_start = LatencyStats::now_us ();
+        _last_starved_us.store (wait_start, std::memory_order_relaxed);
+        data = grow_data ();
+    }
+
+    if (!data.ptr ())
+        data = starved ? pop_data (timeout) : _buf_list.pop (timeout);
     if (!data.ptr ()) {
+        if (starved)
+            _starved_stats.record_error ();
         XCAM_LOG_DEBUG ("BufferPool failed to get buffer");
         return NULL;
     }
+    if (starved)
+        _starved_stats.record_since (wait_start);
+    _acquired_count.fetch_add (1, std::memory_order_relaxed);
     ret_buf = create_buffer_from_data (data);
-    ret_buf->set_buf_pool (self);
+    ret_buf->set_buf_pool (std::move (self));
 
     return ret_buf;
 }
 
-SmartPtr<VideoBuffer>
-BufferPool::get_buffer ()
+SmartPtr<BufferData>
+BufferPool::pop_data (int32_t timeout)
 {
-    return get_buffer (SmartPtr<BufferPool>(this));
+    if (!reclaim_buffers ())
+        return _buf_list.pop (timeout);
+
+    int64_t deadline = timeout >= 0 ? LatencyStats::now_us () + timeout : -1;
+    while (true) {
+        int32_t wait = XCAM_POOL_RECLAIM_INTERVAL;
+        if (deadline >= 0) {
+            int64_t remain = deadline - LatencyStats::now_us ();
+            wait = (int32_t) XCAM_CLAMP (remain, 0, XCAM_POOL_RECLAIM_INTERVAL);
+        }
+
+        SmartPtr<BufferData> data = _buf_list.pop (wait);
+        if (data.ptr () || !_started.load (std::memory_order_acquire))
+            return data;
+        if (!reclaim_buffers ())
+            return deadline >= 0 ? NULL : _buf_list.pop (-1);
+        if (deadline >= 0 && LatencyStats::now_us () >= deadline)
+            return _buf_list.pop (0);
+    }
+}
+
+SmartPtr<BufferData>
+BufferPool::grow_data ()
+{
+    SmartLock lock (_mutex);
+    if (!_started || !_max_extra || _extra_num >= _max_extra)
+        return NULL;
+
+    SmartPtr<BufferData> data = allocate_data (_buffer_info);
+    XCAM_FAIL_RETURN (
+        WARNING, data.ptr (), NULL,
+        "BufferPool grow failed with %d extra buffers", _extra_num.load ());
+
+    ++_allocated_num;
+    ++_extra_num;
+    _grown_count.fetch_add (1, std::memory_order_relaxed);
+    return data;
+}
+
+bool
+BufferPool::shrink_data ()
+{
+    int64_t idle = LatencyStats::now_us () - _last_starved_us.load (std::memory_order_relaxed);
+
+    SmartLock lock (_mutex);
+    if (!_extra_num || idle < _shrink_idle_us)
+        return false;
+
+    --_allocated_num;
+    --_extra_num;
+    _shrunk_count.fetch_add (1, std::memory_order_relaxed);
+    return true;
 }
 
 void
@@ -196,20 +310,45 @@ BufferPool::stop ()
 {
     {
         SmartLock lock (_mutex);
-        _started = false;
+        _started.store (false, std::memory_order_release);
     }
     _buf_list.pause_pop ();
 }
 
+void
+BufferPool::get_metrics (Metrics &metrics) const
+{
+    metrics.acquired = _acquired_count.load (std::memory_order_relaxed);
+    _starved_stats.get_histogram (metrics.starved_wait);
+    metrics.grown = _grown_count.load (std::memory_order_relaxed);
+    metrics.shrunk = _shrunk_count.load (std::memory_order_relaxed);
+}
+
+void
+BufferPool::reset_metrics ()
+{
+    _acquired_count.store (0, std::memory_order_relaxed);
+    _grown_count.store (0, std::memory_order_relaxed);
+    _shrunk_count.store (0, std::memory_order_relaxed);
+    _starved_stats.reset ();
+}
+
 void
 BufferPool::release (SmartPtr<BufferData> &data)
 {
-    {
-        SmartLock lock (_mutex);
-        if (!_started)
-            return;
-    }
-    _buf_list.push (data);
+    if (!_started.load (std::memory_order_acquire))
+        return;
+
+    if (_extra_num.load (std::memory_order_relaxed) && shrink_data ())
+        return;
+
+    _buf_list.push (std::move (data));
+}
+
+bool
+BufferPool::reclaim_buffers ()
+{
+    return false;
 }
 
 bool
@@ -225,7 +364,7 @@ BufferPool::create_buffer_from_data (SmartPtr<BufferData> &data)
     const VideoBufferInfo &info = get_video_info ();
 
     XCAM_ASSERT (data.ptr ());
-    return new BufferProxy (info, data);
+    return make_smart_ptr<BufferProxy> (info, data);
 }
 
 };
@@ -24,6 +24,7 @@
 #include <xcam_std.h>
 #include <safe_list.h>
 #include <video_buffer.h>
+#include <xcam_metrics.h>
 
 namespace XCam {
 
@@ -57,6 +58,9 @@ public:
     void set_buf_pool (const SmartPtr<BufferPool> &pool) {
         _pool = pool;
     }
+    void set_buf_pool (SmartPtr<BufferPool> &&pool) {
+        _pool = std::move (pool);
+    }
 
     // derived from VideoBuffer
     virtual uint8_t *map ();
@@ -84,6 +88,24 @@ class BufferPool
 {
     friend class BufferProxy;
 
+public:
+    struct Metrics {
+        uint64_t          acquired;
+        // get_buffer calls which found no free buffer, errors are the ones that got none
+        LatencyHistogram  starved_wait;
+        // buffers allocated beyond reserve under burst load, and freed again when idle
+        uint64_t          grown;
+        uint64_t          shrunk;
+
+        Metrics () : acquired (0), grown (0), shrunk (0) {}
+        void merge (const Metrics &other) {
+            acquired += other.acquired;
+            starved_wait.merge (other.starved_wait);
+            grown += other.grown;
+            shrunk += other.shrunk;
+        }
+    };
+
 public:
     explicit BufferPool ();
     virtual ~BufferPool ();
@@ -91,9 +113,23 @@ public:
     bool set_video_info (const VideoBufferInfo &info);
     bool reserve (uint32_t max_count = 4);
 
+    /*
+     * timeout of get_buffer when no buffer is free,
+     * -1, wait until a buffer is released or the pool stops
+     * >=0, wait for @timeout microseconds, then get_buffer returns NULL
+     */
+    void set_acquire_timeout (int32_t timeout);
+    /*
+     * allocate up to @max_extra buffers beyond reserve instead of waiting,
+     * extra buffers are freed on release once no get_buffer starved for @shrink_idle_ms
+     */
+    void set_growth (uint32_t max_extra, uint32_t shrink_idle_ms = 1000);
+
     SmartPtr<VideoBuffer> create_buffer_from_external_data (const void* data);
 
     SmartPtr<VideoBuffer> get_buffer (const SmartPtr<BufferPool> &self);
+    SmartPtr<VideoBuffer> get_buffer (SmartPtr<BufferPool> &&self);
+    SmartPtr<VideoBuffer> get_buffer (const SmartPtr<BufferPool> &self, int32_t timeout);
     SmartPtr<VideoBuffer> get_buffer ();
 
     void stop ();
@@ -110,16 +146,30 @@ public:
         return _buf_list.size ();
     }
 
+    void get_metrics (Metrics &metrics) const;
+    void reset_metrics ();
+
 protected:
     virtual bool fixate_video_info (VideoBufferInfo &info);
     virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &buffer_info, const void* in_data = NULL) = 0;
     virtual SmartPtr<BufferProxy> create_buffer_from_data (SmartPtr<BufferData> &data);
+    /*
+     * called while get_buffer finds no free buffer, a pool keeping buffers which come
+     * free without a release returns true, get_buffer then calls it again while waiting
+     */
+    virtual bool reclaim_buffers ();
 
     bool add_data_unsafe (const SmartPtr<BufferData> &data);
 
     void update_video_info_unsafe (const VideoBufferInfo &info);
 
 private:
+    SmartPtr<VideoBuffer> acquire (SmartPtr<BufferPool> &&self, int32_t timeout);
+    SmartPtr<BufferData> pop_data (int32_t timeout);
+    SmartPtr<BufferData> grow_data ();
+    bool shrink_data ();
+
+    // moves @data back to the free list, leaves it to the caller when the pool shrinks
     void release (SmartPtr<BufferData> &data);
     XCAM_DEAD_COPY (BufferPool);
 
@@ -129,7 +179,18 @@ private:
     SafeList<BufferData>     _buf_list;
     uint32_t                 _allocated_num;
     uint32_t                 _max_count;
-    bool                     _started;
+    std::atomic<bool>        _started;
+
+    std::atomic<int32_t>     _acquire_timeout;
+    uint32_t                 _max_extra;
+    int64_t                  _shrink_idle_us;
+    std::atomic<uint32_t>    _extra_num;
+    std::atomic<int64_t>     _last_starved_us;
+
+    std::atomic<uint64_t>    _acquired_count;
+    std::atomic<uint64_t>    _grown_count;
+    std::atomic<uint64_t>    _shrunk_count;
+    LatencyStats             _starved_stats;
 };
 
 class VKDevice;
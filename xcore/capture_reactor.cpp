@@ -0,0 +1,500 @@
+/*
+ * capture_reactor.cpp - single-thread epoll reactor for multi-camera capture
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "capture_reactor.h"
+#include "v4l2_buffer_proxy.h"
+#include "xcam_thread.h"
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#define CAPTURE_REACTOR_MAX_EVENTS 16
+#define CAPTURE_REACTOR_DEFAULT_SKEW 5000      // us
+#define CAPTURE_REACTOR_DEFAULT_PENDING 4
+
+namespace XCam {
+
+struct CaptureSource {
+    uint32_t                 index;
+    int                      fd;
+    SmartPtr<V4l2Device>     dev;
+
+    char                    *raw_path;
+    FILE                    *raw;
+    SmartPtr<BufferPool>     pool;
+    int64_t                  frame_duration;
+    int64_t                  frame_count;
+
+    CaptureSource (uint32_t idx)
+        : index (idx)
+        , fd (-1)
+        , raw_path (NULL)
+        , raw (NULL)
+        , frame_duration (0)
+        , frame_count (0)
+    {}
+
+    ~CaptureSource () {
+        close_raw ();
+        if (raw_path)
+            xcam_free (raw_path);
+    }
+
+    bool is_raw () const {
+        return raw_path != NULL;
+    }
+
+    void close_raw () {
+        if (raw) {
+            fclose (raw);
+            raw = NULL;
+        }
+        if (is_raw () && fd >= 0) {
+            ::close (fd);
+            fd = -1;
+        }
+    }
+};
+
+struct CaptureFrameSet {
+    int64_t                              timestamp;
+    uint32_t                             ready_num;
+    std::vector<SmartPtr<VideoBuffer> >  bufs;
+
+    CaptureFrameSet (int64_t ts, uint32_t source_num)
+        : timestamp (ts)
+        , ready_num (0)
+        , bufs (source_num)
+    {}
+};
+
+class CaptureReactorThread
+    : public Thread
+{
+public:
+    explicit CaptureReactorThread (CaptureReactor *reactor)
+        : Thread ("capture_reactor", ThreadRoleCapture)
+        , _reactor (reactor)
+    {}
+
+protected:
+    virtual bool loop () {
+        return _reactor->reactor_loop ();
+    }
+
+private:
+    CaptureReactor   *_reactor;
+};
+
+static int64_t
+get_monotonic_time ()
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return XCAM_TIMESPEC_2_USEC (now);
+}
+
+const int CaptureReactor::default_epoll_timeout = 100; // ms
+
+CaptureReactor::CaptureReactor ()
+    : _epoll_fd (-1)
+    , _skew_tolerance (CAPTURE_REACTOR_DEFAULT_SKEW)
+    , _max_pending_sets (CAPTURE_REACTOR_DEFAULT_PENDING)
+    , _raw_base_time (0)
+    , _started (false)
+{
+    XCAM_LOG_DEBUG ("CaptureReactor constructed");
+}
+
+CaptureReactor::~CaptureReactor ()
+{
+    stop ();
+
+    XCAM_LOG_DEBUG ("~CaptureReactor destructed");
+}
+
+int
+CaptureReactor::add_capture_device (const SmartPtr<V4l2Device> &dev)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started, -1,
+        "CaptureReactor add capture device failed, reactor already started");
+    XCAM_FAIL_RETURN (
+        ERROR, dev.ptr () && dev->is_opened (), -1,
+        "CaptureReactor add capture device failed, device is not opened");
+
+    SmartPtr<CaptureSource> source = new CaptureSource (_sources.size ());
+    source->dev = dev;
+    _sources.push_back (source);
+
+    return source->index;
+}
+
+int
+CaptureReactor::add_raw_source (const char *raw_path, const SmartPtr<BufferPool> &pool, uint32_t fps)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started, -1,
+        "CaptureReactor add raw source failed, reactor already started");
+    XCAM_FAIL_RETURN (
+        ERROR, raw_path && pool.ptr () && fps, -1,
+        "CaptureReactor add raw source failed, invalid parameters");
+
+    SmartPtr<CaptureSource> source = new CaptureSource (_sources.size ());
+    source->raw_path = strndup (raw_path, XCAM_MAX_STR_SIZE);
+    source->pool = pool;
+    source->frame_duration = 1000000 / fps;
+    _sources.push_back (source);
+
+    return source->index;
+}
+
+bool
+CaptureReactor::set_callback (const SmartPtr<CaptureReactorCallback> &callback)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started, false,
+        "CaptureReactor set callback failed, reactor already started");
+
+    _callback = callback;
+    return true;
+}
+
+bool
+CaptureReactor::set_skew_tolerance (int64_t time_us)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started && time_us >= 0, false,
+        "CaptureReactor set skew tolerance(%" PRId64 ") failed", time_us);
+
+    _skew_tolerance = time_us;
+    return true;
+}
+
+bool
+CaptureReactor::set_max_pending_sets (uint32_t max_num)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started && max_num > 0, false,
+        "CaptureReactor set max pending sets(%d) failed", max_num);
+
+    _max_pending_sets = max_num;
+    return true;
+}
+
+XCamReturn
+CaptureReactor::start ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started, XCAM_RETURN_ERROR_ORDER,
+        "CaptureReactor already started");
+    XCAM_FAIL_RETURN (
+        ERROR, !_sources.empty () && _callback.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "CaptureReactor start failed, no source or callback");
+
+    _epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+    XCAM_FAIL_RETURN (
+        ERROR, _epoll_fd >= 0, XCAM_RETURN_ERROR_FILE,
+        "CaptureReactor create epoll failed, error:%s", strerror (errno));
+
+    // raw sources share one timeline so their frames pair up
+    _raw_base_time = get_monotonic_time ();
+
+    for (uint32_t i = 0; i < _sources.size (); ++i) {
+        SmartPtr<CaptureSource> &source = _sources[i];
+        struct epoll_event event;
+        xcam_mem_clear (event);
+        event.data.u32 = source->index;
+
+        if (source->is_raw ()) {
+            source->raw = fopen (source->raw_path, "rb");
+            if (!source->raw) {
+                XCAM_LOG_ERROR ("CaptureReactor open raw file:%s failed", source->raw_path);
+                close_sources ();
+                return XCAM_RETURN_ERROR_FILE;
+            }
+
+            source->fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            struct itimerspec period;
+            xcam_mem_clear (period);
+            period.it_interval.tv_sec = source->frame_duration / 1000000;
+            period.it_interval.tv_nsec = (source->frame_duration % 1000000) * 1000;
+            period.it_value = period.it_interval;
+            if (source->fd < 0 || timerfd_settime (source->fd, 0, &period, NULL) < 0) {
+                XCAM_LOG_ERROR ("CaptureReactor create timer for raw source(%d) failed", i);
+                close_sources ();
+                return XCAM_RETURN_ERROR_FILE;
+            }
+            source->frame_count = 0;
+            event.events = EPOLLIN;
+        } else {
+            // EPOLLPRI only flags V4L2 events, DQBUF would block on it; events are left to the device owner
+            source->fd = source->dev->get_fd ();
+            event.events = EPOLLIN;
+        }
+
+        if (epoll_ctl (_epoll_fd, EPOLL_CTL_ADD, source->fd, &event) < 0) {
+            XCAM_LOG_ERROR ("CaptureReactor add source(%d) to epoll failed, error:%s", i, strerror (errno));
+            close_sources ();
+            return XCAM_RETURN_ERROR_FILE;
+        }
+    }
+
+    _thread = new CaptureReactorThread (this);
+    if (!_thread->start ()) {
+        _thread.release ();
+        close_sources ();
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+    _started = true;
+
+    XCAM_LOG_INFO ("CaptureReactor started with %d sources", (uint32_t)_sources.size ());
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CaptureReactor::stop ()
+{
+    if (!_started)
+        return XCAM_RETURN_NO_ERROR;
+
+    _thread->stop ();
+    _thread.release ();
+
+    // buffers return to drivers and pools
+    _pending_sets.clear ();
+    close_sources ();
+    _started = false;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CaptureReactor::close_sources ()
+{
+    for (uint32_t i = 0; i < _sources.size (); ++i) {
+        SmartPtr<CaptureSource> &source = _sources[i];
+        if (source->is_raw ())
+            source->close_raw ();
+        else
+            source->fd = -1;
+    }
+
+    if (_epoll_fd >= 0) {
+        ::close (_epoll_fd);
+        _epoll_fd = -1;
+    }
+}
+
+bool
+CaptureReactor::reactor_loop ()
+{
+    struct epoll_event events[CAPTURE_REACTOR_MAX_EVENTS];
+
+    int num = epoll_wait (_epoll_fd, events, CAPTURE_REACTOR_MAX_EVENTS, default_epoll_timeout);
+    if (num < 0) {
+        if (errno == EINTR)
+            return true;
+        XCAM_LOG_WARNING ("CaptureReactor epoll failed but continue, error:%s", strerror (errno));
+        ::usleep (100000); // 100ms
+        return true;
+    }
+
+    /* timeout */
+    if (num == 0) {
+        XCAM_LOG_DEBUG ("CaptureReactor poll timeout and continue");
+        return true;
+    }
+
+    for (int i = 0; i < num; ++i) {
+        XCAM_ASSERT (events[i].data.u32 < _sources.size ());
+        CaptureSource &source = *_sources[events[i].data.u32].ptr ();
+
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+            XCAM_LOG_DEBUG ("CaptureReactor source(%d) polled error", source.index);
+            continue;
+        }
+        if (!(events[i].events & EPOLLIN))
+            continue;
+
+        XCamReturn ret = source.is_raw () ? capture_raw_buffer (source) : capture_device_buffer (source);
+        if (!xcam_ret_is_ok (ret)) {
+            XCAM_LOG_WARNING ("CaptureReactor capture source(%d) failed but continue", source.index);
+        }
+    }
+
+    return true;
+}
+
+XCamReturn
+CaptureReactor::capture_device_buffer (CaptureSource &source)
+{
+    SmartPtr<V4l2Buffer> buf;
+    XCamReturn ret = source.dev->dequeue_buffer (buf);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "CaptureReactor dequeue buffer failed on dev:%s", XCAM_STR (source.dev->get_device_name ()));
+    XCAM_ASSERT (buf.ptr ());
+
+    SmartPtr<VideoBuffer> video_buf = new V4l2BufferProxy (buf, source.dev);
+    push_buffer (source.index, video_buf);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CaptureReactor::capture_raw_buffer (CaptureSource &source)
+{
+    uint64_t expirations = 0;
+    if (read (source.fd, &expirations, sizeof (expirations)) != sizeof (expirations))
+        return XCAM_RETURN_BYPASS;
+
+    // frames missed while the reactor was busy are skipped, not bursted
+    int64_t timestamp = _raw_base_time + (source.frame_count + expirations) * source.frame_duration;
+    source.frame_count += expirations;
+
+    // never block the reactor on a raw pool, the frame is skipped instead
+    if (!source.pool->has_free_buffers ()) {
+        XCAM_LOG_DEBUG ("CaptureReactor raw source(%d) has no free buffer", source.index);
+        return XCAM_RETURN_BYPASS;
+    }
+
+    SmartPtr<VideoBuffer> buf = source.pool->get_buffer (source.pool);
+    XCAM_FAIL_RETURN (
+        WARNING, buf.ptr (), XCAM_RETURN_ERROR_MEM,
+        "CaptureReactor raw source(%d) get buffer failed", source.index);
+
+    XCamReturn ret = read_raw_buffer (source, buf);
+    if (ret == XCAM_RETURN_BYPASS)
+        ret = read_raw_buffer (source, buf);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "CaptureReactor read raw file:%s failed", source.raw_path);
+
+    buf->set_timestamp (timestamp);
+    push_buffer (source.index, buf);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CaptureReactor::read_raw_buffer (CaptureSource &source, SmartPtr<VideoBuffer> &buf)
+{
+    const VideoBufferInfo info = buf->get_video_info ();
+    VideoBufferPlanarInfo planar;
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    uint8_t *dst = buf->map ();
+    XCAM_FAIL_RETURN (
+        WARNING, dst, XCAM_RETURN_ERROR_MEM,
+        "CaptureReactor map raw buffer failed");
+
+    for (uint32_t index = 0; index < info.components; index++) {
+        info.get_planar_info (planar, index);
+        uint32_t line_bytes = planar.width * planar.pixel_bytes;
+
+        for (uint32_t i = 0; i < planar.height; i++) {
+            if (fread (dst + info.offsets [index] + i * info.strides [index], 1, line_bytes, source.raw) < line_bytes) {
+                if (feof (source.raw)) {
+                    fseek (source.raw, 0, SEEK_SET);
+                    ret = XCAM_RETURN_BYPASS;
+                } else {
+                    ret = XCAM_RETURN_ERROR_FILE;
+                }
+                goto done;
+            }
+        }
+    }
+
+done:
+    buf->unmap ();
+    return ret;
+}
+
+void
+CaptureReactor::push_buffer (uint32_t index, const SmartPtr<VideoBuffer> &buf)
+{
+    const uint32_t source_num = _sources.size ();
+    const int64_t timestamp = buf->get_timestamp ();
+
+    std::list<SmartPtr<CaptureFrameSet> >::iterator pos = _pending_sets.end ();
+    for (std::list<SmartPtr<CaptureFrameSet> >::iterator i = _pending_sets.begin ();
+            i != _pending_sets.end (); ++i) {
+        int64_t diff = (*i)->timestamp - timestamp;
+        if (diff <= _skew_tolerance && diff >= -_skew_tolerance && !(*i)->bufs[index].ptr ()) {
+            pos = i;
+            break;
+        }
+    }
+
+    if (pos == _pending_sets.end ()) {
+        SmartPtr<CaptureFrameSet> set = new CaptureFrameSet (timestamp, source_num);
+        pos = _pending_sets.insert (_pending_sets.end (), set);
+    }
+
+    SmartPtr<CaptureFrameSet> set = *pos;
+    set->bufs[index] = buf;
+    set->ready_num++;
+
+    if (set->ready_num == source_num) {
+        _pending_sets.erase (pos);
+
+        // every source has moved past older sets, they can never complete
+        for (std::list<SmartPtr<CaptureFrameSet> >::iterator i = _pending_sets.begin ();
+                i != _pending_sets.end (); ) {
+            if ((*i)->timestamp < set->timestamp) {
+                drop_set (*i);
+                i = _pending_sets.erase (i);
+            } else {
+                ++i;
+            }
+        }
+
+        VideoBufferList bufs;
+        for (uint32_t i = 0; i < source_num; ++i)
+            bufs.push_back (set->bufs[i]);
+
+        XCamReturn ret = _callback->frame_set_ready (this, bufs);
+        if (!xcam_ret_is_ok (ret)) {
+            XCAM_LOG_WARNING ("CaptureReactor frame set(ts:%" PRId64 ") callback failed", set->timestamp);
+        }
+        return;
+    }
+
+    while (_pending_sets.size () > _max_pending_sets) {
+        drop_set (_pending_sets.front ());
+        _pending_sets.pop_front ();
+    }
+}
+
+void
+CaptureReactor::drop_set (const SmartPtr<CaptureFrameSet> &set)
+{
+    XCAM_LOG_DEBUG (
+        "CaptureReactor drop frame set(ts:%" PRId64 ") with %d of %d frames",
+        set->timestamp, set->ready_num, (uint32_t)_sources.size ());
+
+    _callback->frame_set_dropped (this, set->timestamp, set->ready_num);
+}
+
+};
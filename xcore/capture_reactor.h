@@ -0,0 +1,118 @@
+/*
+ * capture_reactor.h - single-thread epoll reactor for multi-camera capture
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_CAPTURE_REACTOR_H
+#define XCAM_CAPTURE_REACTOR_H
+
+#include <xcam_std.h>
+#include <buffer_pool.h>
+#include <v4l2_device.h>
+#include <vector>
+
+namespace XCam {
+
+class CaptureReactor;
+class CaptureReactorThread;
+
+class CaptureReactorCallback
+{
+public:
+    CaptureReactorCallback () {}
+    virtual ~CaptureReactorCallback () {}
+
+    // bufs are ordered by source index, one buffer per source
+    virtual XCamReturn frame_set_ready (CaptureReactor *reactor, const VideoBufferList &bufs) = 0;
+
+    // incomplete set given up, ready_num is the number of sources which delivered
+    virtual void frame_set_dropped (CaptureReactor *reactor, int64_t timestamp, uint32_t ready_num) {
+        XCAM_UNUSED (reactor);
+        XCAM_UNUSED (timestamp);
+        XCAM_UNUSED (ready_num);
+    }
+
+private:
+    XCAM_DEAD_COPY (CaptureReactorCallback);
+};
+
+struct CaptureFrameSet;
+struct CaptureSource;
+
+/*
+ * Polls all capture devices of a camera rig in one thread with epoll and
+ * groups buffers whose timestamps are within the skew tolerance into one
+ * frame set, replacing a PollThread pair per camera.
+ * Raw file sources are paced by timerfd and stamped on a common timeline,
+ * they stand in for cameras when testing.
+ */
+class CaptureReactor
+{
+    friend class CaptureReactorThread;
+
+public:
+    explicit CaptureReactor ();
+    virtual ~CaptureReactor ();
+
+    // device must be started by caller, returns source index or -1
+    int add_capture_device (const SmartPtr<V4l2Device> &dev);
+    // frames are read into buffers of pool, pool video info describes the raw layout
+    int add_raw_source (const char *raw_path, const SmartPtr<BufferPool> &pool, uint32_t fps);
+
+    bool set_callback (const SmartPtr<CaptureReactorCallback> &callback);
+    bool set_skew_tolerance (int64_t time_us);
+    // pending sets beyond max_num are dropped from the oldest
+    bool set_max_pending_sets (uint32_t max_num);
+
+    uint32_t get_source_num () const {
+        return _sources.size ();
+    }
+
+    XCamReturn start ();
+    XCamReturn stop ();
+
+private:
+    bool reactor_loop ();
+    XCamReturn capture_device_buffer (CaptureSource &source);
+    XCamReturn capture_raw_buffer (CaptureSource &source);
+    XCamReturn read_raw_buffer (CaptureSource &source, SmartPtr<VideoBuffer> &buf);
+
+    void push_buffer (uint32_t index, const SmartPtr<VideoBuffer> &buf);
+    void drop_set (const SmartPtr<CaptureFrameSet> &set);
+    void close_sources ();
+
+    XCAM_DEAD_COPY (CaptureReactor);
+
+private:
+    static const int                        default_epoll_timeout;
+
+    int                                     _epoll_fd;
+    std::vector<SmartPtr<CaptureSource> >   _sources;
+    SmartPtr<CaptureReactorCallback>        _callback;
+    SmartPtr<CaptureReactorThread>          _thread;
+
+    int64_t                                 _skew_tolerance;
+    uint32_t                                _max_pending_sets;
+    std::list<SmartPtr<CaptureFrameSet> >   _pending_sets;
+    int64_t                                 _raw_base_time;
+    bool                                    _started;
+};
+
+};
+
+#endif //XCAM_CAPTURE_REACTOR_H
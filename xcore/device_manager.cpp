@@ -38,7 +38,7 @@ class MessageThread
 {
 public:
     explicit MessageThread (DeviceManager *dev_manager)
-        : Thread ("MessageThread")
+        : Thread ("MessageThread", ThreadRoleEvent)
         , _manager (dev_manager)
     {}
 
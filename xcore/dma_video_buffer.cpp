@@ -19,6 +19,8 @@
  */
 
 #include "dma_video_buffer.h"
+#include "xcam_mutex.h"
+#include <sys/mman.h>
 
 namespace XCam {
 
@@ -35,6 +37,8 @@ protected:
 
 private:
     XCamVideoBuffer *_ext_buf;
+    uint8_t         *_mapped;
+    Mutex            _map_mutex;
 };
 
 DmaVideoBuffer::DmaVideoBuffer (const VideoBufferInfo &info, int dma_fd, bool need_close_fd)
@@ -74,6 +78,7 @@ DmaVideoBuffer::get_fd ()
 DmaVideoBufferPriv::DmaVideoBufferPriv (const VideoBufferInfo &info, XCamVideoBuffer *buf)
     : DmaVideoBuffer (info, buf->get_fd ? xcam_video_buffer_get_fd (buf) : 0, false)
     , _ext_buf (buf)
+    , _mapped (NULL)
 {
     if (buf->ref)
         xcam_video_buffer_ref (buf);
@@ -81,6 +86,8 @@ DmaVideoBufferPriv::DmaVideoBufferPriv (const VideoBufferInfo &info, XCamVideoBu
 
 DmaVideoBufferPriv::~DmaVideoBufferPriv ()
 {
+    if (_mapped)
+        munmap (_mapped, get_video_info ().size);
     if (_ext_buf && _ext_buf->unref && _ext_buf->ref)
         xcam_video_buffer_unref (_ext_buf);
 }
@@ -88,16 +95,35 @@ DmaVideoBufferPriv::~DmaVideoBufferPriv ()
 uint8_t *
 DmaVideoBufferPriv::map ()
 {
-    uint8_t *mem = _ext_buf->map (_ext_buf);
-    XCAM_FAIL_RETURN (ERROR, mem, NULL, "DmaVideoBufferPriv::map failed");
+    if (_ext_buf->map) {
+        uint8_t *mem = _ext_buf->map (_ext_buf);
+        XCAM_FAIL_RETURN (ERROR, mem, NULL, "DmaVideoBufferPriv::map failed");
+        return mem;
+    }
+
+    // buffer only carries a dmabuf fd, map it directly
+    SmartLock locker (_map_mutex);
+    if (!_mapped) {
+        int fd = get_fd ();
+        XCAM_FAIL_RETURN (ERROR, fd > 0, NULL, "DmaVideoBufferPriv::map failed, invalid fd");
+
+        void *mem = mmap (NULL, get_video_info ().size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        XCAM_FAIL_RETURN (
+            ERROR, mem != MAP_FAILED, NULL,
+            "DmaVideoBufferPriv::map fd(%d) failed, %s", fd, strerror (errno));
+        _mapped = (uint8_t *)mem;
+    }
 
-    return mem;
+    return _mapped;
 }
 
 bool
 DmaVideoBufferPriv::unmap ()
 {
-    _ext_buf->unmap (_ext_buf);
+    // fd mapping is shared by all users and released with the buffer
+    if (_ext_buf->map && _ext_buf->unmap)
+        _ext_buf->unmap (_ext_buf);
+
     return true;
 }
 
@@ -111,6 +137,9 @@ append_to_dmabuf (XCamVideoBuffer *buf)
             ERROR, xcam_video_buffer_get_fd (buf) > 0, NULL,
             "append_to_dmabuf failed, can't get buf file-handle");
     }
+    XCAM_FAIL_RETURN (
+        ERROR, buf->map || buf->get_fd, NULL,
+        "append_to_dmabuf failed, buf has neither map nor file-handle");
 
     VideoBufferInfo info;
     info.fill (buf->info);
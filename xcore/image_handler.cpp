@@ -68,6 +68,38 @@ ImageHandler::need_allocator ()
     return _enable_allocator;
 }
 
+bool
+ImageHandler::set_out_pool (const SmartPtr<BufferPool> &pool)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, pool.ptr (), false,
+        "ImageHandler(%s) set out pool(is NULL)", XCAM_STR(get_name ()));
+    XCAM_FAIL_RETURN (
+        ERROR, _need_configure, false,
+        "ImageHandler(%s) set out pool failed, handler already configured", XCAM_STR(get_name ()));
+
+    _out_pool = pool;
+    return true;
+}
+
+void
+ImageHandler::get_metrics (Metrics &metrics) const
+{
+    _latency_stats.get_histogram (metrics.latency);
+    if (_allocator.ptr ())
+        _allocator->get_metrics (metrics.out_pool);
+    else
+        metrics.out_pool = BufferPool::Metrics ();
+}
+
+void
+ImageHandler::reset_metrics ()
+{
+    _latency_stats.reset ();
+    if (_allocator.ptr ())
+        _allocator->reset_metrics ();
+}
+
 bool
 ImageHandler::set_allocator (const SmartPtr<BufferPool> &allocator)
 {
@@ -87,7 +119,7 @@ ImageHandler::configure_rest ()
             "image_hander(%s) configure reset failed before reserver buffer since out_video_info was not set",
             XCAM_STR (get_name ()));
 
-        SmartPtr<BufferPool> allocator = create_allocator ();
+        SmartPtr<BufferPool> allocator = _out_pool.ptr () ? _out_pool : create_allocator ();
         XCAM_FAIL_RETURN (
             ERROR, allocator.ptr (), XCAM_RETURN_ERROR_PARAM,
             "image_hander(%s) configure reset failed since allocator not created", XCAM_STR (get_name ()));
@@ -111,6 +143,7 @@ ImageHandler::execute_buffer (const SmartPtr<ImageHandler::Parameters> &param, b
         ERROR, param.ptr (), XCAM_RETURN_ERROR_PARAM,
         "image_handler(%s) execute buffer failed, params is null",
         XCAM_STR (get_name ()));
+    param->start_time = LatencyStats::now_us ();
 
     if (_need_configure) {
         ret = configure_resource (param);
@@ -134,6 +167,8 @@ ImageHandler::execute_buffer (const SmartPtr<ImageHandler::Parameters> &param, b
     }
 
     ret = start_work (param);
+    if (!xcam_ret_is_ok (ret))
+        record_latency (param, ret);
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (ret), ret,
         "image_handler(%s) execute buffer failed in starting workers", XCAM_STR (get_name ()));
@@ -147,6 +182,7 @@ ImageHandler::execute_done (const SmartPtr<ImageHandler::Parameters> &param, XCa
     XCAM_ASSERT (param.ptr ());
 
     if (err < XCAM_RETURN_NO_ERROR) {
+        record_latency (param, err);
         XCAM_LOG_WARNING (
             "image_handler(%s) broken with errno %d", XCAM_STR (get_name ()), (int)err);
         return ;
@@ -178,10 +214,20 @@ ImageHandler::terminate ()
 void
 ImageHandler::execute_status_check (const SmartPtr<ImageHandler::Parameters> &params, const XCamReturn error)
 {
+    record_latency (params, error);
     if (_callback.ptr ())
         _callback->execute_status (this, params, error);
 }
 
+void
+ImageHandler::record_latency (const SmartPtr<ImageHandler::Parameters> &params, const XCamReturn error)
+{
+    if (!xcam_ret_is_ok (error))
+        _latency_stats.record_error ();
+    else if (params.ptr () && params->start_time)
+        _latency_stats.record_since (params->start_time);
+}
+
 XCamReturn
 ImageHandler::reserve_buffers (const VideoBufferInfo &info, uint32_t count)
 {
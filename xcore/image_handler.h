@@ -50,16 +50,19 @@ public:
     struct Parameters {
         SmartPtr<VideoBuffer> in_buf;
         SmartPtr<VideoBuffer> out_buf;
+        // monotonic time in us when execute_buffer was called
+        int64_t               start_time;
 
         Parameters (const SmartPtr<VideoBuffer> &in = NULL, const SmartPtr<VideoBuffer> &out = NULL)
-            : in_buf (in), out_buf (out)
+            : in_buf (in), out_buf (out), start_time (0)
         {}
         virtual ~Parameters() {}
-        bool add_meta (const SmartPtr<MetaBase> &meta);
+        // find_meta<MType> matches by key when MType and @meta declare XCAM_SLOT_TYPE
+        template <typename MType> bool add_meta (const SmartPtr<MType> &meta);
         template <typename MType> SmartPtr<MType> find_meta ();
 
     private:
-        MetaBaseList       _metas;
+        TypedSlots<MetaBase, XCAM_BUFFER_INLINE_SLOTS> _metas;
     };
 
     class Callback {
@@ -73,6 +76,12 @@ public:
         XCAM_DEAD_COPY (Callback);
     };
 
+    struct Metrics {
+        // execute_buffer to completion, failed executions in latency.errors
+        LatencyHistogram     latency;
+        BufferPool::Metrics  out_pool;
+    };
+
 public:
     explicit ImageHandler (const char* name);
     virtual ~ImageHandler ();
@@ -90,6 +99,14 @@ public:
     bool set_out_video_info (const VideoBufferInfo &info);
     bool enable_allocator (bool enable, uint32_t buf_count = XCAM_DEFAULT_HANDLER_BUF_CAP);
     bool need_allocator ();
+    /*
+     * outputs come from @pool instead of the handler's own allocator, e.g. a ShmFrameRing,
+     * reserved with the enable_allocator buf_count on configure
+     */
+    bool set_out_pool (const SmartPtr<BufferPool> &pool);
+
+    void get_metrics (Metrics &metrics) const;
+    void reset_metrics ();
 
     // virtual functions
     // execute_buffer params should  NOT be const
@@ -105,6 +122,7 @@ protected:
     virtual XCamReturn start_work (const SmartPtr<Parameters> &param) = 0;
 
     virtual void execute_status_check (const SmartPtr<Parameters> &params, const XCamReturn error);
+    void record_latency (const SmartPtr<Parameters> &params, const XCamReturn error);
 
     bool set_allocator (const SmartPtr<BufferPool> &allocator);
     const SmartPtr<BufferPool> &get_allocator () const {
@@ -128,17 +146,20 @@ private:
     SmartPtr<Callback>      _callback;
     VideoBufferInfo         _out_video_info;
     SmartPtr<BufferPool>    _allocator;
+    SmartPtr<BufferPool>    _out_pool;
     uint32_t                _buf_capacity;
     char                   *_name;
+    LatencyStats            _latency_stats;
 };
 
-inline bool
-ImageHandler::Parameters::add_meta (const SmartPtr<MetaBase> &meta)
+template <typename MType>
+bool
+ImageHandler::Parameters::add_meta (const SmartPtr<MType> &meta)
 {
     if (!meta.ptr ())
         return false;
 
-    _metas.push_back (meta);
+    _metas.add (meta);
     return true;
 }
 
@@ -146,12 +167,7 @@ template <typename MType>
 SmartPtr<MType>
 ImageHandler::Parameters::find_meta ()
 {
-    for (MetaBaseList::iterator i = _metas.begin (); i != _metas.end (); ++i) {
-        SmartPtr<MType> m = (*i).dynamic_cast_ptr<MType> ();
-        if (m.ptr ())
-            return m;
-    }
-    return NULL;
+    return _metas.template find<MType> ();
 }
 
 };
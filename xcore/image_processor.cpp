@@ -70,7 +70,7 @@ class ImageProcessorThread
 {
 public:
     ImageProcessorThread (ImageProcessor *processor)
-        : Thread ("image_processor")
+        : Thread (processor->get_name (), ThreadRoleProcess)
         , _processor (processor)
     {}
     ~ImageProcessorThread () {}
@@ -95,7 +95,7 @@ class X3aResultsProcessThread
     typedef SafeList<X3aResult> ResultQueue;
 public:
     X3aResultsProcessThread (ImageProcessor *processor)
-        : Thread ("x3a_results_process_thread")
+        : Thread ("x3a_results_process_thread", ThreadRoleProcess)
         , _processor (processor)
     {}
     ~X3aResultsProcessThread () {}
@@ -34,8 +34,8 @@ struct CalibrationParams {
     double offset_x;  //Principal point x coordinate on the image, in pixels
     double offset_y;  //Principal point y coordinate on the image, in pixels
     double skew; //in case if the image coordinate axes u and v are not orthogonal to each other
-    double readout_time;
-    double gyro_delay;
+    double readout_time; //Rolling shutter readout of a whole frame, in microseconds
+    double gyro_delay; //Gyro timestamp offset to frame timestamp, in microseconds
     Vec4d gyro_drift;
 
     CalibrationParams ()
@@ -163,6 +163,37 @@ private:
     CalibrationParams _calib_params;
 };
 
+class MotionFilter
+{
+public:
+    MotionFilter (uint32_t radius = 15, float stdev = 10);
+    virtual ~MotionFilter ();
+
+    void set_filters (uint32_t radius, float stdev);
+
+    uint32_t radius () const {
+        return _radius;
+    };
+    float stdev () const {
+        return _stdev;
+    };
+
+    Mat3d stabilize (int32_t index,
+                     std::list<Mat3d> &motions,
+                     int32_t max);
+
+protected:
+    Mat3d cumulate_motion (uint32_t index, uint32_t from, std::list<Mat3d> &motions);
+
+private:
+    XCAM_DEAD_COPY (MotionFilter);
+
+private:
+    int32_t            _radius;
+    float              _stdev;
+    std::vector<float> _weight;
+};
+
 }
 
 #endif //XCAM_IMAGE_PROJECTIVE_2D_H
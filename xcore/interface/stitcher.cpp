@@ -24,6 +24,7 @@
 #include "stitcher.h"
 #include "xcam_utils.h"
 #include "calibration_parser.h"
+#include "fisheye_dewarp.h"
 #include <string>
 
 // angle to position, output range [-180, 180]
@@ -38,6 +39,8 @@
 
 #define FISHEYE_CONFIG_ENV_VAR "FISHEYE_CONFIG_PATH"
 
+#define COMPOSE_FISHEYE_MAP_FACTOR 16
+
 namespace XCam {
 
 // 合并相邻 CopyArea 的辅助函数：当两个区域来自同一路输入并且在输入/输出上连续时，将其拼接为更大的块。
@@ -87,6 +90,40 @@ split_area_by_out (
     return false;
 }
 
+// geometry of a calibration update, estimated off the frame path
+class StitchCalibrationStage
+    : public Stitcher
+{
+public:
+    StitchCalibrationStage (uint32_t align_x, uint32_t align_y)
+        : Stitcher (align_x, align_y)
+    {}
+
+    virtual XCamReturn stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf) {
+        XCAM_UNUSED (in_bufs);
+        XCAM_UNUSED (out_buf);
+        return XCAM_RETURN_ERROR_PARAM;
+    }
+};
+
+class StitchCalibrationThread
+    : public Thread
+{
+public:
+    explicit StitchCalibrationThread (Stitcher *stitcher)
+        : Thread ("stitch-calib", ThreadRoleBackground)
+        , _stitcher (stitcher)
+    {}
+
+protected:
+    virtual bool loop () {
+        return _stitcher->build_pending_calibration ();
+    }
+
+private:
+    Stitcher *_stitcher;
+};
+
 // 构造函数：指定输出图在 X/Y 方向上的对齐要求，初始化 Stitcher 的内部状态。
 Stitcher::Stitcher (uint32_t align_x, uint32_t align_y)
     : _alignment_x (align_x)
@@ -108,6 +145,14 @@ Stitcher::Stitcher (uint32_t align_x, uint32_t align_y)
     , _complete_stitch (true)
     , _need_fm (false)
     , _blend_pyr_levels (2)
+    , _is_calib_set (false)
+    , _is_calib_live (false)
+    , _has_pending_calib (false)
+    , _calib_building (false)
+    , _calib_running (false)
+    , _calib_ready (false)
+    , _is_viewport_set (false)
+    , _reduced_levels (0)
 {
     XCAM_ASSERT (align_x >= 1);
     XCAM_ASSERT (align_y >= 1);
@@ -120,17 +165,67 @@ Stitcher::Stitcher (uint32_t align_x, uint32_t align_y)
 // 析构函数：释放 set_intrinsic_names/set_extrinsic_names 分配的字符串。
 Stitcher::~Stitcher ()
 {
+    stop_calibration ();
+
     for (int idx = 0; idx < XCAM_STITCH_MAX_CAMERAS; ++idx) {
         xcam_free (_intr_names[idx]);
         xcam_free (_extr_names[idx]);
     }
 }
 
+void
+Stitcher::get_stitch_metrics (Metrics &metrics)
+{
+    metrics = Metrics ();
+    for (uint32_t i = 0; i < StageCount; ++i)
+        _stage_stats[i].get_histogram (metrics.stages[i]);
+}
+
+void
+Stitcher::reset_stitch_metrics ()
+{
+    for (uint32_t i = 0; i < StageCount; ++i)
+        _stage_stats[i].reset ();
+}
+
+const char *
+Stitcher::get_stage_name (Stage stage)
+{
+    switch (stage) {
+    case StageGeoMap:
+        return "geomap";
+    case StageFeatureMatch:
+        return "feature-match";
+    case StageBlend:
+        return "blend";
+    case StageCopy:
+        return "copy";
+    case StageFrame:
+        return "frame";
+    default:
+        break;
+    }
+    return "unknown";
+}
+
+void
+Stitcher::record_stage (Stage stage, int64_t start_us, XCamReturn error)
+{
+    XCAM_ASSERT (stage < StageCount);
+    if (!xcam_ret_is_ok (error))
+        _stage_stats[stage].record_error ();
+    else if (start_us)
+        _stage_stats[stage].record_since (start_us);
+}
+
 // 设置碗面模型参数，供 Bowl 去畸变及顶视图生成使用。
 bool
 Stitcher::set_bowl_config (const BowlDataConfig &config)
 {
     _bowl_config = config;
+
+    SmartLock locker (_calib_mutex);
+    _calibration.bowl = config;
     return true;
 }
 
@@ -261,8 +356,10 @@ Stitcher::set_viewpoints_range (const float *range)
         ERROR, _camera_num, false,
         "stitcher: set viewpoints range failed, please set camera num(%d) first", _camera_num);
 
+    SmartLock locker (_calib_mutex);
     for(uint32_t i = 0; i < _camera_num; ++i) {
         _viewpoints_range[i] = range[i];
+        _calibration.viewpoints_range[i] = range[i];
     }
 
     return true;
@@ -303,55 +400,344 @@ Stitcher::set_extrinsic_names (const char *extr_names[])
  *  - Sphere 模式：直接使用 set_viewpoints_range 提供的角度，round_angle_start 依据相机序号均匀分布。
  *  - Bowl 模式：从 FISHEYE_CONFIG_PATH 指定目录读取 intrinsic/extrinsic 文本，填充 CameraInfo.calibration，
  *    并对外参做平移归一化，以方便碗面坐标系的统一处理。
+ * update_calibration 在首帧前提供的标定会替代配置文件。
  */
 XCamReturn
 Stitcher::init_camera_info ()
 {
-    if (_dewarp_mode == DewarpSphere) {
-        for (uint32_t i = 0; i < _camera_num; ++i) {
-            CameraInfo &info = _camera_info[i];
-            info.angle_range = _viewpoints_range[i];
-            info.round_angle_start = (i * 360.0f / _camera_num) - info.angle_range / 2.0f;
-        }
-    } else {
-        const char *env = std::getenv (FISHEYE_CONFIG_ENV_VAR);
-        std::string path (env, (env ? strlen (env) : 0));
+    SmartLock locker (_calib_mutex);
+    if (!_is_calib_set) {
+        XCamReturn ret = load_calibration (_calibration);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher load calibration failed");
+        _is_calib_set = true;
+    }
+
+    apply_calibration (_calibration);
+    _is_calib_live = true;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+Stitcher::load_calibration (Calibration &calib)
+{
+    calib.bowl = _bowl_config;
+    for (uint32_t i = 0; i < _camera_num; ++i) {
+        calib.viewpoints_range[i] = _viewpoints_range[i];
+        calib.cameras[i] = _camera_info[i].calibration;
+    }
+
+    if (_dewarp_mode == DewarpSphere)
+        return XCAM_RETURN_NO_ERROR;
+
+    const char *env = std::getenv (FISHEYE_CONFIG_ENV_VAR);
+    std::string path (env, (env ? strlen (env) : 0));
+    XCAM_FAIL_RETURN (
+        ERROR, !path.empty (), XCAM_RETURN_ERROR_PARAM,
+        "FISHEYE_CONFIG_PATH is empty, export FISHEYE_CONFIG_PATH first");
+    XCAM_LOG_INFO ("stitcher calibration config path: %s", path.c_str ());
+
+    CalibrationParser parser;
+    char pathname[XCAM_STITCH_NAME_LEN] = {'\0'};
+    for (uint32_t i = 0; i < _camera_num; ++i) {
+        snprintf (pathname, XCAM_STITCH_NAME_LEN, "%s/%s", path.c_str (), _intr_names[i]);
+        XCamReturn ret = parser.parse_intrinsic_file (pathname, calib.cameras[i].intrinsic);
         XCAM_FAIL_RETURN (
-            ERROR, !path.empty (), XCAM_RETURN_ERROR_PARAM,
-            "FISHEYE_CONFIG_PATH is empty, export FISHEYE_CONFIG_PATH first");
-        XCAM_LOG_INFO ("stitcher calibration config path: %s", path.c_str ());
+            ERROR, ret == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_PARAM,
+            "stitcher parse intrinsic params(%s) failed", pathname);
 
-        CalibrationParser parser;
-        char pathname[XCAM_STITCH_NAME_LEN] = {'\0'};
-        for (uint32_t i = 0; i < _camera_num; ++i) {
-            CameraInfo &info = _camera_info[i];
+        snprintf (pathname, XCAM_STITCH_NAME_LEN, "%s/%s", path.c_str (), _extr_names[i]);
+        ret = parser.parse_extrinsic_file (pathname, calib.cameras[i].extrinsic);
+        XCAM_FAIL_RETURN (
+            ERROR, ret == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_PARAM,
+            "stitcher parse extrinsic params(%s) failed", pathname);
+    }
 
-            snprintf (pathname, XCAM_STITCH_NAME_LEN, "%s/%s", path.c_str (), _intr_names[i]);
-            XCamReturn ret = parser.parse_intrinsic_file (pathname, info.calibration.intrinsic);
-            XCAM_FAIL_RETURN (
-                ERROR, ret == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_PARAM,
-                "stitcher parse intrinsic params(%s) failed", pathname);
+    return XCAM_RETURN_NO_ERROR;
+}
 
-            snprintf (pathname, XCAM_STITCH_NAME_LEN, "%s/%s", path.c_str (), _extr_names[i]);
-            ret = parser.parse_extrinsic_file (pathname, info.calibration.extrinsic);
-            XCAM_FAIL_RETURN (
-                ERROR, ret == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_PARAM,
-                "stitcher parse extrinsic params(%s) failed", pathname);
+void
+Stitcher::apply_calibration (const Calibration &calib)
+{
+    _bowl_config = calib.bowl;
+    for (uint32_t i = 0; i < _camera_num; ++i) {
+        _viewpoints_range[i] = calib.viewpoints_range[i];
 
+        CameraInfo &info = _camera_info[i];
+        info.angle_range = _viewpoints_range[i];
+        info.round_angle_start = (i * 360.0f / _camera_num) - info.angle_range / 2.0f;
+        if (_dewarp_mode == DewarpBowl) {
+            info.calibration = calib.cameras[i];
             info.calibration.extrinsic.trans_x += XCAM_CAMERA_POSITION_OFFSET_X;
-
-            info.angle_range = _viewpoints_range[i];
-            info.round_angle_start = (i * 360.0f / _camera_num) - info.angle_range / 2.0f;
         }
+    }
 
+    if (_dewarp_mode == DewarpBowl) {
         centralize_bowl_coord_from_cameras (
             _camera_info[0].calibration.extrinsic, _camera_info[1].calibration.extrinsic,
             _camera_info[2].calibration.extrinsic, _camera_info[3].calibration.extrinsic);
     }
+}
+
+XCamReturn
+Stitcher::update_calibration (const Calibration &calib)
+{
+    SmartLock locker (_calib_mutex);
+    if (!_is_calib_live) {
+        _calibration = calib;
+        _is_calib_set = true;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    _pending_calib = calib;
+    _has_pending_calib = true;
+    if (!_calib_running) {
+        _calib_thread = new StitchCalibrationThread (this);
+        XCAM_ASSERT (_calib_thread.ptr ());
+        _calib_running = true;
+        if (!_calib_thread->start ()) {
+            _calib_running = false;
+            _has_pending_calib = false;
+            _calib_thread.release ();
+            XCAM_LOG_ERROR ("stitcher start calibration thread failed");
+            return XCAM_RETURN_ERROR_THREAD;
+        }
+    }
+    _calib_cond.broadcast ();
 
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+Stitcher::get_calibration (Calibration &calib)
+{
+    SmartLock locker (_calib_mutex);
+    if (_has_pending_calib) {
+        calib = _pending_calib;
+        return XCAM_RETURN_NO_ERROR;
+    }
+    if (_is_calib_set) {
+        calib = _calibration;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    return load_calibration (calib);
+}
+
+bool
+Stitcher::is_calibration_pending ()
+{
+    SmartLock locker (_calib_mutex);
+    return _has_pending_calib || _calib_building || _staged.ptr ();
+}
+
+bool
+Stitcher::set_viewport (const Rect &viewport)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, viewport.pos_x >= 0 && viewport.pos_y >= 0 && viewport.width > 0 && viewport.height > 0, false,
+        "stitcher: set viewport failed, invalid viewport(%d, %d, %d, %d)",
+        viewport.pos_x, viewport.pos_y, viewport.width, viewport.height);
+
+    SmartLock locker (_viewport_mutex);
+    _viewport = viewport;
+    _is_viewport_set = true;
+    return true;
+}
+
+void
+Stitcher::clear_viewport ()
+{
+    SmartLock locker (_viewport_mutex);
+    _is_viewport_set = false;
+}
+
+XCamReturn
+Stitcher::get_merge_areas (std::vector<Rect> &areas)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _camera_num && _output_width && _output_height, XCAM_RETURN_ERROR_PARAM,
+        "stitcher get merge areas failed, camera number or output size was not set");
+
+    if (!_is_overlap_set) {
+        XCamReturn ret = estimate_geometry ();
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher get merge areas failed");
+    }
+
+    areas.clear ();
+    for (uint32_t i = 0; i < _camera_num; ++i)
+        areas.push_back (_overlap_info[i].out_area);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+Stitcher::get_viewport (Rect &viewport)
+{
+    SmartLock locker (_viewport_mutex);
+    if (!_is_viewport_set)
+        return false;
+
+    viewport = _viewport;
+    return true;
+}
+
+bool
+Stitcher::set_reduced_outputs (uint32_t level_mask)
+{
+    uint32_t valid_mask = ((1u << (XCAM_STITCH_MAX_REDUCED_LEVEL + 1)) - 1) & ~1u;
+    XCAM_FAIL_RETURN (
+        ERROR, !(level_mask & ~valid_mask), false,
+        "stitcher: set reduced outputs failed, level mask(0x%x) out of levels [1, %d]",
+        level_mask, XCAM_STITCH_MAX_REDUCED_LEVEL);
+
+    _reduced_levels = level_mask;
+    return true;
+}
+
+XCamReturn
+Stitcher::stage_calibration (const Calibration &calib, SmartPtr<Stitcher> &staged)
+{
+    SmartPtr<StitchCalibrationStage> stage = new StitchCalibrationStage (_alignment_x, _alignment_y);
+    XCAM_ASSERT (stage.ptr ());
+
+    stage->_output_width = _output_width;
+    stage->_output_height = _output_height;
+    stage->_out_start_angle = _out_start_angle;
+    stage->_camera_num = _camera_num;
+    stage->_dewarp_mode = _dewarp_mode;
+    stage->_scale_mode = _scale_mode;
+    stage->_fm_mode = _fm_mode;
+    stage->_fm_status = _fm_status;
+    stage->_fm_frames = _fm_frames;
+    stage->_fm_cfg = _fm_cfg;
+    stage->_fm_region_ratio = _fm_region_ratio;
+    stage->_complete_stitch = _complete_stitch;
+    stage->_need_fm = _need_fm;
+    stage->_blend_pyr_levels = _blend_pyr_levels;
+    stage->_stitch_info = _stitch_info;
+    for (uint32_t i = 0; i < _camera_num; ++i)
+        stage->_crop_info[i] = _crop_info[i];
+    stage->_is_crop_set = _is_crop_set;
+
+    stage->_calibration = calib;
+    stage->_is_calib_set = true;
+
+    XCamReturn ret = stage->estimate_geometry ();
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher stage estimate geometry failed");
+    ret = stage->update_copy_areas ();
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher stage update copy areas failed");
+
+    staged = stage;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+Stitcher::build_pending_calibration ()
+{
+    Calibration calib;
+    {
+        SmartLock locker (_calib_mutex);
+        while (_calib_running && !_has_pending_calib)
+            _calib_cond.wait (_calib_mutex);
+        if (!_calib_running)
+            return false;
+
+        calib = _pending_calib;
+        _has_pending_calib = false;
+        _calib_building = true;
+    }
+
+    SmartPtr<Stitcher> staged;
+    SmartPtr<CalibrationTables> tables;
+    XCamReturn ret = stage_calibration (calib, staged);
+    if (xcam_ret_is_ok (ret))
+        ret = prepare_calibration (*staged.ptr (), tables);
+
+    SmartLock locker (_calib_mutex);
+    _calib_building = false;
+    if (!xcam_ret_is_ok (ret)) {
+        XCAM_LOG_WARNING ("stitcher build calibration failed, keep the current one");
+        return true;
+    }
+
+    // replaces a built one not swapped in yet
+    _staged = staged;
+    _staged_tables = tables;
+    _calib_ready.store (true, std::memory_order_release);
+    return true;
+}
+
+XCamReturn
+Stitcher::apply_ready_calibration ()
+{
+    SmartPtr<Stitcher> staged;
+    SmartPtr<CalibrationTables> tables;
+    {
+        SmartLock locker (_calib_mutex);
+        if (!_staged.ptr ())
+            return XCAM_RETURN_BYPASS;
+
+        staged = std::move (_staged);
+        tables = std::move (_staged_tables);
+        _calib_ready.store (false, std::memory_order_release);
+        _calibration = staged->_calibration;
+    }
+
+    const Stitcher &stage = *staged.ptr ();
+    _bowl_config = stage._bowl_config;
+    for (uint32_t i = 0; i < _camera_num; ++i) {
+        _viewpoints_range[i] = stage._viewpoints_range[i];
+        _camera_info[i] = stage._camera_info[i];
+        _round_view_slices[i] = stage._round_view_slices[i];
+        _center_marks[i] = stage._center_marks[i];
+        _overlap_info[i] = stage._overlap_info[i];
+    }
+    _copy_areas = stage._copy_areas;
+
+    XCamReturn ret = commit_calibration (tables);
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher commit calibration failed");
+
+    XCAM_LOG_INFO ("stitcher calibration updated");
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+Stitcher::stop_calibration ()
+{
+    SmartPtr<Thread> thread;
+    {
+        SmartLock locker (_calib_mutex);
+        _calib_running = false;
+        _has_pending_calib = false;
+        _calib_cond.broadcast ();
+        thread = std::move (_calib_thread);
+    }
+
+    if (thread.ptr ())
+        thread->stop ();
+
+    SmartLock locker (_calib_mutex);
+    _staged.release ();
+    _staged_tables.release ();
+    _calib_ready.store (false, std::memory_order_release);
+}
+
+XCamReturn
+Stitcher::prepare_calibration (Stitcher &staged, SmartPtr<CalibrationTables> &tables)
+{
+    XCAM_UNUSED (staged);
+    XCAM_UNUSED (tables);
+    XCAM_LOG_WARNING ("stitcher backend can't rebuild its tables while stitching, calibration update ignored");
+    return XCAM_RETURN_ERROR_UNKNOWN;
+}
+
+XCamReturn
+Stitcher::commit_calibration (const SmartPtr<CalibrationTables> &tables)
+{
+    XCAM_UNUSED (tables);
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 Stitcher::estimate_round_slices ()
 {
@@ -756,6 +1142,253 @@ Stitcher::update_copy_areas ()
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+Stitcher::gen_fisheye_table (
+    uint32_t idx, uint32_t table_width, uint32_t table_height, std::vector<PointFloat2> &table)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _is_round_view_set && idx < _camera_num, XCAM_RETURN_ERROR_ORDER,
+        "stitcher gen fisheye table failed, need set round_view slices first, idx:%d", idx);
+    XCAM_FAIL_RETURN (
+        ERROR, table_width > 1 && table_height > 1, XCAM_RETURN_ERROR_PARAM,
+        "stitcher gen fisheye table failed, table size(%dx%d) is too small", table_width, table_height);
+
+    const RoundViewSlice &view_slice = _round_view_slices[idx];
+
+    SmartPtr<FisheyeDewarp> dewarper;
+    if (_dewarp_mode == DewarpBowl) {
+        BowlDataConfig bowl = _bowl_config;
+        bowl.angle_start = view_slice.hori_angle_start;
+        bowl.angle_end = format_angle (view_slice.hori_angle_start + view_slice.hori_angle_range);
+        if (bowl.angle_end < bowl.angle_start)
+            bowl.angle_start -= 360.0f;
+
+        XCAM_LOG_DEBUG (
+            "stitcher camera(idx:%d) info(angle start:%.2f, range:%.2f), bowl_info(angle start%.2f, end:%.2f)",
+            idx, view_slice.hori_angle_start, view_slice.hori_angle_range, bowl.angle_start, bowl.angle_end);
+
+        SmartPtr<PolyBowlFisheyeDewarp> fd = new PolyBowlFisheyeDewarp ();
+        fd->set_intr_param (_camera_info[idx].calibration.intrinsic);
+        fd->set_extr_param (_camera_info[idx].calibration.extrinsic);
+        fd->set_bowl_config (bowl);
+        dewarper = fd;
+    } else {
+        const FisheyeInfo &fisheye_info = _stitch_info.fisheye_info[idx];
+        float max_dst_latitude = (fisheye_info.intrinsic.fov > 180.0f) ? 180.0f : fisheye_info.intrinsic.fov;
+        float max_dst_longitude = max_dst_latitude * view_slice.width / view_slice.height;
+
+        SmartPtr<SphereFisheyeDewarp> fd = new SphereFisheyeDewarp ();
+        fd->set_fisheye_info (fisheye_info);
+        fd->set_dst_range (max_dst_longitude, max_dst_latitude);
+        dewarper = fd;
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, dewarper.ptr (), XCAM_RETURN_ERROR_MEM,
+        "stitcher fisheye dewarper is NULL, idx:%d", idx);
+
+    dewarper->set_out_size (view_slice.width, view_slice.height);
+    dewarper->set_table_size (table_width, table_height);
+
+    table.resize (table_width * table_height);
+    dewarper->gen_table (table);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+Stitcher::estimate_geometry ()
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (!_is_round_view_set) {
+        ret = init_camera_info ();
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher init camera info failed");
+    }
+
+    ret = estimate_round_slices ();
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher estimate round view slices failed");
+    ret = estimate_coarse_crops ();
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher estimate coarse crops failed");
+    ret = mark_centers ();
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher mark centers failed");
+    ret = estimate_overlap ();
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher estimate overlap failed");
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+// wrap horizontal distance on the round view into [-width / 2, width / 2)
+static inline float
+wrap_round_offset (float offset, float width)
+{
+    if (offset >= width / 2.0f)
+        offset -= width;
+    else if (offset < -width / 2.0f)
+        offset += width;
+    return offset;
+}
+
+static inline PointFloat2
+interp_table (const std::vector<PointFloat2> &table, uint32_t width, uint32_t height, float x, float y)
+{
+    x = XCAM_CLAMP (x, 0.0f, width - 1.0f);
+    y = XCAM_CLAMP (y, 0.0f, height - 1.0f);
+    uint32_t x0 = XCAM_MIN ((uint32_t)x, width - 2);
+    uint32_t y0 = XCAM_MIN ((uint32_t)y, height - 2);
+    float wx = x - x0, wy = y - y0;
+
+    const PointFloat2 *top = &table[y0 * width + x0];
+    const PointFloat2 *bottom = top + width;
+    PointFloat2 pos;
+    pos.x = (top[0].x * (1.0f - wx) + top[1].x * wx) * (1.0f - wy) + (bottom[0].x * (1.0f - wx) + bottom[1].x * wx) * wy;
+    pos.y = (top[0].y * (1.0f - wx) + top[1].y * wx) * (1.0f - wy) + (bottom[0].y * (1.0f - wx) + bottom[1].y * wx) * wy;
+    return pos;
+}
+
+/*
+ * Copy areas and overlaps keep out_x - out_center_x == slice_x - slice_center_x, so each
+ * stitched position goes back to its slices. Inside overlaps, weights ramp linearly
+ * from one camera to the next instead of the pyramid blending of stitch_buffers.
+ */
+XCamReturn
+Stitcher::compose_camera_maps (
+    const std::vector<PointFloat2> &stitch_points, uint32_t width, uint32_t height,
+    uint32_t table_factor, ComposedMapArray &maps)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, width && height && stitch_points.size () == width * height && table_factor > 0,
+        XCAM_RETURN_ERROR_PARAM,
+        "stitcher compose camera maps failed, points(%d) don't match output(%dx%d) or table factor(%d) is 0",
+        (int)stitch_points.size (), width, height, table_factor);
+    XCAM_FAIL_RETURN (
+        ERROR, _output_width && _output_height, XCAM_RETURN_ERROR_PARAM,
+        "stitcher compose camera maps failed, output size was not set");
+
+    XCamReturn ret = estimate_geometry ();
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher compose camera maps failed");
+
+    const float stitch_width = _output_width;
+    const float stitch_height = _output_height;
+    const uint32_t pixels = width * height;
+
+    std::vector<PointFloat2> fisheye_tables[XCAM_STITCH_MAX_CAMERAS];
+    uint32_t table_sizes[XCAM_STITCH_MAX_CAMERAS][2];
+    // ramp up and ramp down ranges, relative to out center
+    float ramps[XCAM_STITCH_MAX_CAMERAS][4];
+    for (uint32_t i = 0; i < _camera_num; ++i) {
+        const RoundViewSlice &slice = _round_view_slices[i];
+        table_sizes[i][0] = XCAM_ALIGN_UP (slice.width / COMPOSE_FISHEYE_MAP_FACTOR, 4);
+        table_sizes[i][1] = XCAM_ALIGN_UP (slice.height / COMPOSE_FISHEYE_MAP_FACTOR, 2);
+        ret = gen_fisheye_table (i, table_sizes[i][0], table_sizes[i][1], fisheye_tables[i]);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "stitcher gen fisheye table failed, idx:%d", i);
+
+        const Rect &left = _overlap_info[(i + _camera_num - 1) % _camera_num].out_area;
+        const Rect &right = _overlap_info[i].out_area;
+        float center = _center_marks[i].out_center_x;
+        ramps[i][0] = wrap_round_offset (left.pos_x - center, stitch_width);
+        ramps[i][1] = ramps[i][0] + left.width;
+        ramps[i][2] = wrap_round_offset (right.pos_x - center, stitch_width);
+        ramps[i][3] = ramps[i][2] + right.width;
+    }
+
+    // weights of each camera on the whole output, quantized by accumulation to sum 255
+    std::vector<uint8_t> weights (_camera_num * pixels, 0);
+    for (uint32_t pos = 0; pos < pixels; ++pos) {
+        const PointFloat2 &point = stitch_points[pos];
+        if (point.x < 0.0f || point.x > stitch_width || point.y < 0.0f || point.y > stitch_height - 1.0f)
+            continue;
+
+        float sum = 0.0f;
+        uint32_t quantized = 0;
+        for (uint32_t i = 0; i < _camera_num; ++i) {
+            float offset = wrap_round_offset (point.x - _center_marks[i].out_center_x, stitch_width);
+            const float *ramp = ramps[i];
+            float w = 0.0f;
+            if (offset >= ramp[0] && offset < ramp[3]) {
+                if (offset < ramp[1])
+                    w = (offset - ramp[0]) / (ramp[1] - ramp[0]);
+                else if (offset < ramp[2])
+                    w = 1.0f;
+                else
+                    w = (ramp[3] - offset) / (ramp[3] - ramp[2]);
+            }
+            sum += w;
+            uint32_t next = XCAM_MIN ((uint32_t)(sum * 255.0f + 0.5f), 255u);
+            weights[i * pixels + pos] = (uint8_t)(next - quantized);
+            quantized = next;
+        }
+    }
+
+    maps.clear ();
+    for (uint32_t i = 0; i < _camera_num; ++i) {
+        const uint8_t *cam_weights = &weights[i * pixels];
+        int32_t min_x = width, min_y = height, max_x = -1, max_y = -1;
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                if (!cam_weights[y * width + x])
+                    continue;
+                min_x = XCAM_MIN (min_x, (int32_t)x);
+                max_x = XCAM_MAX (max_x, (int32_t)x);
+                min_y = XCAM_MIN (min_y, (int32_t)y);
+                max_y = XCAM_MAX (max_y, (int32_t)y);
+            }
+        }
+        if (max_x < 0)
+            continue;
+
+        ComposedMap map;
+        map.cam_idx = i;
+        map.area.pos_x = XCAM_ALIGN_DOWN (min_x, 2);
+        map.area.pos_y = XCAM_ALIGN_DOWN (min_y, 2);
+        map.area.width = XCAM_MIN (XCAM_ALIGN_UP (max_x + 1, 2), (int32_t)width) - map.area.pos_x;
+        map.area.height = XCAM_MIN (XCAM_ALIGN_UP (max_y + 1, 2), (int32_t)height) - map.area.pos_y;
+        map.table_factor = table_factor;
+        map.table_width = (map.area.width - 1) / table_factor + 2;
+        map.table_height = (map.area.height - 1) / table_factor + 2;
+
+        map.weights.resize (map.area.width * map.area.height);
+        for (int32_t y = 0; y < map.area.height; ++y) {
+            memcpy (
+                &map.weights[y * map.area.width],
+                &cam_weights[(map.area.pos_y + y) * width + map.area.pos_x], map.area.width);
+        }
+
+        const RoundViewSlice &slice = _round_view_slices[i];
+        const std::vector<PointFloat2> &fisheye_table = fisheye_tables[i];
+        const float slice_center = _center_marks[i].slice_center_x;
+        const float scale_x = (table_sizes[i][0] - 1.0f) / (slice.width - 1.0f);
+        const float scale_y = (table_sizes[i][1] - 1.0f) / (slice.height - 1.0f);
+
+        map.table.resize (map.table_width * map.table_height);
+        for (uint32_t ty = 0; ty < map.table_height; ++ty) {
+            uint32_t y = XCAM_MIN (map.area.pos_y + ty * table_factor, height - 1);
+            for (uint32_t tx = 0; tx < map.table_width; ++tx) {
+                uint32_t x = XCAM_MIN (map.area.pos_x + tx * table_factor, width - 1);
+                const PointFloat2 &point = stitch_points[y * width + x];
+
+                float slice_x = slice_center + wrap_round_offset (point.x - _center_marks[i].out_center_x, stitch_width);
+                float slice_y = XCAM_CLAMP (point.y, 0.0f, stitch_height - 1.0f) + _crop_info[i].top;
+                slice_x = XCAM_CLAMP (slice_x, 0.0f, slice.width - 1.0f);
+                slice_y = XCAM_CLAMP (slice_y, 0.0f, slice.height - 1.0f);
+
+                map.table[ty * map.table_width + tx] = interp_table (
+                        fisheye_table, table_sizes[i][0], table_sizes[i][1], slice_x * scale_x, slice_y * scale_y);
+            }
+        }
+
+        XCAM_LOG_DEBUG (
+            "stitcher composed map of camera(idx:%d) area(x:%d, y:%d, w:%d, h:%d) table(%dx%d)",
+            i, map.area.pos_x, map.area.pos_y, map.area.width, map.area.height,
+            map.table_width, map.table_height);
+        maps.push_back (map);
+    }
+
+    XCAM_FAIL_RETURN (
+        ERROR, !maps.empty (), XCAM_RETURN_ERROR_PARAM,
+        "stitcher compose camera maps failed, no camera covers the output");
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 // BowlModel 用于把碗面坐标与原始环视图之间互相映射，供顶视图、碗面渲染和 GeoMapper 使用。
 BowlModel::BowlModel (const BowlDataConfig &config, const uint32_t image_width, const uint32_t image_height)
     : _config (config)
@@ -827,6 +1460,31 @@ BowlModel::get_topview_rect_map (
     return true;
 }
 
+bool
+BowlModel::get_topview_camera_maps (
+    const SmartPtr<Stitcher> &stitcher, Stitcher::ComposedMapArray &maps,
+    uint32_t res_width, uint32_t res_height,
+    float length_mm, float width_mm, uint32_t table_factor)
+{
+    XCAM_ASSERT (stitcher.ptr ());
+
+    uint32_t stitch_width = 0, stitch_height = 0;
+    stitcher->get_output_size (stitch_width, stitch_height);
+    XCAM_FAIL_RETURN (
+        ERROR, stitch_width == _bowl_img_width && stitch_height == _bowl_img_height, false,
+        "bowl model image size(%dx%d) doesn't match stitcher output size(%dx%d)",
+        _bowl_img_width, _bowl_img_height, stitch_width, stitch_height);
+
+    PointMap points;
+    if (!get_topview_rect_map (points, res_width, res_height, length_mm, width_mm))
+        return false;
+
+    XCamReturn ret = stitcher->compose_camera_maps (points, res_width, res_height, table_factor, maps);
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), false, "bowl model compose topview camera maps failed");
+
+    return true;
+}
+
 // 构建用于渲染的顶点/纹理坐标数据，将碗面图像映射到立体几何上。
 bool
 BowlModel::get_stitch_image_vertex_model (
@@ -1002,4 +1660,28 @@ CubeMapModel::get_cubemap_rect_map(
     return true;
 }
 
+bool
+CubeMapModel::get_cubemap_camera_maps (
+    const SmartPtr<Stitcher> &stitcher, Stitcher::ComposedMapArray &maps,
+    uint32_t res_width, uint32_t res_height)
+{
+    XCAM_ASSERT (stitcher.ptr ());
+
+    uint32_t stitch_width = 0, stitch_height = 0;
+    stitcher->get_output_size (stitch_width, stitch_height);
+    XCAM_FAIL_RETURN (
+        ERROR, stitch_width == _erp_img_width && stitch_height == _erp_img_height, false,
+        "cubemap model image size(%dx%d) doesn't match stitcher output size(%dx%d)",
+        _erp_img_width, _erp_img_height, stitch_width, stitch_height);
+
+    PointMap points;
+    if (!get_cubemap_rect_map (points, res_width, res_height))
+        return false;
+
+    XCamReturn ret = stitcher->compose_camera_maps (points, res_width, res_height, 1, maps);
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), false, "cubemap model compose camera maps failed");
+
+    return true;
+}
+
 }
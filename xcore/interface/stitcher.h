@@ -27,10 +27,15 @@
 #include <interface/feature_match.h>
 #include <vector>
 #include <video_buffer.h>
+#include <buffer_pool.h>
+#include <xcam_metrics.h>
+#include <xcam_thread.h>
+#include <atomic>
 
 #define XCAM_STITCH_FISHEYE_MAX_NUM    6
 #define XCAM_STITCH_MAX_CAMERAS XCAM_STITCH_FISHEYE_MAX_NUM
 #define XCAM_STITCH_MIN_SEAM_WIDTH 56
+#define XCAM_STITCH_MAX_REDUCED_LEVEL 4
 
 #define INVALID_INDEX (uint32_t)(-1)
 const float ratio = 1.0f / 3.0f;
@@ -52,6 +57,19 @@ enum StitchResMode {
     StitchRes8K6Cams
 };
 
+/*
+ * Reduced outputs of a stitched frame, attached to the output buffer as metadata.
+ * bufs[level] holds the output downscaled by 2^level, caller buffers already set
+ * before stitching are filled in place, missing levels come from the stitcher.
+ */
+struct StitchReducedOutputs
+    : MetaData
+{
+    XCAM_SLOT_TYPE (StitchReducedOutputs, MetaData);
+
+    SmartPtr<VideoBuffer>   bufs[XCAM_STITCH_MAX_REDUCED_LEVEL + 1];
+};
+
 struct StitchInfo {
     uint32_t merge_width[XCAM_STITCH_FISHEYE_MAX_NUM];
 
@@ -71,6 +89,7 @@ struct ImageMergeInfo {
 class Stitcher;
 
 class VKDevice;
+class StitchCalibrationThread;
 
 class Stitcher
 {
@@ -123,6 +142,70 @@ public:
     };
     typedef std::vector<CopyArea>  CopyAreaArray;
 
+    /*
+     * LUT of one camera composed from a stitched image map and the fisheye dewarp table.
+     * table(i, j) is the fisheye position of output pixel
+     * (area.pos_x + i * table_factor, area.pos_y + j * table_factor), clamped to output.
+     * weights hold the blending weight of each pixel inside area, weights of all
+     * cameras sum to 255 on pixels covered by the stitched image.
+     */
+    struct ComposedMap {
+        uint32_t                  cam_idx;
+        Rect                      area;
+        uint32_t                  table_factor;
+        uint32_t                  table_width;
+        uint32_t                  table_height;
+        std::vector<PointFloat2>  table;
+        std::vector<uint8_t>      weights;
+
+        ComposedMap ()
+            : cam_idx (INVALID_INDEX)
+            , table_factor (1)
+            , table_width (0)
+            , table_height (0)
+        {}
+    };
+    typedef std::vector<ComposedMap>  ComposedMapArray;
+
+    enum Stage {
+        StageGeoMap = 0,
+        StageFeatureMatch,
+        StageBlend,
+        StageCopy,
+        // stitch_buffers, or execute_buffer to frame done
+        StageFrame,
+        StageCount
+    };
+
+    struct Metrics {
+        LatencyHistogram     stages[StageCount];
+        uint32_t             frames_in_flight;
+        // merged over the stitcher's own buffer pools
+        BufferPool::Metrics  pools;
+
+        Metrics () : frames_in_flight (0) {}
+    };
+
+    /*
+     * Calibration the geometry is estimated from, cameras hold the parameters as
+     * parsed from the intrinsic/extrinsic files, before bowl centralization.
+     * Sphere dewarp only takes viewpoints_range.
+     */
+    struct Calibration {
+        BowlDataConfig   bowl;
+        CalibrationInfo  cameras[XCAM_STITCH_MAX_CAMERAS];
+        float            viewpoints_range[XCAM_STITCH_MAX_CAMERAS];
+
+        Calibration () {
+            xcam_mem_clear (viewpoints_range);
+        }
+    };
+
+    // backend tables built for a staged calibration, see prepare_calibration
+    struct CalibrationTables {
+        virtual ~CalibrationTables () {}
+    };
+
 public:
     explicit Stitcher (uint32_t align_x, uint32_t align_y = 1);
     virtual ~Stitcher ();
@@ -238,6 +321,18 @@ public:
     const ImageOverlapInfo &get_overlap (uint32_t idx) const {
         return _overlap_info[idx];
     }
+    const CenterMark &get_center (uint32_t idx) const {
+        return _center_marks[idx];
+    }
+    const RoundViewSlice &get_round_view_slice (uint32_t idx) const {
+        return _round_view_slices[idx];
+    }
+    const ImageCropInfo &get_crop (uint32_t idx) const {
+        return _crop_info[idx];
+    }
+    const CopyAreaArray &get_copy_area () const {
+        return _copy_areas;
+    }
 
     bool set_viewpoints_range (const float *range);
     bool set_intrinsic_names (const char *intr_names[]);
@@ -245,8 +340,62 @@ public:
 
     virtual XCamReturn stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf) = 0;
 
+    // safe to call from any thread while stitching
+    virtual void get_stitch_metrics (Metrics &metrics);
+    virtual void reset_stitch_metrics ();
+    static const char *get_stage_name (Stage stage);
+
     XCamReturn init_camera_info ();
 
+    /*
+     * Before the first frame calib replaces the configured calibration files.
+     * Afterwards geometry and backend tables are rebuilt on a background thread
+     * and swapped in between frames, no frame is dropped. The latest update wins.
+     */
+    XCamReturn update_calibration (const Calibration &calib);
+    XCamReturn get_calibration (Calibration &calib);
+    // an update is waiting, being built or built but not swapped in yet
+    bool is_calibration_pending ();
+
+    /*
+     * Restrict stitching to the output areas intersecting viewport, the rest of the
+     * output buffer is left unwritten. viewport may run past the right edge of the
+     * panorama and wraps around to its left. Takes effect from the next frame,
+     * backends without viewport support keep stitching the whole output.
+     */
+    bool set_viewport (const Rect &viewport);
+    void clear_viewport ();
+    // false if no viewport is set
+    bool get_viewport (Rect &viewport);
+
+    /*
+     * Output areas blended from two cameras, areas[idx] merges camera idx and the next,
+     * the last one may run past the right edge. Before the first frame the geometry is
+     * estimated from the calibration here, set the calibration first.
+     */
+    XCamReturn get_merge_areas (std::vector<Rect> &areas);
+
+    /*
+     * Bit L of level_mask fills the output downscaled by 2^L once a frame is stitched,
+     * each pixel the rounded mean of a 2^L x 2^L block, chroma likewise in chroma
+     * units. L in [1, XCAM_STITCH_MAX_REDUCED_LEVEL], see StitchReducedOutputs. Output
+     * width and height must be multiples of 2^(L+1). Set before the first frame,
+     * backends without reduced output support ignore it.
+     */
+    bool set_reduced_outputs (uint32_t level_mask);
+    uint32_t get_reduced_outputs () const {
+        return _reduced_levels;
+    }
+
+    // fisheye positions of camera idx round view slice, sampled on a table_width x table_height grid
+    XCamReturn gen_fisheye_table (
+        uint32_t idx, uint32_t table_width, uint32_t table_height, std::vector<PointFloat2> &table);
+
+    // stitch_points maps width x height output pixels to stitched image positions
+    XCamReturn compose_camera_maps (
+        const std::vector<PointFloat2> &stitch_points, uint32_t width, uint32_t height,
+        uint32_t table_factor, ComposedMapArray &maps);
+
 protected:
     XCamReturn estimate_round_slices ();
     virtual XCamReturn estimate_coarse_crops ();
@@ -254,20 +403,31 @@ protected:
     XCamReturn estimate_overlap ();
     XCamReturn update_copy_areas ();
 
-    const CenterMark &get_center (uint32_t idx) const {
-        return _center_marks[idx];
-    }
-    const RoundViewSlice &get_round_view_slice (uint32_t idx) const {
-        return _round_view_slices[idx];
-    }
-    const ImageCropInfo &get_crop (uint32_t idx) const {
-        return _crop_info[idx];
-    }
-    const CopyAreaArray &get_copy_area () const {
-        return _copy_areas;
+    void record_stage (Stage stage, int64_t start_us, XCamReturn error = XCAM_RETURN_NO_ERROR);
+
+    // called on the calibration thread, staged holds the estimated geometry;
+    // backends without an override keep their calibration once stitching
+    virtual XCamReturn prepare_calibration (Stitcher &staged, SmartPtr<CalibrationTables> &tables);
+    // called by apply_ready_calibration after the geometry is swapped in
+    virtual XCamReturn commit_calibration (const SmartPtr<CalibrationTables> &tables);
+
+    bool is_calibration_ready () const {
+        return _calib_ready.load (std::memory_order_acquire);
     }
+    // backends call it between frames, with no frame in flight
+    XCamReturn apply_ready_calibration ();
+    // backends call it in terminate, before their tables go away
+    void stop_calibration ();
 
 private:
+    friend class StitchCalibrationThread;
+
+    XCamReturn estimate_geometry ();
+    XCamReturn load_calibration (Calibration &calib);
+    void apply_calibration (const Calibration &calib);
+    XCamReturn stage_calibration (const Calibration &calib, SmartPtr<Stitcher> &staged);
+    bool build_pending_calibration ();
+
     XCAM_DEAD_COPY (Stitcher);
 
 private:
@@ -315,6 +475,28 @@ private:
     uint32_t                    _blend_pyr_levels;
 
     StitchInfo                  _stitch_info;
+
+    LatencyStats                _stage_stats[StageCount];
+
+    Mutex                       _calib_mutex;
+    Cond                        _calib_cond;
+    Calibration                 _calibration;
+    bool                        _is_calib_set;
+    bool                        _is_calib_live;
+    Calibration                 _pending_calib;
+    bool                        _has_pending_calib;
+    bool                        _calib_building;
+    bool                        _calib_running;
+    SmartPtr<Thread>            _calib_thread;
+    SmartPtr<Stitcher>          _staged;
+    SmartPtr<CalibrationTables> _staged_tables;
+    std::atomic<bool>           _calib_ready;
+
+    Mutex                       _viewport_mutex;
+    Rect                        _viewport;
+    bool                        _is_viewport_set;
+
+    uint32_t                    _reduced_levels;
 };
 
 class BowlModel {
@@ -330,6 +512,11 @@ public:
         PointMap &texture_points,
         uint32_t res_width, uint32_t res_height,
         float length_mm = 0.0f, float width_mm = 0.0f);
+    // topview LUTs straight from the fisheye inputs, no stitched image needed
+    bool get_topview_camera_maps (
+        const SmartPtr<Stitcher> &stitcher, Stitcher::ComposedMapArray &maps,
+        uint32_t res_width, uint32_t res_height,
+        float length_mm = 0.0f, float width_mm = 0.0f, uint32_t table_factor = 4);
 
     bool get_stitch_image_vertex_model (
         VertexMap &vertices, PointMap &texture_points, IndexVector &indeices,
@@ -360,6 +547,10 @@ public:
         PointMap &texture_points,
         uint32_t res_width,
         uint32_t res_height);
+    // table factor is 1, cube faces are not continuous to interpolate across
+    bool get_cubemap_camera_maps (
+        const SmartPtr<Stitcher> &stitcher, Stitcher::ComposedMapArray &maps,
+        uint32_t res_width, uint32_t res_height);
 
 private:
     uint32_t _erp_img_width, _erp_img_height;
@@ -22,6 +22,7 @@
 #define XCAM_META_DATA_H
 
 #include <xcam_std.h>
+#include <typed_slots.h>
 #include <list>
 
 namespace XCam {
@@ -37,6 +38,8 @@ private:
 struct MetaData
     : MetaBase
 {
+    XCAM_SLOT_TYPE (MetaData, MetaBase);
+
     int64_t timestamp; // in microseconds
 
     MetaData () {
@@ -50,6 +53,8 @@ private:
 struct DevicePose
     : MetaData
 {
+    XCAM_SLOT_TYPE (DevicePose, MetaData);
+
     double   orientation[4];
     double   translation[3];
     uint32_t confidence;
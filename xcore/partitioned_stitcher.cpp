@@ -0,0 +1,600 @@
+/*
+ * partitioned_stitcher.cpp - stitching split into output strips over processes
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "partitioned_stitcher.h"
+#include "xcam_metrics.h"
+#include "xcam_utils.h"
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+// how often waits look at the health of the other side
+#define XCAM_PARTITION_POLL_US (100 * 1000)
+#define XCAM_PARTITION_STOP_WAIT_MS 2000
+
+namespace XCam {
+
+struct PartitionSlot {
+    // strips still stitching the frame, the coordinator sleeps on it
+    std::atomic<uint32_t>   remaining;
+    std::atomic<int32_t>    error;
+    int64_t                 timestamps[XCAM_STITCH_MAX_CAMERAS];
+};
+
+struct PartitionControl {
+    // frames pushed, the workers sleep on it
+    std::atomic<uint32_t>   pushed;
+    // workers holding a stitcher, or failed to
+    std::atomic<uint32_t>   ready;
+    std::atomic<int32_t>    start_error;
+    std::atomic<uint32_t>   stopping;
+    PartitionSlot           slots[XCAM_PARTITION_MAX_DEPTH];
+};
+
+static inline size_t
+page_align (size_t size)
+{
+    size_t page = (size_t) sysconf (_SC_PAGESIZE);
+    return XCAM_ALIGN_UP (size, page);
+}
+
+/*
+ * Bound between strips @bound - 1 and @bound, 16 pixel aligned and moved to the
+ * nearer side of a merge area it falls into. A strip touching a merge area blends
+ * it whole, with the bounds outside every merge area no two strips write the same
+ * pixels.
+ */
+static int32_t
+get_strip_bound (uint32_t bound, uint32_t count, int32_t width, const std::vector<Rect> &merges)
+{
+    if (bound == 0)
+        return 0;
+    if (bound == count)
+        return width;
+
+    int32_t x = XCAM_ALIGN_DOWN (width * bound / count, 16);
+    for (uint32_t i = 0; i < merges.size (); ++i) {
+        // the last merge area may wrap around to the left edge
+        for (int32_t shift = -width; shift <= width; shift += width) {
+            int32_t x0 = merges[i].pos_x + shift;
+            int32_t x1 = x0 + merges[i].width;
+            if (x <= x0 || x >= x1)
+                continue;
+
+            int32_t left = XCAM_ALIGN_DOWN (x0, 16);
+            int32_t right = XCAM_ALIGN_UP (x1, 16);
+            x = (x - left <= right - x) ? left : right;
+        }
+    }
+    return XCAM_CLAMP (x, 0, width);
+}
+
+// strips are empty when merge areas take their whole width
+static Rect
+get_strip_rect (uint32_t strip, uint32_t count, uint32_t width, uint32_t height, const std::vector<Rect> &merges)
+{
+    int32_t x0 = get_strip_bound (strip, count, width, merges);
+    int32_t x1 = get_strip_bound (strip + 1, count, width, merges);
+    return Rect (x0, 0, XCAM_MAX (x1 - x0, 0), height);
+}
+
+/*
+ * Shared anonymous mapping, inherited by the forked workers: control block, then per
+ * slot the input images and the output.
+ */
+class PartitionRegion
+{
+public:
+    explicit PartitionRegion ()
+        : _ptr (NULL)
+        , _size (0)
+        , _camera_num (0)
+        , _depth (0)
+        , _slot_size (0)
+        , _out_offset (0)
+    {
+        xcam_mem_clear (_in_offsets);
+        xcam_mem_clear (_held);
+    }
+    ~PartitionRegion () {
+        if (_ptr)
+            munmap (_ptr, _size);
+    }
+
+    bool init (
+        const VideoBufferInfo *in_infos, uint32_t camera_num,
+        const VideoBufferInfo &out_info, uint32_t depth);
+
+    PartitionControl *control () const {
+        return (PartitionControl *) _ptr;
+    }
+    uint32_t get_camera_num () const {
+        return _camera_num;
+    }
+    const VideoBufferInfo &get_in_info (uint32_t idx) const {
+        return _in_infos[idx];
+    }
+    const VideoBufferInfo &get_out_info () const {
+        return _out_info;
+    }
+    uint8_t *get_in_data (uint32_t slot, uint32_t idx) const {
+        return _ptr + _slot_size * slot + _in_offsets[idx];
+    }
+    uint8_t *get_out_data (uint32_t slot) const {
+        return _ptr + _slot_size * slot + _out_offset;
+    }
+
+    // coordinator side, a popped output holds its slot
+    void hold_slot (uint32_t slot) {
+        SmartLock lock (_mutex);
+        _held[slot] = true;
+    }
+    void release_slot (uint32_t slot) {
+        SmartLock lock (_mutex);
+        _held[slot] = false;
+        _cond.broadcast ();
+    }
+    void wait_slot (uint32_t slot) {
+        SmartLock lock (_mutex);
+        while (_held[slot])
+            _cond.wait (_mutex);
+    }
+
+private:
+    XCAM_DEAD_COPY (PartitionRegion);
+
+private:
+    uint8_t            *_ptr;
+    size_t              _size;
+    uint32_t            _camera_num;
+    uint32_t            _depth;
+    VideoBufferInfo     _in_infos[XCAM_STITCH_MAX_CAMERAS];
+    VideoBufferInfo     _out_info;
+    size_t              _slot_size;
+    size_t              _in_offsets[XCAM_STITCH_MAX_CAMERAS];
+    size_t              _out_offset;
+
+    Mutex               _mutex;
+    Cond                _cond;
+    bool                _held[XCAM_PARTITION_MAX_DEPTH];
+};
+
+bool
+PartitionRegion::init (
+    const VideoBufferInfo *in_infos, uint32_t camera_num,
+    const VideoBufferInfo &out_info, uint32_t depth)
+{
+    XCAM_ASSERT (!_ptr);
+
+    size_t control_size = page_align (sizeof (PartitionControl));
+    size_t offset = 0;
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        _in_infos[i] = in_infos[i];
+        _in_offsets[i] = control_size + offset;
+        offset += page_align (in_infos[i].size);
+    }
+    _out_info = out_info;
+    _out_offset = control_size + offset;
+    offset += page_align (out_info.size);
+
+    // slot 0 starts behind the control block, the others keep its layout
+    _slot_size = offset;
+    _size = control_size + _slot_size * depth;
+    _camera_num = camera_num;
+    _depth = depth;
+
+    void *ptr = mmap (NULL, _size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    XCAM_FAIL_RETURN (
+        ERROR, ptr != MAP_FAILED, false,
+        "PartitionedStitcher map %" PRIuS " bytes of shared memory failed", _size);
+
+    _ptr = (uint8_t *) ptr;
+    new (_ptr) PartitionControl ();
+    return true;
+}
+
+class PartitionBuffer
+    : public VideoBuffer
+{
+public:
+    explicit PartitionBuffer (
+        const VideoBufferInfo &info, const SmartPtr<PartitionRegion> &region,
+        uint8_t *ptr, int32_t held_slot = -1)
+        : VideoBuffer (info)
+        , _region (region)
+        , _ptr (ptr)
+        , _held_slot (held_slot)
+    {}
+    ~PartitionBuffer () {
+        if (_held_slot >= 0)
+            _region->release_slot (_held_slot);
+    }
+
+    //derived from VideoBuffer
+    virtual uint8_t *map () {
+        return _ptr;
+    }
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+
+private:
+    XCAM_DEAD_COPY (PartitionBuffer);
+
+private:
+    SmartPtr<PartitionRegion>   _region;
+    uint8_t                    *_ptr;
+    int32_t                     _held_slot;
+};
+
+PartitionedStitcher::PartitionedStitcher (const SmartPtr<StripFactory> &factory)
+    : _factory (factory)
+    , _strip_count (2)
+    , _depth (2)
+    , _pushed (0)
+    , _popped (0)
+{
+    for (uint32_t i = 0; i < XCAM_PARTITION_MAX_STRIPS; ++i)
+        _workers[i] = -1;
+}
+
+PartitionedStitcher::~PartitionedStitcher ()
+{
+    stop ();
+}
+
+bool
+PartitionedStitcher::set_strip_count (uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_region.ptr (), false,
+        "PartitionedStitcher set strip count failed, already started");
+    XCAM_FAIL_RETURN (
+        ERROR, count > 0 && count <= XCAM_PARTITION_MAX_STRIPS, false,
+        "PartitionedStitcher strip count %d out of range (1 ~ %d)", count, XCAM_PARTITION_MAX_STRIPS);
+
+    _strip_count = count;
+    return true;
+}
+
+bool
+PartitionedStitcher::set_queue_depth (uint32_t depth)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_region.ptr (), false,
+        "PartitionedStitcher set queue depth failed, already started");
+    XCAM_FAIL_RETURN (
+        ERROR, depth > 0 && depth <= XCAM_PARTITION_MAX_DEPTH, false,
+        "PartitionedStitcher queue depth %d out of range (1 ~ %d)", depth, XCAM_PARTITION_MAX_DEPTH);
+
+    _depth = depth;
+    return true;
+}
+
+XCamReturn
+PartitionedStitcher::start (const VideoBufferInfo *in_infos, uint32_t camera_num, const VideoBufferInfo &out_info)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_region.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "PartitionedStitcher already started");
+    XCAM_FAIL_RETURN (
+        ERROR, _factory.ptr () && in_infos && camera_num > 0 && camera_num <= XCAM_STITCH_MAX_CAMERAS,
+        XCAM_RETURN_ERROR_PARAM,
+        "PartitionedStitcher start failed, invalid params (camera_num:%d)", camera_num);
+    XCAM_FAIL_RETURN (
+        ERROR, out_info.is_valid () && out_info.width >= _strip_count * 16, XCAM_RETURN_ERROR_PARAM,
+        "PartitionedStitcher start failed, output of width %d too small for %d strips",
+        out_info.width, _strip_count);
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        XCAM_FAIL_RETURN (
+            ERROR, in_infos[i].is_valid (), XCAM_RETURN_ERROR_PARAM,
+            "PartitionedStitcher start failed, video info of camera %d invalid", i);
+    }
+
+    SmartPtr<PartitionRegion> region = new PartitionRegion ();
+    XCAM_FAIL_RETURN (
+        ERROR, region->init (in_infos, camera_num, out_info, _depth), XCAM_RETURN_ERROR_MEM,
+        "PartitionedStitcher start failed");
+    _region = region;
+    _pushed = 0;
+    _popped = 0;
+
+    // buffered output would be written again by every worker
+    fflush (NULL);
+    for (uint32_t i = 0; i < _strip_count; ++i) {
+        pid_t pid = fork ();
+        if (pid == 0)
+            run_worker (i);
+
+        if (pid < 0) {
+            XCAM_LOG_ERROR ("PartitionedStitcher fork worker %d failed, %s", i, strerror (errno));
+            stop ();
+            return XCAM_RETURN_ERROR_THREAD;
+        }
+        _workers[i] = pid;
+    }
+
+    PartitionControl *control = _region->control ();
+    while (true) {
+        uint32_t ready = control->ready.load (std::memory_order_acquire);
+        int32_t error = control->start_error.load (std::memory_order_acquire);
+        XCamReturn ret = check_workers ();
+        if (error != XCAM_RETURN_NO_ERROR || !xcam_ret_is_ok (ret)) {
+            stop ();
+            XCAM_LOG_ERROR ("PartitionedStitcher start failed, a worker got no stitcher");
+            return error != XCAM_RETURN_NO_ERROR ? (XCamReturn) error : ret;
+        }
+        if (ready == _strip_count)
+            break;
+        shared_futex_wait (control->ready, ready, XCAM_PARTITION_POLL_US);
+    }
+
+    XCAM_LOG_INFO (
+        "PartitionedStitcher started, %d strips of %dx%d, %d frames in flight",
+        _strip_count, out_info.width, out_info.height, _depth);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+PartitionedStitcher::run_worker (uint32_t strip)
+{
+    // leave with the coordinator
+    pid_t parent = getppid ();
+    prctl (PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid () != parent)
+        _exit (1);
+
+    PartitionControl *control = _region->control ();
+    const VideoBufferInfo &out_info = _region->get_out_info ();
+    Rect rect;
+
+    XCamReturn error = XCAM_RETURN_NO_ERROR;
+    uint32_t width = 0, height = 0;
+    std::vector<Rect> merges;
+    SmartPtr<Stitcher> stitcher = _factory->create_stitcher (strip, _strip_count);
+    if (stitcher.ptr ())
+        stitcher->get_output_size (width, height);
+    if (!stitcher.ptr () || width != out_info.width || height != out_info.height) {
+        XCAM_LOG_ERROR (
+            "PartitionedStitcher strip %d got no stitcher or one with output %dx%d, expect %dx%d",
+            strip, width, height, out_info.width, out_info.height);
+        error = XCAM_RETURN_ERROR_PARAM;
+    } else {
+        // every worker gets the same layout from the same configuration
+        error = stitcher->get_merge_areas (merges);
+        if (xcam_ret_is_ok (error)) {
+            rect = get_strip_rect (strip, _strip_count, out_info.width, out_info.height, merges);
+            if (rect.width > 0 && !stitcher->set_viewport (rect))
+                error = XCAM_RETURN_ERROR_PARAM;
+        }
+    }
+
+    if (error != XCAM_RETURN_NO_ERROR) {
+        int32_t expected = XCAM_RETURN_NO_ERROR;
+        control->start_error.compare_exchange_strong (expected, error);
+    }
+    control->ready.fetch_add (1, std::memory_order_release);
+    shared_futex_wake (control->ready);
+    if (error != XCAM_RETURN_NO_ERROR) {
+        fflush (NULL);
+        _exit (1);
+    }
+
+    XCAM_LOG_DEBUG (
+        "PartitionedStitcher strip %d takes x %d ~ %d", strip, rect.pos_x, rect.pos_x + rect.width);
+
+    uint32_t done = 0;
+    while (!control->stopping.load (std::memory_order_acquire)) {
+        uint32_t pushed = control->pushed.load (std::memory_order_acquire);
+        if (pushed == done) {
+            // stop only wakes, the timeout covers a wake before the wait
+            shared_futex_wait (control->pushed, pushed, XCAM_PARTITION_POLL_US);
+            continue;
+        }
+
+        uint32_t slot_idx = done % _depth;
+        PartitionSlot &slot = control->slots[slot_idx];
+        ++done;
+
+        VideoBufferList in_bufs;
+        for (uint32_t i = 0; i < _region->get_camera_num (); ++i) {
+            SmartPtr<VideoBuffer> buf = new PartitionBuffer (
+                _region->get_in_info (i), _region, _region->get_in_data (slot_idx, i));
+            buf->set_timestamp (slot.timestamps[i]);
+            in_bufs.push_back (buf);
+        }
+        SmartPtr<VideoBuffer> out_buf = new PartitionBuffer (out_info, _region, _region->get_out_data (slot_idx));
+
+        XCamReturn ret = XCAM_RETURN_NO_ERROR;
+        if (rect.width > 0)
+            ret = stitcher->stitch_buffers (in_bufs, out_buf);
+        if (!xcam_ret_is_ok (ret)) {
+            XCAM_LOG_ERROR ("PartitionedStitcher strip %d stitch frame %d failed", strip, done);
+            int32_t expected = XCAM_RETURN_NO_ERROR;
+            slot.error.compare_exchange_strong (expected, ret);
+        }
+        if (slot.remaining.fetch_sub (1, std::memory_order_acq_rel) == 1)
+            shared_futex_wake (slot.remaining);
+    }
+
+    stitcher.release ();
+    fflush (NULL);
+    _exit (0);
+}
+
+XCamReturn
+PartitionedStitcher::check_workers ()
+{
+    for (uint32_t i = 0; i < _strip_count; ++i) {
+        int status = 0;
+        if (_workers[i] <= 0 || waitpid (_workers[i], &status, WNOHANG) != _workers[i])
+            continue;
+
+        XCAM_LOG_ERROR (
+            "PartitionedStitcher worker of strip %d exited, status 0x%x", i, status);
+        _workers[i] = -1;
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+    for (uint32_t i = 0; i < _strip_count; ++i) {
+        if (_workers[i] <= 0)
+            return XCAM_RETURN_ERROR_THREAD;
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+PartitionedStitcher::push_frame (const VideoBufferList &in_bufs)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _region.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "PartitionedStitcher push frame failed, not started");
+    XCAM_FAIL_RETURN (
+        ERROR, in_bufs.size () == _region->get_camera_num (), XCAM_RETURN_ERROR_PARAM,
+        "PartitionedStitcher push frame failed, got %d buffers for %d cameras",
+        (int) in_bufs.size (), _region->get_camera_num ());
+    XCAM_FAIL_RETURN (
+        WARNING, _pushed - _popped < _depth, XCAM_RETURN_ERROR_PARAM,
+        "PartitionedStitcher push frame failed, %d frames in flight, pop one first", _depth);
+
+    XCamReturn ret = check_workers ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "PartitionedStitcher push frame failed, lost a worker");
+
+    uint32_t slot_idx = _pushed % _depth;
+    // the output popped _depth frames ago
+    _region->wait_slot (slot_idx);
+
+    PartitionControl *control = _region->control ();
+    PartitionSlot &slot = control->slots[slot_idx];
+    uint32_t idx = 0;
+    for (VideoBufferList::const_iterator i = in_bufs.begin (); i != in_bufs.end (); ++i, ++idx) {
+        const SmartPtr<VideoBuffer> &buf = *i;
+        const VideoBufferInfo &info = _region->get_in_info (idx);
+        XCAM_FAIL_RETURN (
+            ERROR,
+            buf.ptr () && buf->get_video_info ().format == info.format &&
+            buf->get_video_info ().width == info.width && buf->get_video_info ().height == info.height &&
+            buf->get_video_info ().size == info.size,
+            XCAM_RETURN_ERROR_PARAM,
+            "PartitionedStitcher push frame failed, buffer of camera %d doesn't match", idx);
+
+        const uint8_t *src = buf->map ();
+        XCAM_FAIL_RETURN (
+            ERROR, src, XCAM_RETURN_ERROR_MEM,
+            "PartitionedStitcher map buffer of camera %d failed", idx);
+        memcpy (_region->get_in_data (slot_idx, idx), src, info.size);
+        buf->unmap ();
+        slot.timestamps[idx] = buf->get_timestamp ();
+    }
+
+    slot.error.store (XCAM_RETURN_NO_ERROR, std::memory_order_relaxed);
+    slot.remaining.store (_strip_count, std::memory_order_relaxed);
+    control->pushed.store (++_pushed, std::memory_order_release);
+    shared_futex_wake (control->pushed);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+PartitionedStitcher::pop_frame (SmartPtr<VideoBuffer> &out_buf, int32_t timeout)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _region.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "PartitionedStitcher pop frame failed, not started");
+    if (_popped == _pushed)
+        return XCAM_RETURN_BYPASS;
+
+    uint32_t slot_idx = _popped % _depth;
+    PartitionSlot &slot = _region->control ()->slots[slot_idx];
+    int64_t deadline = timeout >= 0 ? LatencyStats::now_us () + timeout : -1;
+
+    while (true) {
+        uint32_t remaining = slot.remaining.load (std::memory_order_acquire);
+        if (!remaining)
+            break;
+
+        XCamReturn ret = check_workers ();
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "PartitionedStitcher pop frame failed, lost a worker");
+
+        int64_t wait = XCAM_PARTITION_POLL_US;
+        if (deadline >= 0) {
+            int64_t left = deadline - LatencyStats::now_us ();
+            if (left <= 0)
+                return XCAM_RETURN_ERROR_TIMEOUT;
+            wait = XCAM_MIN (wait, left);
+        }
+        shared_futex_wait (slot.remaining, remaining, wait);
+    }
+
+    ++_popped;
+    int32_t error = slot.error.load (std::memory_order_relaxed);
+    XCAM_FAIL_RETURN (
+        ERROR, error == XCAM_RETURN_NO_ERROR, (XCamReturn) error,
+        "PartitionedStitcher frame %d failed in a strip", _popped);
+
+    _region->hold_slot (slot_idx);
+    out_buf = new PartitionBuffer (
+        _region->get_out_info (), _region, _region->get_out_data (slot_idx), slot_idx);
+    out_buf->set_timestamp (slot.timestamps[0]);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+PartitionedStitcher::stop ()
+{
+    if (!_region.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
+    PartitionControl *control = _region->control ();
+    control->stopping.store (1, std::memory_order_release);
+    shared_futex_wake (control->pushed);
+
+    // workers finish the frame at hand, hung ones are killed
+    int64_t deadline = LatencyStats::now_us () + XCAM_PARTITION_STOP_WAIT_MS * 1000;
+    for (uint32_t i = 0; i < XCAM_PARTITION_MAX_STRIPS; ++i) {
+        if (_workers[i] <= 0)
+            continue;
+        while (waitpid (_workers[i], NULL, WNOHANG) == 0) {
+            if (LatencyStats::now_us () > deadline) {
+                XCAM_LOG_WARNING ("PartitionedStitcher worker of strip %d doesn't stop, killed", i);
+                kill (_workers[i], SIGKILL);
+                waitpid (_workers[i], NULL, 0);
+                break;
+            }
+            usleep (1000);
+        }
+        _workers[i] = -1;
+    }
+
+    // popped outputs keep the mapping
+    _region.release ();
+    _pushed = 0;
+    _popped = 0;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
@@ -0,0 +1,99 @@
+/*
+ * partitioned_stitcher.h - stitching split into output strips over processes
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_PARTITIONED_STITCHER_H
+#define XCAM_PARTITIONED_STITCHER_H
+
+#include <xcam_std.h>
+#include <video_buffer.h>
+#include <interface/stitcher.h>
+#include <sys/types.h>
+
+#define XCAM_PARTITION_MAX_STRIPS 16
+#define XCAM_PARTITION_MAX_DEPTH 4
+
+namespace XCam {
+
+class PartitionRegion;
+
+/*
+ * Coordinator of a panorama split into vertical strips. Every strip is stitched by
+ * its own worker process, a stitcher limited to the strip by set_viewport, so it
+ * only maps and blends the cameras contributing to the strip. Strip bounds are kept
+ * out of the merge areas so each overlap is blended by one worker. Inputs and the output
+ * of each frame in flight sit in memory shared with the workers, all strips write
+ * into the same output and frames come back in push order.
+ */
+class PartitionedStitcher
+{
+public:
+    class StripFactory {
+    public:
+        virtual ~StripFactory () {}
+        /*
+         * Called in the worker process of @strip, returns a stitcher configured for the
+         * whole output, the viewport is set by the caller. The place to bind the
+         * worker to its CPUs or NUMA node.
+         */
+        virtual SmartPtr<Stitcher> create_stitcher (uint32_t strip, uint32_t strip_count) = 0;
+    };
+
+public:
+    explicit PartitionedStitcher (const SmartPtr<StripFactory> &factory);
+    ~PartitionedStitcher ();
+
+    bool set_strip_count (uint32_t count);
+    // frames pushed and not yet released by the caller, 2 by default
+    bool set_queue_depth (uint32_t depth);
+
+    /*
+     * Forks the workers and waits until all of them have a stitcher. Fork from a
+     * process with no other threads running when possible.
+     */
+    XCamReturn start (const VideoBufferInfo *in_infos, uint32_t camera_num, const VideoBufferInfo &out_info);
+    XCamReturn stop ();
+
+    // copies @in_bufs to shared memory, waits while the queue is full
+    XCamReturn push_frame (const VideoBufferList &in_bufs);
+    /*
+     * Oldest pushed frame, once every strip is done. @out_buf maps the shared output
+     * in place, its slot is reused after @out_buf is released. timeout in microseconds.
+     */
+    XCamReturn pop_frame (SmartPtr<VideoBuffer> &out_buf, int32_t timeout = -1);
+
+private:
+    void run_worker (uint32_t strip);
+    XCamReturn check_workers ();
+
+    XCAM_DEAD_COPY (PartitionedStitcher);
+
+private:
+    SmartPtr<StripFactory>      _factory;
+    SmartPtr<PartitionRegion>   _region;
+    uint32_t                    _strip_count;
+    uint32_t                    _depth;
+    pid_t                       _workers[XCAM_PARTITION_MAX_STRIPS];
+    uint32_t                    _pushed;
+    uint32_t                    _popped;
+};
+
+}
+
+#endif //XCAM_PARTITIONED_STITCHER_H
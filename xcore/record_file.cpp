@@ -0,0 +1,719 @@
+/*
+ * record_file.cpp - indexed multi-camera recording file
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "record_file.h"
+#include "meta_data.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#define XCAM_RECORD_MAGIC        0x43524358  // "XCRC"
+#define XCAM_RECORD_FRAME_MAGIC  0x4d464358  // "XCFM"
+#define XCAM_RECORD_INDEX_MAGIC  0x49524358  // "XCRI"
+#define XCAM_RECORD_VERSION      1
+
+// file header, frame headers and images start on this boundary
+#define XCAM_RECORD_ALIGN        4096
+
+namespace XCam {
+
+enum RecordFlag {
+    RecordCompressed = 1,
+};
+
+struct RecordFileHeader {
+    uint32_t                magic;
+    uint32_t                version;
+    uint32_t                camera_num;
+    uint32_t                reserved;
+    XCamVideoBufferInfo     infos[XCAM_RECORD_MAX_CAMERAS];
+};
+
+struct RecordImageHeader {
+    int64_t                 timestamp;
+    // from the frame header
+    uint64_t                offset;
+    uint32_t                flags;
+    uint32_t                has_pose;
+    // stored bytes of each plane, equal to the plane size when kept raw
+    uint32_t                plane_sizes[XCAM_VIDEO_MAX_COMPONENTS];
+    double                  orientation[4];
+    double                  translation[3];
+    uint32_t                confidence;
+    uint32_t                reserved;
+};
+
+struct RecordFrameHeader {
+    uint32_t                magic;
+    uint32_t                camera_num;
+    // frame header and images, padding included
+    uint64_t                frame_size;
+    int64_t                 timestamp;
+    RecordImageHeader       images[XCAM_RECORD_MAX_CAMERAS];
+};
+
+struct RecordIndexFooter {
+    uint32_t                magic;
+    uint32_t                reserved;
+    uint64_t                frame_count;
+    uint64_t                index_offset;
+};
+
+static_assert (sizeof (RecordFileHeader) <= XCAM_RECORD_ALIGN, "record file header too large");
+static_assert (sizeof (RecordFrameHeader) <= XCAM_RECORD_ALIGN, "record frame header too large");
+
+static inline uint64_t
+record_align (uint64_t pos)
+{
+    return XCAM_ALIGN_UP (pos, (uint64_t) XCAM_RECORD_ALIGN);
+}
+
+// planes are [offsets[i], offsets[i + 1]), a layout not in that order is kept as one plane
+static uint32_t
+get_planes (const VideoBufferInfo &info, uint32_t *begins, uint32_t *sizes)
+{
+    uint32_t count = XCAM_CLAMP (info.components, 1, XCAM_VIDEO_MAX_COMPONENTS);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t end = (i + 1 < count) ? info.offsets[i + 1] : info.size;
+        if ((uint32_t) info.offsets[i] > end || (i == 0 && info.offsets[0] != 0)) {
+            begins[0] = 0;
+            sizes[0] = info.size;
+            return 1;
+        }
+        begins[i] = info.offsets[i];
+        sizes[i] = end - info.offsets[i];
+    }
+    return count;
+}
+
+static bool
+is_same_layout (const VideoBufferInfo &a, const XCamVideoBufferInfo &b)
+{
+    return a.format == b.format && a.width == b.width && a.height == b.height && a.size == b.size;
+}
+
+class RecordMapping
+{
+public:
+    explicit RecordMapping (uint8_t *ptr, size_t size)
+        : _ptr (ptr)
+        , _size (size)
+    {}
+    ~RecordMapping () {
+        munmap (_ptr, _size);
+    }
+
+    const uint8_t *get_ptr (uint64_t offset) const {
+        return _ptr + offset;
+    }
+    size_t get_size () const {
+        return _size;
+    }
+
+private:
+    XCAM_DEAD_COPY (RecordMapping);
+
+private:
+    uint8_t    *_ptr;
+    size_t      _size;
+};
+
+// uncompressed image read in place, the mapping is read-only
+class RecordMappedBuffer
+    : public VideoBuffer
+{
+public:
+    explicit RecordMappedBuffer (
+        const VideoBufferInfo &info, const SmartPtr<RecordMapping> &mapping, const uint8_t *ptr)
+        : VideoBuffer (info)
+        , _mapping (mapping)
+        , _ptr (ptr)
+    {}
+
+    //derived from VideoBuffer
+    virtual uint8_t *map () {
+        return (uint8_t *) _ptr;
+    }
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+
+private:
+    XCAM_DEAD_COPY (RecordMappedBuffer);
+
+private:
+    SmartPtr<RecordMapping>  _mapping;
+    const uint8_t           *_ptr;
+};
+
+class RecordMemBuffer
+    : public VideoBuffer
+{
+public:
+    explicit RecordMemBuffer (const VideoBufferInfo &info)
+        : VideoBuffer (info)
+        , _ptr (xcam_malloc_type_array (uint8_t, info.size))
+    {}
+    ~RecordMemBuffer () {
+        xcam_free (_ptr);
+    }
+
+    bool is_valid () const {
+        return _ptr != NULL;
+    }
+
+    //derived from VideoBuffer
+    virtual uint8_t *map () {
+        return _ptr;
+    }
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+
+private:
+    XCAM_DEAD_COPY (RecordMemBuffer);
+
+private:
+    uint8_t    *_ptr;
+};
+
+RecordFileWriter::RecordFileWriter ()
+    : _camera_num (0)
+    , _compress (false)
+    , _pos (0)
+{
+}
+
+RecordFileWriter::~RecordFileWriter ()
+{
+    close ();
+}
+
+bool
+RecordFileWriter::set_compression (bool enable)
+{
+#if HAVE_LZ4
+    _compress = enable;
+    return true;
+#else
+    XCAM_FAIL_RETURN (
+        ERROR, !enable, false,
+        "RecordFileWriter compression needs lz4, rebuild with --enable-lz4");
+    _compress = false;
+    return true;
+#endif
+}
+
+XCamReturn
+RecordFileWriter::open (const char *name, const VideoBufferInfo *infos, uint32_t camera_num)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, name && infos && camera_num > 0 && camera_num <= XCAM_RECORD_MAX_CAMERAS,
+        XCAM_RETURN_ERROR_PARAM,
+        "RecordFileWriter open failed, invalid params (camera_num:%d)", camera_num);
+
+    close ();
+
+    RecordFileHeader header;
+    xcam_mem_clear (header);
+    header.magic = XCAM_RECORD_MAGIC;
+    header.version = XCAM_RECORD_VERSION;
+    header.camera_num = camera_num;
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        XCAM_FAIL_RETURN (
+            ERROR, infos[i].is_valid (), XCAM_RETURN_ERROR_PARAM,
+            "RecordFileWriter open failed, video info of camera %d invalid", i);
+        header.infos[i] = infos[i];
+        _infos[i] = infos[i];
+    }
+
+    XCamReturn ret = _file.open (name, "wb");
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "RecordFileWriter open %s failed", name);
+
+    _camera_num = camera_num;
+    _pos = 0;
+    _index.clear ();
+
+    ret = write_data (&header, sizeof (header));
+    if (xcam_ret_is_ok (ret))
+        ret = write_padding ();
+    if (!xcam_ret_is_ok (ret)) {
+        _file.close ();
+        _camera_num = 0;
+    }
+    return ret;
+}
+
+XCamReturn
+RecordFileWriter::write_data (const void *data, uint64_t size)
+{
+    XCamReturn ret = _file.write_file (data, size);
+    if (xcam_ret_is_ok (ret))
+        _pos += size;
+    return ret;
+}
+
+XCamReturn
+RecordFileWriter::write_padding ()
+{
+    static const uint8_t zeros[XCAM_RECORD_ALIGN] = {0};
+    uint64_t pad = record_align (_pos) - _pos;
+    return pad ? write_data (zeros, pad) : XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+RecordFileWriter::pack_image (uint32_t idx, const SmartPtr<VideoBuffer> &buf, RecordImageHeader &image)
+{
+    const VideoBufferInfo &info = _infos[idx];
+    uint32_t begins[XCAM_VIDEO_MAX_COMPONENTS], sizes[XCAM_VIDEO_MAX_COMPONENTS];
+    uint32_t count = get_planes (info, begins, sizes);
+
+    image.timestamp = buf->get_timestamp ();
+    SmartPtr<DevicePose> pose = buf->find_typed_metadata<DevicePose> ();
+    if (pose.ptr ()) {
+        image.has_pose = 1;
+        memcpy (image.orientation, pose->orientation, sizeof (image.orientation));
+        memcpy (image.translation, pose->translation, sizeof (image.translation));
+        image.confidence = pose->confidence;
+    }
+
+    if (!_compress) {
+        for (uint32_t i = 0; i < count; ++i)
+            image.plane_sizes[i] = sizes[i];
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+#if HAVE_LZ4
+    std::vector<uint8_t> &packed = _packed[idx];
+    const uint8_t *src = buf->map ();
+    XCAM_FAIL_RETURN (
+        ERROR, src, XCAM_RETURN_ERROR_MEM,
+        "RecordFileWriter map buffer of camera %d failed", idx);
+
+    size_t bound = 0;
+    for (uint32_t i = 0; i < count; ++i)
+        bound += LZ4_compressBound (sizes[i]);
+    packed.resize (bound);
+
+    size_t used = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        int ret = LZ4_compress_default (
+            (const char *) src + begins[i], (char *) packed.data () + used,
+            sizes[i], (int) (packed.size () - used));
+        // planes which don't shrink are kept raw
+        if (ret <= 0 || (uint32_t) ret >= sizes[i]) {
+            memcpy (packed.data () + used, src + begins[i], sizes[i]);
+            ret = sizes[i];
+        }
+        image.plane_sizes[i] = ret;
+        used += ret;
+    }
+    buf->unmap ();
+
+    packed.resize (used);
+    image.flags |= RecordCompressed;
+    return XCAM_RETURN_NO_ERROR;
+#else
+    XCAM_ASSERT (false);
+    return XCAM_RETURN_ERROR_PARAM;
+#endif
+}
+
+XCamReturn
+RecordFileWriter::write_frame (const VideoBufferList &bufs)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _file.is_valid (), XCAM_RETURN_ERROR_PARAM,
+        "RecordFileWriter write frame failed, file not opened");
+    XCAM_FAIL_RETURN (
+        ERROR, bufs.size () == _camera_num, XCAM_RETURN_ERROR_PARAM,
+        "RecordFileWriter write frame failed, got %d buffers for %d cameras",
+        (int) bufs.size (), _camera_num);
+
+    int64_t timestamp = bufs.front ().ptr () ? bufs.front ()->get_timestamp () : InvalidTimestamp;
+    XCAM_FAIL_RETURN (
+        ERROR, _index.empty () || timestamp > _index.back ().timestamp, XCAM_RETURN_ERROR_PARAM,
+        "RecordFileWriter write frame failed, timestamp(%" PRId64 ") not after the last one(%" PRId64 ")",
+        timestamp, _index.empty () ? InvalidTimestamp : _index.back ().timestamp);
+
+    RecordFrameHeader header;
+    xcam_mem_clear (header);
+    header.magic = XCAM_RECORD_FRAME_MAGIC;
+    header.camera_num = _camera_num;
+    header.timestamp = timestamp;
+
+    uint32_t idx = 0;
+    uint64_t offset = XCAM_RECORD_ALIGN;
+    for (VideoBufferList::const_iterator i = bufs.begin (); i != bufs.end (); ++i, ++idx) {
+        const SmartPtr<VideoBuffer> &buf = *i;
+        XCAM_FAIL_RETURN (
+            ERROR, buf.ptr () && is_same_layout (buf->get_video_info (), _infos[idx]),
+            XCAM_RETURN_ERROR_PARAM,
+            "RecordFileWriter write frame failed, buffer of camera %d doesn't match the recording", idx);
+
+        RecordImageHeader &image = header.images[idx];
+        XCamReturn ret = pack_image (idx, buf, image);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "RecordFileWriter pack image of camera %d failed", idx);
+
+        image.offset = offset;
+        uint64_t stored = 0;
+        for (uint32_t p = 0; p < XCAM_VIDEO_MAX_COMPONENTS; ++p)
+            stored += image.plane_sizes[p];
+        offset = record_align (offset + stored);
+    }
+    header.frame_size = offset;
+
+    uint64_t frame_pos = _pos;
+    XCamReturn ret = write_data (&header, sizeof (header));
+    if (xcam_ret_is_ok (ret))
+        ret = write_padding ();
+
+    idx = 0;
+    for (VideoBufferList::const_iterator i = bufs.begin (); i != bufs.end () && xcam_ret_is_ok (ret); ++i, ++idx) {
+        const SmartPtr<VideoBuffer> &buf = *i;
+        if (header.images[idx].flags & RecordCompressed) {
+            ret = write_data (_packed[idx].data (), _packed[idx].size ());
+        } else {
+            const uint8_t *src = buf->map ();
+            ret = src ? write_data (src, _infos[idx].size) : XCAM_RETURN_ERROR_MEM;
+            buf->unmap ();
+        }
+        if (xcam_ret_is_ok (ret))
+            ret = write_padding ();
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "RecordFileWriter write frame %d failed", (int) _index.size ());
+    XCAM_ASSERT (_pos == frame_pos + header.frame_size);
+
+    IndexEntry entry = {header.timestamp, frame_pos};
+    _index.push_back (entry);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+RecordFileWriter::close ()
+{
+    if (!_file.is_valid ())
+        return XCAM_RETURN_NO_ERROR;
+
+    RecordIndexFooter footer;
+    xcam_mem_clear (footer);
+    footer.magic = XCAM_RECORD_INDEX_MAGIC;
+    footer.frame_count = _index.size ();
+    footer.index_offset = _pos;
+
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (!_index.empty ())
+        ret = write_data (_index.data (), _index.size () * sizeof (IndexEntry));
+    if (xcam_ret_is_ok (ret))
+        ret = write_data (&footer, sizeof (footer));
+    if (!xcam_ret_is_ok (ret)) {
+        XCAM_LOG_WARNING (
+            "RecordFileWriter write index of %s failed, readers fall back to scanning",
+            XCAM_STR (_file.get_file_name ()));
+    }
+
+    _file.close ();
+    _camera_num = 0;
+    _index.clear ();
+    for (uint32_t i = 0; i < XCAM_RECORD_MAX_CAMERAS; ++i)
+        std::vector<uint8_t> ().swap (_packed[i]);
+    return ret;
+}
+
+RecordFileReader::RecordFileReader ()
+    : _camera_num (0)
+{
+}
+
+RecordFileReader::~RecordFileReader ()
+{
+    close ();
+}
+
+XCamReturn
+RecordFileReader::open (const char *name)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, name, XCAM_RETURN_ERROR_PARAM,
+        "RecordFileReader open failed, file name is empty");
+
+    close ();
+
+    int fd = ::open (name, O_RDONLY | O_CLOEXEC);
+    XCAM_FAIL_RETURN (
+        ERROR, fd >= 0, XCAM_RETURN_ERROR_FILE,
+        "RecordFileReader open %s failed, %s", name, strerror (errno));
+
+    struct stat st;
+    void *ptr = MAP_FAILED;
+    if (fstat (fd, &st) == 0 && (uint64_t) st.st_size >= XCAM_RECORD_ALIGN)
+        ptr = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close (fd);
+    XCAM_FAIL_RETURN (
+        ERROR, ptr != MAP_FAILED, XCAM_RETURN_ERROR_FILE,
+        "RecordFileReader map %s failed", name);
+
+    SmartPtr<RecordMapping> mapping = new RecordMapping ((uint8_t *) ptr, st.st_size);
+    const RecordFileHeader *header = (const RecordFileHeader *) mapping->get_ptr (0);
+    XCAM_FAIL_RETURN (
+        ERROR,
+        header->magic == XCAM_RECORD_MAGIC && header->version == XCAM_RECORD_VERSION &&
+        header->camera_num > 0 && header->camera_num <= XCAM_RECORD_MAX_CAMERAS,
+        XCAM_RETURN_ERROR_FILE,
+        "RecordFileReader %s is not a recording", name);
+
+    for (uint32_t i = 0; i < header->camera_num; ++i) {
+        _infos[i].fill (header->infos[i]);
+    }
+    _camera_num = header->camera_num;
+    _mapping = mapping;
+
+    if (!load_index ()) {
+        XCAM_LOG_WARNING ("RecordFileReader %s has no valid index, scanning frames", name);
+        if (!scan_frames ()) {
+            close ();
+            XCAM_LOG_ERROR ("RecordFileReader %s scan frames failed", name);
+            return XCAM_RETURN_ERROR_FILE;
+        }
+    }
+
+    XCAM_LOG_DEBUG ("RecordFileReader %s opened, %d cameras %d frames", name, _camera_num, get_frame_count ());
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+RecordFileReader::close ()
+{
+    _mapping.release ();
+    _camera_num = 0;
+    _index.clear ();
+}
+
+bool
+RecordFileReader::load_index ()
+{
+    uint64_t size = _mapping->get_size ();
+    if (size < XCAM_RECORD_ALIGN + sizeof (RecordIndexFooter))
+        return false;
+
+    RecordIndexFooter footer;
+    memcpy (&footer, _mapping->get_ptr (size - sizeof (footer)), sizeof (footer));
+    if (footer.magic != XCAM_RECORD_INDEX_MAGIC ||
+            footer.frame_count > (size - sizeof (footer)) / sizeof (IndexEntry) ||
+            footer.index_offset + footer.frame_count * sizeof (IndexEntry) + sizeof (footer) != size)
+        return false;
+
+    std::vector<IndexEntry> index (footer.frame_count);
+    if (footer.frame_count)
+        memcpy (index.data (), _mapping->get_ptr (footer.index_offset), footer.frame_count * sizeof (IndexEntry));
+
+    // frames lie between the file header and the index, any entry pointing elsewhere drops the index
+    uint64_t end = footer.index_offset;
+    for (uint32_t i = 0; i < index.size (); ++i) {
+        const IndexEntry &entry = index[i];
+        if (entry.offset < XCAM_RECORD_ALIGN || entry.offset > end ||
+                end - entry.offset < sizeof (RecordFrameHeader))
+            return false;
+
+        const RecordFrameHeader *header = (const RecordFrameHeader *) _mapping->get_ptr (entry.offset);
+        if (header->magic != XCAM_RECORD_FRAME_MAGIC || header->camera_num != _camera_num ||
+                header->frame_size < XCAM_RECORD_ALIGN || header->frame_size > end - entry.offset ||
+                (i > 0 && entry.timestamp <= index[i - 1].timestamp))
+            return false;
+    }
+
+    _index.swap (index);
+    return true;
+}
+
+bool
+RecordFileReader::scan_frames ()
+{
+    uint64_t size = _mapping->get_size ();
+    uint64_t pos = XCAM_RECORD_ALIGN;
+
+    _index.clear ();
+    // a recording cut short by a crash keeps its complete frames
+    while (pos + sizeof (RecordFrameHeader) <= size) {
+        const RecordFrameHeader *header = (const RecordFrameHeader *) _mapping->get_ptr (pos);
+        if (header->magic != XCAM_RECORD_FRAME_MAGIC || header->camera_num != _camera_num ||
+                header->frame_size < XCAM_RECORD_ALIGN || header->frame_size > size - pos)
+            break;
+
+        IndexEntry entry = {header->timestamp, pos};
+        _index.push_back (entry);
+        pos += header->frame_size;
+    }
+    return true;
+}
+
+int64_t
+RecordFileReader::get_frame_timestamp (uint32_t index) const
+{
+    XCAM_FAIL_RETURN (
+        ERROR, index < _index.size (), InvalidTimestamp,
+        "RecordFileReader frame index %d out of range (%d)", index, get_frame_count ());
+    return _index[index].timestamp;
+}
+
+XCamReturn
+RecordFileReader::find_frame (int64_t timestamp, uint32_t &index) const
+{
+    uint32_t begin = 0, end = _index.size ();
+    while (begin < end) {
+        uint32_t mid = begin + (end - begin) / 2;
+        if (_index[mid].timestamp < timestamp)
+            begin = mid + 1;
+        else
+            end = mid;
+    }
+    if (begin == _index.size ())
+        return XCAM_RETURN_BYPASS;
+
+    index = begin;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+RecordFileReader::read_frame (uint32_t index, VideoBufferList &bufs) const
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _mapping.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "RecordFileReader read frame failed, file not opened");
+    XCAM_FAIL_RETURN (
+        ERROR, index < _index.size (), XCAM_RETURN_ERROR_PARAM,
+        "RecordFileReader frame index %d out of range (%d)", index, get_frame_count ());
+    XCAM_FAIL_RETURN (
+        ERROR, bufs.empty () || bufs.size () == _camera_num, XCAM_RETURN_ERROR_PARAM,
+        "RecordFileReader read frame failed, got %d buffers for %d cameras",
+        (int) bufs.size (), _camera_num);
+
+    uint64_t frame_pos = _index[index].offset;
+    const RecordFrameHeader *header = (const RecordFrameHeader *) _mapping->get_ptr (frame_pos);
+    XCAM_FAIL_RETURN (
+        ERROR,
+        header->magic == XCAM_RECORD_FRAME_MAGIC && header->camera_num == _camera_num &&
+        header->frame_size <= _mapping->get_size () - frame_pos,
+        XCAM_RETURN_ERROR_FILE,
+        "RecordFileReader frame %d is corrupted", index);
+
+    bool given = !bufs.empty ();
+    VideoBufferList::iterator given_buf = bufs.begin ();
+    VideoBufferList out_bufs;
+
+    for (uint32_t idx = 0; idx < _camera_num; ++idx) {
+        const RecordImageHeader &image = header->images[idx];
+        const VideoBufferInfo &info = _infos[idx];
+        const uint8_t *src = _mapping->get_ptr (frame_pos + image.offset);
+        bool compressed = image.flags & RecordCompressed;
+
+        uint32_t begins[XCAM_VIDEO_MAX_COMPONENTS], sizes[XCAM_VIDEO_MAX_COMPONENTS];
+        uint32_t count = get_planes (info, begins, sizes);
+        uint64_t stored = 0;
+        bool valid = true;
+        for (uint32_t p = 0; p < count; ++p) {
+            stored += image.plane_sizes[p];
+            valid = valid && (compressed ? image.plane_sizes[p] <= sizes[p] : image.plane_sizes[p] == sizes[p]);
+        }
+        XCAM_FAIL_RETURN (
+            ERROR,
+            valid && image.offset <= header->frame_size && stored <= header->frame_size - image.offset,
+            XCAM_RETURN_ERROR_FILE,
+            "RecordFileReader frame %d camera %d is corrupted", index, idx);
+
+        SmartPtr<VideoBuffer> buf;
+        if (given) {
+            buf = *given_buf++;
+            XCAM_FAIL_RETURN (
+                ERROR, buf.ptr () && is_same_layout (buf->get_video_info (), info),
+                XCAM_RETURN_ERROR_PARAM,
+                "RecordFileReader buffer of camera %d doesn't match the recording", idx);
+        } else if (!compressed) {
+            buf = new RecordMappedBuffer (info, _mapping, src);
+        } else {
+            SmartPtr<RecordMemBuffer> mem = new RecordMemBuffer (info);
+            XCAM_FAIL_RETURN (
+                ERROR, mem->is_valid (), XCAM_RETURN_ERROR_MEM,
+                "RecordFileReader alloc buffer of camera %d failed", idx);
+            buf = mem;
+        }
+
+        if (given || compressed) {
+            uint8_t *dest = buf->map ();
+            XCAM_FAIL_RETURN (
+                ERROR, dest, XCAM_RETURN_ERROR_MEM,
+                "RecordFileReader map buffer of camera %d failed", idx);
+
+            for (uint32_t p = 0; p < count; ++p) {
+                if (image.plane_sizes[p] == sizes[p]) {
+                    memcpy (dest + begins[p], src, sizes[p]);
+                } else {
+#if HAVE_LZ4
+                    int ret = LZ4_decompress_safe (
+                        (const char *) src, (char *) dest + begins[p], image.plane_sizes[p], sizes[p]);
+                    XCAM_FAIL_RETURN (
+                        ERROR, ret == (int) sizes[p], XCAM_RETURN_ERROR_FILE,
+                        "RecordFileReader decode frame %d camera %d plane %d failed", index, idx, p);
+#else
+                    XCAM_LOG_ERROR ("RecordFileReader compressed recordings need lz4, rebuild with --enable-lz4");
+                    return XCAM_RETURN_ERROR_PARAM;
+#endif
+                }
+                src += image.plane_sizes[p];
+            }
+            buf->unmap ();
+        }
+
+        buf->set_timestamp (image.timestamp);
+        if (image.has_pose) {
+            SmartPtr<DevicePose> pose = new DevicePose ();
+            memcpy (pose->orientation, image.orientation, sizeof (pose->orientation));
+            memcpy (pose->translation, image.translation, sizeof (pose->translation));
+            pose->confidence = image.confidence;
+            pose->timestamp = image.timestamp;
+            buf->add_metadata (pose);
+        }
+        if (!given)
+            out_bufs.push_back (buf);
+    }
+
+    if (!given)
+        bufs.swap (out_bufs);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
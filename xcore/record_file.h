@@ -0,0 +1,142 @@
+/*
+ * record_file.h - indexed multi-camera recording file
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_RECORD_FILE_H
+#define XCAM_RECORD_FILE_H
+
+#include <xcam_std.h>
+#include <file.h>
+#include <video_buffer.h>
+#include <vector>
+
+#define XCAM_RECORD_MAX_CAMERAS 8
+
+namespace XCam {
+
+class RecordMapping;
+struct RecordImageHeader;
+
+/*
+ * A recording holds frames of synchronized cameras, one image per camera with its
+ * timestamp and DevicePose metadata. Images start on page boundaries so readers map
+ * them in place, an index of frame timestamps and offsets closes the file.
+ * Layout and byte order are the writer's native ones.
+ */
+class RecordFileWriter
+{
+public:
+    explicit RecordFileWriter ();
+    ~RecordFileWriter ();
+
+    // planes are LZ4 compressed one by one, only with lz4 enabled at build time
+    bool set_compression (bool enable);
+
+    XCamReturn open (const char *name, const VideoBufferInfo *infos, uint32_t camera_num);
+    /*
+     * one buffer per camera in open order, the first buffer's timestamp is the frame's,
+     * frame timestamps must increase as readers seek by timestamp
+     */
+    XCamReturn write_frame (const VideoBufferList &bufs);
+    // writes the index, a recording without one is still readable by scanning
+    XCamReturn close ();
+
+    uint32_t get_frame_count () const {
+        return _index.size ();
+    }
+
+private:
+    XCamReturn write_data (const void *data, uint64_t size);
+    XCamReturn write_padding ();
+    XCamReturn pack_image (uint32_t idx, const SmartPtr<VideoBuffer> &buf, RecordImageHeader &image);
+
+    XCAM_DEAD_COPY (RecordFileWriter);
+
+private:
+    struct IndexEntry {
+        int64_t   timestamp;
+        uint64_t  offset;
+    };
+
+    File                       _file;
+    uint32_t                   _camera_num;
+    VideoBufferInfo            _infos[XCAM_RECORD_MAX_CAMERAS];
+    bool                       _compress;
+    uint64_t                   _pos;
+    std::vector<IndexEntry>    _index;
+    std::vector<uint8_t>       _packed[XCAM_RECORD_MAX_CAMERAS];
+};
+
+/*
+ * Reads a recording through one read-only mapping. Frames are addressed by index,
+ * read_frame is thread safe so frame ranges may be shared out across threads, and
+ * processes may open the same file.
+ */
+class RecordFileReader
+{
+public:
+    explicit RecordFileReader ();
+    ~RecordFileReader ();
+
+    XCamReturn open (const char *name);
+    void close ();
+
+    uint32_t get_camera_num () const {
+        return _camera_num;
+    }
+    const VideoBufferInfo &get_video_info (uint32_t idx) const {
+        XCAM_ASSERT (idx < _camera_num);
+        return _infos[idx];
+    }
+    uint32_t get_frame_count () const {
+        return _index.size ();
+    }
+    int64_t get_frame_timestamp (uint32_t index) const;
+
+    // first frame at or after @timestamp
+    XCamReturn find_frame (int64_t timestamp, uint32_t &index) const;
+
+    /*
+     * @bufs empty, gets one buffer per camera: uncompressed images map the file in
+     * place and must not be written, compressed ones are decoded into new memory.
+     * @bufs given, one per camera, images are copied or decoded into them.
+     */
+    XCamReturn read_frame (uint32_t index, VideoBufferList &bufs) const;
+
+private:
+    bool load_index ();
+    bool scan_frames ();
+
+    XCAM_DEAD_COPY (RecordFileReader);
+
+private:
+    struct IndexEntry {
+        int64_t   timestamp;
+        uint64_t  offset;
+    };
+
+    SmartPtr<RecordMapping>    _mapping;
+    uint32_t                   _camera_num;
+    VideoBufferInfo            _infos[XCAM_RECORD_MAX_CAMERAS];
+    std::vector<IndexEntry>    _index;
+};
+
+}
+
+#endif //XCAM_RECORD_FILE_H
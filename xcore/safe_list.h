@@ -48,6 +48,9 @@ public:
     */
     inline ObjPtr pop (int32_t timeout = -1);
     inline bool push (const ObjPtr &obj);
+    inline bool push (ObjPtr &&obj);
+    // insert @obj ahead of the trailing objects which @before (obj, queued) holds for
+    template<typename Before> inline bool push_ordered (const ObjPtr &obj, Before before);
     inline bool erase (const ObjPtr &obj);
     inline ObjPtr front ();
     uint32_t size () {
@@ -106,7 +109,7 @@ SafeList<OBj>::pop (int32_t timeout)
         return NULL;
     }
 
-    SafeList<OBj>::ObjPtr obj = *_obj_list.begin ();
+    SafeList<OBj>::ObjPtr obj = std::move (*_obj_list.begin ());
     _obj_list.erase (_obj_list.begin ());
     return obj;
 }
@@ -121,6 +124,35 @@ SafeList<OBj>::push (const SafeList<OBj>::ObjPtr &obj)
     return true;
 }
 
+template<class OBj>
+bool
+SafeList<OBj>::push (SafeList<OBj>::ObjPtr &&obj)
+{
+    SmartLock lock (_mutex);
+    _obj_list.push_back (std::move (obj));
+    _new_obj_cond.signal ();
+    return true;
+}
+
+template<class OBj>
+template<typename Before>
+bool
+SafeList<OBj>::push_ordered (const SafeList<OBj>::ObjPtr &obj, Before before)
+{
+    SmartLock lock (_mutex);
+    SafeList<OBj>::ObjIter pos = _obj_list.end ();
+    while (pos != _obj_list.begin ()) {
+        SafeList<OBj>::ObjIter prev = pos;
+        --prev;
+        if (!before (obj, *prev))
+            break;
+        pos = prev;
+    }
+    _obj_list.insert (pos, obj);
+    _new_obj_cond.signal ();
+    return true;
+}
+
 template<class OBj>
 bool
 SafeList<OBj>::erase (const SafeList<OBj>::ObjPtr &obj)
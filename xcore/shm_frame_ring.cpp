@@ -0,0 +1,667 @@
+/*
+ * shm_frame_ring.cpp - frame ring in shared memory for zero-copy consumers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "shm_frame_ring.h"
+#include "xcam_metrics.h"
+#include "xcam_utils.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+#define XCAM_SHM_RING_MAGIC 0x52465358  // "XSFR"
+#define XCAM_SHM_RING_VERSION 2
+
+namespace XCam {
+
+// header words are shared between processes, they must not fall back to locks
+static_assert (ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "shm ring needs lock-free atomics");
+
+enum ShmSlotState {
+    ShmSlotFree = 0,
+    ShmSlotPublished,
+};
+
+struct ShmSlotHeader {
+    std::atomic<uint32_t>   state;
+    std::atomic<uint32_t>   readers;
+    std::atomic<uint64_t>   seq;
+    std::atomic<int64_t>    timestamp;
+};
+
+// one per attached reader, pins has a bit for each slot the reader holds
+struct ShmReaderEntry {
+    std::atomic<int32_t>    pid;
+    std::atomic<uint32_t>   pins;
+};
+
+static_assert (XCAM_SHM_RING_MAX_SLOTS <= 32, "shm ring reader pins need a bit per slot");
+
+struct ShmRingHeader {
+    std::atomic<uint32_t>   magic;
+    uint32_t                version;
+    uint32_t                slot_count;
+    uint32_t                header_size;
+    uint64_t                slot_size;
+    XCamVideoBufferInfo     info;
+    std::atomic<uint64_t>   last_seq;
+    // bumped on every publish and on close, readers sleep on it
+    std::atomic<uint32_t>   futex;
+    std::atomic<uint32_t>   closed;
+    ShmSlotHeader           slots[XCAM_SHM_RING_MAX_SLOTS];
+    ShmReaderEntry          readers[XCAM_SHM_RING_MAX_READERS];
+};
+
+static inline uint32_t
+shm_header_size ()
+{
+    uint32_t page = (uint32_t) sysconf (_SC_PAGESIZE);
+    return XCAM_ALIGN_UP ((uint32_t) sizeof (ShmRingHeader), page);
+}
+
+class ShmRegion
+{
+public:
+    explicit ShmRegion (int fd)
+        : _fd (fd)
+        , _header (NULL)
+        , _data (NULL)
+        , _data_len (0)
+        , _reader (NULL)
+    {}
+    ~ShmRegion () {
+        // frames hold the region, none is pinned any more
+        if (_reader)
+            _reader->pid.store (0, std::memory_order_release);
+        if (_data)
+            munmap (_data, _data_len);
+        if (_header)
+            munmap (_header, shm_header_size ());
+        if (_fd >= 0)
+            ::close (_fd);
+    }
+
+    bool map_header () {
+        void *ptr = mmap (NULL, shm_header_size (), PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        XCAM_FAIL_RETURN (ERROR, ptr != MAP_FAILED, false, "shm ring map header failed");
+        _header = (ShmRingHeader *) ptr;
+        return true;
+    }
+    bool map_data (bool writable) {
+        size_t len = _header->slot_size * _header->slot_count;
+        int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        void *ptr = mmap (NULL, len, prot, MAP_SHARED, _fd, _header->header_size);
+        XCAM_FAIL_RETURN (ERROR, ptr != MAP_FAILED, false, "shm ring map slots failed");
+        _data = (uint8_t *) ptr;
+        _data_len = len;
+        return true;
+    }
+
+    // entries are only freed by their reader, or by the producer once the reader is dead
+    bool attach_reader () {
+        int32_t pid = (int32_t) getpid ();
+        for (uint32_t i = 0; i < XCAM_SHM_RING_MAX_READERS; ++i) {
+            ShmReaderEntry &entry = _header->readers[i];
+            int32_t free_pid = 0;
+            if (entry.pid.compare_exchange_strong (free_pid, pid, std::memory_order_acq_rel)) {
+                entry.pins.store (0, std::memory_order_relaxed);
+                _reader = &entry;
+                return true;
+            }
+        }
+        return false;
+    }
+    void pin_slot (uint32_t index) {
+        if (_reader)
+            _reader->pins.fetch_or (1u << index, std::memory_order_release);
+    }
+    void unpin_slot (uint32_t index) {
+        // pin record first, a dead reader may leak a slot but never drop it twice
+        if (_reader)
+            _reader->pins.fetch_and (~(1u << index), std::memory_order_release);
+        slot (index).readers.fetch_sub (1, std::memory_order_release);
+    }
+
+    int get_fd () const {
+        return _fd;
+    }
+    ShmRingHeader *header () const {
+        return _header;
+    }
+    ShmSlotHeader &slot (uint32_t index) const {
+        XCAM_ASSERT (index < _header->slot_count);
+        return _header->slots[index];
+    }
+    uint8_t *slot_data (uint32_t index) const {
+        XCAM_ASSERT (index < _header->slot_count);
+        return _data + _header->slot_size * index;
+    }
+
+private:
+    XCAM_DEAD_COPY (ShmRegion);
+
+private:
+    int              _fd;
+    ShmRingHeader   *_header;
+    uint8_t         *_data;
+    size_t           _data_len;
+    ShmReaderEntry  *_reader;
+};
+
+class ShmSlotData
+    : public BufferData
+{
+public:
+    explicit ShmSlotData (const SmartPtr<ShmRegion> &region, uint32_t slot)
+        : _region (region)
+        , _slot (slot)
+    {}
+
+    const SmartPtr<ShmRegion> &get_region () const {
+        return _region;
+    }
+    uint32_t get_slot () const {
+        return _slot;
+    }
+
+    //derived from BufferData
+    virtual uint8_t *map () {
+        return _region->slot_data (_slot);
+    }
+    virtual bool unmap () {
+        return true;
+    }
+
+private:
+    SmartPtr<ShmRegion>  _region;
+    uint32_t             _slot;
+};
+
+class ShmSlotBuffer
+    : public BufferProxy
+{
+public:
+    explicit ShmSlotBuffer (const VideoBufferInfo &info, const SmartPtr<BufferData> &data)
+        : BufferProxy (info, data)
+    {}
+
+    ShmSlotData *get_slot_data () const {
+        return get_buffer_data ().static_cast_ptr<ShmSlotData> ().ptr ();
+    }
+};
+
+// reader side frame, keeps its slot from reuse until destroyed
+class ShmFrameBuffer
+    : public VideoBuffer
+{
+public:
+    explicit ShmFrameBuffer (const VideoBufferInfo &info, const SmartPtr<ShmRegion> &region, uint32_t slot)
+        : VideoBuffer (info)
+        , _region (region)
+        , _slot (slot)
+    {}
+    ~ShmFrameBuffer () {
+        _region->unpin_slot (_slot);
+    }
+
+    //derived from VideoBuffer
+    virtual uint8_t *map () {
+        return _region->slot_data (_slot);
+    }
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+
+private:
+    XCAM_DEAD_COPY (ShmFrameBuffer);
+
+private:
+    SmartPtr<ShmRegion>  _region;
+    uint32_t             _slot;
+};
+
+ShmFrameRing::ShmFrameRing (uint32_t slot_count, const char *name)
+    : _name (NULL)
+    , _slot_count (XCAM_CLAMP (slot_count, 2, XCAM_SHM_RING_MAX_SLOTS))
+    , _next_slot (0)
+    , _hold_count (_slot_count / 2)
+    , _seq (0)
+    , _closed (false)
+{
+    if (slot_count != _slot_count) {
+        XCAM_LOG_WARNING ("shm ring slot count %d clamped to %d", slot_count, _slot_count);
+    }
+    if (name)
+        _name = strndup (name, XCAM_MAX_STR_SIZE);
+}
+
+ShmFrameRing::~ShmFrameRing ()
+{
+    close ();
+    if (_name) {
+        if (_region.ptr ())
+            shm_unlink (_name);
+        xcam_free (_name);
+    }
+}
+
+bool
+ShmFrameRing::set_hold_count (uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, count > 0 && count < _slot_count, false,
+        "shm ring hold count %d out of range (1 ~ %d)", count, _slot_count - 1);
+
+    SmartLock lock (_publish_mutex);
+    _hold_count = count;
+    return true;
+}
+
+int
+ShmFrameRing::get_fd () const
+{
+    return _region.ptr () ? _region->get_fd () : -1;
+}
+
+bool
+ShmFrameRing::create_region (const VideoBufferInfo &info)
+{
+    int fd = -1;
+    if (_name) {
+        // a stale object of a crashed producer must not be reused
+        shm_unlink (_name);
+        fd = shm_open (_name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    } else {
+        fd = (int) syscall (SYS_memfd_create, "xcam-frame-ring", MFD_CLOEXEC);
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, fd >= 0, false,
+        "shm ring create %s failed, %s", XCAM_STR (_name), strerror (errno));
+
+    SmartPtr<ShmRegion> region = new ShmRegion (fd);
+    uint32_t page = (uint32_t) sysconf (_SC_PAGESIZE);
+    uint32_t header_size = shm_header_size ();
+    uint64_t slot_size = XCAM_ALIGN_UP (info.size, page);
+
+    XCAM_FAIL_RETURN (
+        ERROR, ftruncate (fd, header_size + slot_size * _slot_count) == 0, false,
+        "shm ring resize to %d slots of %" PRIu64 " bytes failed", _slot_count, slot_size);
+    XCAM_FAIL_RETURN (ERROR, region->map_header (), false, "shm ring create failed");
+
+    ShmRingHeader *header = region->header ();
+    header->version = XCAM_SHM_RING_VERSION;
+    header->slot_count = _slot_count;
+    header->header_size = header_size;
+    header->slot_size = slot_size;
+    header->info = info;
+    XCAM_FAIL_RETURN (ERROR, region->map_data (true), false, "shm ring create failed");
+
+    // readers check the magic before anything else in the header
+    header->magic.store (XCAM_SHM_RING_MAGIC, std::memory_order_release);
+    _region = region;
+
+    XCAM_LOG_INFO (
+        "shm ring %s created, %d slots of %dx%d",
+        XCAM_STR (_name), _slot_count, info.width, info.height);
+    return true;
+}
+
+bool
+ShmFrameRing::fixate_video_info (VideoBufferInfo &info)
+{
+    if (!_region.ptr ())
+        return true;
+
+    // readers already took the layout from the header
+    const XCamVideoBufferInfo &shared = _region->header ()->info;
+    XCAM_FAIL_RETURN (
+        ERROR,
+        shared.format == info.format && shared.width == info.width &&
+        shared.height == info.height && shared.size == info.size,
+        false,
+        "shm ring %s can't change video info once created", XCAM_STR (_name));
+    return true;
+}
+
+SmartPtr<BufferData>
+ShmFrameRing::allocate_data (const VideoBufferInfo &buffer_info, const void *in_data)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !in_data, NULL,
+        "shm ring %s doesn't take external data", XCAM_STR (_name));
+
+    if (!_region.ptr () && !create_region (buffer_info))
+        return NULL;
+
+    XCAM_FAIL_RETURN (
+        WARNING, _next_slot < _slot_count, NULL,
+        "shm ring %s has no slot left, all %d allocated", XCAM_STR (_name), _slot_count);
+
+    return new ShmSlotData (_region, _next_slot++);
+}
+
+SmartPtr<BufferProxy>
+ShmFrameRing::create_buffer_from_data (SmartPtr<BufferData> &data)
+{
+    XCAM_ASSERT (data.ptr ());
+    return new ShmSlotBuffer (get_video_info (), data);
+}
+
+XCamReturn
+ShmFrameRing::publish (const SmartPtr<VideoBuffer> &buf)
+{
+    SmartPtr<ShmSlotBuffer> slot_buf = buf.dynamic_cast_ptr<ShmSlotBuffer> ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        slot_buf.ptr () && slot_buf->get_slot_data ()->get_region ().ptr () == _region.ptr (),
+        XCAM_RETURN_ERROR_PARAM,
+        "shm ring %s publish failed, buffer not from this ring", XCAM_STR (_name));
+
+    SmartLock lock (_publish_mutex);
+    XCAM_FAIL_RETURN (
+        WARNING, !_closed, XCAM_RETURN_ERROR_PARAM,
+        "shm ring %s publish failed, ring closed", XCAM_STR (_name));
+
+    ShmRingHeader *header = _region->header ();
+    uint32_t index = slot_buf->get_slot_data ()->get_slot ();
+    ShmSlotHeader &slot = _region->slot (index);
+    XCAM_FAIL_RETURN (
+        ERROR, slot.state.load (std::memory_order_relaxed) == ShmSlotFree, XCAM_RETURN_ERROR_PARAM,
+        "shm ring %s publish failed, slot %d published twice", XCAM_STR (_name), index);
+
+    // a retired slot may still be pinned, it only leaves _retiring at readers == 0
+    XCAM_ASSERT (slot.readers.load (std::memory_order_relaxed) == 0);
+
+    slot.seq.store (++_seq, std::memory_order_relaxed);
+    slot.timestamp.store (buf->get_timestamp (), std::memory_order_relaxed);
+    slot.state.store (ShmSlotPublished, std::memory_order_seq_cst);
+    header->last_seq.store (_seq, std::memory_order_release);
+
+    _held.push_back (slot_buf);
+    retire_slots ();
+
+    header->futex.fetch_add (1, std::memory_order_release);
+    shared_futex_wake (header->futex);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+ShmFrameRing::reclaim_slots ()
+{
+    bool pinned = false;
+    for (SlotBufferList::iterator i = _retiring.begin (); i != _retiring.end (); ) {
+        ShmSlotHeader &slot = _region->slot ((*i)->get_slot_data ()->get_slot ());
+        if (slot.readers.load (std::memory_order_seq_cst) == 0) {
+            i = _retiring.erase (i); // back to the pool
+        } else {
+            pinned = true;
+            ++i;
+        }
+    }
+    if (!pinned)
+        return;
+
+    // slots stay pinned as long as a reader reads slowly, or forever if it died
+    clear_dead_readers ();
+    for (SlotBufferList::iterator i = _retiring.begin (); i != _retiring.end (); ) {
+        ShmSlotHeader &slot = _region->slot ((*i)->get_slot_data ()->get_slot ());
+        if (slot.readers.load (std::memory_order_seq_cst) == 0)
+            i = _retiring.erase (i);
+        else
+            ++i;
+    }
+}
+
+void
+ShmFrameRing::clear_dead_readers ()
+{
+    ShmRingHeader *header = _region->header ();
+    for (uint32_t i = 0; i < XCAM_SHM_RING_MAX_READERS; ++i) {
+        ShmReaderEntry &entry = header->readers[i];
+        int32_t pid = entry.pid.load (std::memory_order_acquire);
+        if (!pid || kill ((pid_t) pid, 0) == 0 || errno != ESRCH)
+            continue;
+
+        // nobody else takes the entry until its pid is cleared
+        uint32_t pins = entry.pins.exchange (0, std::memory_order_acq_rel);
+        for (uint32_t index = 0; index < _slot_count; ++index) {
+            if (pins & (1u << index))
+                _region->slot (index).readers.fetch_sub (1, std::memory_order_release);
+        }
+        entry.pid.store (0, std::memory_order_release);
+
+        XCAM_LOG_WARNING (
+            "shm ring %s cleared pins(0x%x) of dead reader(pid:%d)",
+            XCAM_STR (_name), pins, pid);
+    }
+}
+
+void
+ShmFrameRing::retire_slots ()
+{
+    reclaim_slots ();
+
+    // past the hold count, and as long as the producer has no free slot left to fill;
+    // buffers it still keeps and slots readers pin leave fewer frames held
+    while (!_held.empty () && (_held.size () > _hold_count || !has_free_buffers ())) {
+        SmartPtr<ShmSlotBuffer> oldest = _held.front ();
+        _held.pop_front ();
+        // pairs with the reader's readers++ then state check, one of the two sees the other
+        _region->slot (oldest->get_slot_data ()->get_slot ()).state.store (
+            ShmSlotFree, std::memory_order_seq_cst);
+        _retiring.push_back (oldest);
+        reclaim_slots ();
+    }
+}
+
+bool
+ShmFrameRing::reclaim_buffers ()
+{
+    // publish alone never reclaims if the producer waits for a slot readers still pin
+    SmartLock lock (_publish_mutex);
+    if (_closed || !_region.ptr ())
+        return false;
+
+    retire_slots ();
+    return !_retiring.empty ();
+}
+
+uint64_t
+ShmFrameRing::get_published_count ()
+{
+    SmartLock lock (_publish_mutex);
+    return _seq;
+}
+
+void
+ShmFrameRing::close ()
+{
+    {
+        SmartLock lock (_publish_mutex);
+        if (_closed)
+            return;
+        _closed = true;
+
+        if (_region.ptr ()) {
+            ShmRingHeader *header = _region->header ();
+            header->closed.store (1, std::memory_order_release);
+            header->futex.fetch_add (1, std::memory_order_release);
+            shared_futex_wake (header->futex);
+        }
+        _held.clear ();
+        _retiring.clear ();
+    }
+    stop ();
+}
+
+ShmFrameReader::ShmFrameReader ()
+    : _last_seq (0)
+    , _dropped (0)
+{
+}
+
+ShmFrameReader::~ShmFrameReader ()
+{
+    close ();
+}
+
+XCamReturn
+ShmFrameReader::open (const char *name)
+{
+    XCAM_ASSERT (name);
+    int fd = shm_open (name, O_RDWR | O_CLOEXEC, 0);
+    XCAM_FAIL_RETURN (
+        ERROR, fd >= 0, XCAM_RETURN_ERROR_FILE,
+        "shm reader open %s failed, %s", name, strerror (errno));
+
+    XCamReturn ret = open (fd);
+    ::close (fd);
+    return ret;
+}
+
+XCamReturn
+ShmFrameReader::open (int fd)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_region.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "shm reader already opened");
+
+    int dup_fd = fcntl (fd, F_DUPFD_CLOEXEC, 0);
+    XCAM_FAIL_RETURN (
+        ERROR, dup_fd >= 0, XCAM_RETURN_ERROR_FILE,
+        "shm reader dup fd %d failed, %s", fd, strerror (errno));
+    SmartPtr<ShmRegion> region = new ShmRegion (dup_fd);
+
+    struct stat st;
+    uint32_t header_size = shm_header_size ();
+    XCAM_FAIL_RETURN (
+        ERROR, fstat (dup_fd, &st) == 0 && (uint64_t) st.st_size >= header_size,
+        XCAM_RETURN_ERROR_FILE, "shm reader fd %d is not a frame ring", fd);
+    XCAM_FAIL_RETURN (ERROR, region->map_header (), XCAM_RETURN_ERROR_MEM, "shm reader open failed");
+
+    const ShmRingHeader *header = region->header ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        header->magic.load (std::memory_order_acquire) == XCAM_SHM_RING_MAGIC &&
+        header->version == XCAM_SHM_RING_VERSION && header->header_size == header_size &&
+        header->slot_count <= XCAM_SHM_RING_MAX_SLOTS &&
+        (uint64_t) st.st_size >= header_size + header->slot_size * header->slot_count,
+        XCAM_RETURN_ERROR_FILE,
+        "shm reader fd %d is not a frame ring or not ready", fd);
+    XCAM_FAIL_RETURN (ERROR, region->map_data (false), XCAM_RETURN_ERROR_MEM, "shm reader open failed");
+    if (!region->attach_reader ()) {
+        XCAM_LOG_WARNING (
+            "shm reader fd %d untracked, more than %d readers, frames pinned at exit leak",
+            fd, XCAM_SHM_RING_MAX_READERS);
+    }
+
+    XCamVideoBufferInfo &info = _info;
+    info = header->info;
+    // frames published before open are not dropped ones
+    _last_seq = 0;
+    _dropped = 0;
+    _region = region;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+ShmFrameReader::close ()
+{
+    _region.release ();
+}
+
+bool
+ShmFrameReader::pin_next_frame (SmartPtr<VideoBuffer> &buf)
+{
+    ShmRingHeader *header = _region->header ();
+
+    while (true) {
+        uint32_t found = header->slot_count;
+        uint64_t found_seq = 0;
+        for (uint32_t i = 0; i < header->slot_count; ++i) {
+            ShmSlotHeader &slot = header->slots[i];
+            if (slot.state.load (std::memory_order_acquire) != ShmSlotPublished)
+                continue;
+            uint64_t seq = slot.seq.load (std::memory_order_relaxed);
+            if (seq > _last_seq && (!found_seq || seq < found_seq)) {
+                found = i;
+                found_seq = seq;
+            }
+        }
+        if (!found_seq)
+            return false;
+
+        ShmSlotHeader &slot = header->slots[found];
+        slot.readers.fetch_add (1, std::memory_order_seq_cst);
+        if (slot.state.load (std::memory_order_seq_cst) != ShmSlotPublished ||
+                slot.seq.load (std::memory_order_acquire) != found_seq) {
+            // retired under us, the producer may reuse it
+            slot.readers.fetch_sub (1, std::memory_order_release);
+            continue;
+        }
+
+        _region->pin_slot (found);
+        if (_last_seq)
+            _dropped += found_seq - _last_seq - 1;
+        _last_seq = found_seq;
+
+        buf = new ShmFrameBuffer (_info, _region, found);
+        buf->set_timestamp (slot.timestamp.load (std::memory_order_relaxed));
+        return true;
+    }
+}
+
+XCamReturn
+ShmFrameReader::read_frame (SmartPtr<VideoBuffer> &buf, int32_t timeout)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _region.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "shm reader read frame failed, not opened");
+
+    ShmRingHeader *header = _region->header ();
+    int64_t deadline = timeout >= 0 ? LatencyStats::now_us () + timeout : -1;
+
+    while (true) {
+        uint32_t futex_val = header->futex.load (std::memory_order_acquire);
+        if (pin_next_frame (buf))
+            return XCAM_RETURN_NO_ERROR;
+        if (header->closed.load (std::memory_order_acquire))
+            return XCAM_RETURN_BYPASS;
+
+        int64_t remain = -1;
+        if (deadline >= 0) {
+            remain = deadline - LatencyStats::now_us ();
+            if (remain <= 0)
+                return XCAM_RETURN_ERROR_TIMEOUT;
+        }
+        shared_futex_wait (header->futex, futex_val, remain);
+    }
+}
+
+}
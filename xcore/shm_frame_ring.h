@@ -0,0 +1,153 @@
+/*
+ * shm_frame_ring.h - frame ring in shared memory for zero-copy consumers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SHM_FRAME_RING_H
+#define XCAM_SHM_FRAME_RING_H
+
+#include <xcam_std.h>
+#include <buffer_pool.h>
+#include <list>
+
+#define XCAM_SHM_RING_MAX_SLOTS 32
+#define XCAM_SHM_RING_MAX_READERS 16
+
+namespace XCam {
+
+class ShmRegion;
+class ShmSlotBuffer;
+
+/*
+ * Output pool whose buffers are slots of one shared memory region, a memfd or a
+ * named POSIX shm object. The producer gets a slot like any pooled buffer, fills
+ * it and publishes it; readers in other processes map the slots read-only.
+ *
+ * Slots change hands through atomics in the region header, neither side takes a
+ * lock and publish never waits for readers. The ring holds the newest published
+ * frames, older ones are retired whether read or not, so a slow reader drops
+ * frames instead of stalling the producer. A retired slot goes back to the pool
+ * once no reader maps it.
+ *
+ * Readers register their pid and the slots they pin in the header, pins of a
+ * reader process which died holding frames are cleared once the producer finds
+ * the slots stuck. A reader killed right between pinning a slot and recording
+ * the pin still leaks that slot, as does one past XCAM_SHM_RING_MAX_READERS.
+ */
+class ShmFrameRing
+    : public BufferPool
+{
+public:
+    // NULL name creates an anonymous memfd, send get_fd () to readers over a unix socket
+    explicit ShmFrameRing (uint32_t slot_count, const char *name = NULL);
+    virtual ~ShmFrameRing ();
+
+    // published frames held for readers, slot_count / 2 by default, fewer when the pool runs short
+    bool set_hold_count (uint32_t count);
+
+    // valid once the pool is reserved
+    int get_fd () const;
+    const char *get_name () const {
+        return _name;
+    }
+
+    // buf must come from this ring, its timestamp goes along with the frame
+    XCamReturn publish (const SmartPtr<VideoBuffer> &buf);
+    uint64_t get_published_count ();
+
+    /*
+     * Ends the stream for readers and stops the pool. Published frames keep the
+     * ring alive until close, call it before dropping the ring.
+     */
+    void close ();
+
+protected:
+    //derived from BufferPool
+    virtual bool fixate_video_info (VideoBufferInfo &info);
+    virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &buffer_info, const void *in_data = NULL);
+    virtual SmartPtr<BufferProxy> create_buffer_from_data (SmartPtr<BufferData> &data);
+    virtual bool reclaim_buffers ();
+
+private:
+    bool create_region (const VideoBufferInfo &info);
+    void retire_slots ();
+    void reclaim_slots ();
+    void clear_dead_readers ();
+
+    XCAM_DEAD_COPY (ShmFrameRing);
+
+private:
+    typedef std::list<SmartPtr<ShmSlotBuffer> > SlotBufferList;
+
+    char                    *_name;
+    uint32_t                 _slot_count;
+    uint32_t                 _next_slot;
+    SmartPtr<ShmRegion>      _region;
+
+    Mutex                    _publish_mutex;
+    uint32_t                 _hold_count;
+    uint64_t                 _seq;
+    bool                     _closed;
+    SlotBufferList           _held;
+    SlotBufferList           _retiring;
+};
+
+/*
+ * Reading side of a ShmFrameRing, usually in another process. Frames are the
+ * mapped slots themselves, valid and kept from reuse while the buffer lives.
+ */
+class ShmFrameReader
+{
+public:
+    explicit ShmFrameReader ();
+    ~ShmFrameReader ();
+
+    XCamReturn open (const char *name);
+    // fd is duplicated, the caller keeps its own
+    XCamReturn open (int fd);
+    void close ();
+
+    const VideoBufferInfo &get_video_info () const {
+        return _info;
+    }
+
+    /*
+     * Oldest held frame newer than the last one read, frames retired before being
+     * read count as dropped. timeout in microseconds, -1 waits until a frame comes.
+     * Returns XCAM_RETURN_BYPASS once the ring is closed and drained.
+     */
+    XCamReturn read_frame (SmartPtr<VideoBuffer> &buf, int32_t timeout = -1);
+    uint64_t get_dropped_count () const {
+        return _dropped;
+    }
+
+private:
+    bool pin_next_frame (SmartPtr<VideoBuffer> &buf);
+
+    XCAM_DEAD_COPY (ShmFrameReader);
+
+private:
+    SmartPtr<ShmRegion>      _region;
+    VideoBufferInfo          _info;
+    uint64_t                 _last_seq;
+    uint64_t                 _dropped;
+};
+
+}
+
+#endif //XCAM_SHM_FRAME_RING_H
@@ -22,7 +22,9 @@
 
 #include <stdint.h>
 #include <atomic>
+#include <new>
 #include <type_traits>
+#include <utility>
 #include <base/xcam_defs.h>
 
 namespace XCam {
@@ -64,6 +66,36 @@ public:
     virtual bool is_a_object () const {
         return false;
     }
+    // true if the object lives inside this count, see make_smart_ptr
+    virtual bool holds_object () const {
+        return false;
+    }
+};
+
+/*
+ * Count and object in one allocation, deleting the count destroys the object.
+ */
+template<typename Obj>
+class RefCountHolder
+    : public RefCount
+{
+public:
+    template<typename... Args>
+    explicit RefCountHolder (Args&&... args) {
+        new (&_storage) Obj (std::forward<Args> (args)...);
+    }
+    virtual ~RefCountHolder () {
+        get_object ()->~Obj ();
+    }
+    virtual bool holds_object () const {
+        return true;
+    }
+    Obj *get_object () {
+        return reinterpret_cast<Obj *> (&_storage);
+    }
+
+private:
+    typename std::aligned_storage<sizeof (Obj), alignof (Obj)>::type _storage;
 };
 
 template<typename Obj>
@@ -80,10 +112,17 @@ RefCount* generate_ref_count (Obj *, std::false_type)
     return new RefCount;
 }
 
+template <typename Obj>
+class SmartPtr;
+
+template <typename Obj, typename... Args>
+SmartPtr<Obj> make_smart_ptr (Args&&... args);
+
 template <typename Obj>
 class SmartPtr {
 private:
     template<typename ObjDerive> friend class SmartPtr;
+    template<typename ObjMake, typename... Args> friend SmartPtr<ObjMake> make_smart_ptr (Args&&... args);
 public:
     SmartPtr (Obj *obj = NULL)
         : _ptr (obj), _ref(NULL)
@@ -120,6 +159,22 @@ public:
         }
     }
 
+    // move from pointer, no ref count change
+    SmartPtr (SmartPtr<Obj> &&obj)
+        : _ptr(obj._ptr), _ref(obj._ref)
+    {
+        obj._ptr = NULL;
+        obj._ref = NULL;
+    }
+
+    template <typename ObjDerive>
+    SmartPtr (SmartPtr<ObjDerive> &&obj)
+        : _ptr(obj._ptr), _ref(obj._ref)
+    {
+        obj._ptr = NULL;
+        obj._ref = NULL;
+    }
+
     ~SmartPtr () {
         release();
     }
@@ -139,15 +194,44 @@ public:
     }
 
     SmartPtr<Obj> & operator = (const SmartPtr<Obj> &obj) {
+        // ref before release in case @obj holds the last reference
+        Obj *ptr = obj._ptr;
+        RefObj *ref = obj._ref;
+        if (ref)
+            ref->ref ();
         release ();
-        set_pointer (obj._ptr, obj._ref);
+        adopt (ptr, ref);
         return *this;
     }
 
     template <typename ObjDerive>
     SmartPtr<Obj> & operator = (const SmartPtr<ObjDerive> &obj) {
+        // ref before release in case @obj holds the last reference
+        ObjDerive *ptr = obj._ptr;
+        RefObj *ref = obj._ref;
+        if (ref)
+            ref->ref ();
+        release ();
+        adopt (ptr, ref);
+        return *this;
+    }
+
+    SmartPtr<Obj> & operator = (SmartPtr<Obj> &&obj) {
+        if (this != &obj) {
+            release ();
+            adopt (obj._ptr, obj._ref);
+            obj._ptr = NULL;
+            obj._ref = NULL;
+        }
+        return *this;
+    }
+
+    template <typename ObjDerive>
+    SmartPtr<Obj> & operator = (SmartPtr<ObjDerive> &&obj) {
         release ();
-        set_pointer (obj._ptr, obj._ref);
+        adopt (obj._ptr, obj._ref);
+        obj._ptr = NULL;
+        obj._ref = NULL;
         return *this;
     }
 
@@ -167,11 +251,14 @@ public:
         if (!_ref->unref()) {
             if (!_ref->is_a_object ()) {
                 //XCAM_ASSERT (dynamic_cast<RefCount*>(_ref));
+                bool held = static_cast<RefCount *> (_ref)->holds_object ();
                 delete _ref;
+                if (!held)
+                    delete _ptr;
             } else {
                 //XCAM_ASSERT (dynamic_cast<Obj*>(_ref) == _ptr);
+                delete _ptr;
             }
-            delete _ptr;
         }
         _ptr = NULL;
         _ref = NULL;
@@ -194,7 +281,37 @@ public:
         return ret;
     }
 
+    // caller guarantees the object is an ObjDerive
+    template <typename ObjDerive>
+    SmartPtr<ObjDerive> static_cast_ptr () const {
+        SmartPtr<ObjDerive> ret(NULL);
+        if (!_ref)
+            return ret;
+        ret.set_pointer (static_cast<ObjDerive*>(_ptr), _ref);
+        return ret;
+    }
+
 private:
+    // takes over a reference already counted for @obj
+    template <typename ObjD>
+    void adopt (ObjD *obj, RefObj *ref) {
+        _ptr = obj;
+        _ref = ref;
+    }
+
+    template <typename... Args>
+    static SmartPtr<Obj> create (std::true_type, Args&&... args) {
+        return SmartPtr<Obj> (new Obj (std::forward<Args> (args)...));
+    }
+
+    template <typename... Args>
+    static SmartPtr<Obj> create (std::false_type, Args&&... args) {
+        RefCountHolder<Obj> *holder = new RefCountHolder<Obj> (std::forward<Args> (args)...);
+        SmartPtr<Obj> ret;
+        ret.adopt (holder->get_object (), holder);
+        return ret;
+    }
+
     template <typename ObjD>
     void set_pointer (ObjD *obj, RefObj *ref) {
         if (!obj)
@@ -223,5 +340,17 @@ private:
     mutable RefObj   *_ref;
 };
 
+/*
+ * Creates Obj with @args. Objects not derived from RefObj are allocated
+ * together with their ref count instead of beside it.
+ * Do not wrap ptr () of the result into another SmartPtr.
+ */
+template <typename Obj, typename... Args>
+SmartPtr<Obj> make_smart_ptr (Args&&... args)
+{
+    typedef std::is_base_of<RefObj, Obj> BaseCheck;
+    return SmartPtr<Obj>::create (BaseCheck (), std::forward<Args> (args)...);
+}
+
 }; // end namespace
 #endif //XCAM_SMARTPTR_H
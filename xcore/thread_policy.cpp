@@ -0,0 +1,402 @@
+/*
+ * thread_policy.cpp - scheduling, affinity and naming of xcore threads
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "thread_policy.h"
+#include <pthread.h>
+#include <errno.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#define XCAM_ISOLATED_CPUS_PATH "/sys/devices/system/cpu/isolated"
+#define XCAM_THREAD_NAME_PREFIX "xc:"
+#define XCAM_THREAD_NAME_SIZE 16
+
+namespace XCam {
+
+static const char *role_names[ThreadRoleCount] = {
+    "default",
+    "capture",
+    "event",
+    "process",
+    "stitch",
+    "worker",
+    "analyzer",
+    "background",
+};
+
+static bool
+parse_cpu_list (const char *list, cpu_set_t &cpus)
+{
+    CPU_ZERO (&cpus);
+
+    const char *pos = list;
+    while (*pos && *pos != '\n') {
+        char *end = NULL;
+        long first = strtol (pos, &end, 10);
+        if (end == pos || first < 0 || first >= CPU_SETSIZE)
+            return false;
+
+        long last = first;
+        pos = end;
+        if (*pos == '-') {
+            ++pos;
+            last = strtol (pos, &end, 10);
+            if (end == pos || last < first || last >= CPU_SETSIZE)
+                return false;
+            pos = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu)
+            CPU_SET (cpu, &cpus);
+
+        if (*pos == ',')
+            ++pos;
+        else if (*pos && *pos != '\n')
+            return false;
+    }
+
+    return CPU_COUNT (&cpus) > 0;
+}
+
+static bool
+get_isolated_cpus (cpu_set_t &cpus)
+{
+    char list[256];
+    xcam_mem_clear (list);
+
+    FILE *fp = fopen (XCAM_ISOLATED_CPUS_PATH, "r");
+    if (!fp)
+        return false;
+    bool ret = (fgets (list, sizeof (list), fp) != NULL);
+    fclose (fp);
+
+    return ret && parse_cpu_list (list, cpus);
+}
+
+/*
+ * Thread names are cut to 15 characters, keep the numeric tail of names like
+ * "soft-stitch-thrs-3" so threads of one pool stay distinguishable.
+ */
+static void
+compose_thread_name (const char *name, char *thread_name)
+{
+    const size_t prefix_len = strlen (XCAM_THREAD_NAME_PREFIX);
+    const size_t max_len = XCAM_THREAD_NAME_SIZE - 1 - prefix_len;
+    size_t len = strlen (name);
+
+    strcpy (thread_name, XCAM_THREAD_NAME_PREFIX);
+    if (len <= max_len) {
+        strcat (thread_name, name);
+        return;
+    }
+
+    size_t tail = len;
+    while (tail > 0 && isdigit (name[tail - 1]))
+        --tail;
+    if (tail < len && tail > 0 && (name[tail - 1] == '-' || name[tail - 1] == '_'))
+        --tail;
+    size_t tail_len = len - tail;
+    if (tail_len == 0 || tail_len >= max_len) {
+        strncat (thread_name, name, max_len);
+        return;
+    }
+
+    strncat (thread_name, name, max_len - tail_len);
+    strcat (thread_name, name + tail);
+}
+
+ThreadPolicy::ThreadPolicy ()
+    : sched_policy (SCHED_OTHER)
+    , priority (0)
+    , nice (0)
+    , pinned (false)
+{
+    CPU_ZERO (&cpus);
+}
+
+bool
+ThreadPolicy::set_cpus (const char *list)
+{
+    XCAM_ASSERT (list);
+
+    cpu_set_t set;
+    bool ret = false;
+    if (!strcmp (list, "isolated")) {
+        ret = get_isolated_cpus (set);
+        XCAM_FAIL_RETURN (
+            WARNING, ret, false,
+            "thread policy found no isolated cpus in %s", XCAM_ISOLATED_CPUS_PATH);
+    } else {
+        ret = parse_cpu_list (list, set);
+        XCAM_FAIL_RETURN (
+            ERROR, ret, false,
+            "thread policy got invalid cpu list:%s", list);
+    }
+
+    cpus = set;
+    pinned = true;
+    return true;
+}
+
+bool
+ThreadPolicy::is_valid () const
+{
+    if (sched_policy == SCHED_FIFO || sched_policy == SCHED_RR) {
+        int min = sched_get_priority_min (sched_policy);
+        int max = sched_get_priority_max (sched_policy);
+        XCAM_FAIL_RETURN (
+            ERROR, priority >= min && priority <= max, false,
+            "thread policy priority:%d out of range (%d ~ %d) of sched policy:%d",
+            priority, min, max, sched_policy);
+    } else {
+        XCAM_FAIL_RETURN (
+            ERROR, sched_policy == SCHED_OTHER && priority == 0, false,
+            "thread policy priority:%d needs sched policy fifo or rr", priority);
+    }
+
+    XCAM_FAIL_RETURN (
+        ERROR, nice >= -20 && nice <= 19, false,
+        "thread policy nice:%d out of range (-20 ~ 19)", nice);
+    return true;
+}
+
+Mutex ThreadPolicyManager::_mutex;
+SmartPtr<ThreadPolicyManager> ThreadPolicyManager::_instance (NULL);
+
+SmartPtr<ThreadPolicyManager>
+ThreadPolicyManager::instance ()
+{
+    SmartLock locker (_mutex);
+    if (_instance.ptr ())
+        return _instance;
+
+    _instance = new ThreadPolicyManager;
+    return _instance;
+}
+
+const char *
+ThreadPolicyManager::role_name (ThreadRole role)
+{
+    XCAM_ASSERT (role >= ThreadRoleDefault && role < ThreadRoleCount);
+    return role_names[role];
+}
+
+ThreadPolicyManager::ThreadPolicyManager ()
+{
+    const char *env = getenv (XCAM_THREAD_POLICY_ENV_VAR);
+    if (env && !parse_policies (env)) {
+        XCAM_LOG_WARNING ("thread policy ignored invalid %s:%s", XCAM_THREAD_POLICY_ENV_VAR, env);
+    }
+}
+
+bool
+ThreadPolicyManager::set_policy (ThreadRole role, const ThreadPolicy &policy)
+{
+    XCAM_ASSERT (role >= ThreadRoleDefault && role < ThreadRoleCount);
+    XCAM_FAIL_RETURN (
+        ERROR, policy.is_valid (), false,
+        "thread policy of role:%s not set", role_name (role));
+
+    SmartLock locker (_policy_mutex);
+    _policies[role] = policy;
+    return true;
+}
+
+ThreadPolicy
+ThreadPolicyManager::get_policy (ThreadRole role)
+{
+    XCAM_ASSERT (role >= ThreadRoleDefault && role < ThreadRoleCount);
+
+    SmartLock locker (_policy_mutex);
+    return _policies[role];
+}
+
+static bool
+field_key_is (const char *field, size_t key_len, const char *key)
+{
+    return key_len == strlen (key) && !strncmp (field, key, key_len);
+}
+
+static bool
+parse_int (const char *value, int &ret)
+{
+    char *end = NULL;
+    errno = 0;
+    long num = strtol (value, &end, 10);
+    if (end == value || *end || errno || num < INT32_MIN || num > INT32_MAX)
+        return false;
+
+    ret = (int) num;
+    return true;
+}
+
+static bool
+parse_role_field (const char *field, ThreadPolicy &policy)
+{
+    const char *value = strchr (field, '=');
+    XCAM_FAIL_RETURN (
+        ERROR, value, false,
+        "thread policy field:%s needs a value", field);
+    size_t key_len = value - field;
+    ++value;
+
+    if (field_key_is (field, key_len, "sched")) {
+        if (!strcmp (value, "fifo"))
+            policy.sched_policy = SCHED_FIFO;
+        else if (!strcmp (value, "rr"))
+            policy.sched_policy = SCHED_RR;
+        else if (!strcmp (value, "other"))
+            policy.sched_policy = SCHED_OTHER;
+        else {
+            XCAM_LOG_ERROR ("thread policy got unknown sched:%s", value);
+            return false;
+        }
+    } else if (field_key_is (field, key_len, "prio")) {
+        XCAM_FAIL_RETURN (
+            ERROR, parse_int (value, policy.priority), false,
+            "thread policy got invalid prio:%s", value);
+    } else if (field_key_is (field, key_len, "nice")) {
+        XCAM_FAIL_RETURN (
+            ERROR, parse_int (value, policy.nice), false,
+            "thread policy got invalid nice:%s", value);
+    } else if (field_key_is (field, key_len, "cpus")) {
+        return policy.set_cpus (value);
+    } else {
+        XCAM_LOG_ERROR ("thread policy got unknown field:%s", field);
+        return false;
+    }
+
+    return true;
+}
+
+bool
+ThreadPolicyManager::parse_policies (const char *config)
+{
+    XCAM_ASSERT (config);
+
+    ThreadPolicy policies[ThreadRoleCount];
+    {
+        SmartLock locker (_policy_mutex);
+        for (int i = 0; i < ThreadRoleCount; ++i)
+            policies[i] = _policies[i];
+    }
+
+    char *str = strndup (config, XCAM_MAX_STR_SIZE);
+    XCAM_ASSERT (str);
+
+    bool ret = true;
+    char *role_save = NULL;
+    for (char *entry = strtok_r (str, ";", &role_save); entry && ret;
+            entry = strtok_r (NULL, ";", &role_save)) {
+        char *field_save = NULL;
+        char *name = strtok_r (entry, ":", &field_save);
+        if (!name)
+            continue;
+
+        int role = 0;
+        for (; role < ThreadRoleCount; ++role) {
+            if (!strcmp (name, role_names[role]))
+                break;
+        }
+        if (role == ThreadRoleCount) {
+            XCAM_LOG_ERROR ("thread policy got unknown role:%s", name);
+            ret = false;
+            break;
+        }
+
+        ThreadPolicy policy;
+        for (char *field = strtok_r (NULL, ":", &field_save); field && ret;
+                field = strtok_r (NULL, ":", &field_save)) {
+            ret = parse_role_field (field, policy);
+        }
+        // fields come in any order, priority is checked against the final sched
+        if (ret && !policy.is_valid ()) {
+            XCAM_LOG_ERROR ("thread policy of role:%s invalid", name);
+            ret = false;
+        }
+        policies[role] = policy;
+    }
+    xcam_free (str);
+
+    if (!ret)
+        return false;
+
+    SmartLock locker (_policy_mutex);
+    for (int i = 0; i < ThreadRoleCount; ++i)
+        _policies[i] = policies[i];
+    return true;
+}
+
+XCamReturn
+ThreadPolicyManager::apply (ThreadRole role, const char *name)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    ThreadPolicy policy = get_policy (role);
+    pthread_t thread = pthread_self ();
+    int err = 0;
+
+    char thread_name[XCAM_THREAD_NAME_SIZE];
+    xcam_mem_clear (thread_name);
+    compose_thread_name (XCAM_STR (name), thread_name);
+#ifdef __USE_GNU
+    err = pthread_setname_np (thread, thread_name);
+    if (err != 0) {
+        XCAM_LOG_WARNING ("Thread(%s) set name failed.(%d, %s)", XCAM_STR (name), err, strerror (err));
+        ret = XCAM_RETURN_ERROR_THREAD;
+    }
+#endif
+
+    if (policy.pinned) {
+        err = pthread_setaffinity_np (thread, sizeof (policy.cpus), &policy.cpus);
+        if (err != 0) {
+            XCAM_LOG_WARNING (
+                "Thread(%s) role:%s set cpu affinity failed.(%d, %s)",
+                XCAM_STR (name), role_name (role), err, strerror (err));
+            ret = XCAM_RETURN_ERROR_THREAD;
+        }
+    }
+
+    if (policy.sched_policy != SCHED_OTHER) {
+        struct sched_param param;
+        xcam_mem_clear (param);
+        param.sched_priority = policy.priority;
+        err = pthread_setschedparam (thread, policy.sched_policy, &param);
+        if (err != 0) {
+            XCAM_LOG_WARNING (
+                "Thread(%s) role:%s set sched policy:%d priority:%d failed.(%d, %s)",
+                XCAM_STR (name), role_name (role), policy.sched_policy, policy.priority, err, strerror (err));
+            ret = XCAM_RETURN_ERROR_THREAD;
+        }
+    } else if (policy.nice != 0) {
+        // niceness is per thread on Linux, addressed by the thread id
+        pid_t tid = (pid_t) syscall (SYS_gettid);
+        if (setpriority (PRIO_PROCESS, tid, policy.nice) != 0) {
+            XCAM_LOG_WARNING (
+                "Thread(%s) role:%s set nice:%d failed.(%d, %s)",
+                XCAM_STR (name), role_name (role), policy.nice, errno, strerror (errno));
+            ret = XCAM_RETURN_ERROR_THREAD;
+        }
+    }
+
+    return ret;
+}
+
+}
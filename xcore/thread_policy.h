@@ -0,0 +1,93 @@
+/*
+ * thread_policy.h - scheduling, affinity and naming of xcore threads
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_THREAD_POLICY_H
+#define XCAM_THREAD_POLICY_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <sched.h>
+
+#define XCAM_THREAD_POLICY_ENV_VAR "XCAM_THREAD_POLICY"
+
+namespace XCam {
+
+enum ThreadRole {
+    ThreadRoleDefault = 0,
+    ThreadRoleCapture,     // capture polling and capture reactors
+    ThreadRoleEvent,       // device events and messages
+    ThreadRoleProcess,     // image processor loops
+    ThreadRoleStitch,      // stitcher thread pools
+    ThreadRoleWorker,      // other thread pools
+    ThreadRoleAnalyzer,    // 3a analyzers
+    ThreadRoleBackground,  // deferred work, e.g. calibration
+    ThreadRoleCount
+};
+
+struct ThreadPolicy {
+    int          sched_policy;  // SCHED_OTHER, SCHED_FIFO or SCHED_RR
+    int          priority;      // SCHED_FIFO and SCHED_RR only, within sched_get_priority_min/max
+    int          nice;          // SCHED_OTHER only, 0 keeps the inherited value
+    bool         pinned;
+    cpu_set_t    cpus;
+
+    ThreadPolicy ();
+    // "2,4-7" or "isolated" for the cores isolated from the kernel scheduler
+    bool set_cpus (const char *list);
+    // priority in range of a real-time sched_policy, nice within -20 ~ 19
+    bool is_valid () const;
+};
+
+/*
+ * Policies by thread role, applied by every XCam::Thread as it starts. Defaults come
+ * from XCAM_THREAD_POLICY, roles separated by ';' and fields by ':', e.g.
+ *   capture:sched=fifo:prio=50:cpus=2;stitch:nice=-5:cpus=isolated
+ * sched=fifo and sched=rr need a prio. Policies the process is not allowed to set
+ * only get a warning.
+ */
+class ThreadPolicyManager
+{
+public:
+    static SmartPtr<ThreadPolicyManager> instance ();
+    static const char *role_name (ThreadRole role);
+
+    bool set_policy (ThreadRole role, const ThreadPolicy &policy);
+    ThreadPolicy get_policy (ThreadRole role);
+    bool parse_policies (const char *config);
+
+    // names the calling thread and applies the policy of @role to it
+    XCamReturn apply (ThreadRole role, const char *name);
+
+protected:
+    explicit ThreadPolicyManager ();
+
+    XCAM_DEAD_COPY (ThreadPolicyManager);
+
+private:
+    Mutex                                 _policy_mutex;
+    ThreadPolicy                          _policies[ThreadRoleCount];
+
+    static Mutex                          _mutex;
+    static SmartPtr<ThreadPolicyManager>  _instance;
+};
+
+}
+
+#endif //XCAM_THREAD_POLICY_H
@@ -25,12 +25,19 @@
 
 namespace XCam {
 
+static bool
+priority_before (
+    const SmartPtr<ThreadPool::UserData> &data, const SmartPtr<ThreadPool::UserData> &queued)
+{
+    return data->get_priority () < queued->get_priority ();
+}
+
 class UserThread
     : public Thread
 {
 public:
-    UserThread (const SmartPtr<ThreadPool> &pool, const char *name)
-        : Thread (name)
+    UserThread (const SmartPtr<ThreadPool> &pool, const char *name, ThreadRole role)
+        : Thread (name, role)
         , _pool (pool)
     {}
 
@@ -103,6 +110,7 @@ ThreadPool::ThreadPool (const char *name)
     : _name (NULL)
     , _min_threads (XCAM_POOL_MIN_THREADS)
     , _max_threads (XCAM_POOL_MIN_THREADS)
+    , _role (ThreadRoleWorker)
     , _allocated_threads (0)
     , _free_threads (0)
     , _running (false)
@@ -138,6 +146,17 @@ ThreadPool::set_threads (uint32_t min, uint32_t max)
     return true;
 }
 
+bool
+ThreadPool::set_role (ThreadRole role)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_running, false,
+        "ThreadPool(%s) set role failed, need stop the pool first", XCAM_STR(get_name ()));
+
+    _role = role;
+    return true;
+}
+
 bool
 ThreadPool::is_running ()
 {
@@ -214,7 +233,7 @@ ThreadPool::create_user_thread_unsafe ()
 {
     char name[256];
     snprintf (name, 255, "%s-%d", XCAM_STR (get_name()), _allocated_threads);
-    SmartPtr<UserThread> thread = new UserThread (this, name);
+    SmartPtr<UserThread> thread = new UserThread (this, name, _role);
     XCAM_ASSERT (thread.ptr ());
     XCAM_FAIL_RETURN (
         ERROR, thread.ptr () && thread->start (), XCAM_RETURN_ERROR_THREAD,
@@ -239,7 +258,7 @@ ThreadPool::queue (const SmartPtr<UserData> &data)
             return XCAM_RETURN_ERROR_THREAD;
     }
 
-    if (!_data_queue.push (data))
+    if (!_data_queue.push_ordered (data, priority_before))
         return XCAM_RETURN_ERROR_THREAD;
 
     do {
@@ -38,18 +38,32 @@ class ThreadPool
 public:
     class UserData {
     public:
-        UserData () {}
+        UserData () : _priority (0) {}
         virtual ~UserData () {}
         virtual XCamReturn run () = 0;
         virtual void done (XCamReturn) {}
+
+        // smaller value is dispatched first, equal priorities keep queue order
+        void set_priority (int64_t priority) {
+            _priority = priority;
+        }
+        int64_t get_priority () const {
+            return _priority;
+        }
+
     private:
         XCAM_DEAD_COPY (UserData);
+
+    private:
+        int64_t    _priority;
     };
 
 public:
     explicit ThreadPool (const char *name);
     virtual ~ThreadPool ();
     bool set_threads (uint32_t min, uint32_t max);
+    // policy role of the user threads, ThreadRoleWorker by default
+    bool set_role (ThreadRole role);
     const char *get_name () const {
         return _name;
     }
@@ -70,6 +84,7 @@ private:
     char                   *_name;
     uint32_t                _min_threads;
     uint32_t                _max_threads;
+    ThreadRole              _role;
     uint32_t                _allocated_threads;
     uint32_t                _free_threads;
     bool                    _running;
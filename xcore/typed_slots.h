@@ -0,0 +1,288 @@
+/*
+ * typed_slots.h - small inline storage of objects keyed by type
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_TYPED_SLOTS_H
+#define XCAM_TYPED_SLOTS_H
+
+#include <xcam_std.h>
+#include <type_traits>
+#include <vector>
+
+namespace XCam {
+
+#define XCAM_SLOT_MAX_DEPTH 8
+
+/*
+ * Declares the direct parent of a type kept in TypedSlots, e.g.
+ *   struct DevicePose : MetaData { XCAM_SLOT_TYPE (DevicePose, MetaData); ... };
+ * single inheritance only. Subclasses don't inherit the declaration.
+ */
+#define XCAM_SLOT_TYPE(self, parent)   \
+    typedef self SlotSelf;             \
+    typedef parent SlotParent
+
+// unique address per type, compares without RTTI
+template <typename T>
+struct TypeKey {
+    static const char id;
+};
+
+template <typename T>
+const char TypeKey<T>::id = 0;
+
+template <typename T>
+inline const void *
+get_type_key ()
+{
+    return &TypeKey<T>::id;
+}
+
+// keys of a type and its declared ancestors up to Base
+struct SlotTypeInfo {
+    const void  *keys[XCAM_SLOT_MAX_DEPTH];
+    uint32_t     count;
+    // every ancestor up to Base is among keys
+    bool         complete;
+};
+
+template <typename T>
+struct SlotTypeDeclared {
+    template <typename U>
+    static typename std::is_same<typename U::SlotSelf, U>::type check (typename U::SlotParent *);
+    template <typename U>
+    static std::false_type check (...);
+
+    static const bool value = decltype (check<T> (NULL))::value;
+};
+
+template <typename Base, typename T>
+const SlotTypeInfo *get_slot_type_info ();
+
+template <typename Base, typename T>
+inline void
+init_slot_parents (SlotTypeInfo &info, std::true_type)
+{
+    typedef typename T::SlotParent Parent;
+    static_assert (std::is_base_of<Parent, T>::value, "slot parent must be a base of the type");
+
+    const SlotTypeInfo *parent = get_slot_type_info<Base, Parent> ();
+    if (info.count + parent->count > XCAM_SLOT_MAX_DEPTH)
+        return;
+    for (uint32_t i = 0; i < parent->count; ++i)
+        info.keys[info.count++] = parent->keys[i];
+    info.complete = parent->complete;
+}
+
+template <typename Base, typename T>
+inline void
+init_slot_parents (SlotTypeInfo &info, std::false_type)
+{
+    XCAM_UNUSED (info);
+}
+
+template <typename Base, typename T>
+inline SlotTypeInfo
+create_slot_type_info ()
+{
+    SlotTypeInfo info;
+    xcam_mem_clear (info);
+    info.keys[info.count++] = get_type_key<T> ();
+    if (std::is_same<T, Base>::value) {
+        info.complete = true;
+        return info;
+    }
+
+    init_slot_parents<Base, T> (
+        info, std::integral_constant<bool, SlotTypeDeclared<T>::value && !std::is_same<T, Base>::value> ());
+    return info;
+}
+
+template <typename Base, typename T>
+const SlotTypeInfo *
+get_slot_type_info ()
+{
+    static const SlotTypeInfo info = create_slot_type_info<Base, T> ();
+    return &info;
+}
+
+/*
+ * Ordered objects of Base, the first N live inline and only the rest allocate.
+ * Each object keeps the keys of the type it was added as and of that type's declared
+ * ancestors (XCAM_SLOT_TYPE), collected once per type. find<T> returns the first object
+ * in insertion order that is a T. When T and the added type are both declared up to Base,
+ * a key match decides and dynamic_cast only runs for objects added as an ancestor of T;
+ * undeclared types always fall back to dynamic_cast.
+ */
+template <typename Base, uint32_t N>
+class TypedSlots
+{
+public:
+    TypedSlots () : _size (0) {}
+
+    template <typename T>
+    void add (const SmartPtr<T> &obj) {
+        static_assert (std::is_base_of<Base, T>::value, "slot objects must derive from Base");
+        add_with_type (obj, get_slot_type_info<Base, T> ());
+    }
+    void add_with_type (const SmartPtr<Base> &obj, const SlotTypeInfo *type);
+    bool remove (const Base *obj);
+    void append (const TypedSlots<Base, N> &other);
+    void clear ();
+
+    template <typename T>
+    SmartPtr<T> find () const;
+
+    uint32_t size () const {
+        return _size;
+    }
+    bool is_empty () const {
+        return !_size;
+    }
+    const SmartPtr<Base> &at (uint32_t idx) const {
+        XCAM_ASSERT (idx < _size);
+        return slot (idx).obj;
+    }
+
+private:
+    struct Slot {
+        SmartPtr<Base>        obj;
+        const SlotTypeInfo   *type;
+
+        Slot () : type (NULL) {}
+    };
+
+    Slot &slot (uint32_t idx) {
+        return idx < N ? _inline[idx] : _spill[idx - N];
+    }
+    const Slot &slot (uint32_t idx) const {
+        return idx < N ? _inline[idx] : _spill[idx - N];
+    }
+
+    template <typename T>
+    SmartPtr<T> find_base (std::true_type) const {
+        if (!_size)
+            return NULL;
+        return slot (0).obj;
+    }
+    template <typename T>
+    SmartPtr<T> find_base (std::false_type) const;
+
+private:
+    Slot                _inline[N];
+    std::vector<Slot>   _spill;
+    uint32_t            _size;
+};
+
+template <typename Base, uint32_t N>
+void
+TypedSlots<Base, N>::add_with_type (const SmartPtr<Base> &obj, const SlotTypeInfo *type)
+{
+    if (_size < N) {
+        _inline[_size].obj = obj;
+        _inline[_size].type = type;
+    } else {
+        _spill.push_back (Slot ());
+        _spill.back ().obj = obj;
+        _spill.back ().type = type;
+    }
+    ++_size;
+}
+
+template <typename Base, uint32_t N>
+bool
+TypedSlots<Base, N>::remove (const Base *obj)
+{
+    uint32_t idx = 0;
+    while (idx < _size && slot (idx).obj.ptr () != obj)
+        ++idx;
+    if (idx == _size)
+        return false;
+
+    for (; idx + 1 < _size; ++idx) {
+        slot (idx).obj = std::move (slot (idx + 1).obj);
+        slot (idx).type = slot (idx + 1).type;
+    }
+
+    --_size;
+    if (_size < N)
+        _inline[_size].obj.release ();
+    else
+        _spill.pop_back ();
+    return true;
+}
+
+template <typename Base, uint32_t N>
+void
+TypedSlots<Base, N>::append (const TypedSlots<Base, N> &other)
+{
+    for (uint32_t i = 0; i < other._size; ++i)
+        add_with_type (other.slot (i).obj, other.slot (i).type);
+}
+
+template <typename Base, uint32_t N>
+void
+TypedSlots<Base, N>::clear ()
+{
+    for (uint32_t i = 0; i < XCAM_MIN (_size, N); ++i)
+        _inline[i].obj.release ();
+    _spill.clear ();
+    _size = 0;
+}
+
+template <typename Base, uint32_t N>
+template <typename T>
+SmartPtr<T>
+TypedSlots<Base, N>::find () const
+{
+    return find_base<T> (std::is_same<T, Base> ());
+}
+
+template <typename Base, uint32_t N>
+template <typename T>
+SmartPtr<T>
+TypedSlots<Base, N>::find_base (std::false_type) const
+{
+    const SlotTypeInfo *wanted = get_slot_type_info<Base, T> ();
+    const void *key = wanted->keys[0];
+    for (uint32_t i = 0; i < _size; ++i) {
+        const Slot &s = slot (i);
+        const SlotTypeInfo *type = s.type;
+        for (uint32_t k = 0; k < type->count; ++k) {
+            if (type->keys[k] == key)
+                return s.obj.template static_cast_ptr<T> ();
+        }
+
+        // with both chains complete, the object can only be a T if it was added as an ancestor of T
+        bool maybe_derived = !type->complete || !wanted->complete;
+        for (uint32_t k = 1; !maybe_derived && k < wanted->count; ++k)
+            maybe_derived = (wanted->keys[k] == type->keys[0]);
+
+        if (maybe_derived) {
+            SmartPtr<T> obj = s.obj.template dynamic_cast_ptr<T> ();
+            if (obj.ptr ())
+                return obj;
+        }
+    }
+    return NULL;
+}
+
+};
+
+#endif //XCAM_TYPED_SLOTS_H
@@ -103,34 +103,16 @@ VideoBuffer::~VideoBuffer ()
     _parent.release ();
 }
 
-bool
-VideoBuffer::attach_buffer (const SmartPtr<VideoBuffer>& buf)
-{
-    _attached_bufs.push_back (buf);
-    return true;
-}
-
 bool
 VideoBuffer::detach_buffer (const SmartPtr<VideoBuffer>& buf)
 {
-    for (VideoBufferList::iterator iter = _attached_bufs.begin ();
-            iter != _attached_bufs.end (); ++iter) {
-        SmartPtr<VideoBuffer>& current = *iter;
-        if (current.ptr () == buf.ptr ()) {
-            _attached_bufs.erase (iter);
-            return true;
-        }
-    }
-
-    //not found
-    return false;
+    return _attached_bufs.remove (buf.ptr ());
 }
 
 bool
 VideoBuffer::copy_attaches (const SmartPtr<VideoBuffer>& buf)
 {
-    _attached_bufs.insert (
-        _attached_bufs.end (), buf->_attached_bufs.begin (), buf->_attached_bufs.end ());
+    _attached_bufs.append (buf->_attached_bufs);
     return true;
 }
 
@@ -140,27 +122,10 @@ VideoBuffer::clear_attached_buffers ()
     _attached_bufs.clear ();
 }
 
-bool
-VideoBuffer::add_metadata (const SmartPtr<MetaData>& data)
-{
-    _metadata_list.push_back (data);
-    return true;
-}
-
 bool
 VideoBuffer::remove_metadata (const SmartPtr<MetaData>& data)
 {
-    for (MetaDataList::iterator iter = _metadata_list.begin ();
-            iter != _metadata_list.end (); ++iter) {
-        SmartPtr<MetaData>& current = *iter;
-        if (current.ptr () == data.ptr ()) {
-            _metadata_list.erase (iter);
-            return true;
-        }
-    }
-
-    //not found
-    return false;
+    return _metadata_list.remove (data.ptr ());
 }
 
 void
@@ -169,4 +134,17 @@ VideoBuffer::clear_all_metadata ()
     _metadata_list.clear ();
 }
 
+void
+take_attached_chain (const SmartPtr<VideoBuffer> &head, VideoBufferList &bufs)
+{
+    SmartPtr<VideoBuffer> buf = head;
+    while (buf.ptr ()) {
+        SmartPtr<VideoBuffer> next = buf->find_typed_attach<VideoBuffer> ();
+        if (next.ptr ())
+            buf->detach_buffer (next);
+        bufs.push_back (std::move (buf));
+        buf = std::move (next);
+    }
+}
+
 };
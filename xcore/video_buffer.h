@@ -23,11 +23,15 @@
 
 #include <xcam_std.h>
 #include <meta_data.h>
+#include <typed_slots.h>
 #include <base/xcam_buffer.h>
 #include <list>
 
 namespace XCam {
 
+// attachments and metadata stored inline per buffer before spilling to the heap
+#define XCAM_BUFFER_INLINE_SLOTS 4
+
 class VideoBuffer;
 typedef std::list<SmartPtr<VideoBuffer>>  VideoBufferList;
 
@@ -94,7 +98,9 @@ public:
         return _videoinfo.format;
     }
 
-    bool attach_buffer (const SmartPtr<VideoBuffer>& buf);
+    // find_typed_attach<BufType> finds the first attached BufType, buffer types are matched by dynamic_cast
+    template <typename BufType>
+    bool attach_buffer (const SmartPtr<BufType>& buf);
     bool detach_buffer (const SmartPtr<VideoBuffer>& buf);
     bool copy_attaches (const SmartPtr<VideoBuffer>& buf);
     void clear_attached_buffers ();
@@ -102,7 +108,9 @@ public:
     template <typename BufType>
     SmartPtr<BufType> find_typed_attach ();
 
-    bool add_metadata (const SmartPtr<MetaData>& data);
+    // find_typed_metadata<MetaType> matches by key when MetaType and @data declare XCAM_SLOT_TYPE
+    template <typename MetaType>
+    bool add_metadata (const SmartPtr<MetaType>& data);
     bool remove_metadata (const SmartPtr<MetaData>& data);
     void clear_all_metadata ();
 
@@ -113,8 +121,11 @@ private:
     XCAM_DEAD_COPY (VideoBuffer);
 
 protected:
-    VideoBufferList           _attached_bufs;
-    MetaDataList              _metadata_list;
+    typedef TypedSlots<VideoBuffer, XCAM_BUFFER_INLINE_SLOTS> AttachSlots;
+    typedef TypedSlots<MetaData, XCAM_BUFFER_INLINE_SLOTS> MetaDataSlots;
+
+    AttachSlots               _attached_bufs;
+    MetaDataSlots             _metadata_list;
 
 private:
     VideoBufferInfo           _videoinfo;
@@ -123,32 +134,38 @@ private:
     SmartPtr<VideoBuffer>     _parent;
 };
 
+template <typename BufType>
+bool VideoBuffer::attach_buffer (const SmartPtr<BufType>& buf)
+{
+    _attached_bufs.add (buf);
+    return true;
+}
+
 template <typename BufType>
 SmartPtr<BufType> VideoBuffer::find_typed_attach ()
 {
-    for (VideoBufferList::iterator iter = _attached_bufs.begin ();
-            iter != _attached_bufs.end (); ++iter) {
-        SmartPtr<BufType> buf = (*iter).dynamic_cast_ptr<BufType> ();
-        if (buf.ptr ())
-            return buf;
-    }
+    return _attached_bufs.find<BufType> ();
+}
 
-    return NULL;
+template <typename MetaType>
+bool VideoBuffer::add_metadata (const SmartPtr<MetaType>& data)
+{
+    _metadata_list.add (data);
+    return true;
 }
 
 template <typename MetaType>
 SmartPtr<MetaType> VideoBuffer::find_typed_metadata ()
 {
-    for (MetaDataList::iterator iter = _metadata_list.begin ();
-            iter != _metadata_list.end (); ++iter) {
-        SmartPtr<MetaType> buf = (*iter).dynamic_cast_ptr<MetaType> ();
-        if (buf.ptr ())
-            return buf;
-    }
-
-    return NULL;
+    return _metadata_list.find<MetaType> ();
 }
 
+/*
+ * Multi-camera inputs are passed as @head with the other cameras chained behind it
+ * by attach_buffer. Appends the whole chain to @bufs in order and detaches it.
+ */
+void take_attached_chain (const SmartPtr<VideoBuffer> &head, VideoBufferList &bufs);
+
 XCamVideoBuffer *convert_to_external_buffer (const SmartPtr<VideoBuffer> &buf);
 
 };
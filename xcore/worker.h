@@ -108,6 +108,10 @@ public:
     bool set_callback (const SmartPtr<Callback> &callback);
 
     virtual XCamReturn work (const SmartPtr<Arguments> &args) = 0;
+    // @args is handed over, workers may move it into their queued items
+    virtual XCamReturn work (SmartPtr<Arguments> &&args) {
+        return work (static_cast<const SmartPtr<Arguments> &> (args));
+    }
     virtual XCamReturn stop () = 0;
 
 protected:
@@ -26,7 +26,7 @@
 namespace XCam {
 
 AnalyzerThread::AnalyzerThread (XAnalyzer *analyzer)
-    : Thread ("AnalyzerThread")
+    : Thread ("AnalyzerThread", ThreadRoleAnalyzer)
     , _analyzer (analyzer)
 {}
 
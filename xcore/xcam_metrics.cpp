@@ -0,0 +1,154 @@
+/*
+ * xcam_metrics.cpp - lock-free latency and counter metrics
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "xcam_metrics.h"
+#include <time.h>
+
+namespace XCam {
+
+static std::atomic<uint32_t> metrics_thread_count (0);
+static thread_local uint32_t metrics_shard_idx = XCAM_METRICS_SHARDS;
+
+static inline uint32_t
+get_shard_idx ()
+{
+    if (metrics_shard_idx >= XCAM_METRICS_SHARDS)
+        metrics_shard_idx = metrics_thread_count.fetch_add (1, std::memory_order_relaxed) % XCAM_METRICS_SHARDS;
+    return metrics_shard_idx;
+}
+
+static inline uint32_t
+get_bucket_idx (uint64_t duration_us)
+{
+    if (!duration_us)
+        return 0;
+
+    uint32_t idx = 64 - __builtin_clzll (duration_us);
+    return XCAM_MIN (idx, (uint32_t)(XCAM_LATENCY_BUCKETS - 1));
+}
+
+LatencyHistogram::LatencyHistogram ()
+    : count (0)
+    , errors (0)
+    , sum_us (0)
+    , max_us (0)
+{
+    xcam_mem_clear (buckets);
+}
+
+void
+LatencyHistogram::merge (const LatencyHistogram &other)
+{
+    count += other.count;
+    errors += other.errors;
+    sum_us += other.sum_us;
+    max_us = XCAM_MAX (max_us, other.max_us);
+    for (uint32_t i = 0; i < XCAM_LATENCY_BUCKETS; ++i)
+        buckets[i] += other.buckets[i];
+}
+
+uint64_t
+LatencyHistogram::mean_us () const
+{
+    return count ? sum_us / count : 0;
+}
+
+uint64_t
+LatencyHistogram::percentile_us (float p) const
+{
+    if (!count)
+        return 0;
+
+    uint64_t rank = (uint64_t)(XCAM_CLAMP (p, 0.0f, 1.0f) * count + 0.5f);
+    rank = XCAM_MAX (rank, (uint64_t)1);
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < XCAM_LATENCY_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank)
+            return XCAM_MIN ((uint64_t)1 << i, max_us);
+    }
+    return max_us;
+}
+
+LatencyStats::LatencyStats ()
+{
+    reset ();
+}
+
+void
+LatencyStats::record (int64_t duration_us)
+{
+    uint64_t duration = duration_us > 0 ? (uint64_t)duration_us : 0;
+    Shard &shard = _shards[get_shard_idx ()];
+
+    shard.count.fetch_add (1, std::memory_order_relaxed);
+    shard.sum_us.fetch_add (duration, std::memory_order_relaxed);
+    shard.buckets[get_bucket_idx (duration)].fetch_add (1, std::memory_order_relaxed);
+
+    uint64_t max = shard.max_us.load (std::memory_order_relaxed);
+    while (duration > max &&
+            !shard.max_us.compare_exchange_weak (max, duration, std::memory_order_relaxed)) {}
+}
+
+void
+LatencyStats::record_error ()
+{
+    _shards[get_shard_idx ()].errors.fetch_add (1, std::memory_order_relaxed);
+}
+
+void
+LatencyStats::get_histogram (LatencyHistogram &hist) const
+{
+    hist = LatencyHistogram ();
+    for (uint32_t s = 0; s < XCAM_METRICS_SHARDS; ++s) {
+        const Shard &shard = _shards[s];
+        hist.count += shard.count.load (std::memory_order_relaxed);
+        hist.errors += shard.errors.load (std::memory_order_relaxed);
+        hist.sum_us += shard.sum_us.load (std::memory_order_relaxed);
+        hist.max_us = XCAM_MAX (hist.max_us, shard.max_us.load (std::memory_order_relaxed));
+        for (uint32_t i = 0; i < XCAM_LATENCY_BUCKETS; ++i)
+            hist.buckets[i] += shard.buckets[i].load (std::memory_order_relaxed);
+    }
+}
+
+void
+LatencyStats::reset ()
+{
+    for (uint32_t s = 0; s < XCAM_METRICS_SHARDS; ++s) {
+        Shard &shard = _shards[s];
+        shard.count.store (0, std::memory_order_relaxed);
+        shard.errors.store (0, std::memory_order_relaxed);
+        shard.sum_us.store (0, std::memory_order_relaxed);
+        shard.max_us.store (0, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < XCAM_LATENCY_BUCKETS; ++i)
+            shard.buckets[i].store (0, std::memory_order_relaxed);
+    }
+}
+
+int64_t
+LatencyStats::now_us ()
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return XCAM_TIMESPEC_2_USEC (now);
+}
+
+}
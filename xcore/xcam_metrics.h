@@ -0,0 +1,93 @@
+/*
+ * xcam_metrics.h - lock-free latency and counter metrics
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_METRICS_H
+#define XCAM_METRICS_H
+
+#include <xcam_std.h>
+#include <atomic>
+
+#define XCAM_METRICS_SHARDS 8
+#define XCAM_METRICS_CACHE_LINE 64
+
+// bucket 0 counts durations under 1us, bucket i counts [2^(i-1), 2^i) us
+#define XCAM_LATENCY_BUCKETS 24
+
+namespace XCam {
+
+// snapshot of LatencyStats, durations in microseconds
+struct LatencyHistogram {
+    uint64_t    count;
+    uint64_t    errors;
+    uint64_t    sum_us;
+    uint64_t    max_us;
+    uint64_t    buckets[XCAM_LATENCY_BUCKETS];
+
+    LatencyHistogram ();
+    void merge (const LatencyHistogram &other);
+
+    uint64_t mean_us () const;
+    // upper bound of the bucket holding the percentile, p in [0, 1]
+    uint64_t percentile_us (float p) const;
+};
+
+/*
+ * Records durations into per-thread shards with relaxed atomics, no lock on
+ * either side. Readers sum the shards, so a snapshot taken while recording
+ * may miss the samples in progress.
+ */
+class LatencyStats
+{
+public:
+    LatencyStats ();
+
+    void record (int64_t duration_us);
+    // duration since start_us, taken by now_us ()
+    void record_since (int64_t start_us) {
+        record (now_us () - start_us);
+    }
+    void record_error ();
+
+    void get_histogram (LatencyHistogram &hist) const;
+    void reset ();
+
+    // monotonic clock in microseconds
+    static int64_t now_us ();
+
+private:
+    XCAM_DEAD_COPY (LatencyStats);
+
+private:
+    struct Shard {
+        std::atomic<uint64_t>   count;
+        std::atomic<uint64_t>   errors;
+        std::atomic<uint64_t>   sum_us;
+        std::atomic<uint64_t>   max_us;
+        std::atomic<uint64_t>   buckets[XCAM_LATENCY_BUCKETS];
+        // keeps neighbouring shards off the same cache line
+        uint8_t                 padding[XCAM_METRICS_CACHE_LINE];
+    };
+
+    Shard                       _shards[XCAM_METRICS_SHARDS];
+};
+
+}
+
+#endif //XCAM_METRICS_H
@@ -24,8 +24,9 @@
 
 namespace XCam {
 
-Thread::Thread (const char *name)
+Thread::Thread (const char *name, ThreadRole role)
     : _name (NULL)
+    , _role (role)
     , _thread_id (0)
     , _started (false)
     , _stopped (true)
@@ -51,6 +52,8 @@ Thread::thread_func (void *user_data)
         SmartLock locker(thread->_mutex);
         pthread_detach (pthread_self());
     }
+    ThreadPolicyManager::instance ()->apply (thread->_role, thread->_name);
+
     ret = thread->started ();
 
     while (true) {
@@ -100,16 +103,6 @@ bool Thread::start ()
     _started = true;
     _stopped = false;
 
-#ifdef __USE_GNU
-    char thread_name[16];
-    xcam_mem_clear (thread_name);
-    snprintf (thread_name, sizeof (thread_name), "xc:%s", XCAM_STR(_name));
-    int ret = pthread_setname_np (_thread_id, thread_name);
-    if (ret != 0) {
-        XCAM_LOG_WARNING ("Thread(%s) set name to thread_id failed.(%d, %s)", XCAM_STR(_name), ret, strerror(ret));
-    }
-#endif
-
     return true;
 }
 
@@ -23,12 +23,13 @@
 
 #include <xcam_std.h>
 #include <xcam_mutex.h>
+#include <thread_policy.h>
 
 namespace XCam {
 
 class Thread {
 public:
-    Thread (const char *name = NULL);
+    Thread (const char *name = NULL, ThreadRole role = ThreadRoleDefault);
     virtual ~Thread ();
 
     bool start ();
@@ -38,6 +39,13 @@ public:
     const char *get_name () const {
         return _name;
     }
+    // selects the ThreadPolicyManager policy, takes effect on next start
+    void set_role (ThreadRole role) {
+        _role = role;
+    }
+    ThreadRole get_role () const {
+        return _role;
+    }
 
 protected:
     // return true to start loop, else the thread stopped
@@ -54,6 +62,7 @@ private:
 
 private:
     char           *_name;
+    ThreadRole      _role;
     pthread_t       _thread_id;
     XCam::Mutex     _mutex;
     XCam::Cond      _exit_cond;
@@ -24,6 +24,10 @@
 #include "xcam_utils.h"
 #include "video_buffer.h"
 #include "image_file.h"
+#include <unistd.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 namespace XCam {
 
@@ -357,4 +361,22 @@ dump_data_buf (const void *buf, const size_t &size, const char *file_name)
     return true;
 }
 
+void
+shared_futex_wait (std::atomic<uint32_t> &word, uint32_t val, int64_t timeout_us)
+{
+    struct timespec ts, *pts = NULL;
+    if (timeout_us >= 0) {
+        ts.tv_sec = timeout_us / 1000000;
+        ts.tv_nsec = (timeout_us % 1000000) * 1000;
+        pts = &ts;
+    }
+    syscall (SYS_futex, &word, FUTEX_WAIT, val, pts, NULL, 0);
+}
+
+void
+shared_futex_wake (std::atomic<uint32_t> &word)
+{
+    syscall (SYS_futex, &word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
 }
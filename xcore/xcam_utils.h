@@ -64,6 +64,10 @@ void dump_buf_perfix_path (const SmartPtr<VideoBuffer> buf, const char *prefix_n
 bool dump_video_buf (const SmartPtr<VideoBuffer> buf, const char *file_name);
 bool dump_data_buf (const void *buf, const size_t &size, const char *file_name);
 
+// futex on a word shared between processes, timeout in microseconds, -1 waits until woken
+void shared_futex_wait (std::atomic<uint32_t> &word, uint32_t val, int64_t timeout_us = -1);
+void shared_futex_wake (std::atomic<uint32_t> &word);
+
 SmartPtr<VideoBuffer>
 external_buf_to_xcam_video_buf (
     uint8_t* buf, uint32_t format,